@@ -0,0 +1,47 @@
+#include "arena.h"
+#include <string.h>
+
+void arenaInit(PatternArena& a, uint8_t* mem, uint32_t capacity){
+  memset(&a, 0, sizeof(a));
+  a.mem = mem;
+  a.capacity = capacity;
+  a.owner[0] = a.owner[1] = ARENA_FREE;
+}
+
+void* arenaAcquire(PatternArena& a, uint8_t owner, uint32_t size, bool& fresh){
+  a.clock++;
+  for(uint8_t e = 0; e < 2; e++) {
+    if(a.owner[e] != owner) continue;
+    a.lastUse[e] = a.clock;
+    fresh = false;
+    return e == 0 ? a.mem : a.mem + a.capacity - a.used[e];
+  }
+
+  uint32_t need = arenaAlign(size);
+  if(need > a.capacity) return nullptr;
+
+  // A free end, else the one used least recently
+  uint8_t e = (a.owner[0] == ARENA_FREE) ? 0 : (a.owner[1] == ARENA_FREE) ? 1
+            : (a.lastUse[0] <= a.lastUse[1]) ? 0 : 1;
+  uint8_t other = e ^ 1;
+  if(need + a.used[other] > a.capacity) {
+    // Only when sizes outgrow the pair the arena was built for - both start over
+    a.owner[other] = ARENA_FREE;
+    a.used[other] = 0;
+  }
+  a.owner[e] = owner;
+  a.used[e] = need;
+  a.lastUse[e] = a.clock;
+
+  uint8_t* p = e == 0 ? a.mem : a.mem + a.capacity - need;
+  memset(p, 0, need);
+  uint32_t inUse = arenaInUse(a);
+  if(inUse > a.peak) a.peak = inUse;
+  a.restarts++;
+  fresh = true;
+  return p;
+}
+
+uint32_t arenaInUse(const PatternArena& a){
+  return a.used[0] + a.used[1];
+}
@@ -0,0 +1,52 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+// ── Pattern State Arena ──────────────────────────────────────────────────────
+// Patterns keep what they carry between frames (heat maps, particles, hue
+// counters) here instead of in static storage, so RAM goes to the patterns
+// that can run at once - the current one and, during a crossfade, the
+// incoming one - not to all of them. One pattern's state is taken from the
+// bottom of the arena and the other's from the top, so an arena the size of
+// the two largest states (arenaPairBytes) fits any pair. A pattern that gets
+// space starts from zeroed state, as after a reboot; the pattern used least
+// recently gives up its space.
+// Hardware-independent.
+
+#include <stdint.h>
+
+static const uint8_t  ARENA_FREE  = 0xFF;   // End not owned by any pattern
+static const uint32_t ARENA_ALIGN = 8;
+
+constexpr uint32_t arenaAlign(uint32_t bytes){
+  return (bytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+// Two largest aligned sizes - the arena that fits any two of them
+constexpr uint32_t arenaPairBytes(const uint16_t* sizes, uint8_t n){
+  uint32_t first = 0, second = 0;
+  for(uint8_t i = 0; i < n; i++) {
+    uint32_t s = arenaAlign(sizes[i]);
+    if(s > first) { second = first; first = s; }
+    else if(s > second) second = s;
+  }
+  return first + second;
+}
+
+struct PatternArena {
+  uint8_t* mem;
+  uint32_t capacity;
+  uint8_t  owner[2];       // Pattern holding the bottom / top end
+  uint32_t used[2];        // Bytes taken at each end
+  uint32_t lastUse[2];
+  uint32_t clock;
+  uint32_t peak;           // Most bytes in use at once
+  uint32_t restarts;       // Times a pattern's state was handed out fresh
+};
+
+void     arenaInit(PatternArena& a, uint8_t* mem, uint32_t capacity);
+// State for owner, size bytes. fresh is set when the space was (re)assigned
+// and zeroed. Null only when size exceeds the whole arena.
+void*    arenaAcquire(PatternArena& a, uint8_t owner, uint32_t size, bool& fresh);
+uint32_t arenaInUse(const PatternArena& a);
+
+#endif
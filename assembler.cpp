@@ -0,0 +1,153 @@
+#include "assembler.h"
+#include <string.h>
+
+static uint8_t countBits(uint64_t v){
+  uint8_t n = 0;
+  while(v){ v &= v - 1; n++; }
+  return n;
+}
+
+void asmInit(FrameAssembler& fa, uint8_t* rgb, uint16_t numLeds){
+  memset(&fa, 0, sizeof(fa));
+  fa.rgb = rgb;
+  fa.numLeds = numLeds;
+  asmResetStats(fa);
+}
+
+void asmReset(FrameAssembler& fa){
+  fa.active = fa.done = false;
+  fa.mask = 0;
+  fa.hops = 0;
+  fa.parityHave = false;
+}
+
+void asmResetStats(FrameAssembler& fa){
+  memset(&fa.stats, 0, sizeof(fa.stats));
+  fa.stats.offsetMinUs = INT32_MAX;
+}
+
+uint16_t asmLatencyUs(const FrameAssembler& fa){
+  const RxStats& st = fa.stats;
+  if(!st.offsetCount) return 0;
+  int64_t above = st.offsetSumUs / st.offsetCount - st.offsetMinUs;
+  return above > 0xFFFF ? 0xFFFF : (uint16_t)above;
+}
+
+static void saturatingAdd(uint16_t& counter, uint32_t n){
+  counter = (counter + n > 0xFFFF) ? 0xFFFF : counter + n;
+}
+
+// Close out the current frame before a new frame id takes over
+static void finishFrame(FrameAssembler& fa, const PacketInfo& next){
+  if(!fa.active || fa.version < 2) return;
+  if(!fa.done) {
+    saturatingAdd(fa.stats.framesLost, 1);
+    saturatingAdd(fa.stats.chunksLost, fa.chunkCount - countBits(fa.mask));
+  }
+  // Frames that never showed up at all (16-bit ids on the wire) - another
+  // leader's ids say nothing about ours
+  uint16_t gap = (uint16_t)(next.frameId - fa.frameId - 1);
+  if(next.token == fa.token && gap < ASM_STALE_FRAMES) {
+    saturatingAdd(fa.stats.framesLost, gap);
+    saturatingAdd(fa.stats.chunksExpected, (uint32_t)gap * fa.chunkCount);
+    saturatingAdd(fa.stats.chunksLost, (uint32_t)gap * fa.chunkCount);
+  }
+}
+
+static void startFrame(FrameAssembler& fa, const PacketInfo& pkt){
+  fa.active = true;
+  fa.done = false;
+  fa.version = pkt.version;
+  fa.token = pkt.token;
+  fa.frameId = pkt.frameId;
+  fa.mask = 0;
+  fa.hops = 0;
+  fa.timestampUs = pkt.timestampUs;
+  fa.parityHave = false;
+  memset(fa.parity, 0, sizeof(fa.parity));
+  if(pkt.version >= 2) {
+    fa.chunkCount = pkt.chunkCount;
+    saturatingAdd(fa.stats.chunksExpected, pkt.chunkCount);
+  } else {
+    fa.chunkCount = (fa.numLeds + PROTO_V1_LEDS_PER_CHUNK - 1) / PROTO_V1_LEDS_PER_CHUNK;
+  }
+}
+
+static void xorInto(uint8_t* acc, const uint8_t* data, int len){
+  for(int i = 0; i < len; i++) acc[i] ^= data[i];
+}
+
+static uint64_t fullMask(uint8_t chunkCount){
+  return (chunkCount >= 64) ? ~0ull : ((1ull << chunkCount) - 1);
+}
+
+// One data chunk missing and the parity chunk in hand - the XOR accumulator is the missing payload
+static bool recoverFromParity(FrameAssembler& fa){
+  uint64_t missing = fullMask(fa.chunkCount) & ~fa.mask;
+  if(!fa.parityHave || countBits(missing) != 1 || !fa.ledsPerChunk) return false;
+
+  uint8_t idx = 0;
+  while(!(missing & (1ull << idx))) idx++;
+  int base = idx * fa.ledsPerChunk;
+  int cnt = fa.numLeds - base;
+  if(cnt > fa.ledsPerChunk) cnt = fa.ledsPerChunk;
+  if(cnt > 0) protoDecodePixels(fa.parityFlags, fa.parity, cnt, fa.rgb + base * 3);
+  fa.mask |= (1ull << idx);
+  saturatingAdd(fa.stats.fecRecovered, 1);
+  return true;
+}
+
+bool asmAddChunk(FrameAssembler& fa, const PacketInfo& pkt, uint8_t hops, uint32_t rxMicros){
+  if(pkt.kind != PKT_PIXELS) return false;
+
+  if(pkt.version >= 2) {
+    // A bad header mustn't reset the frame in progress
+    if(pkt.chunkCount == 0 || pkt.chunkCount > ASM_MAX_CHUNKS) return false;
+    // 16-bit ids on the wire - a little behind, from the same leader and
+    // rendered just before, is a late (relayed) copy of an older frame.
+    // Anything else behind is a new or restarted leader.
+    bool sameLeader = fa.active && pkt.token == fa.token;
+    int16_t ahead = (int16_t)(uint16_t)(pkt.frameId - fa.frameId);
+    if(sameLeader && ahead < 0 && ahead > -ASM_STALE_FRAMES
+       && fa.timestampUs - pkt.timestampUs < ASM_STALE_US) return false;
+    if(!sameLeader || pkt.frameId != fa.frameId) {
+      finishFrame(fa, pkt);
+      startFrame(fa, pkt);
+    } else if(fa.done) {
+      return false;   // Late copy or unneeded parity for a frame already shown
+    }
+
+    // Latency sample - one per chunk, the clock offset cancels in asmLatencyUs()
+    int32_t offset = (int32_t)(rxMicros - pkt.timestampUs);
+    if(offset < fa.stats.offsetMinUs) fa.stats.offsetMinUs = offset;
+    fa.stats.offsetSumUs += offset;
+    fa.stats.offsetCount++;
+  } else if(!fa.active || fa.done) {
+    // v1 has no frame ids - the first chunk after a complete frame starts the next
+    startFrame(fa, pkt);
+  }
+
+  if(pkt.version >= 2 && (pkt.flags & PROTO_FLAG_FEC) && pkt.chunkIdx == pkt.chunkCount) {
+    // Parity chunk - offset carries the LEDs per chunk
+    fa.ledsPerChunk = pkt.offset;
+    fa.parityFlags = pkt.flags;
+    fa.parityHave = true;
+    xorInto(fa.parity, pkt.payload, pkt.payloadLen < sizeof(fa.parity) ? pkt.payloadLen : sizeof(fa.parity));
+  } else {
+    if(pkt.chunkIdx >= fa.chunkCount || (fa.mask & (1ull << pkt.chunkIdx))) return false;
+    int bpl = protoPixelBytes(pkt.version >= 2 ? pkt.flags : 0);
+    int cnt = pkt.payloadLen / bpl;
+    if(cnt <= 0) return false;
+    if(pkt.offset + cnt > fa.numLeds) cnt = fa.numLeds - pkt.offset;
+    if(cnt > 0) protoDecodePixels(pkt.version >= 2 ? pkt.flags : 0, pkt.payload, cnt, fa.rgb + pkt.offset * 3);
+    fa.mask |= (1ull << pkt.chunkIdx);
+    if(pkt.flags & PROTO_FLAG_FEC) xorInto(fa.parity, pkt.payload, pkt.payloadLen);
+  }
+  if(hops > fa.hops) fa.hops = hops;
+
+  if(fa.mask != fullMask(fa.chunkCount) && !recoverFromParity(fa)) return false;
+
+  fa.done = true;
+  saturatingAdd(fa.stats.framesComplete, 1);
+  return true;
+}
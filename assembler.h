@@ -0,0 +1,72 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+// ── Follower Frame Assembly ──────────────────────────────────────────────────
+// Turns parsed pixel packets (v1 or v2) back into complete frames: tracks the
+// chunks of the current frame id, decodes the pixel encoding, rebuilds a single
+// lost chunk from the FEC parity chunk, and keeps the loss/latency statistics
+// that followers report back to the leader. Hardware-independent - the
+// firmware (networking.cpp) and the capture replayer share it.
+
+#include <stdint.h>
+#include "protocol.h"
+
+static const uint8_t ASM_MAX_CHUNKS = 64;    // mask width - MAX_LEDS at the smallest chunks, with room to grow
+static const int16_t ASM_STALE_FRAMES = 100; // Chunks of a frame id up to this far behind the current one are dropped...
+static const uint32_t ASM_STALE_US    = 500000; // ...if rendered at most this long before it, by the same leader
+
+// Receive statistics for one report window (v2 frames only, except framesComplete)
+struct RxStats {
+  uint16_t framesComplete;
+  uint16_t framesLost;       // Torn (partial) or never seen at all
+  uint16_t chunksExpected;
+  uint16_t chunksLost;
+  uint16_t fecRecovered;     // Frames completed thanks to the parity chunk
+  int32_t  offsetMinUs;      // Smallest (rx time - leader timestamp) seen
+  int64_t  offsetSumUs;
+  uint16_t offsetCount;
+};
+
+struct FrameAssembler {
+  uint8_t* rgb;              // Destination frame (numLeds x 3 bytes)
+  uint16_t numLeds;
+
+  bool     active;           // A frame is being (or has been) assembled
+  bool     done;             // ...and it is complete
+  uint8_t  version;
+  uint32_t token;            // Leader sending it
+  uint32_t frameId;
+  uint8_t  chunkCount;
+  uint64_t mask;             // Chunks received
+  uint8_t  hops;             // Deepest relay hop among them
+  uint32_t timestampUs;      // Leader render time of this frame (v2)
+
+  // FEC - XOR of every payload received for this frame, including the parity chunk
+  uint8_t  parity[PROTO_MAX_PACKET];
+  bool     parityHave;
+  uint8_t  parityFlags;
+  uint8_t  ledsPerChunk;
+
+  RxStats  stats;
+};
+
+void asmInit(FrameAssembler& fa, uint8_t* rgb, uint16_t numLeds);
+
+// Drop any partial frame (FSM changes, sync resets) without counting it as lost
+void asmReset(FrameAssembler& fa);
+
+// Feed one parsed PKT_PIXELS packet. Returns true when this packet completed the
+// frame - fa.rgb then holds it, and fa.hops / fa.timestampUs describe it. A
+// frame from another leader, or from the same one restarted (ids and clock
+// from zero), replaces the current one straight away. A
+// leader with a longer strip than numLeds still completes frames; the pixels
+// past the end are dropped. A shorter one leaves the rest of rgb untouched.
+bool asmAddChunk(FrameAssembler& fa, const PacketInfo& pkt, uint8_t hops, uint32_t rxMicros);
+
+void asmResetStats(FrameAssembler& fa);
+
+// Mean transit delay above the fastest frame in the window - queueing, relay
+// and retry delay with the (unknown) clock offset cancelled out
+uint16_t asmLatencyUs(const FrameAssembler& fa);
+
+#endif
@@ -1,82 +1,139 @@
 #include "audio.h"
+#include "music.h"
+#include "spsc_ring.h"
+#include "esp_task_wdt.h"
 
-void initAudio(){
-  M5.Mic.begin(); 
-  M5.Mic.setSampleRate(MIC_SR);
-  lastBpmMillis = millis();
-}
+static const uint32_t AUDIO_BUDGET_US = 1000;   // Per hop - 9% of the 11.6ms it covers, ~5x headroom
 
-void detectAudioFrame(){
-  static int16_t micBuf[MIC_BUF_LEN];
-  if(!M5.Mic.record(micBuf, MIC_BUF_LEN)) return;
-  
-  long sum = 0; 
-  for(auto &v : micBuf) sum += abs(v);
-  float raw = float(sum) / MIC_BUF_LEN / 32767.0f;
-  
-  soundMin = min(raw, SMOOTH * soundMin + (1 - SMOOTH) * raw);
-  soundMax = max(raw, SMOOTH * soundMax + (1 - SMOOTH) * raw);
-  
-  // Adaptive sensitivity for high volume environments
-  float dynamicRange = soundMax - soundMin;
-  const float MIN_DYNAMIC_RANGE = 0.08f;  // Minimum range for reliable beat detection
-  const float HIGH_VOLUME_THRESHOLD = 0.7f;  // When average level indicates high volume environment
-  
-  float adaptedMin = soundMin;
-  float adaptedMax = soundMax;
-  float beatThreshold = 0.6f;  // Default threshold
-  
-  // Detect high volume saturation scenario
-  bool highVolumeEnvironment = (soundMin > HIGH_VOLUME_THRESHOLD) || (dynamicRange < MIN_DYNAMIC_RANGE);
+// ── Capture Task ─────────────────────────────────────────────────────────────
+// A task on core 0 (loop() runs on core 1) keeps one mic block queued ahead of
+// the one being recorded, so the I2S DMA never idles between blocks, and hands
+// each finished block to loop() through a lock-free ring. loop() analyses
+// whatever has arrived every pass; rendering only reads the published features.
+static const uint32_t AUDIO_RING_LEN   = 32;     // 186ms of blocks - rides out a slow loop() pass
+static const uint32_t AUDIO_TASK_STACK = 3072;
+static const UBaseType_t AUDIO_TASK_PRIO = 5;    // Above loop() - it only wakes to hand over a block
+static const int      AUDIO_TASK_CORE  = 0;
+
+struct AudioBlock {
+  int16_t  samples[MIC_BUF_LEN];
+  uint32_t endMs;         // millis() when the last sample landed
+};
+
+static SpscRing<AudioBlock, AUDIO_RING_LEN> audioRing;
+static volatile uint32_t captureBlocks = 0;
+
+static MusicDetector music;
+static uint32_t analysisPeakUs = 0, analysisSumUs = 0, analysisHops = 0;
+
+static void audioCaptureTask(void*){
+  // M5.Mic queues at most two buffers: record() into one while the other fills
+  static int16_t dmaBuf[2][MIC_BUF_LEN];
+  uint8_t cur = 0;
+  bool running = false;
   
-  if(highVolumeEnvironment) {
-    // In high volume environments, expand the dynamic range artificially
-    if(dynamicRange < MIN_DYNAMIC_RANGE) {
-      float expansion = (MIN_DYNAMIC_RANGE - dynamicRange) * 0.5f;
-      adaptedMin = max(0.0f, soundMin - expansion);
-      adaptedMax = min(1.0f, soundMax + expansion);
+  // A mic that stops completing blocks hangs the wait below - let the task watchdog see it
+  esp_task_wdt_add(nullptr);
+  for(;;) {
+    esp_task_wdt_reset();
+    if(currentMode == OFF) {
+      // Let the queued blocks finish, then leave the mic idle until AUTO
+      if(running) { while(M5.Mic.isRecording()) vTaskDelay(1); running = false; }
+      vTaskDelay(50);
+      continue;
+    }
+    if(!running) {
+      M5.Mic.record(dmaBuf[cur], MIC_BUF_LEN);
+      running = true;
     }
     
-    // Lower beat detection threshold in high volume environments
-    beatThreshold = 0.35f;
+    // Queue the next block before the current one completes...
+    M5.Mic.record(dmaBuf[cur ^ 1], MIC_BUF_LEN);
+    // ...then wait for the current one (the queue drops back to one entry)
+    while(M5.Mic.isRecording() >= 2) vTaskDelay(1);
     
-    if(DEBUG_BPM && millis() % 2000 < 50) {
-      Serial.printf("HIGH-VOL: range=%.3f->%.3f, thresh=%.2f, raw=%.3f\n", 
-        dynamicRange, adaptedMax - adaptedMin, beatThreshold, raw);
+    AudioBlock* blk = audioRing.beginWrite();
+    if(blk) {       // Full ring is counted in audioRing.overflows
+      memcpy(blk->samples, dmaBuf[cur], sizeof(blk->samples));
+      blk->endMs = millis();
+      audioRing.commitWrite();
     }
+    captureBlocks++;
+    cur ^= 1;
   }
-  
-  musicLevel = constrain((raw - adaptedMin) / (adaptedMax - adaptedMin + 1e-6f), 0.0f, 1.0f);
-  
-  bool above = (musicLevel > beatThreshold);
-  if(above && !prevAbove){
-    uint32_t t = millis();
-    if(beatCount < 50) {
-      beatTimes[beatCount++] = t;
-    } else { 
-      memmove(beatTimes, beatTimes + 1, 49 * sizeof(uint32_t)); 
-      beatTimes[49] = t; 
+}
+
+void initAudio(){
+  M5.Mic.begin(); 
+  M5.Mic.setSampleRate(MIC_SR);
+  musicInit(music, MIC_SR);
+  lastBpmMillis = millis();
+  xTaskCreatePinnedToCore(audioCaptureTask, "audioCapture", AUDIO_TASK_STACK, nullptr,
+                          AUDIO_TASK_PRIO, nullptr, AUDIO_TASK_CORE);
+}
+
+void serviceAudio(){
+  while(const AudioBlock* blk = audioRing.peek()) {
+    uint32_t start = micros();
+    int hops = musicFeed(music, blk->samples, MIC_BUF_LEN, blk->endMs);
+    audioRing.pop();
+    if(hops) {
+      // Publish the hop - patterns read audioFeatures, effectMusic reads musicLevel
+      audioFeatures = music.features;
+      musicLevel = audioFeatures.level / 32767.0f;
+      analysisHops += hops;
     }
+    uint32_t us = micros() - start;
+    analysisSumUs += us;
+    if(us > analysisPeakUs) analysisPeakUs = us;
   }
-  prevAbove = above;
 }
 
 void updateBPM(){
+  // Music = a confident, steady tempo (with hysteresis so it doesn't flicker)
+  audioDetected = musicUpdate(music);
+  
   uint32_t now = millis();
   if(now - lastBpmMillis >= BPM_WINDOW){
-    int cnt = 0; 
-    uint32_t cutoff = now - BPM_WINDOW;
-    for(int i = 0; i < beatCount; i++) {
-      if(beatTimes[i] >= cutoff) cnt++;
-    }
-    
-    float bpm = cnt * (60000.0f / float(BPM_WINDOW));
-    audioDetected = (cnt >= 4 && bpm >= 30.0f && bpm <= 300.0f);
     lastBpmMillis += BPM_WINDOW; 
-    beatCount = 0;
     
     if(DEBUG_BPM) {
-      Serial.printf("BPM: %d→%.1f [%s]\n", cnt, bpm, audioDetected ? "Music" : "Bg");
+      Serial.printf("BPM: %.1f conf=%.2f beats=%u [%s] bass=%u mid=%u treble=%u\n",
+        music.tempo.bpm, music.tempo.confidence, music.tempo.beats, audioDetected ? "Music" : "Bg",
+        audioFeatures.band[BAND_BASS] >> 7, audioFeatures.band[BAND_MID] >> 7, audioFeatures.band[BAND_TREBLE] >> 7);
+    }
+    if(DEBUG_SERIAL && analysisHops && (DEBUG_BPM || analysisPeakUs > AUDIO_BUDGET_US)) {
+      Serial.printf("AUDIO: analysis avg=%uus peak=%uus per hop (budget %uus)\n",
+        analysisSumUs / analysisHops, analysisPeakUs, AUDIO_BUDGET_US);
+    }
+    static uint32_t reportedDrops = 0;
+    uint32_t drops = audioRing.overflows.load(std::memory_order_relaxed);
+    if(DEBUG_SERIAL && (DEBUG_BPM || drops != reportedDrops)) {
+      Serial.printf("AUDIO: captured=%u blocks ring=%u/%u peak=%u dropped=%u\n",
+        captureBlocks, audioRing.size(), AUDIO_RING_LEN,
+        audioRing.highWater.load(std::memory_order_relaxed), drops);
+      reportedDrops = drops;
     }
+    analysisPeakUs = analysisSumUs = analysisHops = 0;
   }
-}
\ No newline at end of file
+}
+
+bool beatLocked(){
+  return musicBeatLocked(music);
+}
+
+float beatBPM(){
+  return music.tempo.bpm;
+}
+
+uint32_t lastBeatMillis(){
+  return music.lastBeatMs;
+}
+
+uint8_t beatPhase8(){
+  // Extrapolate from the last beat so patterns rendering between hops stay smooth
+  float periodMs = 60000.0f / music.tempo.bpm;
+  float ph = (millis() - music.lastBeatMs) / periodMs;
+  if(ph >= 1.0f) ph -= (int)ph;
+  return (uint8_t)(ph * 256.0f);
+}
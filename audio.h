@@ -5,7 +5,13 @@
 
 // ── Audio Functions ───────────────────────────────────────────────────────────
 void initAudio();
-void detectAudioFrame();
+void serviceAudio();            // Analyse captured blocks - call every loop() pass
 void updateBPM();
 
-#endif
\ No newline at end of file
+// ── Beat Clock (tempo.h) ─────────────────────────────────────────────────────
+bool     beatLocked();          // Music with a confident tempo - the clock below is real
+float    beatBPM();
+uint32_t lastBeatMillis();
+uint8_t  beatPhase8();          // 0 on the beat, rising to 255 just before the next
+
+#endif
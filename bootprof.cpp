@@ -0,0 +1,39 @@
+#include "bootprof.h"
+
+const char* BOOT_MILESTONE_NAMES[BOOT_MILESTONE_COUNT] = {
+  "listening", "first packet", "first leader", "first synced frame"
+};
+
+void bootStageBegin(BootProfile& bp, const char* name, uint32_t nowUs){
+  bootStageEnd(bp, nowUs);
+  if(bp.count >= BOOT_MAX_STAGES) return;
+  BootStage& s = bp.stages[bp.count++];
+  s.name = name;
+  s.startUs = nowUs;
+  s.endUs = 0;
+}
+
+void bootStageEnd(BootProfile& bp, uint32_t nowUs){
+  if(bp.count && bp.stages[bp.count - 1].endUs == 0) {
+    // A stage can't end at time 0 - keep 0 meaning "still running"
+    bp.stages[bp.count - 1].endUs = nowUs ? nowUs : 1;
+  }
+}
+
+bool bootMilestone(BootProfile& bp, BootMilestone m, uint32_t nowUs){
+  if(bp.milestoneUs[m]) return false;
+  bp.milestoneUs[m] = nowUs ? nowUs : 1;
+  return true;
+}
+
+bool bootReached(const BootProfile& bp, BootMilestone m){
+  return bp.milestoneUs[m] != 0;
+}
+
+uint32_t bootStagesUs(const BootProfile& bp){
+  uint32_t total = 0;
+  for(int i = 0; i < bp.count; i++) {
+    if(bp.stages[i].endUs) total += bp.stages[i].endUs - bp.stages[i].startUs;
+  }
+  return total;
+}
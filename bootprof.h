@@ -0,0 +1,50 @@
+#ifndef BOOTPROF_H
+#define BOOTPROF_H
+
+// ── Boot Profiler ────────────────────────────────────────────────────────────
+// Records how long each setup() stage takes and when the node first hears the
+// mesh, first hears a leader and first presents a synced frame. Nodes get
+// power-cycled constantly at events, so power-on to first synced frame is the
+// number that matters. Times are micros() - app start, so the ROM and second
+// stage bootloader (a fixed ~300ms before us) aren't included.
+// Hardware-independent (the caller supplies the time).
+
+#include <stdint.h>
+
+static const uint8_t BOOT_MAX_STAGES = 12;
+
+enum BootMilestone {
+  BOOT_LISTENING = 0,   // ESP-NOW receive callback registered
+  BOOT_FIRST_PACKET,    // Any valid packet parsed
+  BOOT_FIRST_LEADER,    // First packet carrying the leader flag
+  BOOT_FIRST_FRAME,     // First frame presented in sync (as follower, or rendered as leader)
+  BOOT_MILESTONE_COUNT
+};
+
+struct BootStage {
+  const char* name;
+  uint32_t    startUs;
+  uint32_t    endUs;      // 0 while the stage is running
+};
+
+struct BootProfile {
+  BootStage stages[BOOT_MAX_STAGES];
+  uint8_t   count;
+  uint32_t  milestoneUs[BOOT_MILESTONE_COUNT];   // 0 = not reached yet
+  bool      firstFrameAsLeader;
+};
+
+extern const char* BOOT_MILESTONE_NAMES[BOOT_MILESTONE_COUNT];
+
+// Stages nest poorly and don't need to - begin closes whatever stage is open
+void bootStageBegin(BootProfile& bp, const char* name, uint32_t nowUs);
+void bootStageEnd(BootProfile& bp, uint32_t nowUs);
+
+// Returns true the first time a milestone is reached
+bool bootMilestone(BootProfile& bp, BootMilestone m, uint32_t nowUs);
+bool bootReached(const BootProfile& bp, BootMilestone m);
+
+// Sum of the recorded stages
+uint32_t bootStagesUs(const BootProfile& bp);
+
+#endif
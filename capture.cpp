@@ -0,0 +1,51 @@
+#include "capture.h"
+#include "protocol.h"
+#include <string.h>
+
+static uint16_t recordCrc(const uint8_t* rec, const uint8_t* data, uint8_t len){
+  uint16_t crc = protoCrc16(rec + 2, CAPTURE_HEADER_LEN - 4);
+  return protoCrc16(data, len, crc);
+}
+
+int captureEncode(uint8_t* out, uint16_t seq, uint32_t rxMicros, int8_t rssi,
+                  const uint8_t* src, const uint8_t* data, uint8_t len){
+  if(len > CAPTURE_MAX_PACKET) len = CAPTURE_MAX_PACKET;
+  out[0] = CAPTURE_MAGIC0;
+  out[1] = CAPTURE_MAGIC1;
+  out[2] = len;
+  out[3] = (uint8_t)rssi;
+  memcpy(out + 4, &rxMicros, 4);
+  memcpy(out + 8, &seq, 2);
+  if(src) memcpy(out + 10, src, 6);
+  else    memset(out + 10, 0, 6);
+  memcpy(out + CAPTURE_HEADER_LEN, data, len);
+  uint16_t crc = recordCrc(out, data, len);
+  memcpy(out + 16, &crc, 2);
+  return CAPTURE_HEADER_LEN + len;
+}
+
+bool captureNext(const uint8_t* buf, size_t bufLen, size_t& pos, CaptureRecord& rec, size_t* skipped){
+  while(pos + CAPTURE_HEADER_LEN <= bufLen) {
+    const uint8_t* p = buf + pos;
+    uint8_t len = p[2];
+    if(p[0] == CAPTURE_MAGIC0 && p[1] == CAPTURE_MAGIC1 && len > 0 &&
+       pos + CAPTURE_HEADER_LEN + len <= bufLen) {
+      uint16_t crc;
+      memcpy(&crc, p + 16, 2);
+      if(crc == recordCrc(p, p + CAPTURE_HEADER_LEN, len)) {
+        rec.len  = len;
+        rec.rssi = (int8_t)p[3];
+        memcpy(&rec.rxMicros, p + 4, 4);
+        memcpy(&rec.seq, p + 8, 2);
+        memcpy(rec.src, p + 10, 6);
+        rec.data = p + CAPTURE_HEADER_LEN;
+        pos += CAPTURE_HEADER_LEN + len;
+        return true;
+      }
+    }
+    // Debug text, a truncated record or line noise - resync one byte on
+    pos++;
+    if(skipped) (*skipped)++;
+  }
+  return false;
+}
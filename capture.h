@@ -0,0 +1,47 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+// ── ESP-NOW Packet Capture ───────────────────────────────────────────────────
+// With CAPTURE_MODE on, every packet loop() takes off the receive ring is also
+// written to USB serial as a binary record, exactly as it came off the air
+// (relay wrapper included). Records start with a 2-byte magic and carry a CRC,
+// so debug text interleaved on the same port is simply skipped by the reader.
+// Hardware-independent - tools/replay.cpp reads captures with the same code.
+//
+// Record layout (little-endian):
+//   [0-1]   magic 0xC5 0xA7
+//   [2]     packet length
+//   [3]     RSSI (dBm, int8)
+//   [4-7]   receive time (micros())
+//   [8-9]   record sequence (gaps = records dropped because serial was full)
+//   [10-15] sender MAC
+//   [16-17] CRC-16 over [2..16) + packet
+//   [18..]  packet
+
+#include <stdint.h>
+#include <stddef.h>
+
+static const uint8_t  CAPTURE_MAGIC0     = 0xC5;
+static const uint8_t  CAPTURE_MAGIC1     = 0xA7;
+static const uint8_t  CAPTURE_HEADER_LEN = 18;
+static const uint16_t CAPTURE_MAX_PACKET = 250;   // ESP_NOW_MAX_DATA_LEN
+static const uint16_t CAPTURE_MAX_RECORD = CAPTURE_HEADER_LEN + CAPTURE_MAX_PACKET;
+
+struct CaptureRecord {
+  uint32_t rxMicros;
+  uint16_t seq;
+  int8_t   rssi;
+  uint8_t  src[6];
+  uint8_t  len;
+  const uint8_t* data;    // Points into the buffer passed to captureNext()
+};
+
+// Returns the record length written to out (CAPTURE_MAX_RECORD bytes available)
+int captureEncode(uint8_t* out, uint16_t seq, uint32_t rxMicros, int8_t rssi,
+                  const uint8_t* src, const uint8_t* data, uint8_t len);
+
+// Find the next valid record at or after pos, skipping anything that isn't one.
+// Advances pos past it and adds skipped bytes to *skipped. False at end of buffer.
+bool captureNext(const uint8_t* buf, size_t bufLen, size_t& pos, CaptureRecord& rec, size_t* skipped);
+
+#endif
@@ -9,15 +9,54 @@
 #include <esp_wifi.h>
 #include <ArduinoOTA.h>
 #include <math.h>
+#include "onset.h"
+#include "bootprof.h"
+#include "telemetry.h"
+#include "striplayout.h"
+#include "pixelmap.h"
 
 // ── Hardware Config ──────────────────────────────────────────────────────────
 #define LED_PIN         33
-#define NUM_LEDS        334
+#define DEFAULT_LEDS    334   // Strip length until the LEDS command sets another
+#define MIN_LEDS        60    // Patterns place features 20-30 pixels in from the ends
+#define MAX_LEDS        1024  // Buffer capacity - the strip length is a runtime setting up to this
 #define COLOR_ORDER     GRB
 #define CHIPSET         WS2812B
 #define FRAME_DELAY_MS  20
 
-static constexpr size_t MIC_BUF_LEN = 240;
+// ── Strip Layout ─────────────────────────────────────────────────────────────
+// One entry per strip, each on its own pin and output channel, all clocked out
+// in parallel (striplayout.h). Counts add up to DEFAULT_LEDS; whichever strip
+// shows the end of the logical strip grows or shrinks to the runtime length
+// (stripLayoutFit). Two strips fed from the middle of the run, for example:
+//   {LED_PIN, 0, DEFAULT_LEDS / 2, true}, {32, DEFAULT_LEDS / 2, DEFAULT_LEDS - DEFAULT_LEDS / 2, false}
+static const StripConfig STRIPS[] = {
+  {LED_PIN, 0, DEFAULT_LEDS, false},
+};
+static const uint8_t STRIP_COUNT = sizeof(STRIPS) / sizeof(STRIPS[0]);
+
+// ── Pixel Maps ───────────────────────────────────────────────────────────────
+// Where the pixels hang, in mm with y up, segments in logical pixel order
+// (pixelmap.h). Every node runs the same build; the MAP command picks the one
+// this node is mounted as and it is stored with the settings, by position in
+// PIXEL_MAPS - add new maps at the end. A map whose segments don't place
+// exactly numLeds pixels is drawn as the straight line.
+static const MapSegment MAP_POLE[] = {
+  mapArc(DEFAULT_LEDS, MAP_AXIS_Y, 0, 0, 0, 50, 0, 360 * 16, 2400),   // 16 turns round a 100mm pole, 2.4m up
+};
+static const MapSegment MAP_ARCH[] = {
+  mapLine(72, -1000, 0, 0, -1000, 1200, 0),                    // Left leg, up
+  mapArc(DEFAULT_LEDS - 144, MAP_AXIS_Z, 0, 1200, 0, 1000, 180, 0, 0),   // Over the top
+  mapLine(72, 1000, 1200, 0, 1000, 0, 0),                      // Right leg, down
+};
+static const PixelMapDef PIXEL_MAPS[] = {
+  {"line", nullptr,  0, MAP_AXIS_Z},
+  {"pole", MAP_POLE, sizeof(MAP_POLE) / sizeof(MAP_POLE[0]), MAP_AXIS_Y},
+  {"arch", MAP_ARCH, sizeof(MAP_ARCH) / sizeof(MAP_ARCH[0]), MAP_AXIS_Z},
+};
+static const uint8_t PIXEL_MAP_COUNT = sizeof(PIXEL_MAPS) / sizeof(PIXEL_MAPS[0]);
+
+static constexpr size_t MIC_BUF_LEN = 256;   // Samples per capture block (5.8ms)
 static constexpr int      MIC_SR     = 44100;
 
 // ── Debug Control ────────────────────────────────────────────────────────────
@@ -41,6 +80,28 @@ struct BrightnessLevel {
 #define MSGTYPE_TOKEN         0x01
 #define MSGTYPE_OTA_SUSPEND   0x02  // Request all nodes to suspend ESP-NOW for OTA
 #define MSGTYPE_OTA_RESUME    0x03  // Request all nodes to resume ESP-NOW after OTA
+#define MSGTYPE_RELAY         0x04  // Re-broadcast frame: [type][hops][original packet]
+#define MSGTYPE_V2            0x05  // Versioned framing with CRC - layout in protocol.h
+
+// ── Wire Protocol ────────────────────────────────────────────────────────────
+#define WIRE_PROTOCOL   2     // 2 = v2 framing (falls back to v1 until reboot once a v1-only node is heard)
+                              // 1 = always send v1 (receive both)
+
+// ── Multi-hop Relay ──────────────────────────────────────────────────────────
+#define RELAY_MODE      0     // Set to 1 so followers re-broadcast frames past the leader's radio cell
+                              // (all nodes must agree - presentation timing is compensated per hop)
+
+// ── Frame Playout ────────────────────────────────────────────────────────────
+// Every node shows frames through playout.h: at the display rate, blending
+// the leader's frames either side of a moment about one frame interval behind
+#define LEADER_RENDER_FPS 50  // Leader pattern frames - patterns step per frame, so this sets their speed.
+                              // The link level (LINK_LEVELS) sets how many of them go on the air
+#define DISPLAY_FPS     100    // Display rate at most - lower when showLeds() would take over half of loop()
+
+// ── Packet Capture ───────────────────────────────────────────────────────────
+#define CAPTURE_MODE    0     // Set to 1 to stream every received ESP-NOW packet over USB serial
+                              // (binary records, see capture.h - replay with tools/replay.cpp)
+#define CAPTURE_BAUD    921600  // Serial rate while capturing (a 50fps leader is ~65KB/s)
 
 // ── WiFi Configuration (now handled in networking.cpp) ───────────────────────
 // WiFi networks are now defined in networking.cpp to support multiple networks
@@ -52,13 +113,23 @@ static const uint32_t ELECTION_TIMEOUT      = ELECTION_BASE_DELAY + ELECTION_JIT
 static const uint32_t LEADER_TOKEN_INTERVAL = FRAME_DELAY_MS;
 static const uint32_t LEADER_HEARTBEAT_INTERVAL = 100;
 
+// ── Boot ──────────────────────────────────────────────────────────────────────
+// A leader is heard within a few ms (frames + 100Hz audio stream + heartbeats),
+// so a freshly booted node that has heard nothing for BOOT_LISTEN_MS elects
+// straight away instead of sitting out the full LEADER_TIMEOUT.
+static const uint32_t BOOT_LISTEN_MS        = 3 * LEADER_HEARTBEAT_INTERVAL;
+// Audio and the splash wait for the first synced frame, or this long at most
+static const uint32_t BOOT_DEFER_MAX_MS     = 1000;
+
 // ── Audio Config ──────────────────────────────────────────────────────────────
-static constexpr float SMOOTH = 0.995f;
-static constexpr uint32_t BPM_WINDOW = 5000;
+static constexpr uint32_t BPM_WINDOW = 5000;   // Tempo debug report interval
+
+// ── Pattern Registry ─────────────────────────────────────────────────────────
+static const uint8_t PATTERN_COUNT = 42;   // STYLE_NAMES / PATTERNS registry entries
 
 // ── Names ─────────────────────────────────────────────────────────────────────
 extern const char* MODE_NAMES[MODE_COUNT];
-extern const char* STYLE_NAMES[42];
+extern const char* STYLE_NAMES[PATTERN_COUNT];
 extern BrightnessLevel brightnessLevels[6];
 
 // ── Global Variables ──────────────────────────────────────────────────────────
@@ -66,26 +137,29 @@ extern Mode      currentMode;
 extern FsmState  fsmState;
 extern uint8_t   styleIdx;
 extern bool      freezeActive;
-extern CRGB      leds[NUM_LEDS];
+extern CRGB      leds[MAX_LEDS];
+extern uint16_t  numLeds;          // Strip length, MIN_LEDS..MAX_LEDS - loaded with the settings, fixed until reboot
+extern uint8_t   pixelMap;         // This node's entry in PIXEL_MAPS - loaded with the settings
 extern LGFX_Sprite canvas;
 extern Preferences prefs;
+extern BootProfile bootProfile;
 
 // ── Global Brightness Control ────────────────────────────────────────────────
 extern uint8_t   globalBrightnessScale;  // 0-255, runtime adjustable
 
 // ── Control Arrays ────────────────────────────────────────────────────────────
-extern uint8_t speedVals[MODE_COUNT][22], brightVals[MODE_COUNT][22],
-               ssensVals[MODE_COUNT][22], bsensVals[MODE_COUNT][22],
-               vsensVals[MODE_COUNT][22], decayVals[MODE_COUNT][22],
-               timeVals[MODE_COUNT][22];
+extern uint8_t speedVals[MODE_COUNT][PATTERN_COUNT], brightVals[MODE_COUNT][PATTERN_COUNT],
+               ssensVals[MODE_COUNT][PATTERN_COUNT], bsensVals[MODE_COUNT][PATTERN_COUNT],
+               vsensVals[MODE_COUNT][PATTERN_COUNT], decayVals[MODE_COUNT][PATTERN_COUNT],
+               timeVals[MODE_COUNT][PATTERN_COUNT];
 
 // ── Network Variables ─────────────────────────────────────────────────────────
 extern uint8_t  broadcastAddress[6];
-extern uint32_t masterSeq, chunkMask, lastRecvMillis;
+extern uint32_t masterSeq, lastRecvMillis;
 extern uint32_t electionStart, electionEnd;
 extern uint32_t myToken, highestTokenSeen, myDelay;
 extern bool     electionBroadcasted;
-extern uint32_t lastTokenBroadcast, lastHeartbeat, missedFrameCount;
+extern uint32_t lastTokenBroadcast, missedFrameCount;
 
 // ── OTA Coordination Variables ───────────────────────────────────────────────
 extern bool     otaSuspended;           // True when ESP-NOW is suspended for OTA
@@ -94,13 +168,17 @@ extern uint32_t otaSuspendDuration;     // How long to suspend (default 300 seco
 extern uint32_t bootupQuietTime;        // How long to stay quiet after boot (prevent OTA interference)
 
 // ── Audio Variables ───────────────────────────────────────────────────────────
-extern float   soundMin, soundMax, musicLevel;
-extern bool    prevAbove;
-extern uint32_t beatTimes[50];
-extern uint8_t  beatCount;
+extern float   musicLevel;              // audioFeatures.level as 0..1, for patterns
+extern AudioFeatures audioFeatures;     // Latest analysis hop (onset.h)
 extern uint32_t lastBpmMillis;
 extern bool    audioDetected;
 
+// ── System Health ─────────────────────────────────────────────────────────────
+extern uint32_t maxLoopStallUs;         // Longest gap between loop() passes since boot
+extern uint32_t windowLoopStallUs;      // Longest gap since the last health report
+extern LoopHistogram loopHist;          // loop() pass times since the last telemetry beacon
+void feedWatchdog();                    // Task watchdog - loop task only, also during long blocking work
+
 // ── Helper Functions ──────────────────────────────────────────────────────────
 inline uint8_t getSpeed()  { return speedVals[currentMode][styleIdx]; }
 inline uint8_t getBright() { return brightVals[currentMode][styleIdx]; }
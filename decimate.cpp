@@ -0,0 +1,98 @@
+#include "decimate.h"
+#include <string.h>
+
+// ── Compile-time filter design ───────────────────────────────────────────────
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+constexpr double sinTaylor(double x){
+  // Range-reduce to [-pi, pi], then enough terms for double precision
+  while(x >  PI) x -= 2 * PI;
+  while(x < -PI) x += 2 * PI;
+  double term = x, sum = x;
+  for(int n = 1; n < 12; n++) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double besselI0(double x){
+  double term = 1, sum = 1;
+  for(int k = 1; k < 40; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double sqrtNewton(double x){
+  double r = x > 1 ? x : 1;
+  for(int i = 0; i < 60; i++) r = 0.5 * (r + x / r);
+  return r;
+}
+
+struct FirTable {
+  int16_t  h[DECIM_TAPS];
+  int32_t  absSum;    // Sum of |h|, for the accumulator headroom check
+};
+
+constexpr FirTable designLowpass(double cutoffHz, double sampleHz, double beta){
+  FirTable t = {};
+  double ideal[DECIM_TAPS] = {};
+  double centre = (DECIM_TAPS - 1) / 2.0, fc = cutoffHz / sampleHz, sum = 0;
+  for(int i = 0; i < DECIM_TAPS; i++) {
+    double x = i - centre;
+    double sinc = 2 * fc * sinTaylor(2 * PI * fc * x) / (2 * PI * fc * x);   // x is never 0 (even length)
+    double r = x / centre;
+    double w = besselI0(beta * sqrtNewton(1 - r * r > 0 ? 1 - r * r : 0)) / besselI0(beta);
+    ideal[i] = sinc * w;
+    sum += ideal[i];
+  }
+  // Q15 with unity DC gain - rounding error goes into the two centre taps
+  int32_t total = 0;
+  for(int i = 0; i < DECIM_TAPS; i++) {
+    double v = ideal[i] / sum * 32768.0;
+    t.h[i] = (int16_t)(v < 0 ? v - 0.5 : v + 0.5);
+    total += t.h[i];
+  }
+  int32_t fix = 32768 - total;
+  t.h[DECIM_TAPS / 2 - 1] += fix / 2;
+  t.h[DECIM_TAPS / 2]     += fix - fix / 2;
+  for(int i = 0; i < DECIM_TAPS; i++) t.absSum += t.h[i] < 0 ? -t.h[i] : t.h[i];
+  return t;
+}
+
+// Cut-off midway through the transition band; beta 4.55 gives ~50dB stopband,
+// and 64 taps a ~2kHz transition at 44.1kHz
+constexpr FirTable FIR = designLowpass((DECIM_PASS_HZ + DECIM_STOP_HZ) / 2.0, 44100.0, 4.55);
+
+// Each symmetric pair adds up to 65534 x |h|, so the worst case is 32767 x sum|h|
+static_assert(FIR.absSum < 65536, "decimator could overflow its accumulator");
+static_assert(DECIM_TAPS % 2 == 0, "decimator folds symmetric pairs");
+
+}  // namespace
+
+void decimatorInit(Decimator& d){
+  memset(&d, 0, sizeof(d));
+}
+
+int decimate(Decimator& d, const int16_t* in, int count, int16_t* out){
+  int n = 0;
+  for(int i = 0; i < count; i++) {
+    d.pos = d.pos ? d.pos - 1 : DECIM_TAPS - 1;
+    d.line[d.pos] = d.line[d.pos + DECIM_TAPS] = in[i];
+    if(++d.phase < DECIM_FACTOR) continue;
+    d.phase = 0;
+    
+    const int16_t* x = d.line + d.pos;    // x[0] newest ... x[TAPS-1] oldest
+    int32_t acc = 1 << 14;
+    for(int k = 0; k < DECIM_TAPS / 2; k++) {
+      acc += (int32_t)FIR.h[k] * ((int32_t)x[k] + x[DECIM_TAPS - 1 - k]);
+    }
+    acc >>= 15;
+    out[n++] = (int16_t)(acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc));
+  }
+  return n;
+}
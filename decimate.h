@@ -0,0 +1,32 @@
+#ifndef DECIMATE_H
+#define DECIMATE_H
+
+// ── Decimating FIR Front-end ─────────────────────────────────────────────────
+// Low-pass filters the microphone stream and keeps every DECIM_FACTOR-th
+// sample (44.1kHz -> 11.025kHz), so the analysis downstream runs on a quarter
+// of the data. Only the kept outputs are computed - the polyphase saving - and
+// the filter is symmetric, so each costs DECIM_TAPS/2 multiply-adds: 8 per
+// input sample. The Kaiser-windowed-sinc coefficients are worked out by the
+// compiler in Q15 (decimate.cpp), so there is no float maths or table setup
+// at runtime. Hardware-independent.
+
+#include <stdint.h>
+
+static const uint8_t  DECIM_FACTOR    = 4;
+static const uint16_t DECIM_TAPS      = 64;      // Even, symmetric
+static const uint16_t DECIM_PASS_HZ   = 4500;    // Flat to here at 44.1kHz in...
+static const uint16_t DECIM_STOP_HZ   = 6500;    // ...down ~50dB from here, so aliases fold no lower than 4.5kHz
+
+struct Decimator {
+  int16_t line[2 * DECIM_TAPS];   // Delay line, written twice so every window is contiguous
+  uint16_t pos;                   // Newest sample
+  uint8_t  phase;                 // Inputs since the last output
+};
+
+void decimatorInit(Decimator& d);
+
+// Filter count input samples into out (room for count / DECIM_FACTOR + 1).
+// Returns the number of output samples written.
+int  decimate(Decimator& d, const int16_t* in, int count, int16_t* out);
+
+#endif
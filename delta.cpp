@@ -0,0 +1,204 @@
+#include "delta.h"
+#include <string.h>
+
+static const uint8_t DELTA_MAGIC[4] = {'P', 'L', 'D', '1'};
+
+enum DeltaState : uint8_t {
+  DS_HEADER = 0,
+  DS_OP,
+  DS_COPY_DELTA,
+  DS_COPY_LEN,
+  DS_GROUP_SKIP,
+  DS_GROUP_N,
+  DS_GROUP_BYTES,
+  DS_INSERT_LEN,
+  DS_INSERT_BYTES,
+  DS_DONE,
+  DS_ERROR,
+};
+
+// ── Header ──
+
+int deltaHeaderEncode(const DeltaHeader& h, uint8_t* out){
+  memcpy(out + 0,  DELTA_MAGIC, 4);
+  memcpy(out + 4,  &h.patchSize, 4);
+  memcpy(out + 8,  &h.oldSize, 4);
+  memcpy(out + 12, &h.newSize, 4);
+  memcpy(out + 16, h.oldSha, SHA256_LEN);
+  memcpy(out + 16 + SHA256_LEN, h.newSha, SHA256_LEN);
+  return DELTA_HEADER_LEN;
+}
+
+bool deltaHeaderDecode(const uint8_t* in, int len, DeltaHeader& h){
+  if(len < DELTA_HEADER_LEN || memcmp(in, DELTA_MAGIC, 4) != 0) return false;
+  memcpy(&h.patchSize, in + 4, 4);
+  memcpy(&h.oldSize, in + 8, 4);
+  memcpy(&h.newSize, in + 12, 4);
+  memcpy(h.oldSha, in + 16, SHA256_LEN);
+  memcpy(h.newSha, in + 16 + SHA256_LEN, SHA256_LEN);
+  return h.patchSize >= DELTA_HEADER_LEN;
+}
+
+// ── Apply ──
+
+static DeltaResult fail(DeltaApply& a, const char* why){
+  a.state = DS_ERROR;
+  a.error = why;
+  return DELTA_ERROR;
+}
+
+static bool flushOut(DeltaApply& a){
+  if(!a.outLen) return true;
+  sha256Update(a.sha, a.out, a.outLen);
+  bool ok = a.writeNew(a.ctx, a.out, a.outLen);
+  a.outLen = 0;
+  return ok;
+}
+
+// Make oldPos readable from the cache; false past the end of the old image
+static bool fillOld(DeltaApply& a){
+  if(a.oldPos >= a.oldBufStart && a.oldPos < a.oldBufStart + a.oldBufLen) return true;
+  if(a.oldPos >= a.hdr.oldSize) return false;
+  uint32_t n = a.hdr.oldSize - a.oldPos;
+  if(n > DELTA_OLD_CACHE) n = DELTA_OLD_CACHE;
+  if(!a.readOld(a.ctx, a.oldPos, a.oldBuf, n)) return false;
+  a.oldBufStart = a.oldPos;
+  a.oldBufLen = n;
+  return true;
+}
+
+// Copy n old bytes unchanged, in as few reads / writes as the buffers allow
+static bool copyOld(DeltaApply& a, uint32_t n){
+  while(n) {
+    if(!fillOld(a)) return false;
+    uint32_t avail = a.oldBufStart + a.oldBufLen - a.oldPos;
+    uint32_t room = DELTA_OUT_BUF - a.outLen;
+    uint32_t take = n < avail ? n : avail;
+    if(take > room) take = room;
+    memcpy(a.out + a.outLen, a.oldBuf + (a.oldPos - a.oldBufStart), take);
+    a.outLen += take;
+    a.oldPos += take;
+    a.newPos += take;
+    n -= take;
+    if(a.outLen == DELTA_OUT_BUF && !flushOut(a)) return false;
+  }
+  return true;
+}
+
+static bool putByte(DeltaApply& a, uint8_t b){
+  a.out[a.outLen++] = b;
+  a.newPos++;
+  return a.outLen < DELTA_OUT_BUF || flushOut(a);
+}
+
+// After a group or a zero-length op: more groups in this COPY, or the next op
+static void endGroup(DeltaApply& a){
+  a.state = a.remaining ? DS_GROUP_SKIP : DS_OP;
+}
+
+void deltaApplyBegin(DeltaApply& a, DeltaReadFn readOld, DeltaWriteFn writeNew, void* ctx){
+  memset(&a, 0, sizeof(a));
+  a.state = DS_HEADER;
+  a.readOld = readOld;
+  a.writeNew = writeNew;
+  a.ctx = ctx;
+  sha256Init(a.sha);
+}
+
+DeltaResult deltaApplyFeed(DeltaApply& a, const uint8_t* in, uint32_t len){
+  while(len) {
+    switch(a.state) {
+      case DS_HEADER: {
+        uint32_t take = DELTA_HEADER_LEN - a.hdrLen;
+        if(take > len) take = len;
+        memcpy(a.hdrBuf + a.hdrLen, in, take);
+        a.hdrLen += take; in += take; len -= take;
+        if(a.hdrLen < DELTA_HEADER_LEN) break;
+        if(!deltaHeaderDecode(a.hdrBuf, DELTA_HEADER_LEN, a.hdr)) return fail(a, "not a delta patch");
+        a.state = DS_OP;
+        break;
+      }
+      case DS_OP: {
+        uint8_t op = *in++; len--;
+        if(op == DELTA_OP_COPY) a.state = DS_COPY_DELTA;
+        else if(op == DELTA_OP_INSERT) a.state = DS_INSERT_LEN;
+        else if(op == DELTA_OP_END) {
+          if(a.newPos != a.hdr.newSize) return fail(a, "output size mismatch");
+          if(!flushOut(a)) return fail(a, "write failed");
+          uint8_t got[SHA256_LEN];
+          sha256Final(a.sha, got);
+          if(memcmp(got, a.hdr.newSha, SHA256_LEN) != 0) return fail(a, "output SHA-256 mismatch");
+          a.state = DS_DONE;
+          return DELTA_DONE;
+        } else return fail(a, "unknown op");
+        break;
+      }
+      case DS_INSERT_BYTES: {
+        uint32_t take = a.remaining < len ? a.remaining : len;
+        uint32_t room = DELTA_OUT_BUF - a.outLen;
+        if(take > room) take = room;
+        memcpy(a.out + a.outLen, in, take);
+        a.outLen += take; a.newPos += take; a.remaining -= take;
+        in += take; len -= take;
+        if(a.outLen == DELTA_OUT_BUF && !flushOut(a)) return fail(a, "write failed");
+        if(!a.remaining) a.state = DS_OP;
+        break;
+      }
+      case DS_GROUP_BYTES: {
+        if(!fillOld(a)) return fail(a, "read past old image");
+        if(!putByte(a, a.oldBuf[a.oldPos - a.oldBufStart] + *in)) return fail(a, "write failed");
+        a.oldPos++; in++; len--;
+        a.remaining--;
+        if(--a.groupN == 0) endGroup(a);
+        break;
+      }
+      case DS_DONE:
+        return DELTA_DONE;      // Trailing bytes (flash padding) are ignored
+      case DS_ERROR:
+        return DELTA_ERROR;
+      default: {
+        // Varint fields
+        uint8_t b = *in++; len--;
+        a.varAcc |= (uint32_t)(b & 0x7F) << a.varShift;
+        a.varShift += 7;
+        if(b & 0x80) {
+          if(a.varShift > 28) return fail(a, "bad varint");
+          break;
+        }
+        uint32_t v = a.varAcc;
+        a.varAcc = 0;
+        a.varShift = 0;
+        switch(a.state) {
+          case DS_COPY_DELTA:
+            a.oldPos += (int32_t)((v >> 1) ^ -(int32_t)(v & 1));
+            a.state = DS_COPY_LEN;
+            break;
+          case DS_COPY_LEN:
+            if(v > a.hdr.newSize - a.newPos) return fail(a, "copy past new size");
+            a.remaining = v;
+            endGroup(a);
+            break;
+          case DS_GROUP_SKIP:
+            if(v > a.remaining) return fail(a, "group past copy");
+            if(!copyOld(a, v)) return fail(a, "read past old image");
+            a.remaining -= v;
+            a.state = DS_GROUP_N;
+            break;
+          case DS_GROUP_N:
+            if(v > a.remaining) return fail(a, "group past copy");
+            a.groupN = v;
+            if(v) a.state = DS_GROUP_BYTES;
+            else  endGroup(a);
+            break;
+          case DS_INSERT_LEN:
+            if(v > a.hdr.newSize - a.newPos) return fail(a, "insert past new size");
+            a.remaining = v;
+            a.state = v ? DS_INSERT_BYTES : DS_OP;
+            break;
+        }
+        break;
+      }
+    }
+  }
+  return a.state == DS_ERROR ? DELTA_ERROR : a.state == DS_DONE ? DELTA_DONE : DELTA_MORE;
+}
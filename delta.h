@@ -0,0 +1,77 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+// ── Firmware Delta Patches ───────────────────────────────────────────────────
+// A patch rebuilds a new firmware image from the one a node already runs. Most
+// releases change one pattern or a threshold, so most of the new image is the
+// old one - either byte-for-byte or with a few bytes changed where addresses
+// moved. tools/mkdelta.cpp writes the patch; the node applies it streaming,
+// reading the old image from its running partition and writing the new one
+// to the inactive partition, with a fixed ~1KB of state.
+//
+// Patch = header, then ops, then DELTA_OP_END:
+//   header  "PLD1" patchSize4 oldSize4 newSize4 oldSha32 newSha32
+//   COPY    [1] oldDelta(zigzag varint, from the end of the last COPY) len(varint)
+//           then groups covering len: skip(varint) n(varint) n diff bytes -
+//           skip bytes copied unchanged, then n bytes of old + diff (mod 256)
+//   INSERT  [2] len(varint) len literal bytes
+//   END     [0] - output must be newSize bytes hashing to newSha
+//
+// Hardware-independent: the firmware (ota.cpp) and the host tool share this.
+
+#include <stdint.h>
+#include "sha256.h"
+
+static const uint8_t  DELTA_HEADER_LEN = 4 + 4 + 4 + 4 + SHA256_LEN + SHA256_LEN;
+static const uint16_t DELTA_OLD_CACHE  = 512;    // Old-image read window
+static const uint16_t DELTA_OUT_BUF    = 512;    // Output written in blocks this size
+
+enum DeltaOp : uint8_t { DELTA_OP_END = 0, DELTA_OP_COPY = 1, DELTA_OP_INSERT = 2 };
+
+struct DeltaHeader {
+  uint32_t patchSize;          // Whole patch, header included
+  uint32_t oldSize, newSize;
+  uint8_t  oldSha[SHA256_LEN];
+  uint8_t  newSha[SHA256_LEN];
+};
+
+int  deltaHeaderEncode(const DeltaHeader& h, uint8_t* out);
+bool deltaHeaderDecode(const uint8_t* in, int len, DeltaHeader& h);   // False without the magic
+
+// Read len bytes of the old image at offset / append len bytes to the new one
+typedef bool (*DeltaReadFn)(void* ctx, uint32_t offset, uint8_t* buf, uint32_t len);
+typedef bool (*DeltaWriteFn)(void* ctx, const uint8_t* buf, uint32_t len);
+
+enum DeltaResult : uint8_t {
+  DELTA_MORE = 0,     // Feed the next part of the patch
+  DELTA_DONE,         // Output complete and its SHA-256 matches
+  DELTA_ERROR,        // Malformed patch, IO failure or hash mismatch - see error
+};
+
+struct DeltaApply {
+  DeltaHeader  hdr;
+  uint8_t      hdrBuf[DELTA_HEADER_LEN];
+  uint8_t      hdrLen;
+  uint8_t      state;
+  uint32_t     varAcc;         // Varint being decoded
+  uint8_t      varShift;
+  uint32_t     oldPos;         // Old image cursor
+  uint32_t     newPos;         // Bytes of output produced
+  uint32_t     remaining;      // Left in the current COPY / INSERT
+  uint32_t     groupN;         // Diff bytes left in the current group
+  uint8_t      oldBuf[DELTA_OLD_CACHE];
+  uint32_t     oldBufStart, oldBufLen;
+  uint8_t      out[DELTA_OUT_BUF];
+  uint16_t     outLen;
+  Sha256       sha;
+  DeltaReadFn  readOld;
+  DeltaWriteFn writeNew;
+  void*        ctx;
+  const char*  error;
+};
+
+void        deltaApplyBegin(DeltaApply& a, DeltaReadFn readOld, DeltaWriteFn writeNew, void* ctx);
+// Feed the patch in order, any split - header included
+DeltaResult deltaApplyFeed(DeltaApply& a, const uint8_t* in, uint32_t len);
+
+#endif
@@ -25,6 +25,9 @@ OTA_PORT=3232
 VERSION_FILE="version.txt"
 MAX_RETRIES=3
 ESPOTA_PATH="/Users/johncohn/Library/Arduino15/packages/esp32/hardware/esp32/3.2.1/tools/espota.py"
+ARCHIVE_DIR="./builds"          # Every compiled image, as v<version>.bin - the bases for delta patches
+MKDELTA="./tools/mkdelta"
+DELTA=${DELTA:-0}               # DELTA=1 ./deploy_nodes.sh - send patches against each node's build
 
 # Arrays for tracking nodes
 declare -a NODES=()
@@ -107,6 +110,8 @@ compile_project() {
         
         if arduino-cli compile --fqbn $FQBN --build-path "$BUILD_DIR" .; then
             echo "Compilation successful with new version!"
+            mkdir -p "$ARCHIVE_DIR"
+            cp "$BUILD_DIR/playalights_claude_v58.ino.bin" "$ARCHIVE_DIR/v$(cat "$VERSION_FILE").bin"
             return 0
         else
             echo "Compilation failed!"
@@ -118,6 +123,35 @@ compile_project() {
     fi
 }
 
+# Firmware version a node advertises over mDNS (TXT "fw"), empty if unknown.
+# Needs avahi-browse; without it every upload is a full image.
+node_fw_version() {
+    local ip=$1
+    command -v avahi-browse >/dev/null 2>&1 || return 0
+    avahi-browse -rpt _arduino._tcp 2>/dev/null | grep "^=" | grep ";$ip;" | grep -o '"fw=[^"]*"' | head -1 | sed 's/"fw=\(.*\)"/\1/'
+}
+
+# Patch from the node's build to the new one, if that's worth sending.
+# Prints the patch path, nothing to send the full image.
+make_delta_for_node() {
+    local ip=$1
+    local binary_file=$2
+    local node_version=$(node_fw_version "$ip")
+    local base="$ARCHIVE_DIR/v$node_version.bin"
+    [ -n "$node_version" ] && [ -f "$base" ] || return 0
+    if [ ! -x "$MKDELTA" ]; then
+        g++ -std=c++17 -O2 -I. -o "$MKDELTA" tools/mkdelta.cpp delta.cpp sha256.cpp || return 0
+    fi
+    local patch="$BUILD_DIR/delta-from-v$node_version.pld"
+    if [ ! -f "$patch" ] || [ "$patch" -ot "$binary_file" ]; then
+        "$MKDELTA" "$base" "$binary_file" "$patch" >&2 || return 0
+    fi
+    # Under half the image or it isn't worth the rebuild on the node
+    local patch_size=$(wc -c < "$patch")
+    local image_size=$(wc -c < "$binary_file")
+    [ $((patch_size * 2)) -lt $image_size ] && echo "$patch"
+}
+
 # Function to upload to a single node with retry logic
 upload_to_node() {
     local ip=$1
@@ -146,10 +180,23 @@ upload_to_node() {
         return 1
     fi
     
+    # With DELTA=1, send a patch against the node's build when there is a good one.
+    # It goes up as a filesystem image (-s); the node rebuilds the firmware from it.
+    local upload_file="$binary_file"
+    local upload_kind=""
+    if [ "$DELTA" = "1" ]; then
+        local patch=$(make_delta_for_node "$ip" "$binary_file")
+        if [ -n "$patch" ]; then
+            upload_file="$patch"
+            upload_kind="-s"
+            echo "   Node $node_num (Attempt $attempt): sending delta $(basename "$patch") ($(wc -c < "$patch") bytes)"
+        fi
+    fi
+    
     # Use espota.py for OTA upload
     local upload_output
     local exit_code
-    upload_output=$(python3 "$ESPOTA_PATH" -i "$ip" -p "$OTA_PORT" -a "$PASSWORD" -f "$binary_file" -r -d -t 60 2>&1)
+    upload_output=$(python3 "$ESPOTA_PATH" -i "$ip" -p "$OTA_PORT" -a "$PASSWORD" $upload_kind -f "$upload_file" -r -d -t 60 2>&1)
     exit_code=$?
     
     # Show output with node prefix
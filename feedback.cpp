@@ -0,0 +1,124 @@
+#include "feedback.h"
+#include <string.h>
+
+void reportFromStats(RxReport& rep, const FrameAssembler& fa, int8_t rssi){
+  const RxStats& st = fa.stats;
+  rep.framesComplete = st.framesComplete;
+  rep.framesLost     = st.framesLost;
+  rep.chunksExpected = st.chunksExpected;
+  rep.chunksLost     = st.chunksLost;
+  rep.fecRecovered   = st.fecRecovered;
+  rep.latencyUs      = asmLatencyUs(fa);
+  rep.rssi           = rssi;
+  rep.hops           = fa.hops;
+}
+
+int reportEncode(const RxReport& rep, uint8_t* out){
+  memcpy(out + 0,  &rep.framesComplete, 2);
+  memcpy(out + 2,  &rep.framesLost, 2);
+  memcpy(out + 4,  &rep.chunksExpected, 2);
+  memcpy(out + 6,  &rep.chunksLost, 2);
+  memcpy(out + 8,  &rep.fecRecovered, 2);
+  memcpy(out + 10, &rep.latencyUs, 2);
+  out[12] = (uint8_t)rep.rssi;
+  out[13] = rep.hops;
+  return RX_REPORT_LEN;
+}
+
+bool reportDecode(const uint8_t* in, int len, RxReport& rep){
+  if(len < RX_REPORT_LEN) return false;
+  memcpy(&rep.framesComplete, in + 0,  2);
+  memcpy(&rep.framesLost,     in + 2,  2);
+  memcpy(&rep.chunksExpected, in + 4,  2);
+  memcpy(&rep.chunksLost,     in + 6,  2);
+  memcpy(&rep.fecRecovered,   in + 8,  2);
+  memcpy(&rep.latencyUs,      in + 10, 2);
+  rep.rssi = (int8_t)in[12];
+  rep.hops = in[13];
+  return true;
+}
+
+uint32_t reportSlotOffsetMs(uint32_t token){
+  // Tokens are MAC-derived, so the low bits are already well spread
+  return (token % FEEDBACK_REPORT_SLOTS) * (FEEDBACK_REPORT_MS / FEEDBACK_REPORT_SLOTS);
+}
+
+void linkAdaptReset(LinkAdapt& la){
+  memset(&la, 0, sizeof(la));
+}
+
+void linkAdaptNote(LinkAdapt& la, uint32_t token, const RxReport& rep, uint32_t nowMs){
+  // Same node, else a free slot, else the stalest entry
+  int slot = -1, freeSlot = -1, stalest = 0;
+  for(int i = 0; i < FEEDBACK_MAX_NODES && slot < 0; i++){
+    if(la.nodes[i].token == token) slot = i;
+    else if(la.nodes[i].token == 0) { if(freeSlot < 0) freeSlot = i; }
+    else if(nowMs - la.nodes[i].lastMs > nowMs - la.nodes[stalest].lastMs) stalest = i;
+  }
+  if(slot < 0) slot = (freeSlot >= 0) ? freeSlot : stalest;
+  la.nodes[slot].token = token;
+  la.nodes[slot].lastMs = nowMs;
+  la.nodes[slot].report = rep;
+}
+
+static uint16_t permille(uint32_t part, uint32_t whole){
+  return whole ? (uint16_t)(part * 1000 / whole) : 0;
+}
+
+bool linkAdaptUpdate(LinkAdapt& la, uint32_t nowMs){
+  uint16_t worstFrame = 0, worstChunk = 0, worstLatency = 0;
+  uint8_t reporting = 0;
+  for(int i = 0; i < FEEDBACK_MAX_NODES; i++){
+    const LinkEntry& e = la.nodes[i];
+    if(!e.token || nowMs - e.lastMs > FEEDBACK_STALE_MS) continue;
+    const RxReport& r = e.report;
+    uint16_t fl = permille(r.framesLost, (uint32_t)r.framesLost + r.framesComplete);
+    uint16_t cl = permille(r.chunksLost, r.chunksExpected);
+    if(fl > worstFrame)          worstFrame = fl;
+    if(cl > worstChunk)          worstChunk = cl;
+    if(r.latencyUs > worstLatency) worstLatency = r.latencyUs;
+    reporting++;
+  }
+  la.worstFramePermille = worstFrame;
+  la.worstChunkPermille = worstChunk;
+  la.worstLatencyUs = worstLatency;
+  la.reporting = reporting;
+
+  uint8_t before = la.level;
+  if(!reporting) {
+    // Nobody listening (or only v1 nodes) - nothing to adapt to
+    la.cleanWindows = 0;
+  } else if(worstFrame > FEEDBACK_DOWN_PERMILLE) {
+    if(la.level + 1 < LINK_LEVEL_COUNT) la.level++;
+    la.cleanWindows = 0;
+  } else if(worstFrame <= FEEDBACK_UP_FRAME_PERMILLE && worstChunk <= FEEDBACK_UP_CHUNK_PERMILLE) {
+    if(++la.cleanWindows >= FEEDBACK_UP_WINDOWS) {
+      if(la.level > 0) la.level--;
+      la.cleanWindows = 0;
+    }
+  } else {
+    la.cleanWindows = 0;
+  }
+  return la.level != before;
+}
+
+uint32_t linkFrameAirtimeUs(const LinkLevel& lvl, uint16_t numLeds, uint16_t rateKbps){
+  uint16_t chunks = linkChunks(lvl, numLeds);
+  uint16_t bytes = lvl.ledsPerChunk * protoPixelBytes(lvl.flags);
+  uint32_t us = 0;
+  for(uint16_t c = 0; c < chunks; c++) {
+    uint16_t cnt = (c + 1 < chunks) ? lvl.ledsPerChunk : numLeds - c * lvl.ledsPerChunk;
+    us += protoAirtimeUs(PROTO_HEADER_LEN + cnt * protoPixelBytes(lvl.flags), rateKbps);
+  }
+  if(lvl.flags & PROTO_FLAG_FEC) us += protoAirtimeUs(PROTO_HEADER_LEN + bytes, rateKbps);
+  return us;
+}
+
+uint8_t linkPickRate(const uint16_t* rateKbps, uint8_t n, uint16_t numLeds){
+  const LinkLevel& top = LINK_LEVELS[0];
+  uint32_t budgetUs = 1000UL * LINK_AIR_BUDGET_PERMILLE / top.fps;
+  for(uint8_t i = 0; i < n; i++) {
+    if(linkFrameAirtimeUs(top, numLeds, rateKbps[i]) <= budgetUs) return i;
+  }
+  return n - 1;
+}
@@ -0,0 +1,115 @@
+#ifndef FEEDBACK_H
+#define FEEDBACK_H
+
+// ── Receive Reports & Link Adaptation ────────────────────────────────────────
+// Followers send a compact PKT_REPORT once per FEEDBACK_REPORT_MS, each in its
+// own token-derived slot so reports don't collide with each other. The leader
+// keeps the latest report per follower and, once per FEEDBACK_ADAPT_MS, moves
+// one step along LINK_LEVELS to suit the WORST fresh link: down quickly when
+// frames are being lost, back up slowly once every link has been clean for a
+// while. Lower levels trade frame rate on the air and colour depth for
+// complete frames - a clean 15fps, blended back up to the display rate by
+// every node's playout, beats torn frames on half the fleet. The leader always
+// renders at LEADER_RENDER_FPS (pattern speed doesn't depend on the level) and
+// sends the newest frame at the level's rate. Hardware-independent.
+
+#include <stdint.h>
+#include "assembler.h"
+
+static const uint32_t FEEDBACK_REPORT_MS     = 1000;  // Report period per follower
+static const uint8_t  FEEDBACK_REPORT_SLOTS  = 20;    // 50ms slots within the period
+static const uint32_t FEEDBACK_ADAPT_MS      = 2000;  // Leader re-evaluates this often
+static const uint32_t FEEDBACK_STALE_MS      = 3500;  // Ignore reports older than this
+static const uint8_t  FEEDBACK_MAX_NODES     = 32;
+static const uint16_t FEEDBACK_DOWN_PERMILLE = 50;    // Frame loss that forces a step down
+static const uint16_t FEEDBACK_UP_FRAME_PERMILLE = 10;  // Frame loss and chunk loss low enough
+static const uint16_t FEEDBACK_UP_CHUNK_PERMILLE = 20;  // ...to consider stepping up
+static const uint8_t  FEEDBACK_UP_WINDOWS    = 3;     // Clean windows in a row before stepping up
+
+// One step of the adaptation ladder
+struct LinkLevel {
+  uint8_t fps;            // Frames on the air per second
+  uint8_t flags;          // PROTO_FLAG_FEC / PROTO_FLAG_RGB565
+  uint8_t ledsPerChunk;
+};
+static constexpr LinkLevel LINK_LEVELS[] = {
+  { 25, 0,                                   75 },   // Raw - the playout blends it up to the display rate
+  { 25, PROTO_FLAG_FEC,                      75 },   // +1 parity chunk per frame
+  { 20, PROTO_FLAG_FEC,                      60 },
+  { 15, PROTO_FLAG_FEC,                      50 },   // Shorter packets survive busy air better
+  { 15, PROTO_FLAG_FEC | PROTO_FLAG_RGB565,  60 },   // 2 bytes/LED - fewer, shorter packets
+  { 12, PROTO_FLAG_FEC | PROTO_FLAG_RGB565,  40 },
+};
+static const uint8_t LINK_LEVEL_COUNT = sizeof(LINK_LEVELS) / sizeof(LINK_LEVELS[0]);
+
+// Data chunks per frame for numLeds pixels at a level (parity chunk not included)
+constexpr uint16_t linkChunks(const LinkLevel& lvl, uint16_t numLeds){
+  return (numLeds + lvl.ledsPerChunk - 1) / lvl.ledsPerChunk;
+}
+
+// Most data chunks any level splits numLeds pixels into - must fit ASM_MAX_CHUNKS
+constexpr uint16_t linkMaxChunks(uint16_t numLeds){
+  uint16_t most = 0;
+  for(uint8_t i = 0; i < LINK_LEVEL_COUNT; i++) {
+    if(linkChunks(LINK_LEVELS[i], numLeds) > most) most = linkChunks(LINK_LEVELS[i], numLeds);
+  }
+  return most;
+}
+
+// ── Airtime ──────────────────────────────────────────────────────────────────
+// A longer strip means more chunks per frame. At 1Mbps a 75-LED chunk is on
+// the air for 2.6ms, so 334 LEDs take 13ms of every 40ms frame and 1000 LEDs
+// wouldn't fit at all. The radio runs at the slowest rate (the longest range)
+// that keeps the top level's frames within LINK_AIR_BUDGET_PERMILLE of its
+// interval on the air, leaving the rest for audio, reports, telemetry and retries.
+static const uint16_t LINK_AIR_BUDGET_PERMILLE = 700;
+
+// Radio time of one frame at a level - every data chunk plus the parity chunk
+uint32_t linkFrameAirtimeUs(const LinkLevel& lvl, uint16_t numLeds, uint16_t rateKbps);
+
+// Index of the first of n rates (slowest first) that fits the budget for
+// numLeds pixels, or the last one when none does
+uint8_t  linkPickRate(const uint16_t* rateKbps, uint8_t n, uint16_t numLeds);
+
+// Follower -> leader report payload
+struct RxReport {
+  uint16_t framesComplete;
+  uint16_t framesLost;
+  uint16_t chunksExpected;
+  uint16_t chunksLost;
+  uint16_t fecRecovered;
+  uint16_t latencyUs;     // asmLatencyUs()
+  int8_t   rssi;          // Mean of the window, dBm
+  uint8_t  hops;          // Relay depth of the last frame
+};
+static const uint8_t RX_REPORT_LEN = 14;
+
+void reportFromStats(RxReport& rep, const FrameAssembler& fa, int8_t rssi);
+int  reportEncode(const RxReport& rep, uint8_t* out);
+bool reportDecode(const uint8_t* in, int len, RxReport& rep);
+
+// Delay of this node's report slot within FEEDBACK_REPORT_MS
+uint32_t reportSlotOffsetMs(uint32_t token);
+
+// Leader side
+struct LinkEntry {
+  uint32_t token;
+  uint32_t lastMs;
+  RxReport report;
+};
+struct LinkAdapt {
+  LinkEntry nodes[FEEDBACK_MAX_NODES];
+  uint8_t   level;
+  uint8_t   cleanWindows;
+  // Worst link at the last evaluation, for debug output
+  uint16_t  worstFramePermille, worstChunkPermille, worstLatencyUs;
+  uint8_t   reporting;
+};
+
+void linkAdaptReset(LinkAdapt& la);
+void linkAdaptNote(LinkAdapt& la, uint32_t token, const RxReport& rep, uint32_t nowMs);
+
+// Evaluate the fresh reports - returns true when the level changed
+bool linkAdaptUpdate(LinkAdapt& la, uint32_t nowMs);
+
+#endif
@@ -0,0 +1,99 @@
+#include "fft.h"
+#include <math.h>
+#include <string.h>
+
+// Largest value that can go through a butterfly without overflowing int16:
+// one stage grows a component by at most 1 + sqrt(2)
+static const int16_t FFT_STAGE_LIMIT = 13000;
+
+void fftInit(RealFft& f, uint16_t n){
+  if(n > FFT_MAX_N) n = FFT_MAX_N;
+  f.n = n;
+  f.log2Half = 0;
+  while((1u << (f.log2Half + 1)) < n) f.log2Half++;
+  for(int k = 0; k < n / 2; k++){
+    double th = 2.0 * M_PI * k / n;
+    f.cosT[k] = (int16_t)lround(cos(th) * 32767.0);
+    f.sinT[k] = (int16_t)lround(sin(th) * 32767.0);
+  }
+}
+
+static int16_t maxAbs(const int16_t* a, const int16_t* b, int len){
+  int16_t m = 0;
+  for(int i = 0; i < len; i++){
+    int16_t x = a[i] < 0 ? -a[i] : a[i];
+    int16_t y = b[i] < 0 ? -b[i] : b[i];
+    if(x > m) m = x;
+    if(y > m) m = y;
+  }
+  return m;
+}
+
+static void shiftDown(int16_t* a, int16_t* b, int len){
+  for(int i = 0; i < len; i++){ a[i] >>= 1; b[i] >>= 1; }
+}
+
+int fftRealPower(RealFft& f, const int16_t* in, uint32_t* power){
+  const int m = f.n / 2;
+  int exp = 0;
+
+  // Pack even/odd samples as re/im, bit-reversed, normalised up to just under
+  // the stage limit so quiet input keeps its resolution
+  int16_t peak = 1;
+  for(int i = 0; i < f.n; i++){
+    int16_t v = in[i] < 0 ? (in[i] == -32768 ? 32767 : -in[i]) : in[i];
+    if(v > peak) peak = v;
+  }
+  int up = 0;
+  while((peak << (up + 1)) <= FFT_STAGE_LIMIT) up++;
+  int down = (peak > FFT_STAGE_LIMIT) ? 1 + (peak > 2 * FFT_STAGE_LIMIT) : 0;
+  for(int i = 0; i < m; i++){
+    uint32_t r = 0;
+    for(int b = 0; b < f.log2Half; b++) if(i & (1 << b)) r |= 1u << (f.log2Half - 1 - b);
+    f.re[r] = (int16_t)(((int32_t)in[2*i]     << up) >> down);
+    f.im[r] = (int16_t)(((int32_t)in[2*i + 1] << up) >> down);
+  }
+  exp = down - up;
+
+  // Radix-2 DIT stages, twiddle W_m^j = W_n^(2j)
+  for(int len = 2, step = f.n / 2; len <= m; len <<= 1, step >>= 1){
+    if(maxAbs(f.re, f.im, m) > FFT_STAGE_LIMIT) { shiftDown(f.re, f.im, m); exp++; }
+    int half = len / 2;
+    for(int s = 0; s < m; s += len){
+      for(int j = 0; j < half; j++){
+        int16_t c = f.cosT[j * step], sn = f.sinT[j * step];
+        int a = s + j, b = a + half;
+        // t = x[b] * (cos - j sin)
+        int16_t tr = (int16_t)(((int32_t)f.re[b] * c + (int32_t)f.im[b] * sn + (1 << 14)) >> 15);
+        int16_t ti = (int16_t)(((int32_t)f.im[b] * c - (int32_t)f.re[b] * sn + (1 << 14)) >> 15);
+        f.re[b] = f.re[a] - tr;  f.im[b] = f.im[a] - ti;
+        f.re[a] = f.re[a] + tr;  f.im[a] = f.im[a] + ti;
+      }
+    }
+  }
+
+  // The split step grows values like one more stage
+  if(maxAbs(f.re, f.im, m) > FFT_STAGE_LIMIT) { shiftDown(f.re, f.im, m); exp++; }
+
+  // Split the half-length complex spectrum Z into the real spectrum X:
+  //   X[k] = (Z[k] + conj Z[m-k]) / 2 + W_n^k (Z[k] - conj Z[m-k]) / 2j
+  for(int k = 0; k < m; k++){
+    int km = (k == 0) ? 0 : m - k;
+    int32_t a = f.re[k], b = f.im[k], c = f.re[km], d = f.im[km];
+    int32_t er = (a + c) >> 1, ei = (b - d) >> 1;     // Even part
+    int32_t orr = (b + d) >> 1, oi = (c - a) >> 1;    // Odd part
+    int32_t xr = er + ((orr * f.cosT[k] + oi * f.sinT[k]) >> 15);
+    int32_t xi = ei + ((oi * f.cosT[k] - orr * f.sinT[k]) >> 15);
+    power[k] = (uint32_t)(xr * xr) + (uint32_t)(xi * xi);
+  }
+  return exp;
+}
+
+uint16_t fftLog2Q8(uint32_t x){
+  if(x <= 1) return 0;
+  uint8_t ip = 31 - __builtin_clz(x);
+  // Mantissa 1.f, log2(1 + f) ~= f + 0.34 f (1 - f) (max error ~0.005)
+  uint32_t fr = (ip >= 8) ? (x >> (ip - 8)) & 0xFF : (x << (8 - ip)) & 0xFF;
+  uint32_t corr = (fr * (256 - fr) * 87) >> 16;
+  return (uint16_t)((ip << 8) + fr + corr);
+}
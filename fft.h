@@ -0,0 +1,33 @@
+#ifndef FFT_H
+#define FFT_H
+
+// ── Fixed-point Real FFT ─────────────────────────────────────────────────────
+// N-point real FFT done as an N/2-point complex radix-2 FFT plus a split step,
+// all in int16 with Q15 twiddles and block floating point: the input is
+// normalised up to use the full 16 bits, and a stage only shifts down when it
+// could overflow. Quiet microphone input keeps its precision, loud input never
+// wraps. Tables are built once by fftInit(). Hardware-independent.
+
+#include <stdint.h>
+
+static const uint16_t FFT_MAX_N = 512;
+
+struct RealFft {
+  uint16_t n;                       // Real input length (power of two, <= FFT_MAX_N)
+  uint8_t  log2Half;                // log2(n/2)
+  int16_t  cosT[FFT_MAX_N / 2];     // cos/sin(2*pi*k/n), Q15
+  int16_t  sinT[FFT_MAX_N / 2];
+  int16_t  re[FFT_MAX_N / 2];       // Complex work buffers
+  int16_t  im[FFT_MAX_N / 2];
+};
+
+void fftInit(RealFft& f, uint16_t n);
+
+// Transform n real samples (unchanged) into n/2 bins of squared magnitude, DC
+// to just below Nyquist. Returns the block exponent e: true power = power[k] * 4^e.
+int fftRealPower(RealFft& f, const int16_t* in, uint32_t* power);
+
+// log2(x) in Q8.8 (0 for x <= 1) - cheap enough to run on every bin
+uint16_t fftLog2Q8(uint32_t x);
+
+#endif
@@ -0,0 +1,340 @@
+#include "meshota.h"
+#include <string.h>
+
+static const uint32_t OTA_COMMIT_GAP_MS = 100;   // Between COMMIT repeats
+
+static inline bool bitGet(const uint8_t* map, uint16_t i){ return map[i >> 3] & (1 << (i & 7)); }
+static inline void bitSet(uint8_t* map, uint16_t i){ map[i >> 3] |= (1 << (i & 7)); }
+static inline void bitClear(uint8_t* map, uint16_t i){ map[i >> 3] &= ~(1 << (i & 7)); }
+
+// ── Payloads ──
+
+int otaOfferEncode(const OtaOffer& o, uint8_t* out){
+  memcpy(out + 0,  &o.session, 4);
+  memcpy(out + 4,  &o.imageSize, 4);
+  memcpy(out + 8,  &o.chunkCount, 2);
+  out[10] = o.chunkSize;
+  memcpy(out + 11, o.version, OTA_VERSION_LEN);
+  memcpy(out + 11 + OTA_VERSION_LEN, o.sha, SHA256_LEN);
+  out[OTA_OFFER_V1_LEN] = o.format;
+  memcpy(out + OTA_OFFER_V1_LEN + 1, o.baseSha, SHA256_LEN);
+  return OTA_OFFER_LEN;
+}
+
+bool otaOfferDecode(const uint8_t* in, int len, OtaOffer& o){
+  if(len < OTA_OFFER_V1_LEN) return false;
+  memset(&o, 0, sizeof(o));
+  memcpy(&o.session,    in + 0, 4);
+  memcpy(&o.imageSize,  in + 4, 4);
+  memcpy(&o.chunkCount, in + 8, 2);
+  o.chunkSize = in[10];
+  memcpy(o.version, in + 11, OTA_VERSION_LEN);
+  o.version[OTA_VERSION_LEN - 1] = 0;
+  memcpy(o.sha, in + 11 + OTA_VERSION_LEN, SHA256_LEN);
+  if(len >= OTA_OFFER_LEN) {
+    o.format = in[OTA_OFFER_V1_LEN];
+    memcpy(o.baseSha, in + OTA_OFFER_V1_LEN + 1, SHA256_LEN);
+  }
+  return o.format <= OTA_FORMAT_DELTA;
+}
+
+int otaStatusEncode(const OtaStatus& s, uint8_t* out){
+  memcpy(out + 0, &s.session, 4);
+  out[4] = s.state;
+  memcpy(out + 5, &s.held, 2);
+  memcpy(out + 7, &s.windowBase, 2);
+  memcpy(out + 9, s.missing, OTA_NACK_BYTES);
+  return OTA_STATUS_LEN;
+}
+
+bool otaStatusDecode(const uint8_t* in, int len, OtaStatus& s){
+  if(len < OTA_STATUS_LEN) return false;
+  memcpy(&s.session, in + 0, 4);
+  s.state = in[4];
+  memcpy(&s.held, in + 5, 2);
+  memcpy(&s.windowBase, in + 7, 2);
+  memcpy(s.missing, in + 9, OTA_NACK_BYTES);
+  return true;
+}
+
+void otaOfferInit(OtaOffer& o, uint32_t session, uint32_t imageSize, const char* version,
+                  const uint8_t sha[SHA256_LEN], const uint8_t* baseSha){
+  memset(&o, 0, sizeof(o));
+  o.session = session;
+  o.imageSize = imageSize;
+  o.chunkSize = OTA_CHUNK_BYTES;
+  o.chunkCount = (imageSize + OTA_CHUNK_BYTES - 1) / OTA_CHUNK_BYTES;
+  strncpy(o.version, version, OTA_VERSION_LEN - 1);
+  memcpy(o.sha, sha, SHA256_LEN);
+  if(baseSha) {
+    o.format = OTA_FORMAT_DELTA;
+    memcpy(o.baseSha, baseSha, SHA256_LEN);
+  }
+}
+
+uint32_t otaChunkOffset(const OtaOffer& o, uint16_t idx){
+  return (uint32_t)idx * o.chunkSize;
+}
+
+uint16_t otaChunkLen(const OtaOffer& o, uint16_t idx){
+  uint32_t off = otaChunkOffset(o, idx);
+  if(idx >= o.chunkCount || off >= o.imageSize) return 0;
+  uint32_t left = o.imageSize - off;
+  return left < o.chunkSize ? left : o.chunkSize;
+}
+
+// ── Receiver ──
+
+void otaRxInit(OtaReceiver& r, uint32_t token){
+  memset(&r, 0, sizeof(r));
+  r.token = token;
+}
+
+bool otaRxActive(const OtaReceiver& r){
+  return r.state != OTA_RX_IDLE;
+}
+
+static void rxBeginPass(OtaReceiver& r, uint32_t nowMs){
+  memset(r.held, 0, sizeof(r.held));
+  r.heldCount = 0;
+  r.attempts++;
+  r.state = OTA_RX_RECEIVING;
+  r.lastHeardMs = nowMs;
+}
+
+OtaOfferAction otaRxOffer(OtaReceiver& r, const OtaOffer& o, uint32_t maxImage,
+                          const char* runningVersion, uint32_t nowMs,
+                          const uint8_t* runningSha){
+  if(r.state != OTA_RX_IDLE && o.session == r.offer.session) {
+    r.lastHeardMs = nowMs;
+    return OTA_OFFER_IGNORE;
+  }
+
+  // New session (a restarted seed replaces the old one)
+  r.offer = o;
+  r.attempts = 0;
+  r.lastHeardMs = nowMs;
+  r.nextStatusMs = nowMs + (r.token % OTA_STATUS_SLOTS) * (OTA_STATUS_MS / OTA_STATUS_SLOTS);
+
+  if(strncmp(o.version, runningVersion, OTA_VERSION_LEN) == 0) {
+    r.state = OTA_RX_CURRENT;
+    return OTA_OFFER_CURRENT;
+  }
+  if(o.format == OTA_FORMAT_DELTA && (!runningSha || memcmp(o.baseSha, runningSha, SHA256_LEN) != 0)) {
+    r.state = OTA_RX_NEED_FULL;
+    return OTA_OFFER_IGNORE;
+  }
+  bool layoutOk = o.chunkSize && o.chunkCount <= OTA_MAX_CHUNKS
+               && o.chunkCount == (o.imageSize + o.chunkSize - 1) / o.chunkSize;
+  if(!layoutOk || o.imageSize > maxImage) {
+    r.state = OTA_RX_FAILED;
+    return OTA_OFFER_IGNORE;
+  }
+  rxBeginPass(r, nowMs);
+  return OTA_OFFER_START;
+}
+
+bool otaRxChunk(OtaReceiver& r, uint32_t session, uint16_t idx, uint16_t len, uint32_t nowMs){
+  if(r.state == OTA_RX_IDLE || session != r.offer.session) return false;
+  r.lastHeardMs = nowMs;
+  if(r.state != OTA_RX_RECEIVING || len != otaChunkLen(r.offer, idx) || bitGet(r.held, idx)) return false;
+  bitSet(r.held, idx);
+  r.heldCount++;
+  return true;
+}
+
+void otaRxChunkBad(OtaReceiver& r, uint16_t idx){
+  if(r.state != OTA_RX_RECEIVING || idx >= r.offer.chunkCount || !bitGet(r.held, idx)) return;
+  bitClear(r.held, idx);
+  r.heldCount--;
+}
+
+bool otaRxComplete(const OtaReceiver& r){
+  return r.state == OTA_RX_RECEIVING && r.heldCount == r.offer.chunkCount;
+}
+
+bool otaRxVerify(OtaReceiver& r, const uint8_t sha[SHA256_LEN], uint32_t nowMs){
+  if(memcmp(sha, r.offer.sha, SHA256_LEN) == 0) {
+    r.state = OTA_RX_VERIFIED;
+    r.verifiedMs = nowMs;
+    return true;
+  }
+  // A bad flash write, most likely - one clean pass, then give up
+  if(r.attempts < 2) rxBeginPass(r, nowMs);
+  else               r.state = OTA_RX_FAILED;
+  return false;
+}
+
+bool otaRxStatusDue(OtaReceiver& r, OtaStatus& st, uint32_t nowMs){
+  if(r.state == OTA_RX_IDLE || (int32_t)(nowMs - r.nextStatusMs) < 0) return false;
+  r.nextStatusMs += OTA_STATUS_MS;
+  if((int32_t)(nowMs - r.nextStatusMs) >= 0) r.nextStatusMs = nowMs + OTA_STATUS_MS;  // Fell behind
+  otaRxStatusFill(r, st);
+  return true;
+}
+
+void otaRxStatusFill(const OtaReceiver& r, OtaStatus& st){
+  memset(&st, 0, sizeof(st));
+  st.session = r.offer.session;
+  st.state = r.state;
+  st.held = r.heldCount;
+  if(r.state == OTA_RX_RECEIVING) {
+    uint16_t base = 0;
+    while(base < r.offer.chunkCount && bitGet(r.held, base)) base++;
+    st.windowBase = base;
+    for(uint16_t i = 0; i < OTA_NACK_BYTES * 8 && base + i < r.offer.chunkCount; i++)
+      if(!bitGet(r.held, base + i)) bitSet(st.missing, i);
+  }
+}
+
+bool otaRxCommit(OtaReceiver& r, uint32_t session, uint32_t nowMs){
+  if(r.state == OTA_RX_IDLE || session != r.offer.session) return false;
+  r.lastHeardMs = nowMs;
+  return r.state == OTA_RX_VERIFIED;
+}
+
+bool otaRxShouldSelfCommit(const OtaReceiver& r, uint32_t nowMs){
+  return r.state == OTA_RX_VERIFIED && nowMs - r.lastHeardMs > OTA_SELF_COMMIT_MS;
+}
+
+bool otaRxTimedOut(const OtaReceiver& r, uint32_t nowMs){
+  return r.state != OTA_RX_IDLE && r.state != OTA_RX_VERIFIED && nowMs - r.lastHeardMs > OTA_RX_IDLE_MS;
+}
+
+void otaRxAbort(OtaReceiver& r){
+  r.state = OTA_RX_IDLE;
+  r.heldCount = 0;
+}
+
+// ── Seed ──
+
+void otaTxStart(OtaSender& s, const OtaOffer& offer, uint32_t nowMs){
+  memset(&s, 0, sizeof(s));
+  s.offer = offer;
+  s.startMs = nowMs;
+  s.active = true;
+}
+
+static bool peerDone(uint8_t state){
+  return state == OTA_RX_VERIFIED || state == OTA_RX_CURRENT || state == OTA_RX_FAILED || state == OTA_RX_NEED_FULL;
+}
+
+void otaTxPeerCounts(const OtaSender& s, uint32_t nowMs, uint8_t* fresh, uint8_t* done, uint8_t* failed,
+                     uint8_t* needFull){
+  uint8_t f = 0, d = 0, x = 0, nf = 0;
+  for(int i = 0; i < OTA_MAX_RECEIVERS; i++) {
+    const OtaPeer& p = s.peers[i];
+    bool finishing = p.state == OTA_RX_RECEIVING && p.held == s.offer.chunkCount;
+    if(!p.token || nowMs - p.lastMs > (finishing ? OTA_FINISH_STALE_MS : OTA_RECEIVER_STALE_MS)) continue;
+    f++;
+    if(p.state == OTA_RX_FAILED || p.state == OTA_RX_NEED_FULL) x++;
+    else if(peerDone(p.state)) d++;
+    if(p.state == OTA_RX_NEED_FULL) nf++;
+  }
+  if(fresh)    *fresh = f;
+  if(done)     *done = d;
+  if(failed)   *failed = x;
+  if(needFull) *needFull = nf;
+}
+
+void otaTxNoteStatus(OtaSender& s, uint32_t token, const OtaStatus& st, uint32_t nowMs){
+  if(!s.active || st.session != s.offer.session) return;
+  s.statusHeard++;
+
+  // Same node, else a free slot, else the stalest entry
+  int slot = -1, freeSlot = -1, stalest = 0;
+  for(int i = 0; i < OTA_MAX_RECEIVERS && slot < 0; i++) {
+    if(s.peers[i].token == token) slot = i;
+    else if(s.peers[i].token == 0) { if(freeSlot < 0) freeSlot = i; }
+    else if(nowMs - s.peers[i].lastMs > nowMs - s.peers[stalest].lastMs) stalest = i;
+  }
+  if(slot < 0) slot = (freeSlot >= 0) ? freeSlot : stalest;
+  OtaPeer& p = s.peers[slot];
+  p.token = token;
+  p.lastMs = nowMs;
+  p.state = st.state;
+  p.held = st.held;
+
+  if(st.state != OTA_RX_RECEIVING) return;
+  // Chunks past the pass position are still on their way - only queue real gaps
+  for(uint16_t i = 0; i < OTA_NACK_BYTES * 8; i++) {
+    uint32_t idx = (uint32_t)st.windowBase + i;
+    if(idx >= s.offer.chunkCount || idx >= s.nextChunk) break;
+    if(!bitGet(st.missing, i) || bitGet(s.need, idx)) continue;
+    if(bitGet(s.recent[0], idx) || bitGet(s.recent[1], idx)) { s.repairsSuppressed++; continue; }
+    bitSet(s.need, idx);
+  }
+}
+
+static int firstNeeded(const OtaSender& s){
+  int bytes = (s.offer.chunkCount + 7) / 8;
+  for(int b = 0; b < bytes; b++) {
+    if(!s.need[b]) continue;
+    for(int i = 0; i < 8; i++) if(s.need[b] & (1 << i)) return b * 8 + i;
+  }
+  return -1;
+}
+
+OtaTxKind otaTxNext(OtaSender& s, uint32_t nowMs, uint16_t* chunk){
+  if(!s.active) return OTA_TX_NONE;
+
+  if(s.commitsSent) {
+    // Keep repeating while anyone still reports "verified, waiting" - a node
+    // that switched has rebooted and gone quiet
+    bool waiting = false;
+    for(int i = 0; i < OTA_MAX_RECEIVERS; i++) {
+      const OtaPeer& p = s.peers[i];
+      if(p.token && p.state == OTA_RX_VERIFIED && nowMs - p.lastMs < 2 * OTA_STATUS_MS) waiting = true;
+    }
+    if(s.commitsSent >= OTA_COMMIT_MAX || (s.commitsSent >= OTA_COMMIT_REPEATS && !waiting)) {
+      s.active = false;
+      return OTA_TX_DONE;
+    }
+    if(nowMs - s.lastOfferMs < OTA_COMMIT_GAP_MS) return OTA_TX_NONE;
+    s.lastOfferMs = nowMs;
+    s.commitsSent++;
+    return OTA_TX_COMMIT;
+  }
+
+  if(s.offersSent == 0 || nowMs - s.lastOfferMs >= OTA_OFFER_MS) {
+    s.lastOfferMs = nowMs;
+    s.offersSent++;
+    return OTA_TX_OFFER;
+  }
+  // Receivers erase their partition when the offer arrives - give them time
+  if(nowMs - s.startMs < OTA_ANNOUNCE_MS) return OTA_TX_NONE;
+
+  if(nowMs - s.recentSwapMs >= OTA_STATUS_MS) {
+    s.recentCur ^= 1;
+    memset(s.recent[s.recentCur], 0, sizeof(s.recent[0]));
+    s.recentSwapMs = nowMs;
+  }
+
+  int need = firstNeeded(s);
+  if(need >= 0) {
+    bitClear(s.need, need);
+    bitSet(s.recent[s.recentCur], need);
+    s.pass++;
+    s.repairsSent++;
+    s.dataSent++;
+    *chunk = need;
+    return OTA_TX_DATA;
+  }
+
+  if(s.nextChunk < s.offer.chunkCount) {
+    bitSet(s.recent[s.recentCur], s.nextChunk);
+    *chunk = s.nextChunk++;
+    s.dataSent++;
+    if(s.nextChunk == s.offer.chunkCount) s.passDoneMs = nowMs;
+    return OTA_TX_DATA;
+  }
+
+  // Pass done, nothing requested - commit once everyone we can hear is done
+  if(nowMs - s.passDoneMs < OTA_SETTLE_MS) return OTA_TX_NONE;
+  uint8_t fresh, done, failed;
+  otaTxPeerCounts(s, nowMs, &fresh, &done, &failed);
+  if(done + failed < fresh) return OTA_TX_NONE;
+  s.lastOfferMs = nowMs;
+  s.commitsSent = 1;
+  return OTA_TX_COMMIT;
+}
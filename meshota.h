@@ -0,0 +1,193 @@
+#ifndef MESHOTA_H
+#define MESHOTA_H
+
+// ── Mesh Firmware Distribution ───────────────────────────────────────────────
+// One seed node broadcasts a firmware image over ESP-NOW and every node writes
+// it to its inactive OTA partition at the same time - one broadcast for the
+// whole fleet instead of one WiFi upload per node.
+//
+//   PKT_OTA_OFFER   seed, ~2Hz      session, size, chunk layout, version, SHA-256
+//   PKT_OTA_DATA    seed            one chunk - frameId = chunk index, chunkIdx = send count
+//   PKT_OTA_STATUS  receivers       state, chunks held, and a bitmap of missing chunks
+//                                   from the first gap (the repair request)
+//   PKT_OTA_COMMIT  seed            switch to the new image now
+//
+// Receivers track held chunks in a bitmap and report their first gaps every
+// OTA_STATUS_MS in a token-derived slot. The seed resends requested chunks
+// ahead of its sequential pass, so repairs run alongside the first broadcast
+// and late joiners catch up from the gaps they report. Once every receiver it
+// has heard from reports a verified SHA-256 (or an up-to-date version) the
+// seed sends COMMIT and the fleet reboots together. A receiver that verified
+// but never hears COMMIT switches after OTA_SELF_COMMIT_MS of silence.
+//
+// The image is either a full build or a delta patch (delta.h) against the
+// build identified by baseSha. A receiver running a different build answers
+// OTA_RX_NEED_FULL and sits the session out.
+//
+// Hardware-independent: the firmware (ota.cpp) and tools/meshota_sim.cpp run
+// the same state machines; the caller moves the bytes and does the flash IO.
+
+#include <stdint.h>
+#include "sha256.h"
+
+static const uint8_t  OTA_CHUNK_BYTES     = 192;     // 20 header + 4 session + 192 = 216 < 250
+static const uint16_t OTA_MAX_CHUNKS      = 16384;   // 3MB at 192 bytes - the largest app partition
+static const uint8_t  OTA_VERSION_LEN     = 16;
+static const uint8_t  OTA_NACK_BYTES      = 64;      // Repair window: 512 chunks per status
+static const uint32_t OTA_TX_INTERVAL_MS  = 4;       // Seed paces one packet per tick - 250 packets/s
+static const uint32_t OTA_OFFER_MS        = 500;     // Offer repeated this often through the session
+static const uint32_t OTA_ANNOUNCE_MS     = 3000;    // Offers only at first - receivers erase meanwhile
+static const uint32_t OTA_STATUS_MS       = 500;     // Receiver status period...
+static const uint8_t  OTA_STATUS_SLOTS    = 20;      // ...split into token-derived slots
+static const uint32_t OTA_RECEIVER_STALE_MS = 3000;  // Seed stops waiting for a silent receiver...
+static const uint32_t OTA_FINISH_STALE_MS = 20000;   // ...unless it reported every chunk - hashing and
+                                                     // rebuilding a delta keep it quiet for a while
+static const uint32_t OTA_SETTLE_MS       = 1500;    // Seed listens this long after its pass before committing
+static const uint8_t  OTA_COMMIT_REPEATS  = 5;       // At least - more while verified nodes still report
+static const uint8_t  OTA_COMMIT_MAX      = 50;      // 5s of COMMITs at most
+static const uint32_t OTA_RX_IDLE_MS      = 10000;   // Receiver abandons a session the seed went quiet on
+static const uint32_t OTA_SELF_COMMIT_MS  = 30000;   // Verified receiver that never heard COMMIT
+static const uint8_t  OTA_MAX_RECEIVERS   = 32;
+
+enum OtaRxState : uint8_t {
+  OTA_RX_IDLE = 0,
+  OTA_RX_RECEIVING,
+  OTA_RX_VERIFIED,    // SHA-256 matched - waiting for COMMIT
+  OTA_RX_FAILED,      // Verification failed twice, or the image doesn't fit
+  OTA_RX_CURRENT,     // Already running this version - nothing to do
+  OTA_RX_NEED_FULL,   // Delta offered against a build we don't run
+};
+
+enum OtaFormat : uint8_t {
+  OTA_FORMAT_FULL = 0,   // The image itself
+  OTA_FORMAT_DELTA,      // delta.h patch - rebuilt against the running image after it verifies
+};
+
+struct OtaOffer {
+  uint32_t session;
+  uint32_t imageSize;
+  uint16_t chunkCount;
+  uint8_t  chunkSize;
+  char     version[OTA_VERSION_LEN];   // NUL-padded
+  uint8_t  sha[SHA256_LEN];           // Of the bytes sent - the patch, for a delta
+  uint8_t  format;                     // OtaFormat
+  uint8_t  baseSha[SHA256_LEN];        // Delta only: the image the patch applies to
+};
+static const uint8_t OTA_OFFER_V1_LEN = 4 + 4 + 2 + 1 + OTA_VERSION_LEN + SHA256_LEN;   // Full images only
+static const uint8_t OTA_OFFER_LEN = OTA_OFFER_V1_LEN + 1 + SHA256_LEN;
+
+struct OtaStatus {
+  uint32_t session;
+  uint8_t  state;                      // OtaRxState
+  uint16_t held;
+  uint16_t windowBase;                 // Bit i of missing = chunk windowBase + i is missing
+  uint8_t  missing[OTA_NACK_BYTES];
+};
+static const uint8_t OTA_STATUS_LEN = 4 + 1 + 2 + 2 + OTA_NACK_BYTES;
+
+int  otaOfferEncode(const OtaOffer& o, uint8_t* out);
+bool otaOfferDecode(const uint8_t* in, int len, OtaOffer& o);
+int  otaStatusEncode(const OtaStatus& s, uint8_t* out);
+bool otaStatusDecode(const uint8_t* in, int len, OtaStatus& s);
+
+// Fill the offer for an image (session from the caller - random or time-based).
+// For a delta, imageSize / sha describe the patch and baseSha the image it patches.
+void otaOfferInit(OtaOffer& o, uint32_t session, uint32_t imageSize, const char* version,
+                  const uint8_t sha[SHA256_LEN], const uint8_t* baseSha = nullptr);
+uint32_t otaChunkOffset(const OtaOffer& o, uint16_t idx);
+uint16_t otaChunkLen(const OtaOffer& o, uint16_t idx);
+
+// ── Receiver ──
+struct OtaReceiver {
+  OtaRxState state;
+  OtaOffer   offer;
+  uint8_t    held[OTA_MAX_CHUNKS / 8];
+  uint16_t   heldCount;
+  uint8_t    attempts;           // Receive passes started for this session
+  uint32_t   lastHeardMs;        // Anything from the seed
+  uint32_t   verifiedMs;
+  uint32_t   nextStatusMs;
+  uint32_t   token;              // Ours - picks the status slot
+};
+
+enum OtaOfferAction : uint8_t {
+  OTA_OFFER_IGNORE = 0,   // Not for us (same session, bad layout, already finished)
+  OTA_OFFER_START,        // New session - caller prepares the partition (erase) for offer.imageSize
+  OTA_OFFER_CURRENT,      // We already run this version - caller needn't do anything
+};
+
+void otaRxInit(OtaReceiver& r, uint32_t token);
+bool otaRxActive(const OtaReceiver& r);                 // In a session (any state but IDLE)
+
+// maxImage: where the bytes go - the inactive partition, or the patch staging
+// area for a delta. runningVersion / runningSha: this build (runningSha may be
+// null when no delta can be applied).
+OtaOfferAction otaRxOffer(OtaReceiver& r, const OtaOffer& o, uint32_t maxImage,
+                          const char* runningVersion, uint32_t nowMs,
+                          const uint8_t* runningSha = nullptr);
+
+// Returns true when the chunk is new - caller writes it at otaChunkOffset()
+bool otaRxChunk(OtaReceiver& r, uint32_t session, uint16_t idx, uint16_t len, uint32_t nowMs);
+// The write didn't read back correctly - forget the chunk so it gets requested again
+void otaRxChunkBad(OtaReceiver& r, uint16_t idx);
+bool otaRxComplete(const OtaReceiver& r);
+
+// After the caller hashed the written image - false means the pass restarts
+// (caller re-prepares the partition) or, after the second failure, FAILED
+bool otaRxVerify(OtaReceiver& r, const uint8_t sha[SHA256_LEN], uint32_t nowMs);
+
+// Fill a status packet when one is due; false otherwise
+bool otaRxStatusDue(OtaReceiver& r, OtaStatus& st, uint32_t nowMs);
+// Fill one now - sent just before going quiet to hash / rebuild a complete image
+void otaRxStatusFill(const OtaReceiver& r, OtaStatus& st);
+
+// True when a verified receiver should switch (COMMIT heard, or seed gone long enough)
+bool otaRxCommit(OtaReceiver& r, uint32_t session, uint32_t nowMs);
+bool otaRxShouldSelfCommit(const OtaReceiver& r, uint32_t nowMs);
+
+// Seed silent for OTA_RX_IDLE_MS while still receiving - caller aborts the partition
+bool otaRxTimedOut(const OtaReceiver& r, uint32_t nowMs);
+void otaRxAbort(OtaReceiver& r);
+
+// ── Seed ──
+enum OtaTxKind : uint8_t { OTA_TX_NONE = 0, OTA_TX_OFFER, OTA_TX_DATA, OTA_TX_COMMIT, OTA_TX_DONE };
+
+struct OtaPeer {
+  uint32_t token;
+  uint32_t lastMs;
+  uint8_t  state;
+  uint16_t held;
+};
+
+struct OtaSender {
+  OtaOffer offer;
+  uint8_t  need[OTA_MAX_CHUNKS / 8];   // Repair requests not yet resent
+  // Chunks sent in the current and previous OTA_STATUS_MS - a status written
+  // before the copy arrived (or by a second receiver missing the same chunk)
+  // must not queue it again
+  uint8_t  recent[2][OTA_MAX_CHUNKS / 8];
+  uint8_t  recentCur;
+  uint32_t recentSwapMs;
+  uint16_t nextChunk;                  // Sequential pass position
+  uint8_t  pass;                       // Bumped on resends - makes repeats distinct to relay dedupe
+  uint32_t startMs, lastOfferMs, passDoneMs;
+  uint8_t  commitsSent;
+  bool     active;
+  OtaPeer  peers[OTA_MAX_RECEIVERS];
+  // Stats
+  uint32_t offersSent, dataSent, repairsSent, statusHeard, repairsSuppressed;
+};
+
+void      otaTxStart(OtaSender& s, const OtaOffer& offer, uint32_t nowMs);
+
+// What to send on this pacing tick. For OTA_TX_DATA, *chunk is the index to send.
+OtaTxKind otaTxNext(OtaSender& s, uint32_t nowMs, uint16_t* chunk);
+
+void      otaTxNoteStatus(OtaSender& s, uint32_t token, const OtaStatus& st, uint32_t nowMs);
+
+// Fresh receivers, and how many of them are done (verified / current) or failed.
+// Failed includes needFull - receivers that can't use this delta.
+void      otaTxPeerCounts(const OtaSender& s, uint32_t nowMs, uint8_t* fresh, uint8_t* done, uint8_t* failed,
+                          uint8_t* needFull = nullptr);
+
+#endif
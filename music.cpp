@@ -0,0 +1,64 @@
+#include "music.h"
+#include <string.h>
+
+void musicInit(MusicDetector& m, uint32_t sampleRate, bool decimate){
+  memset(&m.features, 0, sizeof(m.features));
+  m.decimated = decimate;
+  m.inputRate = sampleRate;
+  decimatorInit(m.decimator);
+  uint32_t rate = decimate ? sampleRate / DECIM_FACTOR : sampleRate;
+  
+  uint16_t n = FFT_MAX_N;
+  while(n > 64 && n * 1000.0f / rate > MUSIC_HOP_MS * 1.5f) n /= 2;
+  analyzerInit(m.analyzer, rate, n, n);
+  tempoInit(m.tempo, n * 1000.0f / rate);
+  m.detected = false;
+  m.lastBeatMs = 0;
+}
+
+// Analyse samples already at the analysis rate; after is how many input-rate
+// samples of the block come after them, to date beats
+static int analyse(MusicDetector& m, const int16_t* samples, int count, uint32_t endMs, uint32_t after){
+  int hops = 0;
+  while(count > 0) {
+    int used = analyzerFeed(m.analyzer, samples, count);
+    samples += used;
+    count -= used;
+    if(!m.analyzer.hopReady) continue;
+    
+    m.features = m.analyzer.features;
+    // Tempo sees only what rose above the onset threshold
+    uint16_t over = m.features.flux > m.features.threshold ? m.features.flux - m.features.threshold : 0;
+    tempoUpdate(m.tempo, over, m.features.onset);
+    // Date the beat by when its hop ended, not by when the block was handled
+    if(m.tempo.beat) {
+      uint32_t later = after + (uint32_t)count * (m.decimated ? DECIM_FACTOR : 1);
+      m.lastBeatMs = endMs - later * 1000 / m.inputRate;
+    }
+    hops++;
+  }
+  return hops;
+}
+
+int musicFeed(MusicDetector& m, const int16_t* samples, int count, uint32_t endMs){
+  if(!m.decimated) return analyse(m, samples, count, endMs, 0);
+  
+  // A slice at a time through a small buffer at the analysis rate
+  static const int SLICE = 256;
+  int16_t low[SLICE / DECIM_FACTOR + 1];
+  int hops = 0;
+  while(count > 0) {
+    int take = count < SLICE ? count : SLICE;
+    int n = decimate(m.decimator, samples, take, low);
+    samples += take;
+    count -= take;
+    hops += analyse(m, low, n, endMs, count);
+  }
+  return hops;
+}
+
+bool musicUpdate(MusicDetector& m){
+  if(tempoLocked(m.tempo))                                   m.detected = true;
+  else if(m.tempo.confidence < TEMPO_LOCK_CONF * MUSIC_UNLOCK) m.detected = false;
+  return m.detected;
+}
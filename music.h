@@ -0,0 +1,44 @@
+#ifndef MUSIC_H
+#define MUSIC_H
+
+// ── Music Detector ───────────────────────────────────────────────────────────
+// Everything between microphone samples and what patterns see: the
+// decimating front-end (decimate.h), spectral onsets and bands (onset.h), the
+// tempo tracker (tempo.h), the audioDetected
+// decision and the beat clock. audio.cpp feeds it from the capture ring and
+// tools/audio_eval.cpp feeds it from WAV files, so the benchmark scores the
+// firmware's own code path. Hardware-independent.
+
+#include <stdint.h>
+#include "decimate.h"
+#include "onset.h"
+#include "tempo.h"
+
+static const float    MUSIC_HOP_MS = 11.6f;   // Analysis hop (and FFT length) in time - 128 samples at 11.025kHz
+static const float    MUSIC_UNLOCK = 0.6f;    // detected drops below this share of TEMPO_LOCK_CONF
+
+struct MusicDetector {
+  bool          decimated;      // Analysis runs at sampleRate / DECIM_FACTOR
+  uint32_t      inputRate;
+  Decimator     decimator;
+  AudioAnalyzer analyzer;
+  TempoTracker  tempo;
+  AudioFeatures features;       // Latest hop
+  bool          detected;       // Music: a confident tempo, with hysteresis
+  uint32_t      lastBeatMs;     // When the last beat's hop ended, on the caller's clock
+};
+
+// FFT length and hop are the power of two nearest MUSIC_HOP_MS at the analysis
+// rate. decimate = false analyses at the full input rate (the benchmark's "before")
+void musicInit(MusicDetector& m, uint32_t sampleRate, bool decimate = true);
+
+// Analyse a block whose last sample was captured at endMs. Returns the number
+// of hops completed (at most one when count <= hop).
+int  musicFeed(MusicDetector& m, const int16_t* samples, int count, uint32_t endMs);
+
+// Re-evaluate detected from the tempo confidence - returns it
+bool musicUpdate(MusicDetector& m);
+
+inline bool musicBeatLocked(const MusicDetector& m){ return m.detected && tempoLocked(m.tempo); }
+
+#endif
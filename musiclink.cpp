@@ -0,0 +1,49 @@
+#include "musiclink.h"
+#include <string.h>
+
+int musicPacketEncode(const MusicPacket& p, uint8_t* out){
+  memcpy(out + 0, &p.level, 2);
+  memcpy(out + 2, p.band, 2 * BAND_COUNT);
+  out[8] = p.flags;
+  out[9] = p.phase8;
+  memcpy(out + 10, &p.bpm10, 2);
+  return MUSIC_PACKET_LEN;
+}
+
+bool musicPacketDecode(const uint8_t* in, int len, MusicPacket& p){
+  if(len < MUSIC_PACKET_LEN) return false;
+  memcpy(&p.level, in + 0, 2);
+  memcpy(p.band, in + 2, 2 * BAND_COUNT);
+  p.flags  = in[8];
+  p.phase8 = in[9];
+  memcpy(&p.bpm10, in + 10, 2);
+  return true;
+}
+
+uint8_t musicScale8(uint16_t levelQ15){
+  uint32_t sq = (uint32_t)levelQ15 * levelQ15 >> 15;    // Q15
+  return MUSIC_SCALE_MIN + (uint8_t)((sq * (255 - MUSIC_SCALE_MIN) + (1 << 14)) >> 15);
+}
+
+void musicStreamReset(MusicStream& s){
+  memset(&s, 0, sizeof(s));
+}
+
+void musicStreamNote(MusicStream& s, const MusicPacket& p, uint16_t seq, uint32_t nowMs){
+  if(s.received) {
+    uint16_t gap = seq - s.lastSeq;
+    if(gap == 0 || gap > 0x8000) return;     // Duplicate or late - keep the newer packet
+    s.lost += gap - 1;
+  }
+  s.last = p;
+  s.lastMs = nowMs ? nowMs : 1;
+  s.lastSeq = seq;
+  s.received++;
+  if(p.flags & MUSIC_FLAG_BEAT) s.beats++;
+}
+
+uint8_t musicStreamScale(const MusicStream& s, uint32_t nowMs){
+  if(!s.lastMs || nowMs - s.lastMs > MUSIC_STREAM_STALE_MS) return 255;
+  if(!(s.last.flags & MUSIC_FLAG_ACTIVE)) return 255;
+  return musicScale8(s.last.level);
+}
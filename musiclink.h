@@ -0,0 +1,56 @@
+#ifndef MUSICLINK_H
+#define MUSICLINK_H
+
+// ── Audio Feature Stream ─────────────────────────────────────────────────────
+// The leader broadcasts a tiny PKT_AUDIO packet every MUSIC_STREAM_MS with the
+// latest audio features (level, bands, beat flag/phase, tempo), independent of
+// pixel frames. Pixel frames stay musically neutral and every node applies the
+// music scaling in its own output stage (FastLED's global brightness at show
+// time), so a lost pixel frame no longer loses a beat and the envelope each
+// node shows is at most one stream packet old. Hardware-independent.
+
+#include <stdint.h>
+#include "onset.h"
+
+static const uint32_t MUSIC_STREAM_MS    = 10;     // 100Hz
+static const uint32_t MUSIC_STREAM_STALE_MS = 100; // No packet for this long - fall back to neutral
+static const uint8_t  MUSIC_SCALE_MIN    = 8;      // 3% - quiet passages nearly off, as effectMusic() did
+
+// Payload flags
+static const uint8_t  MUSIC_FLAG_ACTIVE  = 0x01;   // audioDetected - apply the music scaling
+static const uint8_t  MUSIC_FLAG_BEAT    = 0x02;   // A beat fell since the previous packet
+static const uint8_t  MUSIC_FLAG_ONSET   = 0x04;   // ...an onset did
+static const uint8_t  MUSIC_FLAG_LOCKED  = 0x08;   // Tempo locked - phase and bpm are meaningful
+
+struct MusicPacket {
+  uint16_t level;               // AudioFeatures.level, Q15
+  uint16_t band[BAND_COUNT];    // AudioFeatures.band, Q15
+  uint8_t  flags;
+  uint8_t  phase8;              // Beat phase, 0 on the beat
+  uint16_t bpm10;               // Tempo x10
+};
+static const uint8_t MUSIC_PACKET_LEN = 12;
+
+int  musicPacketEncode(const MusicPacket& p, uint8_t* out);
+bool musicPacketDecode(const uint8_t* in, int len, MusicPacket& p);
+
+// The music envelope as a brightness scale: level squared for contrast, from
+// MUSIC_SCALE_MIN (quiet) to 255 (loud)
+uint8_t musicScale8(uint16_t levelQ15);
+
+// Follower side - the latest packet and how the stream is doing
+struct MusicStream {
+  MusicPacket last;
+  uint32_t    lastMs;           // When it arrived (0 = never)
+  uint16_t    lastSeq;
+  uint32_t    received, lost;   // Packets heard / gaps in the sequence
+  uint32_t    beats;            // Beat flags heard
+};
+
+void    musicStreamReset(MusicStream& s);
+void    musicStreamNote(MusicStream& s, const MusicPacket& p, uint16_t seq, uint32_t nowMs);
+// Output scale for now: the leader's envelope while the stream is fresh and
+// says music, otherwise 255 (neutral)
+uint8_t musicStreamScale(const MusicStream& s, uint32_t nowMs);
+
+#endif
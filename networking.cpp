@@ -2,6 +2,19 @@
 #include "ota.h"
 #include "audio.h"
 #include "patterns.h"
+#include "relay.h"
+#include "spsc_ring.h"
+#include "scheduler.h"
+#include "protocol.h"
+#include "assembler.h"
+#include "playout.h"
+#include "feedback.h"
+#include "capture.h"
+#include "musiclink.h"
+#include "output.h"
+#include "telemetry.h"
+#include "version.h"
+#include <esp_timer.h>
 
 // WiFi networks to try in order
 struct WiFiNetwork {
@@ -18,14 +31,205 @@ const int numWiFiNetworks = sizeof(wifiNetworks) / sizeof(wifiNetworks[0]);
 // WiFi management variables
 bool wifiConnected = false;
 bool wifiPreviouslyConnected = false;
-uint32_t lastWiFiCheck = 0;
-uint32_t lastWiFiStatusCheck = 0;
 const uint32_t WIFI_CHECK_INTERVAL = 120000; // Check every 2 minutes when connected
 const uint32_t WIFI_CHECK_INTERVAL_DISCONNECTED = 30000; // Check every 30 seconds when disconnected
 const uint32_t WIFI_STATUS_CHECK_INTERVAL = 10000; // Quick status check every 10 seconds
+const uint32_t WIFI_SETTLE_TIME = 30000; // No background scans this long after a disconnect
 bool wifiCheckInProgress = false;
 bool wifiJustDisconnected = false;
 
+// Background connect runs as a state machine stepped from handleNetworking(),
+// so a scan or a slow access point never holds up loop() (or the LEDs)
+enum WiFiConnectState { WIFI_BG_IDLE, WIFI_BG_SCANNING, WIFI_BG_CONNECTING };
+static WiFiConnectState wifiConnectState = WIFI_BG_IDLE;
+static uint32_t wifiStateStart = 0;
+static int      wifiCandidate = -1;                 // Index into wifiNetworks being tried
+static bool     wifiCandidateSeen[sizeof(wifiNetworks) / sizeof(wifiNetworks[0])];
+const uint32_t WIFI_SCAN_TIMEOUT    = 6000;   // 13 channels x 300ms plus margin
+const uint32_t WIFI_CONNECT_TIMEOUT = 3000;   // Per candidate network
+const uint32_t WIFI_POLL_INTERVAL   = 50;     // State machine step while scanning/connecting
+
+// Deferred sync reset - the radio stays down for SYNC_RESET_PAUSE between
+// esp_now_deinit() and re-init, without blocking loop()
+static const uint32_t SYNC_RESET_PAUSE      = 200;
+static const uint32_t WIFI_TRANSITION_PAUSE = 100;   // Let the network settle before resetting
+static TimerId syncResetTimer = TIMER_NONE;
+
+static void checkWiFiStatusQuickly(void*);
+static void checkWiFiPeriodically(void*);
+static void sendHeartbeat(void*);
+static void sendReport(void*);
+static void adaptLink(void*);
+static void markLeaderFrameDue(void*);
+static void sendAudioFeatures(void*);
+
+// Frame assembly and presentation
+static CRGB     rxLeds[MAX_LEDS];       // Followers assemble chunks here, never in the live buffer -
+                                        // the leader, which assembles nothing, keeps its pattern canvas here
+static FrameAssembler rxAsm;            // Chunk tracking, FEC and receive statistics for rxLeds
+static bool     rxFrameReady = false;   // rxLeds holds a complete frame not yet in the playout history
+static uint32_t rxFrameMicros = 0;      // When it completed
+static uint32_t rxFramesLostTotal = 0;  // Since boot, for debug output
+static int32_t  rxRssiSum = 0;          // Report window RSSI accumulator
+static uint16_t rxRssiCount = 0;
+
+// Display - every node shows frames from the playout history at its own rate (see playout.h)
+static CRGB     playoutFrames[PLAYOUT_SLOTS][MAX_LEDS];
+static Playout  playout;
+static uint8_t  playoutHops = 0;        // Relay depth of the newest frame
+static uint32_t nextDisplayUs = 0;
+
+// Receive handoff - onRecv runs in the WiFi task and only copies packets into
+// this ring; loop() drains it, so all protocol state is touched from one task
+static const uint32_t RX_RING_LEN = 32;        // Two frames at MAX_LEDS, six at 334
+struct RxPacket {
+  uint32_t rxMicros;
+  int8_t   rssi;
+  uint8_t  len;
+  uint8_t  src[6];
+  uint8_t  data[ESP_NOW_MAX_DATA_LEN];
+};
+static SpscRing<RxPacket, RX_RING_LEN> rxRing;
+static void drainRxRing();
+
+// Wire protocol state (see protocol.h)
+static uint16_t txFrameId = 0;
+static uint32_t lastLeaderTxMillis = 0;       // Last pixel packet - doubles as heartbeat in v2
+static bool     legacyPeerHeard = false;      // A v1-only node was heard - speak v1 until reboot
+static uint32_t rxCrcErrors = 0, rxBadVersion = 0;
+
+// Packet capture (CAPTURE_MODE, see capture.h)
+static uint16_t captureSeq = 0;
+static uint32_t captureDropped = 0;             // Records skipped because the serial buffer was full
+
+// v1 framing while the fleet is mid-rollout, v2 otherwise
+static bool speakV1(){
+  return WIRE_PROTOCOL < 2 || legacyPeerHeard;
+}
+
+// Receive feedback - followers report, the leader adapts (see feedback.h)
+static LinkAdapt linkAdapt;
+static bool      leaderFrameDue = false;        // Set by the frame timer, consumed by the LEADER state
+static uint32_t  reportsSent = 0, reportsHeard = 0;
+
+static const LinkLevel& linkLevel(){
+  return LINK_LEVELS[linkAdapt.level];
+}
+
+// The leader renders at LEADER_RENDER_FPS but puts only the link level's fps
+// on the air - every node's display blends the frames in between. The send
+// times advance by the level's interval, not from the render that went out, so
+// rates that don't divide the render rate still average out exactly (20fps
+// sends 2 renders in 5). Half a render of slack keeps timer jitter from
+// pushing a send to the next render.
+static uint32_t nextTxFrameUs = 0;
+static bool leaderTxDue(){
+  uint32_t nowUs = micros(), renderUs = 1000000 / LEADER_RENDER_FPS, period = 1000000 / linkLevel().fps;
+  int32_t late = (int32_t)(nowUs - nextTxFrameUs);
+  if(late < -(int32_t)(renderUs / 2)) return false;
+  nextTxFrameUs = late > (int32_t)period ? nowUs + period : nextTxFrameUs + period;
+  return true;
+}
+
+// Audio feature stream - the leader sends, followers scale their output by it (see musiclink.h)
+static MusicStream musicStream;
+static uint16_t    txAudioSeq = 0;
+static uint32_t    txLastBeatMs = 0, txLastOnsetHop = 0;
+
+// Fleet telemetry - every node beacons, every node keeps the table (see telemetry.h)
+static FleetTable fleet;
+static uint16_t   txBeaconSeq = 0;
+static uint32_t   framesShown = 0;        // Presented since boot
+static int8_t     linkRssi = 0;           // Mean RSSI of the last report window
+static void sendTelemetry(void*);
+
+// Multi-hop relay state (only used when RELAY_MODE is enabled)
+static const uint8_t  RELAY_QUEUE_LEN = linkChunks(LINK_LEVELS[0], MAX_LEDS) + 2;   // A frame's chunks plus a heartbeat
+struct PendingRelay {
+  volatile bool pending;   // Set by loop() once the slot is filled, cleared by serviceRelays
+  uint32_t dueMicros;
+  uint8_t  len;
+  uint8_t  buf[ESP_NOW_MAX_DATA_LEN];
+};
+static PendingRelay relayQueue[RELAY_QUEUE_LEN];
+static RelayCache   relayCache;
+static RelayRole    relayRole;
+static esp_timer_handle_t relayTimer = nullptr;
+static uint32_t     relaysSent = 0, relaysDropped = 0;
+
+static void queueRelay(const uint8_t* data, int len, uint8_t hops){
+  if(len + 2 > ESP_NOW_MAX_DATA_LEN) return;
+  
+  for(int i = 0; i < RELAY_QUEUE_LEN; i++){
+    PendingRelay &r = relayQueue[i];
+    if(r.pending) continue;
+    uint32_t holdUs = esp_random() % RELAY_JITTER_US;
+    r.dueMicros = micros() + holdUs;
+    r.buf[0] = MSGTYPE_RELAY;
+    r.buf[1] = hops + 1;
+    memcpy(r.buf + 2, data, len);
+    r.len = len + 2;
+    r.pending = true;
+    // Idle until something is queued. If the timer is already armed this fails
+    // harmlessly - it fires within RELAY_JITTER_US and re-arms for what's left.
+    esp_timer_start_once(relayTimer, holdUs + 1);
+    return;
+  }
+  relaysDropped++;
+}
+
+// Runs from a one-shot esp_timer so forwarding isn't held up by showLeds() in
+// loop(). Sends what's due, then re-arms for the earliest entry still waiting.
+static void serviceRelays(void*){
+  uint32_t nowUs = micros();
+  int32_t  nextUs = INT32_MAX;
+  for(int i = 0; i < RELAY_QUEUE_LEN; i++){
+    PendingRelay &r = relayQueue[i];
+    if(!r.pending) continue;
+    int32_t waitUs = (int32_t)(r.dueMicros - nowUs);
+    if(waitUs > 0) { nextUs = min(nextUs, waitUs); continue; }
+    esp_now_send(broadcastAddress, r.buf, r.len);
+    relaysSent++;
+    r.pending = false;
+  }
+  if(nextUs != INT32_MAX) esp_timer_start_once(relayTimer, nextUs);
+}
+
+// ESP-NOW PHY rates, slowest (longest range) first - see linkPickRate()
+struct AirRate { wifi_phy_rate_t phy; uint16_t kbps; };
+static const AirRate AIR_RATES[] = {
+  {WIFI_PHY_RATE_1M_L, 1000}, {WIFI_PHY_RATE_2M_L, 2000}, {WIFI_PHY_RATE_5M_L, 5500}, {WIFI_PHY_RATE_11M_L, 11000},
+};
+static const uint8_t AIR_RATE_COUNT = sizeof(AIR_RATES) / sizeof(AIR_RATES[0]);
+static const uint8_t AIR_RATE_RELAY = 3;   // Relayed traffic multiplies airtime - 11Mbps keeps 3 hops inside a 20ms frame
+static_assert(linkMaxChunks(MAX_LEDS) <= ASM_MAX_CHUNKS, "MAX_LEDS splits into more chunks than a frame can track");
+
+static void initAirRate(){
+  uint16_t kbps[AIR_RATE_COUNT];
+  for(uint8_t i = 0; i < AIR_RATE_COUNT; i++) kbps[i] = AIR_RATES[i].kbps;
+  uint8_t first = RELAY_MODE ? AIR_RATE_RELAY : 0;
+  uint8_t rate = first + linkPickRate(kbps + first, AIR_RATE_COUNT - first, numLeds);
+  esp_wifi_config_espnow_rate(WIFI_IF_STA, AIR_RATES[rate].phy);
+  if(DEBUG_SERIAL) {
+    uint32_t us = linkFrameAirtimeUs(LINK_LEVELS[0], numLeds, AIR_RATES[rate].kbps);
+    Serial.printf("ESP-NOW: %u LEDs at %.1fMbps - %u chunks, %.1fms on air per frame\n", numLeds,
+      AIR_RATES[rate].kbps / 1000.0f, linkChunks(LINK_LEVELS[0], numLeds), us / 1000.0f);
+  }
+}
+
+static void initRelay(){
+  relayCacheReset(relayCache);
+  relayRoleReset(relayRole, millis());
+  if(!RELAY_MODE) return;
+  
+  if(!relayTimer) {
+    esp_timer_create_args_t args = {};
+    args.callback = serviceRelays;
+    args.name = "relay";
+    esp_timer_create(&args, &relayTimer);   // Started by queueRelay()
+  }
+}
+
 void initNetworking(){
   if(DEBUG_SERIAL) Serial.println("Initializing ESP-NOW (priority)...");
   
@@ -37,11 +241,14 @@ void initNetworking(){
   
   esp_now_init();
   esp_now_register_recv_cb(onRecv);
+  bootMilestone(bootProfile, BOOT_LISTENING, micros());
   esp_now_peer_info_t peer={};
   memcpy(peer.peer_addr, broadcastAddress, 6);
   peer.channel = 0; 
   peer.encrypt = false;
   esp_now_add_peer(&peer);
+  initAirRate();
+  initRelay();
 
   uint8_t mac_raw[6];
   esp_wifi_get_mac(WIFI_IF_STA, mac_raw);
@@ -55,38 +262,45 @@ void initNetworking(){
     );
   }
   
-  // Show ESP-NOW ready status immediately
-  canvas.fillSprite(TFT_BLACK);
-  canvas.fillRect(0, 0, M5.Lcd.width(), 40, TFT_BLUE);
-  canvas.setTextSize(2);
-  canvas.setTextColor(TFT_WHITE);
-  canvas.setCursor(10, 10);
-  canvas.print("ESP-NOW READY");
-  canvas.setTextSize(1);
-  canvas.setCursor(10, 50);
-  canvas.print("Local mesh active");
-  canvas.setCursor(10, 65);
-  canvas.print("WiFi check starting...");
-  canvas.pushSprite(0, 0);
-  
   // Initialize WiFi state tracking
   wifiConnected = false;
   wifiPreviouslyConnected = false;
   wifiJustDisconnected = false;
   
   // Schedule first WiFi check for 3 seconds from now (non-blocking)
-  lastWiFiCheck = millis() - WIFI_CHECK_INTERVAL + 3000;
-  lastWiFiStatusCheck = millis();
+  timerOnce(3000, checkWiFiPeriodically);
+  timerEvery(WIFI_STATUS_CHECK_INTERVAL, checkWiFiStatusQuickly);
+  
+  // Leader heartbeat - the timer runs always, sendHeartbeat decides whether to send
+  timerEvery(LEADER_HEARTBEAT_INTERVAL, sendHeartbeat);
+  
+  // Receive reports go out in this node's own slot; the leader re-evaluates the link
+  // and sends frames at the current link level's rate
+  asmInit(rxAsm, (uint8_t*)rxLeds, numLeds);
+  playoutInit(playout, (uint8_t*)playoutFrames[0], (uint8_t*)playoutFrames[1], (uint8_t*)playoutFrames[2], numLeds);
+  linkAdaptReset(linkAdapt);
+  timerEveryAfter(reportSlotOffsetMs(myToken) + 1, FEEDBACK_REPORT_MS, sendReport);
+  timerEvery(FEEDBACK_ADAPT_MS, adaptLink);
+  timerEvery(1000 / LEADER_RENDER_FPS, markLeaderFrameDue);
+  
+  // Music reactivity travels separately from the (musically neutral) pixels
+  musicStreamReset(musicStream);
+  timerEvery(MUSIC_STREAM_MS, sendAudioFeatures);
+  
+  fleetReset(fleet);
+  timerEveryAfter(telemetrySlotOffsetMs(myToken) + 1, TELEMETRY_BEACON_MS, sendTelemetry);
   
   if(DEBUG_SERIAL) Serial.println("ESP-NOW initialization complete - no blocking!");
 }
 
-void checkWiFiStatusQuickly() {
-  uint32_t now = millis();
-  
-  // Quick WiFi status check every 10 seconds (non-blocking)
-  if (now - lastWiFiStatusCheck < WIFI_STATUS_CHECK_INTERVAL) return;
-  lastWiFiStatusCheck = now;
+static void clearJustDisconnected(void*) {
+  wifiJustDisconnected = false;
+}
+
+// Quick WiFi status check every 10 seconds (scheduler callback)
+static void checkWiFiStatusQuickly(void*) {
+  if (currentMode != AUTO) return;
+  if (wifiConnectState != WIFI_BG_IDLE) return; // Background connect owns the state until it finishes
   
   // Quick check - no scanning, just see if we're still connected
   bool currentlyConnected = (WiFi.status() == WL_CONNECTED);
@@ -101,6 +315,7 @@ void checkWiFiStatusQuickly() {
       if(DEBUG_SERIAL) Serial.println("WiFi disconnected - switching to LOCAL mode");
       wifiConnected = false;
       wifiJustDisconnected = true;
+      timerOnce(WIFI_SETTLE_TIME, clearJustDisconnected);
       
       // CRITICAL: When WiFi disconnects, ensure ESP-NOW is still working
       // Sometimes WiFi disconnect can interfere with ESP-NOW
@@ -118,129 +333,122 @@ void checkWiFiStatusQuickly() {
     handleWiFiTransition(wifiPreviouslyConnected, currentlyConnected);
     wifiPreviouslyConnected = currentlyConnected;
   }
-  
-  // Clear the "just disconnected" flag after a few status checks
-  if (wifiJustDisconnected && now - lastWiFiStatusCheck > 30000) {
-    wifiJustDisconnected = false;
-  }
 }
 
-void checkWiFiPeriodically() {
-  uint32_t now = millis();
-  
-  // Use different intervals based on connection status
-  uint32_t checkInterval = wifiConnected ? WIFI_CHECK_INTERVAL : WIFI_CHECK_INTERVAL_DISCONNECTED;
-  if (now - lastWiFiCheck < checkInterval) return;
-  if (wifiCheckInProgress) return; // Prevent overlapping checks
-  
-  // Don't do WiFi scanning if we just disconnected - let things settle
-  if (wifiJustDisconnected) {
-    if(DEBUG_SERIAL) Serial.println("Skipping WiFi scan - recently disconnected, letting ESP-NOW stabilize");
-    lastWiFiCheck = now; // Reset timer
-    return;
+static void finishWiFiCheck() {
+  if (!wifiConnected && DEBUG_SERIAL) {
+    Serial.println("No WiFi available - continuing in LOCAL mode");
   }
-  
-  lastWiFiCheck = now;
-  wifiCheckInProgress = true;
-  
-  if(DEBUG_SERIAL) Serial.println("Background WiFi scan starting...");
-  
-  // Quick check if already connected
-  if (WiFi.status() == WL_CONNECTED) {
-    if (!wifiConnected) {
-      wifiConnected = true;
-      wifiPreviouslyConnected = true;
-      if(DEBUG_SERIAL) Serial.printf("WiFi already connected: %s\n", WiFi.localIP().toString().c_str());
-    }
-    wifiCheckInProgress = false;
+  wifiConnectState = WIFI_BG_IDLE;
+  wifiCheckInProgress = false;
+}
+
+// Start connecting to the next network that showed up in the scan
+static void tryNextWiFiCandidate(uint32_t now) {
+  while (++wifiCandidate < numWiFiNetworks) {
+    if (!wifiCandidateSeen[wifiCandidate]) continue;
+    
+    if(DEBUG_SERIAL) Serial.printf("Trying WiFi: %s (background)\n", wifiNetworks[wifiCandidate].ssid);
+    WiFi.begin(wifiNetworks[wifiCandidate].ssid, wifiNetworks[wifiCandidate].password);
+    wifiConnectState = WIFI_BG_CONNECTING;
+    wifiStateStart = now;
     return;
   }
-  
-  // WiFi not connected - try to find and connect
-  wifiConnected = false;
-  wifiPreviouslyConnected = false;
-  
-  // CRITICAL: Temporarily reduce ESP-NOW activity during WiFi scan
-  // Save current FSM state
-  FsmState savedState = fsmState;
-  
-  // Quick scan with very short timeout
-  WiFi.disconnect(); // Ensure clean state
-  int networksFound = WiFi.scanNetworks(false, false, false, 300); // 300ms max
-  
-  if (networksFound > 0) {
-    for(int i = 0; i < numWiFiNetworks; i++) {
-      // Check if this network is available
-      bool networkFound = false;
-      for(int j = 0; j < networksFound; j++) {
-        if(WiFi.SSID(j) == String(wifiNetworks[i].ssid)) {
-          networkFound = true;
-          break;
-        }
+  finishWiFiCheck();
+}
+
+static void stepWiFiConnect(uint32_t now) {
+  switch (wifiConnectState) {
+    case WIFI_BG_IDLE: {
+      if (currentMode != AUTO) return;
+      
+      // Don't do WiFi scanning if we just disconnected - let things settle
+      if (wifiJustDisconnected) {
+        if(DEBUG_SERIAL) Serial.println("Skipping WiFi scan - recently disconnected, letting ESP-NOW stabilize");
+        return;
       }
       
-      if(!networkFound) continue;
+      // Quick check if already connected
+      if (WiFi.status() == WL_CONNECTED) {
+        if (!wifiConnected) {
+          wifiConnected = true;
+          wifiPreviouslyConnected = true;
+          if(DEBUG_SERIAL) Serial.printf("WiFi already connected: %s\n", WiFi.localIP().toString().c_str());
+        }
+        return;
+      }
       
-      if(DEBUG_SERIAL) Serial.printf("Trying WiFi: %s (background)\n", wifiNetworks[i].ssid);
+      // WiFi not connected - start an asynchronous scan and come back for the results
+      wifiConnected = false;
+      wifiPreviouslyConnected = false;
+      wifiCheckInProgress = true;
       
-      WiFi.begin(wifiNetworks[i].ssid, wifiNetworks[i].password);
+      if(DEBUG_SERIAL) Serial.println("Background WiFi scan starting...");
+      WiFi.disconnect(); // Ensure clean state
+      WiFi.scanNetworks(true, false, false, 300); // async, 300ms per channel
+      wifiConnectState = WIFI_BG_SCANNING;
+      wifiStateStart = now;
+      break;
+    }
+    
+    case WIFI_BG_SCANNING: {
+      int16_t networksFound = WiFi.scanComplete();
+      if (networksFound == WIFI_SCAN_RUNNING) {
+        if (now - wifiStateStart < WIFI_SCAN_TIMEOUT) return;
+        if(DEBUG_SERIAL) Serial.println("WiFi scan timed out");
+        networksFound = 0;
+      }
       
-      // Very short connection attempt - only 3 seconds max
-      int attempts = 0;
-      while (WiFi.status() != WL_CONNECTED && attempts < 6) {
-        delay(500);
-        attempts++;
-        
-        // Feed watchdog during WiFi connection
-        if (attempts % 2 == 0) {
-          // Let ESP-NOW continue working during connection attempt
-          esp_now_send(broadcastAddress, (uint8_t*)"", 0); // Keepalive
+      for (int i = 0; i < numWiFiNetworks; i++) {
+        wifiCandidateSeen[i] = false;
+        for (int j = 0; j < networksFound; j++) {
+          if (WiFi.SSID(j) == String(wifiNetworks[i].ssid)) {
+            wifiCandidateSeen[i] = true;
+            break;
+          }
         }
       }
+      WiFi.scanDelete();
       
+      wifiCandidate = -1;
+      tryNextWiFiCandidate(now);
+      break;
+    }
+    
+    case WIFI_BG_CONNECTING: {
       if (WiFi.status() == WL_CONNECTED) {
         wifiConnected = true;
         wifiPreviouslyConnected = true;
         if(DEBUG_SERIAL) {
           Serial.printf("WiFi connected (background): %s, IP: %s\n", 
-            wifiNetworks[i].ssid, WiFi.localIP().toString().c_str());
+            wifiNetworks[wifiCandidate].ssid, WiFi.localIP().toString().c_str());
         }
-        break;
-      } else {
+        finishWiFiCheck();
+      } else if (now - wifiStateStart >= WIFI_CONNECT_TIMEOUT) {
         WiFi.disconnect();
+        tryNextWiFiCandidate(now);
       }
+      break;
     }
   }
+}
+
+// Scheduler callback - polls quickly while a scan/connect is in flight, then
+// goes back to sleep for the check interval
+static void checkWiFiPeriodically(void*) {
+  stepWiFiConnect(millis());
   
-  if (!wifiConnected && DEBUG_SERIAL) {
-    Serial.println("No WiFi available - continuing in LOCAL mode");
-  }
-  
-  // Restore ESP-NOW state after WiFi operations
-  if (savedState != fsmState) {
-    if(DEBUG_SERIAL) Serial.printf("FSM state changed during WiFi scan: %d -> %d\n", savedState, fsmState);
+  uint32_t next = WIFI_POLL_INTERVAL;
+  if (wifiConnectState == WIFI_BG_IDLE) {
+    // Use different intervals based on connection status
+    next = wifiConnected ? WIFI_CHECK_INTERVAL : WIFI_CHECK_INTERVAL_DISCONNECTED;
   }
-  
-  wifiCheckInProgress = false;
+  timerOnce(next, checkWiFiPeriodically);
 }
 
-void forceSyncReset() {
-  if(DEBUG_SERIAL) Serial.println("[SYNC] Forcing synchronization reset...");
-  
-  // Clear all FSM state
-  fsmState = FOLLOWER;
-  lastRecvMillis = 0;
-  lastHeartbeat = 0;
-  electionEnd = 0;
-  highestTokenSeen = 0;
-  
-  // Clear LED state to force fresh pattern
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
-  
-  // Reset networking state
-  esp_now_deinit();
-  delay(200); // Brief pause for cleanup
+// Second half of forceSyncReset(), once the radio has had SYNC_RESET_PAUSE to clean up
+static void finishSyncReset(void*) {
+  syncResetTimer = TIMER_NONE;
   
   // Reinitialize ESP-NOW
   esp_now_init();
@@ -250,6 +458,15 @@ void forceSyncReset() {
   peer.channel = 0; 
   peer.encrypt = false;
   esp_now_add_peer(&peer);
+  initAirRate();
+  initRelay();
+  rxRing.clear();  // Anything queued belongs to the old session
+  
+  // Clear all FSM state
+  fsmState = FOLLOWER;
+  lastRecvMillis = 0;
+  electionEnd = 0;
+  highestTokenSeen = 0;
   
   // Force new election after brief delay
   uint32_t now = millis();
@@ -262,6 +479,27 @@ void forceSyncReset() {
   }
 }
 
+void forceSyncReset() {
+  if(DEBUG_SERIAL) Serial.println("[SYNC] Forcing synchronization reset...");
+  
+  // Park the FSM - handleNetworking() idles until finishSyncReset() runs
+  fsmState = FOLLOWER;
+  
+  // Clear LED state to force fresh pattern
+  playoutReset(playout);
+  fill_solid(leds, numLeds, CRGB::Black);
+  showLeds();
+  
+  // Reset networking state, re-init after a brief pause for cleanup
+  esp_now_deinit();
+  timerCancel(syncResetTimer);
+  syncResetTimer = timerOnce(SYNC_RESET_PAUSE, finishSyncReset);
+}
+
+static void transitionSyncReset(void*) {
+  forceSyncReset();
+}
+
 void handleWiFiTransition(bool wasConnected, bool nowConnected) {
   if (wasConnected == nowConnected) return; // No change
   
@@ -271,14 +509,58 @@ void handleWiFiTransition(bool wasConnected, bool nowConnected) {
       nowConnected ? "CONNECTED" : "DISCONNECTED");
   }
   
-  // Brief pause to let network settle
-  delay(100);
+  // Force sync reset on any WiFi transition, after a brief pause to let the
+  // network settle. This prevents nodes from getting stuck in stale states
+  timerOnce(WIFI_TRANSITION_PAUSE, transitionSyncReset);
   
-  // Force sync reset on any WiFi transition
-  // This prevents nodes from getting stuck in stale states
-  forceSyncReset();
+  if(DEBUG_SERIAL) Serial.println("[WIFI] Sync reset scheduled - nodes should resynchronize");
+}
+
+// A complete frame - from the leader's radio, or rendered here by the leader -
+// joins the playout history. What the strip shows comes from serviceDisplay().
+static void pushFrame(const CRGB* frame, uint32_t leaderUs, uint32_t localUs, uint8_t hops){
+  playoutPush(playout, (const uint8_t*)frame, leaderUs, localUs);
+  playoutHops = hops;
+  framesShown++;
+}
+
+// Music scaling for the output stage. v2 frames are musically neutral: the
+// leader uses its own features, followers the latest stream packet. Frames sent
+// as v1 carry the scaling baked in (v1 nodes can't hear the stream), so 255.
+static uint8_t musicOutputScale(){
+  if(fsmState == LEADER) return (audioDetected && !speakV1()) ? musicScale8(audioFeatures.level) : 255;
+  return musicStreamScale(musicStream, millis());
+}
+
+// At the display rate, blend the playout history into leds and show it. The
+// rate is capped so showLeds() - which waits for the wire - takes at most half
+// of loop(). Relay mode holds the nodes closer to the leader back so every hop
+// level lights up together.
+static uint32_t displayPeriodUs(){
+  uint32_t us = 1000000 / DISPLAY_FPS, showUs = showLedsUs() * 2;
+  return showUs > us ? showUs : us;
+}
+
+static void serviceDisplay(){
+  uint32_t nowUs = micros();
+  if((int32_t)(nowUs - nextDisplayUs) < 0) return;
+  uint32_t period = displayPeriodUs();
+  nextDisplayUs = nowUs - nextDisplayUs > period ? nowUs + period : nextDisplayUs + period;
+  
+  // Skip LED updates if ESP-NOW suspended for OTA
+  if(otaSuspended) return;
+  uint32_t extraUs = RELAY_MODE ? relayPresentDelayMs(playoutHops) * 1000 : 0;
+  if(playoutRender(playout, nowUs, extraUs, (uint8_t*)leds) == PLAYOUT_EMPTY) return;
   
-  if(DEBUG_SERIAL) Serial.println("[WIFI] Sync reset complete - nodes should resynchronize");
+  // Every node applies its LOCAL brightness and the music envelope at show
+  // time - the frame itself is at FULL brightness
+  FastLED.setBrightness(scale8(globalBrightnessScale, musicOutputScale()));
+  showLeds();
+  if(bootMilestone(bootProfile, BOOT_FIRST_FRAME, micros())) {
+    bootProfile.firstFrameAsLeader = (fsmState == LEADER);
+    if(DEBUG_SERIAL) Serial.printf("BOOT: first synced frame at %ums (%s)\n",
+      bootProfile.milestoneUs[BOOT_FIRST_FRAME] / 1000, fsmState == LEADER ? "leader" : "follower");
+  }
 }
 
 void handleNetworking(){
@@ -286,37 +568,68 @@ void handleNetworking(){
   
   if(currentMode != AUTO) return;
   
+  // Radio is down between the two halves of a sync reset
+  if(timerPending(syncResetTimer)) return;
   
   // No OTA mode checks needed - v56 style handles OTA gracefully
+  // WiFi status and background connect run from the scheduler (see initNetworking)
   
-  // Check WiFi status quickly and frequently (non-blocking)
-  checkWiFiStatusQuickly();
+  drainRxRing();
   
-  // Check WiFi connectivity periodically in background (blocking but infrequent)
-  if (!wifiJustDisconnected) { // Skip if we just disconnected
-    checkWiFiPeriodically();
+  // A mesh firmware transfer owns the radio and the strip until it ends
+  static bool meshOtaHeld = false;
+  if(meshOtaService(now)) { meshOtaHeld = true; return; }
+  if(meshOtaHeld) {
+    meshOtaHeld = false;
+    lastRecvMillis = now;
+    resetFrameAssembly();
   }
   
+  serviceDisplay();
+  
   switch(fsmState){
     case FOLLOWER: {
-      if(chunkMask == ((1u << ((NUM_LEDS + 74) / 75)) - 1u)){
-        // Skip LED updates if ESP-NOW suspended for OTA
-        if(!otaSuspended) {
-          // Followers apply only their LOCAL brightness (no audio detection)
-          // The LED data already contains the leader's music reactivity at FULL brightness
-          FastLED.setBrightness(globalBrightnessScale);
-          FastLED.show(); 
+      if(rxFrameReady){
+        // Complete frame - into the playout history, stamped with the leader's
+        // render time (v1 frames carry none - their arrival stands in)
+        pushFrame(rxLeds, rxAsm.version >= 2 ? rxAsm.timestampUs : rxFrameMicros, rxFrameMicros, rxAsm.hops);
+        rxFrameReady = false;
+      }
+      
+      if(RELAY_MODE) {
+        if(relayUpdateRole(relayRole, now, esp_random()) && DEBUG_SERIAL) {
+          Serial.printf("RELAY: %s relaying (level %u, %.1f peer copies per frame)\n",
+            relayRole.active ? "started" : "stopped", relayRole.level, relayRole.peers16 / 16.0f);
+        }
+        if(DEBUG_SERIAL && millis() % 10000 < 50) {
+          Serial.printf("RELAY: active=%s sent=%u dropped=%u\n",
+            relayRole.active ? "yes" : "no", relaysSent, relaysDropped);
         }
-        chunkMask = 0;
       }
       
+      if(DEBUG_SERIAL && millis() % 10000 < 50) {
+        Serial.printf("RX: ring depth=%u peak=%u/%u overflows=%u crc=%u badver=%u lost=%u proto=v%d reports=%u\n",
+          rxRing.size(), rxRingHighWater(), RX_RING_LEN, rxRingOverflows(),
+          rxCrcErrors, rxBadVersion, rxFramesLostTotal + rxAsm.stats.framesLost, speakV1() ? 1 : 2, reportsSent);
+        Serial.printf("AUDIO RX: packets=%u lost=%u beats=%u scale=%u\n",
+          musicStream.received, musicStream.lost, musicStream.beats, musicOutputScale());
+        if(CAPTURE_MODE) Serial.printf("CAPTURE: %u records, %u dropped (serial full)\n", captureSeq, captureDropped);
+        Serial.printf("PLAYOUT: interval=%uus delay=%uus frames=%u blended=%u extrapolated=%u held=%u display=%uHz\n",
+          playout.intervalUs, playoutDelayUs(playout, 0), playout.stats.frames, playout.stats.blended,
+          playout.stats.extrapolated, playout.stats.held, 1000000 / displayPeriodUs());
+      }
+      
+      // Until a leader has been heard at all there is nothing to wait out -
+      // a running leader is audible within a few ms
       uint32_t timeSinceLastMsg = now - lastRecvMillis;
-      if(timeSinceLastMsg > LEADER_TIMEOUT){
+      uint32_t leaderTimeout = bootReached(bootProfile, BOOT_FIRST_LEADER) ? LEADER_TIMEOUT : BOOT_LISTEN_MS;
+      if(timeSinceLastMsg > leaderTimeout){
         missedFrameCount++;
         if(missedFrameCount >= 3) {
           // IMPORTANT: Reset LED state when becoming disconnected
-          fill_solid(leds, NUM_LEDS, CRGB::Black);
-          FastLED.show();
+          playoutReset(playout);
+          fill_solid(leds, numLeds, CRGB::Black);
+          showLeds();
           
           fsmState = ELECT;
           electionStart = now; 
@@ -326,7 +639,7 @@ void handleNetworking(){
                     + random(0, ELECTION_JITTER);
           electionBroadcasted = false;
           missedFrameCount = 0;
-          chunkMask = 0;  // Reset chunk mask
+          resetFrameAssembly();
           if(DEBUG_SERIAL) {
             Serial.printf("FSM: FOLLOWER→ELECT (timeout=%ums) token=0x%06X delay=%ums\n",
               timeSinceLastMsg, myToken, myDelay
@@ -351,13 +664,15 @@ void handleNetworking(){
         if(highestTokenSeen > myToken){
           fsmState = FOLLOWER; 
           lastRecvMillis = now;
-          chunkMask = 0;  // CRITICAL: Reset chunk tracking
+          resetFrameAssembly();  // CRITICAL: Reset chunk tracking
           missedFrameCount = 0;
           if(DEBUG_SERIAL) {
             Serial.printf("FSM: ELECT lost→FOLLOWER (high=0x%06X)\n", highestTokenSeen);
           }
         } else {
           fsmState = LEADER;
+          playoutReset(playout);   // Our own clock from here on
+          fill_solid(rxLeds, numLeds, CRGB::Black);
           if(DEBUG_SERIAL) {
             Serial.printf("FSM: ELECT won→LEADER (high=0x%06X)\n", highestTokenSeen);
           }
@@ -367,19 +682,15 @@ void handleNetworking(){
     }
     
     case LEADER: {
-      if(now - lastHeartbeat >= LEADER_HEARTBEAT_INTERVAL){
-        sendToken(); 
-        lastHeartbeat = now;
-      }
-      
       if(highestTokenSeen > myToken){
         // CRITICAL: Properly reset state when stepping down
-        fill_solid(leds, NUM_LEDS, CRGB::Black);
-        FastLED.show();
+        playoutReset(playout);
+        fill_solid(leds, numLeds, CRGB::Black);
+        showLeds();
         
         fsmState = FOLLOWER; 
         lastRecvMillis = now; 
-        chunkMask = 0;  // Reset chunk mask completely
+        resetFrameAssembly();  // Reset chunk tracking completely
         missedFrameCount = 0;
         if(DEBUG_SERIAL) {
           Serial.printf("FSM: LEADER saw higher token→FOLLOWER (0x%06X) - resetting LED state\n", highestTokenSeen);
@@ -387,119 +698,441 @@ void handleNetworking(){
         break;
       }
       
+      // Frame rate follows the link level the followers' reports call for
+      if(!leaderFrameDue) break;
+      leaderFrameDue = false;
+      
+      // The display blends into leds - patterns draw over their own last frame
+      memcpy(leds, rxLeds, sizeof(CRGB) * numLeds);
+      
       // Use simple, fast pattern execution to eliminate latency
       // Crossfade disabled for performance - was causing 0.5s delays
       if(freezeActive) {
-        detectAudioFrame();
         if(audioDetected) effectMusic();
         else             effectWildBG();
       } else {
-        detectAudioFrame();
         if(audioDetected) runTimed(effectMusic);
         else             runTimed(effectWildBG);
       }
+      memcpy(rxLeds, leds, sizeof(CRGB) * numLeds);
       
-      // Send the LED data with music reactivity baked into the colors at FULL brightness
-      sendRaw();
+      // v1 followers can't hear the audio stream - bake the music into their pixels
+      if(audioDetected && speakV1()) {
+        uint8_t musicScale = musicScale8(audioFeatures.level);
+        for(int i = 0; i < numLeds; i++) leds[i].nscale8(musicScale);
+      }
       
-      // Skip LED updates if ESP-NOW suspended for OTA
-      if(!otaSuspended) {
-        // Apply leader's local brightness for its own display
-        FastLED.setBrightness(globalBrightnessScale);
-        FastLED.show();
+      // Send the LED data at FULL brightness - music scaling happens at each node's output.
+      // Shown through the same playout as the followers, from the same frames,
+      // so in step with them - leader frames are "hop 0", with the direct followers
+      if(leaderTxDue()) {
+        uint32_t stamp = sendRaw();
+        pushFrame(leds, stamp, stamp, 0);
       }
       
       if(DEBUG_SERIAL && millis() % 10000 < 50) { // Less frequent debug
         Serial.printf("LEADER: music=%.2f, audioDetected=%s, localBright=%d, wifi=%s\n", 
           musicLevel, audioDetected ? "true" : "false", globalBrightnessScale, 
           wifiConnected ? "connected" : "local");
+        Serial.printf("LINK: level=%u (%ufps on air%s%s %u/chunk) nodes=%u worst frame loss=%u%% chunk loss=%u%% latency=%uus\n",
+          linkAdapt.level, linkLevel().fps,
+          (linkLevel().flags & PROTO_FLAG_FEC) ? " fec" : "", (linkLevel().flags & PROTO_FLAG_RGB565) ? " 565" : "",
+          linkLevel().ledsPerChunk, linkAdapt.reporting,
+          linkAdapt.worstFramePermille / 10, linkAdapt.worstChunkPermille / 10, linkAdapt.worstLatencyUs);
       }
       break;
     }
   }
 }
 
-void onRecv(const esp_now_recv_info_t*, const uint8_t* data, int len){
+static void processPacket(const PacketInfo& pkt, uint8_t hops, uint32_t rxMicros){
   uint32_t now = millis();
   
-  if(len >= 5 && data[0] == MSGTYPE_TOKEN) {
-    uint32_t incomingToken; 
-    memcpy(&incomingToken, data+1, 4);
-    
-    if(incomingToken > highestTokenSeen) {
-      highestTokenSeen = incomingToken;
-    }
-    
-    if(fsmState == FOLLOWER && currentMode == AUTO) {
+  // Firmware transfer traffic says nothing about leadership
+  if(pkt.kind >= PKT_OTA_OFFER && pkt.kind <= PKT_OTA_COMMIT) {
+    meshOtaHandlePacket(pkt, now);
+    return;
+  }
+  
+  // Neither do health beacons - any node may send them
+  if(pkt.kind == PKT_TELEMETRY) {
+    TelemetryBeacon b;
+    if(telemetryDecode(pkt.payload, pkt.payloadLen, b)) fleetNote(fleet, pkt.token, b, now);
+    return;
+  }
+  
+  // Every leader packet carries its token - pixel chunks double as heartbeats.
+  // Reports come from followers: a higher-token node that boots and starts
+  // following must not topple the leader it just adopted.
+  if(pkt.kind != PKT_REPORT && pkt.token > highestTokenSeen) {
+    highestTokenSeen = pkt.token;
+  }
+  
+  bool fromLeader = (pkt.flags & PROTO_FLAG_LEADER) && pkt.token != myToken;
+  if(fromLeader && bootMilestone(bootProfile, BOOT_FIRST_LEADER, micros()) && DEBUG_SERIAL) {
+    Serial.printf("BOOT: leader 0x%06X heard at %ums\n", pkt.token, bootProfile.milestoneUs[BOOT_FIRST_LEADER] / 1000);
+  }
+  
+  // A leader is already running and would win this election anyway - follow it now
+  if(fromLeader && fsmState == ELECT && pkt.token > myToken && currentMode == AUTO) {
+    fsmState = FOLLOWER;
+    lastRecvMillis = now;
+    resetFrameAssembly();
+    missedFrameCount = 0;
+    if(DEBUG_SERIAL) Serial.printf("FSM: ELECT→FOLLOWER (leader 0x%06X already running)\n", pkt.token);
+  }
+  
+  if(pkt.kind == PKT_HEARTBEAT) {
+    if(fsmState == FOLLOWER && currentMode == AUTO && (pkt.flags & PROTO_FLAG_LEADER)) {
       lastRecvMillis = now;
       missedFrameCount = 0;
       if(DEBUG_HEARTBEAT) {
-        Serial.printf("Heartbeat: token=0x%06X (leader alive)\n", incomingToken);
+        Serial.printf("Heartbeat: token=0x%06X v%d (leader alive)\n", pkt.token, pkt.version);
       }
     }
     return;
   }
   
+  if(pkt.kind == PKT_AUDIO) {
+    // Audio features double as a leader heartbeat
+    MusicPacket mp;
+    if(fsmState == FOLLOWER && currentMode == AUTO && (pkt.flags & PROTO_FLAG_LEADER)
+       && musicPacketDecode(pkt.payload, pkt.payloadLen, mp)) {
+      musicStreamNote(musicStream, mp, (uint16_t)pkt.frameId, now);
+      lastRecvMillis = now;
+      missedFrameCount = 0;
+    }
+    return;
+  }
   
-  if(len < 10 || data[0] != MSGTYPE_RAW) return;
+  if(pkt.kind == PKT_REPORT) {
+    // Followers' view of the link - only the leader acts on it
+    RxReport rep;
+    if(fsmState == LEADER && reportDecode(pkt.payload, pkt.payloadLen, rep)) {
+      linkAdaptNote(linkAdapt, pkt.token, rep, now);
+      reportsHeard++;
+    }
+    return;
+  }
   
-  uint32_t incomingToken; 
-  memcpy(&incomingToken, data+5, 4);
+  if(pkt.kind != PKT_PIXELS) return;
   
   // Minimal debug output to avoid blocking (only if heartbeat debug enabled)
   if(DEBUG_HEARTBEAT && millis() % 5000 < 50) { // Much less frequent
-    Serial.printf("onRecv: fsm=%s token=0x%06X\n",
-      (fsmState==LEADER?"LEADER":fsmState==FOLLOWER?"FOLLOWER":"ELECT"), incomingToken
+    Serial.printf("onRecv: fsm=%s token=0x%06X v%d\n",
+      (fsmState==LEADER?"LEADER":fsmState==FOLLOWER?"FOLLOWER":"ELECT"), pkt.token, pkt.version
     );
   }
   
-  if(fsmState == LEADER && incomingToken > myToken){
+  if(fsmState == LEADER && pkt.token > myToken){
     if(DEBUG_SERIAL) Serial.printf("Conflict: stepping DOWN (saw higher token)\n");
     fsmState = FOLLOWER; 
     lastRecvMillis = now; 
-    chunkMask = 0;
+    resetFrameAssembly();
     missedFrameCount = 0;
     return;
   }
   
   if(fsmState == FOLLOWER && currentMode == AUTO){
-    uint8_t idx = data[9];
-    int base = idx * 75, cnt = min(75, NUM_LEDS - base);
-    memcpy(leds + base, data + 10, cnt * 3);
-    chunkMask |= (1 << idx);
+    if(asmAddChunk(rxAsm, pkt, hops, rxMicros)) {
+      rxFrameReady = true;
+      rxFrameMicros = rxMicros;
+    }
     lastRecvMillis = now;
     missedFrameCount = 0;
   }
 }
 
-void sendRaw(){
-  int chunks = (NUM_LEDS + 74) / 75;
-  uint8_t buf[1+4+4+1+75*3];
+// Capture mode - copy the packet to serial as-is; never block loop() on the port
+static void capturePacket(const RxPacket& rx){
+  uint8_t rec[CAPTURE_MAX_RECORD];
+  int len = captureEncode(rec, captureSeq++, rx.rxMicros, rx.rssi, rx.src, rx.data, rx.len);
+  if(Serial.availableForWrite() < len) { captureDropped++; return; }
+  Serial.write(rec, len);
+}
+
+static void handleRxPacket(const RxPacket& rx){
+  if(CAPTURE_MODE) capturePacket(rx);
+  
+  const uint8_t* data = rx.data;
+  int len = rx.len;
+  uint8_t hops = 0;
+  
+  // Unwrap relayed frames - the original packet follows the 2-byte relay header
+  if(len >= 2 && data[0] == MSGTYPE_RELAY) {
+    if(!RELAY_MODE) return;
+    hops = data[1];
+    data += 2;
+    len  -= 2;
+  }
+  
+  // Integrity first - a corrupted copy must not poison the relay cache or the LEDs
+  PacketInfo pkt;
+  ParseResult result = protoParse(data, len, pkt);
+  if(result == PARSE_BAD_CRC)     { rxCrcErrors++;  return; }
+  if(result == PARSE_BAD_VERSION) { rxBadVersion++; return; }
+  if(result != PARSE_OK) return;
+  bootMilestone(bootProfile, BOOT_FIRST_PACKET, rx.rxMicros);
+  
+  // A v1-only node is around - talk v1 from now on so it can follow us, even
+  // once it goes quiet (see protocol.h)
+  if(!legacyPeerHeard && protoFromLegacyPeer(pkt, myToken)) {
+    legacyPeerHeard = true;
+    if(DEBUG_SERIAL) Serial.printf("PROTO: v1-only node 0x%06X heard - speaking v1 until reboot\n", pkt.token);
+  }
+  
+  if(RELAY_MODE) {
+    // Every frame reaches us several times (leader + relays) - process it once
+    if(!relayCacheInsert(relayCache, relayKey(data, len))) {
+      if(pkt.kind == PKT_PIXELS) relayNoteExtraCopy(relayRole, hops);
+      return;
+    }
+    if(pkt.kind == PKT_PIXELS) relayNoteFirstCopy(relayRole, rx.rssi, hops);
+    if(relayRole.active && fsmState == FOLLOWER && currentMode == AUTO && hops < RELAY_MAX_HOPS
+       && !(pkt.kind >= PKT_OTA_OFFER && pkt.kind <= PKT_OTA_COMMIT)) {
+      queueRelay(data, len, hops);
+    }
+  }
+  
+  if(pkt.kind == PKT_PIXELS && fsmState == FOLLOWER) {
+    rxRssiSum += rx.rssi;
+    rxRssiCount++;
+  }
+  
+  processPacket(pkt, hops, rx.rxMicros);
+}
+
+// Runs at the top of every AUTO-mode loop - processes everything onRecv queued
+static void drainRxRing(){
+  while(const RxPacket* pkt = rxRing.peek()) {
+    handleRxPacket(*pkt);
+    rxRing.pop();
+  }
+}
+
+uint32_t rxRingOverflows(){ return rxRing.overflows.load(std::memory_order_relaxed); }
+uint32_t rxRingHighWater(){ return rxRing.highWater.load(std::memory_order_relaxed); }
+
+// WiFi task context - copy and get out; never touch FSM or LED state here
+void onRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len){
+  if(len < 1 || len > ESP_NOW_MAX_DATA_LEN) return;
   
-  for(int c = 0; c < chunks; c++){
-    int base = c * 75, cnt = min(75, NUM_LEDS - base);
-    buf[0] = MSGTYPE_RAW;
-    memcpy(buf+1, &masterSeq, 4);
-    memcpy(buf+5, &myToken, 4);
-    buf[9] = c;
+  RxPacket* pkt = rxRing.beginWrite();
+  if(!pkt) return;  // loop() fell behind - counted in rxRing.overflows
+  
+  pkt->rxMicros = micros();
+  pkt->rssi = info ? info->rx_ctrl->rssi : RELAY_RSSI_STRONG;
+  pkt->len = len;
+  if(info) memcpy(pkt->src, info->src_addr, 6);
+  else     memset(pkt->src, 0, 6);
+  memcpy(pkt->data, data, len);
+  rxRing.commitWrite();
+}
+
+uint32_t sendRaw(){
+  uint32_t stamp = micros();
+  
+  // Send FULL BRIGHTNESS LED data - each node applies its own brightness locally
+  if(speakV1()) {
+    int chunks = (numLeds + PROTO_V1_LEDS_PER_CHUNK - 1) / PROTO_V1_LEDS_PER_CHUNK;
+    uint8_t buf[PROTO_V1_HEADER_LEN + PROTO_V1_LEDS_PER_CHUNK*3 + 1];
     
-    // Send FULL BRIGHTNESS LED data - each node applies its own brightness locally
-    for(int i = 0; i < cnt; i++){
-      CRGB &led = leds[base + i];
-      buf[10 + i*3    ] = led.r;  // No brightness scaling here
-      buf[10 + i*3 + 1] = led.g;
-      buf[10 + i*3 + 2] = led.b;
+    for(int c = 0; c < chunks; c++){
+      int base = c * PROTO_V1_LEDS_PER_CHUNK, cnt = min((int)PROTO_V1_LEDS_PER_CHUNK, numLeds - base);
+      buf[0] = MSGTYPE_RAW;
+      memcpy(buf+1, &masterSeq, 4);
+      memcpy(buf+5, &myToken, 4);
+      buf[9] = c;
+      memcpy(buf+10, leds + base, cnt*3);  // No brightness scaling here
+      buf[10 + cnt*3] = PROTO_V2_CAPABLE_MARK;
+      
+      esp_now_send(broadcastAddress, buf, 10 + cnt*3 + 1);
+      masterSeq++;
     }
+  } else {
+    // Chunk size and encoding follow the link level
+    const LinkLevel& lvl = linkLevel();
+    int chunks = linkChunks(lvl, numLeds);
+    int bpl = protoPixelBytes(lvl.flags);
+    uint8_t buf[PROTO_MAX_PACKET];
+    uint8_t parity[PROTO_MAX_PACKET - PROTO_HEADER_LEN];
+    memset(parity, 0, sizeof(parity));
     
-    esp_now_send(broadcastAddress, buf, 10 + cnt*3);
-    masterSeq++;
+    for(int c = 0; c < chunks; c++){
+      int base = c * lvl.ledsPerChunk, cnt = min((int)lvl.ledsPerChunk, numLeds - base);
+      int bytes = protoEncodePixels(lvl.flags, (const uint8_t*)(leds + base), cnt, buf + PROTO_HEADER_LEN);
+      if(lvl.flags & PROTO_FLAG_FEC) {
+        for(int i = 0; i < bytes; i++) parity[i] ^= buf[PROTO_HEADER_LEN + i];
+      }
+      int len = protoBuildV2(buf, PKT_PIXELS, PROTO_FLAG_LEADER | lvl.flags, myToken, txFrameId, c, chunks,
+                             stamp, base, buf + PROTO_HEADER_LEN, bytes);
+      esp_now_send(broadcastAddress, buf, len);
+      masterSeq++;
+    }
+    
+    if(lvl.flags & PROTO_FLAG_FEC) {
+      // Parity chunk: index == count, offset carries the chunk size for the rebuild
+      int len = protoBuildV2(buf, PKT_PIXELS, PROTO_FLAG_LEADER | lvl.flags, myToken, txFrameId, chunks, chunks,
+                             stamp, lvl.ledsPerChunk, parity, lvl.ledsPerChunk * bpl);
+      esp_now_send(broadcastAddress, buf, len);
+      masterSeq++;
+    }
   }
+  txFrameId++;
+  lastLeaderTxMillis = millis();
+  return stamp;
+}
+
+// Every LEADER_HEARTBEAT_INTERVAL from the scheduler. In v2 the pixel stream
+// already carries the heartbeat, so this only speaks up when frames stall.
+static void sendHeartbeat(void*){
+  if(currentMode != AUTO || fsmState != LEADER || timerPending(syncResetTimer)) return;
+  if(!speakV1() && millis() - lastLeaderTxMillis < LEADER_HEARTBEAT_INTERVAL) return;
+  sendToken();
+}
+
+// Follower receive report, once per FEEDBACK_REPORT_MS in this node's slot
+static void sendReport(void*){
+  if(currentMode != AUTO || fsmState != FOLLOWER || speakV1() || timerPending(syncResetTimer)) return;
+  if(rxAsm.stats.framesComplete + rxAsm.stats.framesLost == 0) return;  // Nothing heard from a v2 leader
+  
+  RxReport rep;
+  linkRssi = rxRssiCount ? rxRssiSum / rxRssiCount : 0;
+  reportFromStats(rep, rxAsm, linkRssi);
+  rxFramesLostTotal += rxAsm.stats.framesLost;
+  asmResetStats(rxAsm);
+  rxRssiSum = 0;
+  rxRssiCount = 0;
+  
+  uint8_t buf[PROTO_HEADER_LEN + RX_REPORT_LEN];
+  int payloadLen = reportEncode(rep, buf + PROTO_HEADER_LEN);
+  int len = protoBuildV2(buf, PKT_REPORT, 0, myToken, (uint16_t)masterSeq, 0, 0, micros(), 0,
+                         buf + PROTO_HEADER_LEN, payloadLen);
+  esp_now_send(broadcastAddress, buf, len);
+  masterSeq++;
+  reportsSent++;
+}
+
+// Health beacon, once per TELEMETRY_BEACON_MS in this node's slot. Our own
+// goes into the fleet table too, so a dump shows every node.
+static void sendTelemetry(void*){
+  TelemetryBeacon b;
+  telemetryParseVersion(FIRMWARE_VERSION, b.version);
+  b.role = currentMode != AUTO ? TELEM_OFF : fsmState == LEADER ? TELEM_LEADER
+         : fsmState == FOLLOWER ? TELEM_FOLLOWER : TELEM_ELECT;
+  b.resetReason = esp_reset_reason();
+  b.brightness = globalBrightnessScale;
+  b.rssi = fsmState == FOLLOWER ? linkRssi : 0;
+  b.uptimeS = millis() / 1000;
+  b.freeHeap = ESP.getFreeHeap();
+  b.minFreeHeap = ESP.getMinFreeHeap();
+  uint32_t p99 = loopHistPercentile(loopHist, 990), worst = loopHistPercentile(loopHist, 1000);
+  b.loopP99Us = p99 < 65535 ? p99 : 65535;
+  b.loopMaxMs = worst / 1000;
+  loopHistReset(loopHist);
+  b.framesShown = framesShown;
+  b.framesDropped = rxFramesLostTotal + rxAsm.stats.framesLost;
+  fleetNote(fleet, myToken, b, millis());
+  
+  // Radio is down between the two halves of a sync reset, or busy with a firmware transfer
+  if(timerPending(syncResetTimer) || meshOtaActive() || speakV1()) return;
+  uint8_t buf[PROTO_HEADER_LEN + TELEMETRY_BEACON_LEN];
+  int payloadLen = telemetryEncode(b, buf + PROTO_HEADER_LEN);
+  int len = protoBuildV2(buf, PKT_TELEMETRY, 0, myToken, txBeaconSeq++, 0, 0, micros(), 0,
+                         buf + PROTO_HEADER_LEN, payloadLen);
+  esp_now_send(broadcastAddress, buf, len);
+}
+
+void printFleetTable(){
+  uint32_t now = millis();
+  uint8_t order[TELEMETRY_MAX_NODES];
+  uint8_t n = fleetSorted(fleet, order);
+  Serial.printf("FLEET: %u nodes (table on 0x%06X, %s)\n", n, myToken,
+    fsmState == LEADER ? "leader" : fsmState == FOLLOWER ? "follower" : "electing");
+  Serial.println("  token    role  version   up(h)  heap/min KB  loop p99/max  shown  drop%  rssi  bri  reset     flags");
+  for(uint8_t i = 0; i < n; i++) {
+    const FleetEntry& e = fleet.nodes[order[i]];
+    const TelemetryBeacon& b = e.beacon;
+    static const char* ROLES[] = {"F", "L", "E", "off"};
+    uint8_t f = fleetFlags(e, now);
+    Serial.printf("%c 0x%06X %-4s  %2u.%u.%-3u %6.1f  %4u/%-4u    %5.1fms/%-3ums %6u %5.1f %5d %4u  %-8s  %s%s%s%s%s%s\n",
+      e.token == myToken ? '*' : ' ', e.token, b.role < 4 ? ROLES[b.role] : "?",
+      b.version[0], b.version[1], b.version[2], b.uptimeS / 3600.0f,
+      b.freeHeap / 1024, b.minFreeHeap / 1024, b.loopP99Us / 1000.0f, b.loopMaxMs,
+      b.framesShown, e.dropPermille / 10.0f, b.rssi, b.brightness,
+      telemetryResetName(b.resetReason),
+      (f & FLEET_STALE) ? "STALE " : "", (f & FLEET_LOW_HEAP) ? "LOW-HEAP " : "", (f & FLEET_LEAK) ? "LEAK? " : "",
+      (f & FLEET_BAD_LINK) ? "BAD-LINK " : "", (f & FLEET_SLOW_LOOP) ? "SLOW-LOOP " : "",
+      (f & FLEET_REBOOTED) ? "REBOOTED " : "");
+  }
+}
+
+static void markLeaderFrameDue(void*){
+  leaderFrameDue = true;
+}
+
+// Leader: latest audio features every MUSIC_STREAM_MS, between pixel frames
+static void sendAudioFeatures(void*){
+  if(currentMode != AUTO || fsmState != LEADER || speakV1() || timerPending(syncResetTimer)) return;
+  
+  MusicPacket mp;
+  mp.level = audioFeatures.level;
+  memcpy(mp.band, audioFeatures.band, sizeof(mp.band));
+  mp.flags = 0;
+  if(audioDetected) mp.flags |= MUSIC_FLAG_ACTIVE;
+  if(beatLocked())  mp.flags |= MUSIC_FLAG_LOCKED;
+  if(lastBeatMillis() != txLastBeatMs) { mp.flags |= MUSIC_FLAG_BEAT; txLastBeatMs = lastBeatMillis(); }
+  if(audioFeatures.onset && audioFeatures.hop != txLastOnsetHop) { mp.flags |= MUSIC_FLAG_ONSET; txLastOnsetHop = audioFeatures.hop; }
+  mp.phase8 = beatPhase8();
+  mp.bpm10 = (uint16_t)(beatBPM() * 10);
+  
+  uint8_t buf[PROTO_HEADER_LEN + MUSIC_PACKET_LEN];
+  int payloadLen = musicPacketEncode(mp, buf + PROTO_HEADER_LEN);
+  int len = protoBuildV2(buf, PKT_AUDIO, PROTO_FLAG_LEADER, myToken, txAudioSeq++, 0, 0, micros(), 0,
+                         buf + PROTO_HEADER_LEN, payloadLen);
+  esp_now_send(broadcastAddress, buf, len);
+  lastLeaderTxMillis = millis();
+}
+
+// Leader: move along the link ladder to suit the worst follower
+static void adaptLink(void*){
+  if(fsmState != LEADER) {
+    // Start every leadership term from the top of the ladder
+    linkAdaptReset(linkAdapt);
+    return;
+  }
+  uint8_t before = linkAdapt.level;
+  if(!linkAdaptUpdate(linkAdapt, millis())) return;
+  
+  if(DEBUG_SERIAL) {
+    Serial.printf("LINK: level %u -> %u (%ufps on air, worst frame loss %u.%u%%, %u nodes reporting)\n",
+      before, linkAdapt.level, linkLevel().fps,
+      linkAdapt.worstFramePermille / 10, linkAdapt.worstFramePermille % 10, linkAdapt.reporting);
+  }
+}
+
+void resetFrameAssembly(){
+  asmReset(rxAsm);
+  rxFrameReady = false;
+  playoutReset(playout);   // A new leader's clock, or none
 }
 
 void sendToken(){
-  uint8_t buf[5] = {MSGTYPE_TOKEN, 0, 0, 0, 0};
-  memcpy(buf+1, &myToken, 4);
-  esp_now_send(broadcastAddress, buf, sizeof(buf));
+  if(speakV1()) {
+    // Trailing sequence number makes each heartbeat unique for relay dedupe;
+    // older nodes only read the first 5 bytes
+    uint8_t buf[10] = {MSGTYPE_TOKEN, 0, 0, 0, 0, 0, 0, 0, 0, PROTO_V2_CAPABLE_MARK};
+    memcpy(buf+1, &myToken, 4);
+    memcpy(buf+5, &masterSeq, 4);
+    esp_now_send(broadcastAddress, buf, sizeof(buf));
+  } else {
+    // Leader keepalive, or an election bid - only the leader flag tells them apart
+    uint8_t buf[PROTO_HEADER_LEN];
+    int len = protoBuildV2(buf, PKT_HEARTBEAT, fsmState == LEADER ? PROTO_FLAG_LEADER : 0, myToken,
+                           (uint16_t)masterSeq, 0, 0, micros(), 0, nullptr, 0);
+    esp_now_send(broadcastAddress, buf, len);
+  }
+  masterSeq++;
 }
 
 // ── OTA Coordination Functions ───────────────────────────────────────────────
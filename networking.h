@@ -7,10 +7,16 @@
 void initNetworking();
 void handleNetworking();
 void onRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len);
-void sendRaw();
+uint32_t sendRaw();          // Returns the frame's timestamp (leader render time)
 void sendToken();
 void forceSyncReset();
 void handleWiFiTransition(bool wasConnected, bool nowConnected);
+void resetFrameAssembly();   // Drop any partially received frame and the playout history
+void printFleetTable();      // Latest telemetry beacon of every node heard (serial "FLEET")
+
+// Receive ring health - packets dropped because loop() fell behind, and peak depth
+uint32_t rxRingOverflows();
+uint32_t rxRingHighWater();
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "onset.h"
+#include <math.h>
+#include <string.h>
+
+static uint16_t binFor(const AudioAnalyzer& a, uint32_t hz){
+  uint32_t bin = (hz * a.n + a.sampleRate / 2) / a.sampleRate;
+  return bin > a.n / 2 ? a.n / 2 : bin;
+}
+
+void analyzerInit(AudioAnalyzer& a, uint32_t sampleRate, uint16_t fftN, uint16_t hop){
+  memset(&a, 0, sizeof(a));
+  fftInit(a.fft, fftN);
+  a.sampleRate = sampleRate;
+  a.n = a.fft.n;
+  a.hopLen = (hop && hop <= a.n) ? hop : a.n;
+  a.hopMs10 = (uint16_t)((uint32_t)a.hopLen * 10000 / sampleRate);
+  for(int i = 0; i < a.n; i++){
+    a.window[i] = (int16_t)lround(32767.0 * 0.5 * (1.0 - cos(2.0 * M_PI * i / a.n)));
+  }
+  a.binLo = binFor(a, ONSET_MIN_HZ);
+  if(a.binLo < 1) a.binLo = 1;
+  a.binHi = binFor(a, ONSET_MAX_HZ);
+  a.bandEdge[BAND_BASS]    = a.binLo;
+  a.bandEdge[BAND_MID]     = binFor(a, BAND_BASS_HZ);
+  a.bandEdge[BAND_TREBLE]  = binFor(a, BAND_MID_HZ);
+  a.bandEdge[BAND_COUNT]   = a.binHi;
+  for(int b = 0; b < BAND_COUNT; b++) a.log2Bins[b] = fftLog2Q8(a.bandEdge[b + 1] - a.bandEdge[b]);
+  // Power of a tone grows with n^2 - at the same bin width (the decimated rate) a
+  // 128-point FFT reads 4 log2 below a 512-point one
+  a.logGain = a.n < ONSET_REF_N ? 2 * fftLog2Q8(ONSET_REF_N / a.n) : 0;
+  for(int k = 0; k < a.n / 2; k++) a.prevLog[k] = ONSET_LOG_FLOOR;
+  for(int b = 0; b <= BAND_COUNT; b++) a.agcPeak[b] = AGC_SILENCE;
+}
+
+// Q15 position of a log power within [peak - AGC_RANGE, peak]; the peak follows
+// loud passages at once and decays slowly through quiet ones
+static uint16_t agcScale(int32_t& peak, int32_t value, int32_t decay){
+  peak -= decay;
+  if(peak < AGC_SILENCE) peak = AGC_SILENCE;
+  if(value > peak) peak = value;
+  int32_t above = value - (peak - AGC_RANGE);
+  if(above <= 0) return 0;
+  return (uint16_t)((above * 32767) / AGC_RANGE);
+}
+
+static void analyzeHop(AudioAnalyzer& a){
+  for(int i = 0; i < a.n; i++) a.scratch[i] = (int16_t)(((int32_t)a.frame[i] * a.window[i]) >> 15);
+  int exp2 = fftRealPower(a.fft, a.scratch, a.power) * (2 << 8) + a.logGain;   // power * 4^e -> log2 + 2e
+
+  // Spectral flux - rectified log-magnitude increase. Each bin is compared with
+  // the loudest of its neighbours last hop, so vibrato and noise wandering
+  // between bins don't count as new energy. Averaged per band, then summed, so
+  // a kick in the few bass bins weighs as much as a hat across the treble
+  int32_t flux = 0, left = ONSET_LOG_FLOOR;
+  for(int b = 0; b < BAND_COUNT; b++){
+    // Background hiss well under this band's peak only adds random flux - clamp it away
+    int32_t floor = a.agcPeak[b] - a.log2Bins[b] - ONSET_FLOOR_BELOW;
+    if(floor < ONSET_LOG_FLOOR) floor = ONSET_LOG_FLOOR;
+    int32_t bandFlux = 0;
+    for(int k = a.bandEdge[b]; k < a.bandEdge[b + 1]; k++){
+      int32_t l = a.power[k] ? (int32_t)fftLog2Q8(a.power[k]) + exp2 : 0;
+      if(l < floor) l = floor;
+      int32_t ref = a.prevLog[k];
+      if(left > ref) ref = left;
+      if(k + 1 < a.binHi && a.prevLog[k + 1] > ref) ref = a.prevLog[k + 1];
+      if(l > ref) bandFlux += l - ref;
+      left = a.prevLog[k];
+      a.prevLog[k] = l;
+    }
+    int bins = a.bandEdge[b + 1] - a.bandEdge[b];
+    if(bins > 0) flux += bandFlux / bins;
+  }
+  if(flux > 0xFFFF) flux = 0xFFFF;
+
+  // Band and overall energy, log2 Q8.8
+  int32_t decay = AGC_DECAY_PER_S * a.hopMs10 / 10000;
+  if(decay < 1) decay = 1;
+  uint64_t total = 0;
+  AudioFeatures& f = a.features;
+  for(int b = 0; b < BAND_COUNT; b++){
+    uint64_t sum = 0;
+    for(int k = a.bandEdge[b]; k < a.bandEdge[b + 1]; k++) sum += a.power[k];
+    total += sum;
+    int32_t l = 0;
+    while(sum >> 32) { sum >>= 2; l += 2 << 8; }
+    l += fftLog2Q8((uint32_t)sum) + exp2;
+    f.band[b] = agcScale(a.agcPeak[b], l, decay);
+  }
+  int32_t lt = 0;
+  while(total >> 32) { total >>= 2; lt += 2 << 8; }
+  lt += fftLog2Q8((uint32_t)total) + exp2;
+  f.level = agcScale(a.agcPeak[BAND_COUNT], lt, decay);
+  bool silent = lt < AGC_SILENCE;
+
+  // Peak-pick the previous hop against the running threshold
+  int32_t thresh = a.fluxMean + ONSET_THRESH_K * a.fluxDev / 2 + ONSET_THRESH_MIN;
+  uint16_t cand = a.fluxPrev[0];
+  uint32_t gapHops = (uint32_t)ONSET_MIN_GAP_MS * 10 / (a.hopMs10 ? a.hopMs10 : 1);
+  f.onset = !silent && cand > thresh && cand > a.fluxPrev[1] && cand >= flux &&
+            f.hop - a.lastOnsetHop > gapHops;
+  if(f.onset) a.lastOnsetHop = f.hop;
+  f.flux = (uint16_t)flux;
+  f.threshold = (uint16_t)(thresh > 0xFFFF ? 0xFFFF : thresh);
+
+  // Running statistics, ~16 hop time constant
+  int32_t dev = flux - a.fluxMean;
+  a.fluxMean += dev / 16;
+  a.fluxDev  += ((dev < 0 ? -dev : dev) - a.fluxDev) / 16;
+  a.fluxPrev[1] = a.fluxPrev[0];
+  a.fluxPrev[0] = (uint16_t)flux;
+  f.hop++;
+}
+
+int analyzerFeed(AudioAnalyzer& a, const int16_t* samples, int count){
+  a.hopReady = false;
+  int need = a.hopLen - a.fill;
+  int take = count < need ? count : need;
+  // The frame holds the last n samples; the newest hop lands at the end
+  memcpy(a.frame + (a.n - a.hopLen) + a.fill, samples, take * sizeof(int16_t));
+  a.fill += take;
+  if(a.fill == a.hopLen) {
+    analyzeHop(a);
+    memmove(a.frame, a.frame + a.hopLen, (a.n - a.hopLen) * sizeof(int16_t));
+    a.fill = 0;
+    a.hopReady = true;
+  }
+  return take;
+}
@@ -0,0 +1,78 @@
+#ifndef ONSET_H
+#define ONSET_H
+
+// ── Spectral-flux Onsets & Band Energies ─────────────────────────────────────
+// Consumes microphone samples in any block size and, once per hop, runs a
+// Hann-windowed fixed-point FFT (fft.h) to produce a small AudioFeatures
+// snapshot: AGC-normalised loudness, bass/mid/treble energy and onsets.
+//
+// Onsets use spectral flux - the summed per-bin INCREASE in log magnitude from
+// one hop to the next - against an adaptive threshold (running mean + spread),
+// peak-picked so each onset fires once. A steady loud signal has no flux, so
+// sheer volume no longer reads as beats; a new note or drum hit does.
+// Hardware-independent - tools/audio_eval.cpp runs the same code on the host.
+
+#include <stdint.h>
+#include "fft.h"
+
+// Analysis covers 40Hz..4.5kHz whatever the sample rate (the decimator's passband, decimate.h)
+static const uint16_t ONSET_MIN_HZ        = 40;
+static const uint16_t ONSET_MAX_HZ        = 4500;
+static const uint16_t ONSET_REF_N         = 512;   // FFT length per 11.6ms at 44.1kHz - log levels are scaled to it
+static const uint16_t BAND_BASS_HZ        = 250;   // Bass: MIN..250, mid: 250..2000, treble: 2000..MAX
+static const uint16_t BAND_MID_HZ         = 2000;
+
+static const int32_t  ONSET_LOG_FLOOR     = 16 << 8;  // Per-bin log2 power floor (mic noise), Q8.8
+static const int32_t  ONSET_FLOOR_BELOW   = 8 << 8;   // ...raised to this far under the band's average bin at its peak
+static const int32_t  ONSET_THRESH_MIN    = 64;       // Flux must beat this (Q8.8 log2 per bin)...
+static const int32_t  ONSET_THRESH_K      = 6;        // ...and mean + K/2 x mean deviation
+static const uint16_t ONSET_MIN_GAP_MS    = 100;      // Refractory time between onsets
+static const int32_t  AGC_RANGE           = 8 << 8;   // Level/bands span this much log2 power (24dB) below the peak
+static const int32_t  AGC_DECAY_PER_S     = 128;      // Peak tracker decay, Q8.8 log2 per second (1.5dB/s)
+static const int32_t  AGC_SILENCE         = 24 << 8;  // Below this total log2 power it's silence
+
+enum AudioBand { BAND_BASS = 0, BAND_MID, BAND_TREBLE, BAND_COUNT };
+
+// What patterns (and the tempo tracker) get from the microphone - one per hop
+struct AudioFeatures {
+  uint16_t level;               // Overall loudness, Q15 against the AGC peak
+  uint16_t band[BAND_COUNT];    // Per-band energy, Q15, each band against its own AGC
+  uint16_t flux;                // Spectral flux of this hop, Q8.8 log2 per bin
+  uint16_t threshold;           // Adaptive threshold it was compared against
+  bool     onset;               // Onset in this hop (peak-picked - marks the previous hop)
+  uint32_t hop;                 // Hops analysed since init
+};
+
+struct AudioAnalyzer {
+  RealFft  fft;
+  uint32_t sampleRate;
+  uint16_t n, hopLen;           // FFT length and hop (hop <= n)
+  uint16_t hopMs10;             // Hop length in 0.1ms units
+  uint16_t binLo, binHi;        // Analysed bins [lo, hi)
+  uint16_t bandEdge[BAND_COUNT + 1];
+  int32_t  log2Bins[BAND_COUNT];  // log2(bins in band), Q8.8
+  int32_t  logGain;             // Q8.8 added to every log power so a shorter FFT reads like ONSET_REF_N
+
+  int16_t  window[FFT_MAX_N];   // Hann, Q15
+  int16_t  frame[FFT_MAX_N];    // Last n input samples
+  int16_t  scratch[FFT_MAX_N];
+  uint16_t fill;                // New samples in the current hop
+  uint32_t power[FFT_MAX_N / 2];
+  int32_t  prevLog[FFT_MAX_N / 2];
+
+  int32_t  fluxMean, fluxDev;   // Running mean / mean deviation of flux, Q8.8
+  uint16_t fluxPrev[2];         // Flux one and two hops back, for peak picking
+  uint32_t lastOnsetHop;
+  int32_t  agcPeak[BAND_COUNT + 1];   // Bands, then overall level (log2 Q8.8)
+
+  AudioFeatures features;
+  bool     hopReady;            // Set by analyzerFeed when features were updated
+};
+
+void analyzerInit(AudioAnalyzer& a, uint32_t sampleRate, uint16_t fftN, uint16_t hop);
+
+// Feed up to count samples; stops early at the end of a hop so the caller can
+// act on each one. Returns samples consumed - call again with the rest.
+int  analyzerFeed(AudioAnalyzer& a, const int16_t* samples, int count);
+
+#endif
@@ -1,12 +1,29 @@
 #include "ota.h"
 #include "networking.h"
 #include "esp_task_wdt.h"
+#include "scheduler.h"
+#include "storage.h"
+#include "meshota.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "version.h"
+#include "delta.h"
+#include "output.h"
+#include <ESPmDNS.h>
 
 // OTA mode state tracking
 static bool otaMode = false;
 static unsigned long otaModeStartTime = 0;
 static const unsigned long OTA_MODE_TIMEOUT = 300000; // 5 minutes
 static bool espnowWasActive = false;
+static const uint32_t OTA_RESULT_DISPLAY_TIME = 3000; // Success/error screen before reboot
+static bool applyWifiDelta();
+
+static void otaRestart(void*) {
+  if(DEBUG_SERIAL) Serial.println("[OTA] Rebooting now...");
+  flushSettings("reboot");
+  ESP.restart();
+}
 
 void enterOTAMode() {
   if (otaMode) return; // Already in OTA mode
@@ -54,9 +71,6 @@ void exitOTAMode() {
   // Restore WiFi power management
   WiFi.setSleep(true);
   
-  // Wait before reinitializing ESP-NOW to avoid conflicts
-  delay(500);
-  
   if(DEBUG_SERIAL) Serial.println("[OTA] Mode exited - systems will reinitialize");
 }
 
@@ -74,8 +88,11 @@ void initOTA(){
   }
   
   // Only initialize OTA if WiFi is connected
+  // loop() calls this every pass until WiFi is up - say so once, not every pass
   if (WiFi.status() != WL_CONNECTED) {
-    if(DEBUG_SERIAL) Serial.println("OTA disabled - no WiFi connection");
+    static bool reported = false;
+    if(DEBUG_SERIAL && !reported) Serial.println("OTA disabled - no WiFi connection");
+    reported = true;
     return;
   }
   
@@ -89,9 +106,15 @@ void initOTA(){
   // Set port (default 3232 is fine for most cases)
   ArduinoOTA.setPort(3232);
   
+  // We reboot ourselves from a timer so the result screen stays up without blocking
+  ArduinoOTA.setRebootOnSuccess(false);
+  
   setOTACallbacks();
   ArduinoOTA.begin();
   
+  // Advertise the build we run - deploy_nodes.sh picks the delta base from it
+  MDNS.addServiceTxt("arduino", "tcp", "fw", FIRMWARE_VERSION);
+  
   // Mark as initialized
   otaInitialized = true;
   
@@ -112,6 +135,9 @@ void setOTACallbacks(){
     
     if(DEBUG_SERIAL) Serial.println("OTA Start updating " + type);
     
+    // Unsaved settings go to flash before the update owns it
+    flushSettings("ota");
+    
     // ESP-NOW suspension is now controlled manually via serial commands
     // Use deploy script: echo "SUSPEND_ESPNOW" > /dev/ttyACM0 before OTA
     
@@ -120,14 +146,14 @@ void setOTACallbacks(){
     WiFi.mode(WIFI_STA); // Ensure we stay in STA mode for OTA
     
     // Turn off all LEDs to reduce power consumption during upload
-    fill_solid(leds, NUM_LEDS, CRGB::Black);
-    FastLED.show();
+    fill_solid(leds, numLeds, CRGB::Black);
+    showLeds();
     
     // Show OTA status on LED strip - solid blue
-    for(int i = 0; i < NUM_LEDS; i += 10) {
+    for(int i = 0; i < numLeds; i += 10) {
       leds[i] = CRGB::Blue;
     }
-    FastLED.show();
+    showLeds();
     
     // Show OTA status on LCD
     canvas.fillSprite(TFT_BLACK);
@@ -145,11 +171,30 @@ void setOTACallbacks(){
   });
 
   ArduinoOTA.onEnd([]() {
+    // A patch uploaded as a filesystem image - rebuild the new firmware from it
+    if(ArduinoOTA.getCommand() == U_SPIFFS && !applyWifiDelta()) {
+      if(DEBUG_SERIAL) Serial.println("[OTA] Delta not applied - keeping the current firmware");
+      fill_solid(leds, numLeds, CRGB::Red);
+      showLeds();
+      canvas.fillSprite(TFT_BLACK);
+      canvas.fillRect(0, 0, M5.Lcd.width(), 40, TFT_RED);
+      canvas.setTextSize(2);
+      canvas.setTextColor(TFT_WHITE);
+      canvas.setCursor(10, 10);
+      canvas.print("DELTA FAILED");
+      canvas.setTextSize(1);
+      canvas.setCursor(10, 50);
+      canvas.print("Send the full image");
+      canvas.pushSprite(0, 0);
+      otaSuspended = true;
+      timerOnce(OTA_RESULT_DISPLAY_TIME, otaRestart);
+      return;
+    }
     if(DEBUG_SERIAL) Serial.println("[OTA] Update completed successfully!");
     
     // Success indication - solid green
-    fill_solid(leds, NUM_LEDS, CRGB::Green);
-    FastLED.show();
+    fill_solid(leds, numLeds, CRGB::Green);
+    showLeds();
     
     // Show success on LCD
     canvas.fillSprite(TFT_BLACK);
@@ -168,12 +213,13 @@ void setOTACallbacks(){
     // ESP-NOW resumption is now controlled manually via serial commands  
     // Use deploy script: echo "RESUME_ESPNOW" > /dev/ttyACM0 after OTA
     
-    delay(3000); // Show success for 3 seconds before reboot
-    if(DEBUG_SERIAL) Serial.println("[OTA] Rebooting now...");
-    // ESP will automatically restart after OTA completion
+    // Show success for 3 seconds before reboot - keep the mesh from drawing over it
+    otaSuspended = true;
+    timerOnce(OTA_RESULT_DISPLAY_TIME, otaRestart);
   });
 
   ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
+    feedWatchdog();   // The whole upload runs inside handleOTA()
     static unsigned long lastUpdate = 0;
     unsigned long now = millis();
     
@@ -240,8 +286,8 @@ void setOTACallbacks(){
     }
     
     // Error indication - solid red
-    fill_solid(leds, NUM_LEDS, CRGB::Red);
-    FastLED.show();
+    fill_solid(leds, numLeds, CRGB::Red);
+    showLeds();
     
     // Show error on LCD
     canvas.fillSprite(TFT_BLACK);
@@ -262,14 +308,13 @@ void setOTACallbacks(){
     // ESP-NOW resumption is now controlled manually via serial commands
     // Use deploy script: echo "RESUME_ESPNOW" > /dev/ttyACM0 after OTA failure
     
-    delay(3000); // Show error for 3 seconds
-    
     // Exit OTA mode before restart to ensure clean recovery
     exitOTAMode();
-    delay(500);
     
-    if(DEBUG_SERIAL) Serial.println("[OTA] Restarting after error...");
-    ESP.restart();
+    // Show error for 3 seconds, then restart
+    if(DEBUG_SERIAL) Serial.println("[OTA] Restarting after error in 3s...");
+    otaSuspended = true;
+    timerOnce(OTA_RESULT_DISPLAY_TIME, otaRestart);
   });
 }
 
@@ -285,4 +330,416 @@ void handleOTA(){
   if (WiFi.status() == WL_CONNECTED) {
     ArduinoOTA.handle();
   }
-}
\ No newline at end of file
+}
+
+// ── Firmware Images ───────────────────────────────────────────────────────────
+
+// SHA-256 of the first size bytes of a partition, 1KB at a time
+static bool hashPartition(const esp_partition_t* part, uint32_t size, uint8_t sha[SHA256_LEN]){
+  static uint8_t block[1024];
+  Sha256 h;
+  sha256Init(h);
+  for(uint32_t off = 0; off < size; off += sizeof(block)) {
+    uint32_t n = size - off < sizeof(block) ? size - off : sizeof(block);
+    if(esp_partition_read(part, off, block, n) != ESP_OK) return false;
+    sha256Update(h, block, n);
+    if((off & 0xFFFF) == 0) { feedWatchdog(); yield(); }
+  }
+  sha256Final(h, sha);
+  return true;
+}
+
+// Identifies the build we run for deltas - hashed once, on first use
+static const uint8_t* runningImageSha(){
+  static uint8_t sha[SHA256_LEN];
+  static bool known = false;
+  if(!known) {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if(!running || !hashPartition(running, ESP.getSketchSize(), sha)) return nullptr;
+    known = true;
+  }
+  return sha;
+}
+
+// Patches are staged in the data partition: WiFi uploads land there as a
+// filesystem image (espota.py -s), mesh receivers write them there, and a seed
+// broadcasts from there. The sketch keeps no files of its own.
+static const esp_partition_t* stagingPartition(){
+  const esp_partition_t* p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+  if(!p) p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, nullptr);
+  return p;
+}
+
+static bool readStagedHeader(const esp_partition_t* stage, DeltaHeader& h){
+  uint8_t buf[DELTA_HEADER_LEN];
+  return stage && esp_partition_read(stage, 0, buf, sizeof(buf)) == ESP_OK
+      && deltaHeaderDecode(buf, sizeof(buf), h) && h.patchSize <= stage->size;
+}
+
+// ── Delta Patches ─────────────────────────────────────────────────────────────
+// Rebuild the new image from the running one plus the staged patch (delta.h),
+// streaming into the inactive partition. Blocks for a few seconds - about as
+// long as writing a full image, minus the transfer.
+
+struct DeltaIo {
+  const esp_partition_t* running;
+  esp_ota_handle_t       handle;
+};
+
+static bool deltaReadRunning(void* ctx, uint32_t offset, uint8_t* buf, uint32_t len){
+  return esp_partition_read(((DeltaIo*)ctx)->running, offset, buf, len) == ESP_OK;
+}
+
+static bool deltaWriteTarget(void* ctx, const uint8_t* buf, uint32_t len){
+  return esp_ota_write(((DeltaIo*)ctx)->handle, buf, len) == ESP_OK;
+}
+
+// Returns the partition holding the rebuilt, validated image - or null
+static const esp_partition_t* applyStagedDelta(){
+  const esp_partition_t* stage = stagingPartition();
+  DeltaHeader h;
+  if(!readStagedHeader(stage, h)) return nullptr;
+  const uint8_t* base = runningImageSha();
+  if(!base || h.oldSize != ESP.getSketchSize() || memcmp(base, h.oldSha, SHA256_LEN) != 0) {
+    if(DEBUG_SERIAL) Serial.println("[DELTA] Patch is for a different build - send the full image");
+    return nullptr;
+  }
+  const esp_partition_t* target = esp_ota_get_next_update_partition(nullptr);
+  if(!target || h.newSize > target->size) return nullptr;
+  
+  uint32_t t0 = millis();
+  static DeltaApply apply;   // ~1.4KB - kept off the loop task's stack
+  DeltaIo io = {esp_ota_get_running_partition(), 0};
+  if(esp_ota_begin(target, h.newSize, &io.handle) != ESP_OK) return nullptr;
+  deltaApplyBegin(apply, deltaReadRunning, deltaWriteTarget, &io);
+  
+  static uint8_t block[1024];
+  DeltaResult r = DELTA_MORE;
+  for(uint32_t off = 0; off < h.patchSize && r == DELTA_MORE; off += sizeof(block)) {
+    uint32_t n = h.patchSize - off < sizeof(block) ? h.patchSize - off : sizeof(block);
+    if(esp_partition_read(stage, off, block, n) != ESP_OK) break;
+    r = deltaApplyFeed(apply, block, n);
+    feedWatchdog();
+    yield();
+  }
+  if(r != DELTA_DONE) {
+    if(DEBUG_SERIAL) Serial.printf("[DELTA] Apply failed: %s\n", r == DELTA_ERROR ? apply.error : "patch truncated");
+    esp_ota_abort(io.handle);
+    return nullptr;
+  }
+  esp_err_t err = esp_ota_end(io.handle);
+  if(err != ESP_OK) {
+    if(DEBUG_SERIAL) Serial.printf("[DELTA] Rebuilt image rejected: %s\n", esp_err_to_name(err));
+    return nullptr;
+  }
+  if(DEBUG_SERIAL) Serial.printf("[DELTA] %u-byte patch rebuilt a %u-byte image in %ums\n",
+    h.patchSize, h.newSize, millis() - t0);
+  return target;
+}
+
+// WiFi path: ArduinoOTA wrote a filesystem upload into the staging partition -
+// if it is a patch, rebuild and boot the new image
+static bool applyWifiDelta(){
+  DeltaHeader h;
+  if(!readStagedHeader(stagingPartition(), h)) return false;
+  
+  canvas.fillSprite(TFT_BLACK);
+  canvas.fillRect(0, 0, M5.Lcd.width(), 40, TFT_BLUE);
+  canvas.setTextSize(2);
+  canvas.setTextColor(TFT_WHITE);
+  canvas.setCursor(10, 10);
+  canvas.print("DELTA");
+  canvas.setTextSize(1);
+  canvas.setCursor(10, 50);
+  canvas.printf("Rebuilding %uKB image", h.newSize / 1024);
+  canvas.pushSprite(0, 0);
+  
+  const esp_partition_t* target = applyStagedDelta();
+  return target && esp_ota_set_boot_partition(target) == ESP_OK;
+}
+
+// ── Mesh OTA ──────────────────────────────────────────────────────────────────
+// Firmware distribution over ESP-NOW (meshota.h). The seed broadcasts the image
+// it is running - flash the new build to one node over USB or WiFi, then send
+// it "MESHOTA" - and every other node writes it straight into its inactive OTA
+// partition. If the seed holds a staged patch that produced the build it runs,
+// it broadcasts the patch instead; receivers stage it and rebuild locally.
+// Single hop: relays don't forward OTA packets.
+
+static OtaReceiver meshRx;
+static OtaSender   meshTx;
+static esp_ota_handle_t       meshHandle = 0;
+static bool                   meshReady  = false;     // Receiver: destination prepared for writes
+static const esp_partition_t* meshPart   = nullptr;   // Receiver: partition being written
+static const esp_partition_t* meshBoot   = nullptr;   // Receiver: verified image to switch to
+static const esp_partition_t* meshSrc    = nullptr;   // Seed: partition being broadcast
+static TimerId  meshTxTimer = TIMER_NONE;
+static uint32_t meshLedMs = 0;
+static const uint32_t MESH_OTA_LED_MS = 100;
+
+static void meshOtaSend(uint8_t kind, uint16_t frameId, uint8_t chunkIdx, const uint8_t* payload, uint16_t len){
+  uint8_t buf[PROTO_MAX_PACKET];
+  int n = protoBuildV2(buf, kind, 0, myToken, frameId, chunkIdx, 0, micros(), 0, payload, len);
+  esp_now_send(broadcastAddress, buf, n);
+}
+
+static void meshOtaTxTick(void*){
+  uint8_t payload[4 + OTA_CHUNK_BYTES];
+  uint16_t idx = 0;
+  uint32_t now = millis();
+  switch(otaTxNext(meshTx, now, &idx)) {
+    case OTA_TX_OFFER:
+      meshOtaSend(PKT_OTA_OFFER, 0, 0, payload, otaOfferEncode(meshTx.offer, payload));
+      break;
+    case OTA_TX_DATA: {
+      uint16_t len = otaChunkLen(meshTx.offer, idx);
+      memcpy(payload, &meshTx.offer.session, 4);
+      if(esp_partition_read(meshSrc, otaChunkOffset(meshTx.offer, idx), payload + 4, len) != ESP_OK) break;
+      meshOtaSend(PKT_OTA_DATA, idx, meshTx.pass, payload, 4 + len);
+      break;
+    }
+    case OTA_TX_COMMIT:
+      memcpy(payload, &meshTx.offer.session, 4);
+      meshOtaSend(PKT_OTA_COMMIT, 0, 0, payload, 4);
+      break;
+    case OTA_TX_DONE: {
+      timerCancel(meshTxTimer);
+      meshTxTimer = TIMER_NONE;
+      uint8_t fresh, done, failed, needFull;
+      otaTxPeerCounts(meshTx, now, &fresh, &done, &failed, &needFull);
+      if(DEBUG_SERIAL) {
+        Serial.printf("[MESHOTA] Seed done in %us: %u nodes, %u ready, %u failed\n",
+          (now - meshTx.startMs) / 1000, fresh, done, failed - needFull);
+        if(needFull) Serial.printf("[MESHOTA] %u nodes run another build - seed again with MESHOTA FULL\n", needFull);
+        Serial.printf("[MESHOTA] offers=%u data=%u repairs=%u (suppressed %u) status=%u\n",
+          meshTx.offersSent, meshTx.dataSent, meshTx.repairsSent, meshTx.repairsSuppressed, meshTx.statusHeard);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+bool meshOtaStartSeed(bool full){
+  if(meshTx.active || otaRxActive(meshRx)) {
+    if(DEBUG_SERIAL) Serial.println("[MESHOTA] Transfer already in progress");
+    return false;
+  }
+  uint32_t t0 = millis();
+  const uint8_t* running = runningImageSha();
+  if(!running) {
+    if(DEBUG_SERIAL) Serial.println("[MESHOTA] Running image not readable - can't seed");
+    return false;
+  }
+  
+  // The staged patch made this build - send it instead of the whole image
+  OtaOffer offer;
+  DeltaHeader h;
+  const esp_partition_t* stage = stagingPartition();
+  uint8_t sha[SHA256_LEN];
+  if(!full && readStagedHeader(stage, h) && memcmp(h.newSha, running, SHA256_LEN) == 0
+     && h.patchSize <= (uint32_t)OTA_MAX_CHUNKS * OTA_CHUNK_BYTES && hashPartition(stage, h.patchSize, sha)) {
+    meshSrc = stage;
+    otaOfferInit(offer, esp_random(), h.patchSize, FIRMWARE_VERSION, sha, h.oldSha);
+  } else {
+    uint32_t size = ESP.getSketchSize();
+    if(size > (uint32_t)OTA_MAX_CHUNKS * OTA_CHUNK_BYTES) return false;
+    meshSrc = esp_ota_get_running_partition();
+    otaOfferInit(offer, esp_random(), size, FIRMWARE_VERSION, running);
+  }
+  
+  otaTxStart(meshTx, offer, millis());
+  meshTxTimer = timerEvery(OTA_TX_INTERVAL_MS, meshOtaTxTick);
+  if(DEBUG_SERIAL) {
+    Serial.printf("[MESHOTA] Seeding v%s %s: %u bytes, %u chunks (prepared in %ums), session %08X\n",
+      FIRMWARE_VERSION, offer.format == OTA_FORMAT_DELTA ? "delta" : "full image",
+      offer.imageSize, offer.chunkCount, millis() - t0, offer.session);
+  }
+  return true;
+}
+
+static void meshRxClose(){
+  if(meshHandle) esp_ota_abort(meshHandle);
+  meshHandle = 0;
+  meshReady = false;
+}
+
+// Erase the destination for the offered bytes: the inactive partition through
+// esp_ota_begin for a full image, the staging area for a patch
+static bool meshRxPrepare(){
+  meshRxClose();
+  feedWatchdog();   // The erase is the longest single block the loop task does
+  esp_err_t err;
+  if(meshRx.offer.format == OTA_FORMAT_DELTA) {
+    err = esp_partition_erase_range(meshPart, 0, (meshRx.offer.imageSize + 4095) & ~4095u);
+  } else {
+    err = esp_ota_begin(meshPart, meshRx.offer.imageSize, &meshHandle);
+    if(err != ESP_OK) meshHandle = 0;
+  }
+  if(err != ESP_OK) {
+    if(DEBUG_SERIAL) Serial.printf("[MESHOTA] Can't prepare the partition: %s\n", esp_err_to_name(err));
+    otaRxAbort(meshRx);
+    return false;
+  }
+  meshReady = true;
+  return true;
+}
+
+static bool meshRxWrite(uint32_t off, const uint8_t* data, uint16_t len){
+  if(meshRx.offer.format == OTA_FORMAT_DELTA) return esp_partition_write(meshPart, off, data, len) == ESP_OK;
+  return esp_ota_write_with_offset(meshHandle, data, len, off) == ESP_OK;
+}
+
+static void meshRxFinish(uint32_t now){
+  // Tell the seed we have everything before going quiet to hash (and rebuild)
+  OtaStatus st;
+  uint8_t payload[OTA_STATUS_LEN];
+  otaRxStatusFill(meshRx, st);
+  meshOtaSend(PKT_OTA_STATUS, 0, 0, payload, otaStatusEncode(st, payload));
+  
+  uint8_t sha[SHA256_LEN];
+  if(!hashPartition(meshPart, meshRx.offer.imageSize, sha)) memset(sha, 0, sizeof(sha));
+  if(otaRxVerify(meshRx, sha, now)) {
+    if(meshRx.offer.format == OTA_FORMAT_DELTA) {
+      meshReady = false;
+      meshBoot = applyStagedDelta();
+    } else {
+      esp_err_t err = esp_ota_end(meshHandle);
+      meshHandle = 0;
+      meshReady = false;
+      meshBoot = err == ESP_OK ? meshPart : nullptr;
+      if(err != ESP_OK && DEBUG_SERIAL) Serial.printf("[MESHOTA] Image rejected: %s\n", esp_err_to_name(err));
+    }
+    // Hash matched but no bootable image came of it - nothing more to get from this session
+    if(!meshBoot) {
+      meshRx.state = OTA_RX_FAILED;
+      return;
+    }
+    if(DEBUG_SERIAL) Serial.printf("[MESHOTA] v%s verified - waiting for commit\n", meshRx.offer.version);
+  } else if(meshRx.state == OTA_RX_RECEIVING) {
+    if(DEBUG_SERIAL) Serial.println("[MESHOTA] SHA-256 mismatch - receiving again");
+    meshRxPrepare();
+  } else {
+    if(DEBUG_SERIAL) Serial.println("[MESHOTA] SHA-256 mismatch twice - giving up");
+    meshRxClose();
+  }
+}
+
+static void meshRxSwitch(const char* why){
+  esp_err_t err = esp_ota_set_boot_partition(meshBoot);
+  if(err != ESP_OK) {
+    if(DEBUG_SERIAL) Serial.printf("[MESHOTA] Can't boot the new image: %s\n", esp_err_to_name(err));
+    otaRxAbort(meshRx);
+    return;
+  }
+  if(DEBUG_SERIAL) Serial.printf("[MESHOTA] Switching to v%s (%s) - rebooting\n", meshRx.offer.version, why);
+  fill_solid(leds, numLeds, CRGB::Green);
+  showLeds();
+  flushSettings("mesh ota");
+  ESP.restart();
+}
+
+void meshOtaHandlePacket(const PacketInfo& pkt, uint32_t now){
+  if(pkt.token == myToken) return;
+  
+  if(pkt.kind == PKT_OTA_STATUS) {
+    OtaStatus st;
+    if(meshTx.active && otaStatusDecode(pkt.payload, pkt.payloadLen, st)) otaTxNoteStatus(meshTx, pkt.token, st, now);
+    return;
+  }
+  if(meshTx.active) return;   // Seeding - we're the source, not a receiver
+  
+  if(pkt.kind == PKT_OTA_OFFER) {
+    OtaOffer offer;
+    if(!otaOfferDecode(pkt.payload, pkt.payloadLen, offer)) return;
+    bool delta = offer.format == OTA_FORMAT_DELTA;
+    // Only hash our own image when a new delta session needs it
+    bool fresh = !otaRxActive(meshRx) || offer.session != meshRx.offer.session;
+    const esp_partition_t* part = delta ? stagingPartition() : esp_ota_get_next_update_partition(nullptr);
+    OtaOfferAction action = otaRxOffer(meshRx, offer, part ? part->size : 0, FIRMWARE_VERSION, now,
+                                       delta && fresh ? runningImageSha() : nullptr);
+    if(action == OTA_OFFER_START) {
+      if(DEBUG_SERIAL) Serial.printf("[MESHOTA] Receiving v%s from 0x%06X: %u-byte %s in %u chunks\n",
+        offer.version, pkt.token, offer.imageSize, delta ? "patch" : "image", offer.chunkCount);
+      meshPart = part;
+      meshRxPrepare();
+    } else if(fresh && meshRx.state == OTA_RX_NEED_FULL && DEBUG_SERIAL) {
+      Serial.printf("[MESHOTA] v%s offered as a delta against another build - skipping\n", offer.version);
+    }
+    return;
+  }
+  
+  if(pkt.kind == PKT_OTA_DATA) {
+    if(pkt.payloadLen < 4 || !meshReady) return;
+    uint32_t session;
+    memcpy(&session, pkt.payload, 4);
+    uint16_t idx = pkt.frameId, len = pkt.payloadLen - 4;
+    if(len != otaChunkLen(meshRx.offer, idx) || !otaRxChunk(meshRx, session, idx, len, now)) return;
+    
+    // Read every chunk back - a bad write is simply requested again
+    uint32_t off = otaChunkOffset(meshRx.offer, idx);
+    uint8_t check[OTA_CHUNK_BYTES];
+    if(!meshRxWrite(off, pkt.payload + 4, len)
+       || esp_partition_read(meshPart, off, check, len) != ESP_OK
+       || memcmp(check, pkt.payload + 4, len) != 0) {
+      otaRxChunkBad(meshRx, idx);
+    }
+    return;
+  }
+  
+  if(pkt.kind == PKT_OTA_COMMIT) {
+    uint32_t session;
+    if(pkt.payloadLen < 4) return;
+    memcpy(&session, pkt.payload, 4);
+    if(otaRxCommit(meshRx, session, now)) meshRxSwitch("commit");
+  }
+}
+
+// Progress on the strip: blue fill while receiving (white while seeding), green once verified
+static void meshOtaShowProgress(uint32_t now){
+  if(now - meshLedMs < MESH_OTA_LED_MS) return;
+  meshLedMs = now;
+  uint32_t done, total;
+  CRGB color;
+  if(meshTx.active) {
+    done = meshTx.nextChunk; total = meshTx.offer.chunkCount; color = CRGB::White;
+  } else {
+    done = meshRx.heldCount; total = meshRx.offer.chunkCount;
+    color = meshRx.state == OTA_RX_VERIFIED ? CRGB::Green : meshRx.state == OTA_RX_FAILED ? CRGB::Red : CRGB::Blue;
+  }
+  int lit = total ? (int)((uint64_t)done * numLeds / total) : 0;
+  fill_solid(leds, numLeds, CRGB::Black);
+  fill_solid(leds, lit, color);
+  FastLED.setBrightness(globalBrightnessScale);
+  showLeds();
+}
+
+bool meshOtaActive(){
+  return meshTx.active || meshRx.state == OTA_RX_RECEIVING || meshRx.state == OTA_RX_VERIFIED;
+}
+
+bool meshOtaService(uint32_t now){
+  static bool initialised = false;
+  if(!initialised) { otaRxInit(meshRx, myToken); initialised = true; }
+  
+  if(otaRxActive(meshRx) && !meshTx.active) {
+    if(otaRxComplete(meshRx)) meshRxFinish(now);
+    OtaStatus st;
+    if(otaRxStatusDue(meshRx, st, now)) {
+      uint8_t payload[OTA_STATUS_LEN];
+      meshOtaSend(PKT_OTA_STATUS, 0, 0, payload, otaStatusEncode(st, payload));
+    }
+    if(otaRxShouldSelfCommit(meshRx, now)) meshRxSwitch("seed gone quiet");
+    if(otaRxTimedOut(meshRx, now)) {
+      if(DEBUG_SERIAL) Serial.printf("[MESHOTA] Seed silent - abandoning at %u/%u chunks\n",
+        meshRx.heldCount, meshRx.offer.chunkCount);
+      meshRxClose();
+      otaRxAbort(meshRx);
+    }
+  }
+  
+  if(!meshOtaActive()) return false;
+  meshOtaShowProgress(now);
+  return true;
+}
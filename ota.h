@@ -3,10 +3,17 @@
 
 #include "config.h"
 #include <ArduinoOTA.h>
+#include "protocol.h"
 
 // ── OTA Functions ─────────────────────────────────────────────────────────────
 void initOTA();
 void handleOTA();
 void setOTACallbacks();
 
+// ── Mesh OTA (meshota.h) ──────────────────────────────────────────────────────
+bool meshOtaStartSeed(bool full);                           // Broadcast the running build (its staged patch unless full)
+void meshOtaHandlePacket(const PacketInfo& pkt, uint32_t now);
+bool meshOtaService(uint32_t now);                          // True while a transfer owns the radio + LEDs
+bool meshOtaActive();
+
 #endif
\ No newline at end of file
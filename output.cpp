@@ -0,0 +1,71 @@
+#include "output.h"
+
+// STRIPS fitted to the runtime strip length. Strips fed in logical order
+// point straight into leds; any other layout gets a physical buffer that
+// showLeds() fills first.
+static StripConfig strips[STRIP_MAX_CHANNELS];
+static uint8_t     stripCount   = 0;
+static bool        directLayout = true;
+static CRGB*       stripLeds    = leds;
+
+template<uint8_t PIN> static void addStrip(CRGB* buf, uint16_t count){
+  FastLED.addLeds<CHIPSET, PIN, COLOR_ORDER>(buf, count).setCorrection(TypicalLEDStrip);
+}
+
+// FastLED takes the pin as a template argument - one case per usable pin
+// (Grove G32/G33, hat G26/G25/G0)
+static bool addStripOnPin(uint8_t pin, CRGB* buf, uint16_t count){
+  switch(pin) {
+    case 33: if(buf) addStrip<33>(buf, count); return true;
+    case 32: if(buf) addStrip<32>(buf, count); return true;
+    case 26: if(buf) addStrip<26>(buf, count); return true;
+    case 25: if(buf) addStrip<25>(buf, count); return true;
+    case 0:  if(buf) addStrip<0>(buf, count);  return true;
+    default: return false;
+  }
+}
+
+void initLeds(){
+  // Check every pin (null buffer) before registering any strip
+  bool valid = stripLayoutFit(STRIPS, STRIP_COUNT, numLeds, strips);
+  for(uint8_t i = 0; i < STRIP_COUNT && valid; i++) {
+    valid = addStripOnPin(strips[i].pin, nullptr, 0);
+  }
+  if(valid) {
+    stripCount = STRIP_COUNT;
+    directLayout = stripLayoutDirect(strips, stripCount);
+    if(!directLayout) stripLeds = new CRGB[numLeds];
+    for(uint8_t i = 0; i < stripCount; i++) {
+      addStripOnPin(strips[i].pin, stripLeds + stripPhysicalStart(strips, i), strips[i].count);
+    }
+  } else {
+    // A bad table mustn't leave the node dark - everything on the first pin
+    if(DEBUG_SERIAL) Serial.printf("LEDS: STRIPS doesn't fit %u pixels on usable pins - one strip on LED_PIN\n", numLeds);
+    strips[0] = {LED_PIN, 0, numLeds, false};
+    stripCount = 1;
+    addStrip<LED_PIN>(leds, numLeds);
+  }
+  fill_solid(leds, numLeds, CRGB::Black);
+  showLeds();
+  if(DEBUG_SERIAL) printLedConfig();
+}
+
+void showLeds(){
+  if(!directLayout) stripRemap(strips, stripCount, (const uint8_t*)leds, (uint8_t*)stripLeds);
+  FastLED.show();
+}
+
+uint32_t showLedsUs(){
+  return stripFrameUs(strips, stripCount);
+}
+
+void printLedConfig(){
+  uint32_t frameUs = stripFrameUs(strips, stripCount);
+  Serial.printf("LEDS: %u pixels (%u-%u, LEDS <n> to change) on %u strip(s)%s, %.1fms per frame (%.1fms as one strip), %u fps max\n",
+    numLeds, MIN_LEDS, MAX_LEDS, stripCount, directLayout ? "" : " (remapped)",
+    frameUs / 1000.0f, stripWireUs(numLeds) / 1000.0f, 1000000 / frameUs);
+  for(uint8_t i = 0; i < stripCount; i++) {
+    Serial.printf("  strip %u: pin %u, pixels %u-%u%s\n", i, strips[i].pin, strips[i].logicalStart,
+      strips[i].logicalStart + strips[i].count - 1, strips[i].reversed ? " reversed" : "");
+  }
+}
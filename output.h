@@ -0,0 +1,12 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "config.h"
+
+// ── LED Output ────────────────────────────────────────────────────────────────
+void initLeds();   // Register every strip in STRIPS with FastLED and blank them
+void showLeds();   // FastLED.show() for the logical leds buffer, remapped to the strips when needed
+uint32_t showLedsUs();   // Wire time of one showLeds() - the slowest strip
+void printLedConfig();
+
+#endif
@@ -1,7 +1,10 @@
 #include "patterns.h"
+#include "audio.h"
+#include "arena.h"
+#include <new>
 
 // ── Names ─────────────────────────────────────────────────────────────────────
-const char* STYLE_NAMES[42] = {
+const char* STYLE_NAMES[] = {
   "Rainbow","Chase","Juggle","Rainbow+Glitter",
   "Confetti","BPM","Fire","Color Wheel","Random",
   "Pulse Wave","Meteor Shower","Color Spiral","Plasma Field",
@@ -15,44 +18,239 @@ const char* STYLE_NAMES[42] = {
   "Heartbeat","Aurora Boreal","Matrix Code","Crystal Cave",
   "Lava Flow","Waveform","Rainbow2","Confetti2"
 };
+static_assert(sizeof(STYLE_NAMES) / sizeof(STYLE_NAMES[0]) == PATTERN_COUNT, "one name per pattern");
+
+// ── Pattern State ─────────────────────────────────────────────────────────────
+// What each pattern carries between frames. Default member initialisers are
+// its starting state; patternState<T>() hands it out from the arena.
+struct HueState          { uint8_t hue; };   // Patterns that only turn a hue or phase
+struct MoveState         { uint32_t lastMove; };
+struct ChaseState        { uint32_t last; uint16_t pos; uint8_t hue; };
+struct FireState         { uint8_t heat[MAX_LEDS/2]; };
+struct PulseWaveState    { uint16_t center = numLeds/2; uint8_t hue; uint8_t wave; };
+struct MeteorState {
+  struct Meteor { int16_t pos; uint8_t hue; uint8_t size; int8_t speed; };
+  Meteor meteors[8];
+  bool   initialized;
+};
+struct ColorSpiralState  { uint16_t spiral_pos; uint8_t hue_offset; };
+struct PlasmaFieldState {
+  uint16_t time_counter;
+  uint8_t  plasma_hue;
+  uint8_t  wave_offset1 = 0, wave_offset2 = 85, wave_offset3 = 170;
+  uint8_t  drift_counter;
+};
+struct SparkleStormState { uint8_t storm_intensity; uint8_t base_hue; };
+struct AuroraWavesState  { uint16_t wave1_pos, wave2_pos, wave3_pos; uint8_t aurora_hue = 96; };
+struct OrganicFlowState {
+  uint16_t flow_time;
+  uint8_t  base_hue;
+  float    node_positions[8];
+  float    node_velocities[8];
+  uint8_t  node_hues[8];
+  bool     initialized;
+};
+struct WaveCollapseState {
+  uint16_t wave_time;
+  uint8_t  collapse_hue = 160;
+  int16_t  collapse_center = numLeds / 2;
+  uint8_t  collapse_phase;
+  uint16_t wave_radius;
+};
+static const float DRIFT_VELOCITY_STEP = 1.0f / 500;   // Every velocity Color Drift reaches is a multiple
+struct ColorDriftState {
+  uint8_t  drift_hues[MAX_LEDS];
+  int16_t  drift_velocities[MAX_LEDS];   // DRIFT_VELOCITY_STEPs - exact, at half the RAM of floats
+  bool     initialized;
+  uint16_t drift_time;
+};
+struct LiquidRainbowState {
+  uint16_t liquid_time;
+  float    wave_phases[5] = {0, 85, 170, 42, 213};
+  float    wave_speeds[5] = {1.0f, 1.3f, 0.7f, 1.7f, 0.9f};
+};
+struct SineBreathState   { uint16_t breath_time; uint8_t breath_hue = 64; uint8_t hue_drift_timer; };
+struct FractalNoiseState { uint16_t noise_time; uint8_t noise_hue_base; float noise_scale = 0.1f; };
+struct RainbowStrobeState{ uint8_t hue; uint8_t strobe_counter; bool strobe_on = true; };
+struct RippleState       { uint16_t center = numLeds / 2; uint8_t step; };
+struct HeartbeatState    { uint32_t lastBeat; bool inBeat; };
+struct MatrixCodeState {
+  uint16_t streams[10] = {255, 255, 255, 255, 255, 255, 255, 255, 255, 255};   // 0-254 falling, 255 idle
+  uint32_t lastUpdate;
+};
+
+// ── Pattern Registry ──────────────────────────────────────────────────────────
+// Indexed by styleIdx. stateSize is the state the pattern asks patternState()
+// for (0 = none) - it sizes the arena.
+struct PatternDef {
+  void     (*fn)(uint8_t sp);
+  uint16_t stateSize;
+};
+
+static constexpr PatternDef PATTERNS[PATTERN_COUNT] = {
+  {styleRainbow,        sizeof(HueState)},
+  {styleChase,          sizeof(ChaseState)},
+  {styleJuggle,         sizeof(HueState)},
+  {styleRainbowGlitter, sizeof(HueState)},          // styleRainbow's
+  {styleConfetti,       sizeof(HueState)},
+  {styleBPM,            sizeof(HueState)},
+  {styleFire,           sizeof(FireState)},
+  {styleColorWheel,     sizeof(HueState)},
+  {styleRandom,         0},
+  {stylePulseWave,      sizeof(PulseWaveState)},
+  {styleMeteorShower,   sizeof(MeteorState)},
+  {styleColorSpiral,    sizeof(ColorSpiralState)},
+  {stylePlasmaField,    sizeof(PlasmaFieldState)},
+  {styleSparkleStorm,   sizeof(SparkleStormState)},
+  {styleAuroraWaves,    sizeof(AuroraWavesState)},
+  {styleOrganicFlow,    sizeof(OrganicFlowState)},
+  {styleWaveCollapse,   sizeof(WaveCollapseState)},
+  {styleColorDrift,     sizeof(ColorDriftState)},
+  {styleLiquidRainbow,  sizeof(LiquidRainbowState)},
+  {styleSineBreath,     sizeof(SineBreathState)},
+  {styleFractalNoise,   sizeof(FractalNoiseState)},
+  {styleRainbowStrobe,  sizeof(RainbowStrobeState)},
+  // NEW PATTERNS (22-41)
+  {styleTwinkleStars,   0},
+  {styleRainbowRipples, sizeof(RippleState)},
+  {styleDNAHelix,       0},
+  {styleNeonPulse,      sizeof(HueState)},
+  {styleDigitalRain,    sizeof(MoveState)},
+  {stylePlasmaBalls,    0},
+  {styleLightningStorm, 0},
+  {styleKaleidoscope,   sizeof(HueState)},
+  {styleCandleFlicker,  0},
+  {styleColorDrips,     sizeof(MoveState)},
+  {styleGalaxySpiral,   0},
+  {stylePrism,          sizeof(HueState)},
+  {styleHeartbeat,      sizeof(HeartbeatState)},
+  {styleAuroraBoreal,   0},
+  {styleMatrixCode,     sizeof(MatrixCodeState)},
+  {styleCrystalCave,    0},
+  {styleLavaFlow,       0},
+  {styleWaveform,       sizeof(HueState)},
+  {styleRainbow,        sizeof(HueState)},          // Safe duplicate of pattern 0
+  {styleConfetti,       sizeof(HueState)},          // Safe duplicate of pattern 4
+};
+
+static constexpr uint16_t stateSizeOf(uint8_t i){ return PATTERNS[i].stateSize; }
+
+static constexpr uint32_t stateBytesTotal(){
+  uint32_t total = 0;
+  for(uint8_t i = 0; i < PATTERN_COUNT; i++) total += stateSizeOf(i);
+  return total;
+}
+
+static constexpr uint32_t stateArenaBytes(){
+  uint16_t sizes[PATTERN_COUNT] = {};
+  for(uint8_t i = 0; i < PATTERN_COUNT; i++) sizes[i] = stateSizeOf(i);
+  return arenaPairBytes(sizes, PATTERN_COUNT);
+}
+
+static constexpr uint16_t stateLargest(){
+  uint16_t largest = 0;
+  for(uint8_t i = 0; i < PATTERN_COUNT; i++) if(stateSizeOf(i) > largest) largest = stateSizeOf(i);
+  return largest;
+}
+
+// ── State Arena ───────────────────────────────────────────────────────────────
+alignas(ARENA_ALIGN) static uint8_t stateMem[stateArenaBytes()];
+static PatternArena stateArena = {stateMem, sizeof(stateMem), {ARENA_FREE, ARENA_FREE}};
+static uint8_t renderingPattern = 0;
+
+// The running pattern's state - fresh (default-initialised) when it has just
+// been given its space
+template<class T> static T& patternState(){
+  static_assert(sizeof(T) <= stateLargest(), "declare the state's size in PATTERNS");
+  bool fresh;
+  void* p = arenaAcquire(stateArena, renderingPattern, sizeof(T), fresh);
+  if(fresh) new (p) T();
+  return *(T*)p;
+}
+
+// Draw one frame of pattern idx into leds (controls follow styleIdx)
+static void renderPattern(uint8_t idx){
+  if(idx >= PATTERN_COUNT) return;
+  renderingPattern = idx;
+  PATTERNS[idx].fn(getSpeed());
+}
+
+// ── Pixel Map ─────────────────────────────────────────────────────────────────
+// Position of every pixel, built once (pixelmap.h) - mapped patterns read it
+// instead of doing trig per pixel
+static MapPoint mapPoints[MAX_LEDS];
+
+void initPixelMap(){
+  if(pixelMap >= PIXEL_MAP_COUNT) pixelMap = 0;
+  const PixelMapDef& def = PIXEL_MAPS[pixelMap];
+  uint32_t t0 = micros();
+  bool fits = mapBuild(def, numLeds, mapPoints);
+  uint32_t us = micros() - t0;
+  if(DEBUG_SERIAL) {
+    if(fits || !def.segs) Serial.printf("MAP: \"%s\", %u pixels built in %uus\n", def.name, numLeds, us);
+    else Serial.printf("MAP: \"%s\" places %u pixels, strip has %u - drawing as a line\n",
+      def.name, mapPixels(def), numLeds);
+  }
+}
+
+bool selectPixelMap(const char* name){
+  for(uint8_t i = 0; i < PIXEL_MAP_COUNT; i++) {
+    if(strcasecmp(name, PIXEL_MAPS[i].name) != 0) continue;
+    pixelMap = i;
+    initPixelMap();
+    return true;
+  }
+  return false;
+}
+
+void printPixelMaps(){
+  Serial.printf("MAP: %u pixels, %u bytes of map table\n", numLeds, sizeof(MapPoint) * numLeds);
+  for(uint8_t i = 0; i < PIXEL_MAP_COUNT; i++) {
+    const PixelMapDef& def = PIXEL_MAPS[i];
+    uint16_t n = mapPixels(def);
+    Serial.printf("  %c %-8s %s\n", i == pixelMap ? '*' : ' ', def.name,
+      !def.segs ? "any length" : n == numLeds ? "fits" : "wrong length - drawn as a line");
+  }
+}
 
 // ── Basic Pattern Functions ───────────────────────────────────────────────────
 static inline void addGlitter(fract8 c){ 
   if(random8()<c) {
     // Glitter at FULL brightness - brightness scaling happens later
-    leds[random16(NUM_LEDS)] += CRGB::White;
+    leds[random16(numLeds)] += CRGB::White;
   }
 }
 
 void styleRainbow(uint8_t sp){ 
-  static uint8_t h; 
+  uint8_t& h = patternState<HueState>().hue; 
   h+=sp; 
-  fill_rainbow(leds,NUM_LEDS,h,1);
+  fill_rainbow(leds,numLeds,h,1);
   // NO brightness scaling here - patterns generate at full brightness
 }
 
 void styleChase(uint8_t sp){
-  static uint32_t last; 
-  static uint16_t pos; 
-  static uint8_t hue;
+  ChaseState& st = patternState<ChaseState>();
+  uint32_t& last = st.last; 
+  uint16_t& pos = st.pos; 
+  uint8_t& hue = st.hue;
   uint32_t now=millis();
   if(now-last<map(9-sp,0,9,5,200)) return;
-  last=now; pos=(pos+1)%NUM_LEDS;
-  fadeToBlackBy(leds,NUM_LEDS,map(getDe(),0,9,50,4));
-  for(int i=0;i<NUM_LEDS;i+=20)
+  last=now; pos=(pos+1)%numLeds;
+  fadeToBlackBy(leds,numLeds,map(getDe(),0,9,50,4));
+  for(int i=0;i<numLeds;i+=20)
     for(int t=0;t<10;t++){
-      int idx=(pos+i+NUM_LEDS-t)%NUM_LEDS;
+      int idx=(pos+i+numLeds-t)%numLeds;
       leds[idx] |= CHSV(hue+i,255,map(t,0,9,255,50));
     }
   hue++;
 }
 
 void styleJuggle(uint8_t sp){
-  static uint8_t h; 
+  uint8_t& h = patternState<HueState>().hue; 
   uint16_t bpm=map(sp,0,9,10,120);
-  fadeToBlackBy(leds,NUM_LEDS,map(getDe(),0,9,20,200));
+  fadeToBlackBy(leds,numLeds,map(getDe(),0,9,20,200));
   for(int i=0;i<4;i++) 
-    leds[beatsin16(bpm,0,NUM_LEDS-1,i*20)] |= CHSV(h+=64,200,255);
+    leds[beatsin16(bpm,0,numLeds-1,i*20)] |= CHSV(h+=64,200,255);
 }
 
 void styleRainbowGlitter(uint8_t sp){ 
@@ -61,28 +259,29 @@ void styleRainbowGlitter(uint8_t sp){
 }
 
 void styleConfetti(uint8_t sp){
-  static uint8_t h;
-  fadeToBlackBy(leds,NUM_LEDS,map(getDe(),0,9,10,100));
+  uint8_t& h = patternState<HueState>().hue;
+  fadeToBlackBy(leds,numLeds,map(getDe(),0,9,10,100));
   addGlitter(getSS()*25);
   for(int i=0;i<sp*2;i++) 
-    leds[random16(NUM_LEDS)] |= CHSV(h+random8(64),200,255);
+    leds[random16(numLeds)] |= CHSV(h+random8(64),200,255);
   h++;
 }
 
 void styleBPM(uint8_t sp){
-  static uint8_t h; 
+  uint8_t& h = patternState<HueState>().hue; 
   uint16_t bpm=map(sp,0,9,30,300);
   CRGBPalette16 pal=PartyColors_p; 
-  uint8_t beat=beatsin8(bpm,64,255);
-  for(int i=0;i<NUM_LEDS;i++) 
+  // Pulse on the music's own beat when there is one, else at the SPEED tempo
+  uint8_t beat=beatLocked() ? 64 + scale8(cos8(beatPhase8()),191) : beatsin8(bpm,64,255);
+  for(int i=0;i<numLeds;i++) 
     leds[i]=ColorFromPalette(pal,h+i*2,beat-h+i*10);
-  blur1d(leds,NUM_LEDS,map(getDe(),0,9,20,200)); 
+  blur1d(leds,numLeds,map(getDe(),0,9,20,200)); 
   h++;
 }
 
 void styleFire(uint8_t sp){
-  static uint8_t heat[NUM_LEDS/2]; 
-  int half=NUM_LEDS/2;
+  uint8_t* heat = patternState<FireState>().heat; 
+  int half=numLeds/2;
   uint8_t cool=map(sp,0,9,100,20), spark=map(sp,0,9,50,200);
   for(int i=0;i<half;i++) 
     heat[i]=qsub8(heat[i],random8(0,((cool*10)/half)+2));
@@ -97,34 +296,35 @@ void styleFire(uint8_t sp){
 }
 
 void styleColorWheel(uint8_t sp){
-  static uint8_t hue = 0;
+  uint8_t& hue = patternState<HueState>().hue;
   uint8_t hueSpeed = map(sp, 0, 9, 1, 12);
   hue += hueSpeed;
   
   // Create the color at FULL brightness - scaling happens later
   CRGB color = CHSV(hue, 255, 255);
-  fill_solid(leds, NUM_LEDS, color);
+  fill_solid(leds, numLeds, color);
 }
 
 void styleRandom(uint8_t sp){
-  fadeToBlackBy(leds,NUM_LEDS,map(getDe(),0,9,10,100));
+  fadeToBlackBy(leds,numLeds,map(getDe(),0,9,10,100));
   for(int i=0;i<sp;i++) 
-    leds[random16(NUM_LEDS)] = CHSV(random8(),200,255);
+    leds[random16(numLeds)] = CHSV(random8(),200,255);
 }
 
 // ── Creative Patterns ─────────────────────────────────────────────────────────
 void stylePulseWave(uint8_t sp){
-  static uint8_t center = NUM_LEDS/2;
-  static uint8_t hue = 0;
-  static uint8_t wave = 0;
+  PulseWaveState& st = patternState<PulseWaveState>();
+  uint16_t& center = st.center;
+  uint8_t& hue = st.hue;
+  uint8_t& wave = st.wave;
   
-  fadeToBlackBy(leds, NUM_LEDS, map(getDe(),0,9,30,150));
+  fadeToBlackBy(leds, numLeds, map(getDe(),0,9,30,150));
   
   uint8_t waveSpeed = map(sp, 0, 9, 1, 8);
   wave += waveSpeed;
   
-  for(int i = 0; i < NUM_LEDS; i++){
-    uint8_t distance = abs(i - center);
+  for(int i = 0; i < numLeds; i++){
+    uint16_t distance = abs(i - center);
     uint8_t brightness = sin8(wave - distance * 8);
     if(brightness > 128){
       CRGB color = CHSV(hue + distance * 2, 255 - getSS() * 20, brightness);
@@ -133,13 +333,13 @@ void stylePulseWave(uint8_t sp){
   }
   
   hue += 2;
-  if(random8() < 5) center = random16(NUM_LEDS/4, 3*NUM_LEDS/4);
+  if(random8() < 5) center = random16(numLeds/4, 3*numLeds/4);
 }
 
 void styleMeteorShower(uint8_t sp){
-  struct Meteor { int16_t pos; uint8_t hue; uint8_t size; int8_t speed; };
-  static Meteor meteors[8];
-  static bool initialized = false;
+  MeteorState& st = patternState<MeteorState>();
+  MeteorState::Meteor* meteors = st.meteors;
+  bool& initialized = st.initialized;
   
   if(!initialized){
     for(int i = 0; i < 8; i++){
@@ -148,14 +348,14 @@ void styleMeteorShower(uint8_t sp){
     initialized = true;
   }
   
-  fadeToBlackBy(leds, NUM_LEDS, map(getDe(),0,9,20,120));
+  fadeToBlackBy(leds, numLeds, map(getDe(),0,9,20,120));
   
   for(int m = 0; m < 8; m++){
-    Meteor &meteor = meteors[m];
+    MeteorState::Meteor &meteor = meteors[m];
     
     for(int t = 0; t < meteor.size; t++){
       int16_t trailPos = meteor.pos - t;
-      if(trailPos >= 0 && trailPos < NUM_LEDS){
+      if(trailPos >= 0 && trailPos < numLeds){
         uint8_t brightness = map(t, 0, meteor.size-1, 255, 50);
         leds[trailPos] += CHSV(meteor.hue + random8(getSS()*5), 200, brightness);
       }
@@ -165,7 +365,7 @@ void styleMeteorShower(uint8_t sp){
       meteor.pos += meteor.speed;
     }
     
-    if(meteor.pos >= NUM_LEDS + meteor.size){
+    if(meteor.pos >= numLeds + meteor.size){
       meteor.pos = -meteor.size;
       meteor.hue = random8();
       meteor.size = 3 + random8(5);
@@ -175,15 +375,16 @@ void styleMeteorShower(uint8_t sp){
 }
 
 void styleColorSpiral(uint8_t sp){
-  static uint16_t spiral_pos = 0;
-  static uint8_t hue_offset = 0;
+  ColorSpiralState& st = patternState<ColorSpiralState>();
+  uint16_t& spiral_pos = st.spiral_pos;
+  uint8_t& hue_offset = st.hue_offset;
   
   uint8_t spiralSpeed = map(sp, 0, 9, 1, 12);
   spiral_pos += spiralSpeed;
   hue_offset += 1;
   
-  for(int i = 0; i < NUM_LEDS; i++){
-    uint8_t spiral_hue = hue_offset + (spiral_pos/16) + sin8((i * 256 / NUM_LEDS) + spiral_pos/4) / 8;
+  for(int i = 0; i < numLeds; i++){
+    uint8_t spiral_hue = hue_offset + (spiral_pos/16) + sin8((i * 256 / numLeds) + spiral_pos/4) / 8;
     uint8_t brightness = sin8(spiral_pos/2 + i * 8) + 128;
     
     if(random8() < getSS() * 10){
@@ -199,10 +400,11 @@ void styleColorSpiral(uint8_t sp){
 }
 
 void stylePlasmaField(uint8_t sp){
-  static uint16_t time_counter = 0;
-  static uint8_t plasma_hue = 0;
-  static uint8_t wave_offset1 = 0, wave_offset2 = 85, wave_offset3 = 170;
-  static uint8_t drift_counter = 0;
+  PlasmaFieldState& st = patternState<PlasmaFieldState>();
+  uint16_t& time_counter = st.time_counter;
+  uint8_t& plasma_hue = st.plasma_hue;
+  uint8_t &wave_offset1 = st.wave_offset1, &wave_offset2 = st.wave_offset2, &wave_offset3 = st.wave_offset3;
+  uint8_t& drift_counter = st.drift_counter;
   
   uint8_t plasmaSpeed = map(sp, 0, 9, 1, 8);
   time_counter += plasmaSpeed;
@@ -215,7 +417,7 @@ void stylePlasmaField(uint8_t sp){
     wave_offset3 += random8(3) - 1;
   }
   
-  for(int i = 0; i < NUM_LEDS; i++){
+  for(int i = 0; i < numLeds; i++){
     uint8_t layer1 = sin8(time_counter/4 + i * 8 + wave_offset1);
     uint8_t layer2 = sin8(time_counter/3 + i * 6 + wave_offset2);
     uint8_t layer3 = sin8(time_counter/5 + i * 4 + wave_offset3);
@@ -235,29 +437,30 @@ void stylePlasmaField(uint8_t sp){
 }
 
 void styleSparkleStorm(uint8_t sp){
-  static uint8_t storm_intensity = 0;
-  static uint8_t base_hue = 0;
+  SparkleStormState& st = patternState<SparkleStormState>();
+  uint8_t& storm_intensity = st.storm_intensity;
+  uint8_t& base_hue = st.base_hue;
   
   if(random8() < 10){
     storm_intensity = random8(50, 255);
   }
   storm_intensity = scale8(storm_intensity, 250);
   
-  fadeToBlackBy(leds, NUM_LEDS, map(getDe(),0,9,10,80));
+  fadeToBlackBy(leds, numLeds, map(getDe(),0,9,10,80));
   
   uint8_t sparkle_count = map(sp, 0, 9, 2, 20);
   uint8_t storm_sparkles = (storm_intensity * sparkle_count) / 255;
   
   for(int i = 0; i < sparkle_count; i++){
     if(random8() < 150){
-      uint16_t pos = random16(NUM_LEDS);
+      uint16_t pos = random16(numLeds);
       uint8_t hue = base_hue + random8(getSS() * 30);
       leds[pos] = CHSV(hue, 200 + random8(55), 200 + random8(55));
     }
   }
   
   for(int i = 0; i < storm_sparkles; i++){
-    uint16_t pos = random16(NUM_LEDS);
+    uint16_t pos = random16(numLeds);
     uint8_t hue = base_hue + random8(60);
     leds[pos] = CHSV(hue, 255, 255);
   }
@@ -266,17 +469,18 @@ void styleSparkleStorm(uint8_t sp){
 }
 
 void styleAuroraWaves(uint8_t sp){
-  static uint16_t wave1_pos = 0, wave2_pos = 0, wave3_pos = 0;
-  static uint8_t aurora_hue = 96;
+  AuroraWavesState& st = patternState<AuroraWavesState>();
+  uint16_t &wave1_pos = st.wave1_pos, &wave2_pos = st.wave2_pos, &wave3_pos = st.wave3_pos;
+  uint8_t& aurora_hue = st.aurora_hue;
   
   uint8_t waveSpeed = map(sp, 0, 9, 1, 5);
   wave1_pos += waveSpeed;
   wave2_pos += waveSpeed * 2;
   wave3_pos += waveSpeed / 2;
   
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
+  fill_solid(leds, numLeds, CRGB::Black);
   
-  for(int i = 0; i < NUM_LEDS; i++){
+  for(int i = 0; i < numLeds; i++){
     uint8_t wave1 = sin8(wave1_pos + i * 4);
     uint8_t wave2 = sin8(wave2_pos + i * 6 + 85);
     uint8_t wave3 = sin8(wave3_pos + i * 2 + 170);
@@ -318,16 +522,17 @@ void styleAuroraWaves(uint8_t sp){
 
 // ── Organic Patterns ──────────────────────────────────────────────────────────
 void styleOrganicFlow(uint8_t sp){
-  static uint16_t flow_time = 0;
-  static uint8_t base_hue = 0;
-  static float node_positions[8];
-  static float node_velocities[8];
-  static uint8_t node_hues[8];
-  static bool initialized = false;
+  OrganicFlowState& st = patternState<OrganicFlowState>();
+  uint16_t& flow_time = st.flow_time;
+  uint8_t& base_hue = st.base_hue;
+  float* node_positions = st.node_positions;
+  float* node_velocities = st.node_velocities;
+  uint8_t* node_hues = st.node_hues;
+  bool& initialized = st.initialized;
   
   if(!initialized) {
     for(int i = 0; i < 8; i++) {
-      node_positions[i] = random(NUM_LEDS);
+      node_positions[i] = random(numLeds);
       node_velocities[i] = (random(20) - 10) / 10.0f;
       node_hues[i] = random(256);
     }
@@ -338,7 +543,7 @@ void styleOrganicFlow(uint8_t sp){
   flow_time += flowSpeed;
   base_hue += 1;
   
-  for(int i = 0; i < NUM_LEDS; i++) {
+  for(int i = 0; i < numLeds; i++) {
     leds[i].nscale8(map(getDe(), 0, 9, 240, 200));
   }
   
@@ -349,14 +554,14 @@ void styleOrganicFlow(uint8_t sp){
     }
     
     node_positions[n] += node_velocities[n];
-    if(node_positions[n] < 0) node_positions[n] = NUM_LEDS - 1;
-    if(node_positions[n] >= NUM_LEDS) node_positions[n] = 0;
+    if(node_positions[n] < 0) node_positions[n] = numLeds - 1;
+    if(node_positions[n] >= numLeds) node_positions[n] = 0;
     
     node_hues[n] += random8(3);
     
     int center = (int)node_positions[n];
     for(int spread = -6; spread <= 6; spread++) {
-      int pos = (center + spread + NUM_LEDS) % NUM_LEDS;
+      int pos = (center + spread + numLeds) % numLeds;
       float distance = abs(spread) / 6.0f;
       uint8_t brightness = 255 * (1.0f - distance * distance);
       uint8_t hue = base_hue + node_hues[n] + random8(getSS() * 10);
@@ -367,30 +572,31 @@ void styleOrganicFlow(uint8_t sp){
 }
 
 void styleWaveCollapse(uint8_t sp){
-  static uint16_t wave_time = 0;
-  static uint8_t collapse_hue = 160;
-  static int16_t collapse_center = NUM_LEDS / 2;
-  static uint8_t collapse_phase = 0;
-  static uint8_t wave_radius = 0;
+  WaveCollapseState& st = patternState<WaveCollapseState>();
+  uint16_t& wave_time = st.wave_time;
+  uint8_t& collapse_hue = st.collapse_hue;
+  int16_t& collapse_center = st.collapse_center;
+  uint8_t& collapse_phase = st.collapse_phase;
+  uint16_t& wave_radius = st.wave_radius;
   
   uint8_t waveSpeed = map(sp, 0, 9, 1, 8);
   wave_time += waveSpeed;
   
   if(random8() < 3) {
     collapse_center += random8(10) - 5;
-    collapse_center = constrain(collapse_center, 20, NUM_LEDS - 20);
+    collapse_center = constrain(collapse_center, 20, numLeds - 20);
   }
   
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
+  fill_solid(leds, numLeds, CRGB::Black);
   
   if(collapse_phase == 0) {
     wave_radius += waveSpeed;
-    if(wave_radius > NUM_LEDS/2) {
+    if(wave_radius > numLeds/2) {
       collapse_phase = 1;
       collapse_hue += 60 + random8(getSS() * 30);
     }
   } else {
-    if(wave_radius > 0) wave_radius -= waveSpeed * 2;
+    if(wave_radius > 0) wave_radius = (wave_radius > waveSpeed * 2) ? wave_radius - waveSpeed * 2 : 0;
     else {
       collapse_phase = 0;
       wave_radius = 0;
@@ -398,7 +604,7 @@ void styleWaveCollapse(uint8_t sp){
     }
   }
   
-  for(int i = 0; i < NUM_LEDS; i++) {
+  for(int i = 0; i < numLeds; i++) {
     float distance = abs(i - collapse_center);
     float wave_dist = distance - wave_radius;
     
@@ -419,15 +625,16 @@ void styleWaveCollapse(uint8_t sp){
 }
 
 void styleColorDrift(uint8_t sp){
-  static uint8_t drift_hues[NUM_LEDS];
-  static float drift_velocities[NUM_LEDS];
-  static bool initialized = false;
-  static uint16_t drift_time = 0;
+  ColorDriftState& st = patternState<ColorDriftState>();
+  uint8_t* drift_hues = st.drift_hues;
+  int16_t* drift_steps = st.drift_velocities;
+  bool& initialized = st.initialized;
+  uint16_t& drift_time = st.drift_time;
   
   if(!initialized) {
-    for(int i = 0; i < NUM_LEDS; i++) {
+    for(int i = 0; i < numLeds; i++) {
       drift_hues[i] = random(256);
-      drift_velocities[i] = (random(40) - 20) / 100.0f;
+      drift_steps[i] = (random(40) - 20) * 5;          // (random(40) - 20) / 100
     }
     initialized = true;
   }
@@ -435,26 +642,27 @@ void styleColorDrift(uint8_t sp){
   uint8_t driftSpeed = map(sp, 0, 9, 1, 10);
   drift_time += driftSpeed;
   
-  for(int i = 0; i < NUM_LEDS; i++) {
-    uint8_t left_hue = (i > 0) ? drift_hues[i-1] : drift_hues[NUM_LEDS-1];
-    uint8_t right_hue = (i < NUM_LEDS-1) ? drift_hues[i+1] : drift_hues[0];
+  for(int i = 0; i < numLeds; i++) {
+    uint8_t left_hue = (i > 0) ? drift_hues[i-1] : drift_hues[numLeds-1];
+    uint8_t right_hue = (i < numLeds-1) ? drift_hues[i+1] : drift_hues[0];
     
     float influence = 0.02f;
     drift_hues[i] = drift_hues[i] * (1.0f - influence) + 
                     (left_hue + right_hue) * influence * 0.5f;
     
     if(random8() < 5) {
-      drift_velocities[i] += (random(20) - 10) / 500.0f;
-      drift_velocities[i] = constrain(drift_velocities[i], -0.5f, 0.5f);
+      drift_steps[i] += random(20) - 10;               // (random(20) - 10) / 500
+      drift_steps[i] = constrain(drift_steps[i], -250, 250);
     }
+    float drift_velocity = drift_steps[i] * DRIFT_VELOCITY_STEP;
     
-    drift_hues[i] += drift_velocities[i] * driftSpeed;
+    drift_hues[i] += drift_velocity * driftSpeed;
     
     if(random8() < getSS() * 2) {
       drift_hues[i] += random8(getSS() * 15) - getSS() * 7;
     }
     
-    uint8_t brightness = 150 + abs(drift_velocities[i]) * 2000 + 
+    uint8_t brightness = 150 + fabsf(drift_velocity) * 2000 + 
                         sin8(drift_time + i * 16) / 4;
     uint8_t saturation = 180 + sin8(drift_time * 2 + i * 8) / 4;
     
@@ -463,9 +671,10 @@ void styleColorDrift(uint8_t sp){
 }
 
 void styleLiquidRainbow(uint8_t sp){
-  static uint16_t liquid_time = 0;
-  static float wave_phases[5] = {0, 85, 170, 42, 213};
-  static float wave_speeds[5] = {1.0f, 1.3f, 0.7f, 1.7f, 0.9f};
+  LiquidRainbowState& st = patternState<LiquidRainbowState>();
+  uint16_t& liquid_time = st.liquid_time;
+  float* wave_phases = st.wave_phases;
+  float* wave_speeds = st.wave_speeds;
   
   uint8_t liquidSpeed = map(sp, 0, 9, 1, 8);
   liquid_time += liquidSpeed;
@@ -478,7 +687,7 @@ void styleLiquidRainbow(uint8_t sp){
     }
   }
   
-  for(int i = 0; i < NUM_LEDS; i++) {
+  for(int i = 0; i < numLeds; i++) {
     float wave_sum = 0;
     for(int w = 0; w < 5; w++) {
       wave_sum += sin8(wave_phases[w] + i * (8 + w * 2)) / 255.0f;
@@ -499,9 +708,10 @@ void styleLiquidRainbow(uint8_t sp){
 }
 
 void styleSineBreath(uint8_t sp){
-  static uint16_t breath_time = 0;
-  static uint8_t breath_hue = 64;
-  static uint8_t hue_drift_timer = 0;
+  SineBreathState& st = patternState<SineBreathState>();
+  uint16_t& breath_time = st.breath_time;
+  uint8_t& breath_hue = st.breath_hue;
+  uint8_t& hue_drift_timer = st.hue_drift_timer;
   
   uint8_t breathSpeed = map(sp, 0, 9, 1, 6);
   breath_time += breathSpeed;
@@ -516,8 +726,8 @@ void styleSineBreath(uint8_t sp){
   
   float master_breath = (sin8(breath_time) / 255.0f + 1.0f) / 2.0f;
   
-  for(int i = 0; i < NUM_LEDS; i++) {
-    float center_distance = abs(i - NUM_LEDS/2) / (float)(NUM_LEDS/2);
+  for(int i = 0; i < numLeds; i++) {
+    float center_distance = abs(i - numLeds/2) / (float)(numLeds/2);
     
     float breath1 = sin8(breath_time + i * 4) / 255.0f;
     float breath2 = sin8(breath_time * 0.7f + i * 2) / 255.0f;
@@ -539,9 +749,10 @@ void styleSineBreath(uint8_t sp){
 }
 
 void styleFractalNoise(uint8_t sp){
-  static uint16_t noise_time = 0;
-  static uint8_t noise_hue_base = 0;
-  static float noise_scale = 0.1f;
+  FractalNoiseState& st = patternState<FractalNoiseState>();
+  uint16_t& noise_time = st.noise_time;
+  uint8_t& noise_hue_base = st.noise_hue_base;
+  float& noise_scale = st.noise_scale;
   
   uint8_t noiseSpeed = map(sp, 0, 9, 1, 8);
   noise_time += noiseSpeed;
@@ -552,7 +763,7 @@ void styleFractalNoise(uint8_t sp){
     noise_scale = constrain(noise_scale, 0.05f, 0.3f);
   }
   
-  for(int i = 0; i < NUM_LEDS; i++) {
+  for(int i = 0; i < numLeds; i++) {
     float noise1 = sin8(noise_time + i * 8 * noise_scale * 100) / 255.0f;
     float noise2 = sin8(noise_time * 1.3f + i * 16 * noise_scale * 100) / 255.0f;
     float noise3 = sin8(noise_time * 0.7f + i * 32 * noise_scale * 100) / 255.0f;
@@ -576,9 +787,10 @@ void styleFractalNoise(uint8_t sp){
 }
 
 void styleRainbowStrobe(uint8_t sp){
-  static uint8_t hue = 0;
-  static uint8_t strobe_counter = 0;
-  static bool strobe_on = true;
+  RainbowStrobeState& st = patternState<RainbowStrobeState>();
+  uint8_t& hue = st.hue;
+  uint8_t& strobe_counter = st.strobe_counter;
+  bool& strobe_on = st.strobe_on;
   
   // Moderate strobe rate to prevent system overload and reboots
   uint8_t strobeSpeed = map(sp, 0, 9, 15, 40);  // Reduced from extreme values
@@ -596,59 +808,15 @@ void styleRainbowStrobe(uint8_t sp){
   if(strobe_on) {
     // Create the color at FULL brightness - scaling happens later
     CRGB color = CHSV(hue, 255, 255);
-    fill_solid(leds, NUM_LEDS, color);
+    fill_solid(leds, numLeds, color);
   } else {
-    fill_solid(leds, NUM_LEDS, CRGB::Black);
+    fill_solid(leds, numLeds, CRGB::Black);
   }
 }
 
 // ── Effect Control Functions ──────────────────────────────────────────────────
 void effectWild(){
-  switch(styleIdx){
-    case 0: styleRainbow(getSpeed());      break;
-    case 1: styleChase(getSpeed());        break;
-    case 2: styleJuggle(getSpeed());       break;
-    case 3: styleRainbowGlitter(getSpeed()); break;
-    case 4: styleConfetti(getSpeed());     break;
-    case 5: styleBPM(getSpeed());          break;
-    case 6: styleFire(getSpeed());         break;
-    case 7: styleColorWheel(getSpeed());   break;
-    case 8: styleRandom(getSpeed());       break;
-    case 9: stylePulseWave(getSpeed());    break;
-    case 10: styleMeteorShower(getSpeed()); break;
-    case 11: styleColorSpiral(getSpeed());  break;
-    case 12: stylePlasmaField(getSpeed());  break;
-    case 13: styleSparkleStorm(getSpeed()); break;
-    case 14: styleAuroraWaves(getSpeed());  break;
-    case 15: styleOrganicFlow(getSpeed());  break;
-    case 16: styleWaveCollapse(getSpeed()); break;
-    case 17: styleColorDrift(getSpeed());   break;
-    case 18: styleLiquidRainbow(getSpeed()); break;
-    case 19: styleSineBreath(getSpeed());   break;
-    case 20: styleFractalNoise(getSpeed()); break;
-    case 21: styleRainbowStrobe(getSpeed()); break;
-    // NEW PATTERNS (20 additional patterns)
-    case 22: styleTwinkleStars(getSpeed()); break;
-    case 23: styleRainbowRipples(getSpeed()); break;
-    case 24: styleDNAHelix(getSpeed()); break;
-    case 25: styleNeonPulse(getSpeed()); break;
-    case 26: styleDigitalRain(getSpeed()); break;
-    case 27: stylePlasmaBalls(getSpeed()); break;
-    case 28: styleLightningStorm(getSpeed()); break;
-    case 29: styleKaleidoscope(getSpeed()); break;
-    case 30: styleCandleFlicker(getSpeed()); break;
-    case 31: styleColorDrips(getSpeed()); break;
-    case 32: styleGalaxySpiral(getSpeed()); break;
-    case 33: stylePrism(getSpeed()); break;
-    case 34: styleHeartbeat(getSpeed()); break;
-    case 35: styleAuroraBoreal(getSpeed()); break;
-    case 36: styleMatrixCode(getSpeed()); break;
-    case 37: styleCrystalCave(getSpeed()); break;
-    case 38: styleLavaFlow(getSpeed()); break;
-    case 39: styleWaveform(getSpeed()); break;
-    case 40: styleRainbow(getSpeed()); break; // Safe duplicate of pattern 0
-    case 41: styleConfetti(getSpeed()); break; // Safe duplicate of pattern 4
-  }
+  renderPattern(styleIdx);
 }
 
 void effectWildBG(){ 
@@ -658,55 +826,37 @@ void effectWildBG(){
 
 void effectMusic(){ 
   effectWild();
-  
-  // CRITICAL FIX: Apply dramatic music scaling to FULL BRIGHTNESS patterns
-  // Enhanced responsiveness: much more dramatic nearly-off to full-bright response
-  
-  // Always apply music scaling with enhanced contrast
-  // musicLevel ranges from 0.0 to 1.0, use the full range for maximum drama
-  float enhancedMusicLevel = musicLevel;
-  
-  // Boost the contrast: square the music level for more dramatic response
-  // This makes quiet sections much dimmer and loud sections stay bright
-  enhancedMusicLevel = enhancedMusicLevel * enhancedMusicLevel;
-  
-  // Set minimum to very low (3% instead of 12%) for dramatic contrast
-  const float MIN_BRIGHTNESS = 0.03f;  // 3% minimum
-  const float MAX_BRIGHTNESS = 1.0f;   // 100% maximum
-  
-  // Scale from 3% to 100% based on enhanced music level
-  float finalLevel = MIN_BRIGHTNESS + (enhancedMusicLevel * (MAX_BRIGHTNESS - MIN_BRIGHTNESS));
-  
-  uint8_t musicScale = uint8_t(finalLevel * 255);
-  for(int i = 0; i < NUM_LEDS; i++) {
-    leds[i].nscale8(musicScale);
-  }
+  // NO music scaling here either - frames stay musically neutral and every node
+  // applies the music envelope at its output stage (musiclink.h)
 }
 
 // ── NEW PATTERNS: Inspired by Pixelblaze Community ──────────────────────────
 // stylePerlinWaves removed due to system crashes - too computationally intensive
 
 void styleTwinkleStars(uint8_t sp) {
-  static uint8_t density = 80;
+  const uint8_t density = 80;
   if (random8() < density) {
-    leds[random16(NUM_LEDS)] += CHSV(random8(), 255, random8(100, 255));
+    leds[random16(numLeds)] += CHSV(random8(), 255, random8(100, 255));
   }
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     leds[i].nscale8(250 - sp / 4); // Fade based on speed
   }
 }
 
 void styleRainbowRipples(uint8_t sp) {
-  static uint8_t center = NUM_LEDS / 2;
-  static uint8_t step = 0;
+  RippleState& st = patternState<RippleState>();
+  uint16_t& center = st.center;
+  uint8_t& step = st.step;
   
   if (step == 0) {
-    center = random8(NUM_LEDS);
+    center = random16(numLeds);
     step = 1;
   }
   
-  for (int i = 0; i < NUM_LEDS; i++) {
-    uint8_t distance = abs(i - center);
+  // Rings spread through space from a pixel, not just along the strip
+  const MapPoint& c = mapPoints[center];
+  for (int i = 0; i < numLeds; i++) {
+    uint16_t distance = mapDistance(mapPoints[i], c.x, c.y, c.z) >> 8;   // 128 = half the map
     uint8_t brightness = sin8(distance * 8 - millis() / (20 - sp / 15));
     leds[i] = CHSV((distance * 4 + millis() / 100) % 255, 255, brightness);
   }
@@ -715,7 +865,7 @@ void styleRainbowRipples(uint8_t sp) {
 }
 
 void styleDNAHelix(uint8_t sp) {
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     uint8_t angle1 = (millis() / (30 - sp / 10) + i * 8) % 255;
     uint8_t angle2 = (millis() / (30 - sp / 10) + i * 8 + 128) % 255;
     uint8_t bright1 = sin8(angle1);
@@ -728,10 +878,10 @@ void styleDNAHelix(uint8_t sp) {
 }
 
 void styleNeonPulse(uint8_t sp) {
-  static uint8_t hue = 0;
+  uint8_t& hue = patternState<HueState>().hue;
   uint8_t beat = sin8(millis() / (50 - sp / 6));
   
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     uint8_t brightness = qadd8(beat, sin8(i * 4 + millis() / 100));
     leds[i] = CHSV(hue, 200, brightness);
   }
@@ -740,29 +890,29 @@ void styleNeonPulse(uint8_t sp) {
 
 void styleDigitalRain(uint8_t sp) {
   // Fade all pixels
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     leds[i].nscale8(230); // Slower fade for more visible trails
   }
   
   // Add multiple new "drops" - much more active
   if (random8() < (sp + 40)) { // Much higher frequency
-    leds[random8(NUM_LEDS / 3)] = CHSV(96, 255, 255); // Bright green from top third
+    leds[random16(numLeds / 3)] = CHSV(96, 255, 255); // Bright green from top third
   }
   
   // Add additional drops from various positions
   if (random8() < (sp / 2 + 25)) {
-    leds[random8(NUM_LEDS / 5)] = CHSV(120, 255, 200); // Lighter green variation
+    leds[random16(numLeds / 5)] = CHSV(120, 255, 200); // Lighter green variation
   }
   
   // Add occasional bright white "data packets"
   if (random8() < (sp / 4 + 15)) {
-    leds[random8(NUM_LEDS / 6)] = CHSV(0, 0, 255); // Bright white
+    leds[random16(numLeds / 6)] = CHSV(0, 0, 255); // Bright white
   }
   
   // Rain effect - move pixels down (faster)
-  static uint32_t lastMove = 0;
+  uint32_t& lastMove = patternState<MoveState>().lastMove;
   if (millis() - lastMove > (60 - sp)) { // Faster movement
-    for (int i = NUM_LEDS - 1; i > 0; i--) {
+    for (int i = numLeds - 1; i > 0; i--) {
       if (leds[i-1].g > leds[i].g || (leds[i-1].r + leds[i-1].g + leds[i-1].b) > 50) {
         leds[i] = leds[i-1];
         leds[i-1].nscale8(180); // More visible trail
@@ -773,8 +923,8 @@ void styleDigitalRain(uint8_t sp) {
 }
 
 void stylePlasmaBalls(uint8_t sp) {
-  for (int i = 0; i < NUM_LEDS; i++) {
-    uint8_t x = i;
+  for (int i = 0; i < numLeds; i++) {
+    uint16_t x = i;   // sin8() takes the low byte - the pattern repeats every 256 pixels
     uint8_t t = millis() / (30 - sp / 10);
     
     uint8_t plasma = sin8(x * 16 + t) + 
@@ -788,53 +938,56 @@ void stylePlasmaBalls(uint8_t sp) {
 
 void styleLightningStorm(uint8_t sp) {
   // Fade to dark blue background (less aggressive fading)
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     leds[i] = CHSV(160, 255, 25); // Slightly brighter background
     leds[i].nscale8(220); // Less aggressive fade for more atmosphere
   }
   
   // Multiple lightning strikes - much more frequent and varied
   if (random8() < (sp / 4 + 15)) { // Much higher frequency
-    uint8_t strike_pos = random8(NUM_LEDS - 30);
+    uint16_t strike_pos = random16(numLeds - 30);
     uint8_t strike_len = random8(8, 25); // Longer strikes
     
-    for (int i = strike_pos; i < strike_pos + strike_len && i < NUM_LEDS; i++) {
+    for (int i = strike_pos; i < strike_pos + strike_len && i < numLeds; i++) {
       leds[i] = CHSV(0, 0, 255); // Bright white
     }
   }
   
   // Add secondary smaller lightning strikes
   if (random8() < (sp / 6 + 10)) {
-    uint8_t strike_pos = random8(NUM_LEDS - 15);
+    uint16_t strike_pos = random16(numLeds - 15);
     uint8_t strike_len = random8(3, 12);
     
-    for (int i = strike_pos; i < strike_pos + strike_len && i < NUM_LEDS; i++) {
+    for (int i = strike_pos; i < strike_pos + strike_len && i < numLeds; i++) {
       leds[i] = CHSV(45, 100, 200); // Yellowish lightning
     }
   }
   
   // Add occasional purple lightning (different voltage)
   if (random8() < (sp / 8 + 5)) {
-    uint8_t strike_pos = random8(NUM_LEDS - 10);
+    uint16_t strike_pos = random16(numLeds - 10);
     uint8_t strike_len = random8(2, 8);
     
-    for (int i = strike_pos; i < strike_pos + strike_len && i < NUM_LEDS; i++) {
+    for (int i = strike_pos; i < strike_pos + strike_len && i < numLeds; i++) {
       leds[i] = CHSV(200, 150, 180); // Purple lightning
     }
   }
 }
 
 void styleKaleidoscope(uint8_t sp) {
-  static uint8_t offset = 0;
-  uint8_t center = NUM_LEDS / 2;
-  
-  for (int i = 0; i < center; i++) {
-    uint8_t hue = (i * 8 + offset) % 255;
-    uint8_t brightness = sin8(i * 16 + millis() / (40 - sp / 8));
-    CRGB color = CHSV(hue, 255, brightness);
-    
-    leds[i] = color;
-    leds[NUM_LEDS - 1 - i] = color; // Mirror effect
+  uint8_t& offset = patternState<HueState>().hue;
+  uint8_t t = millis() / (40 - sp / 8);
+  
+  // Six mirrored wedges round the polar axis, rings out from it - a line
+  // folds about its middle
+  for (int i = 0; i < numLeds; i++) {
+    const MapPoint& p = mapPoints[i];
+    uint16_t wedge = p.angle * 6;
+    uint8_t fold = (wedge & 0x8000 ? ~wedge : wedge) >> 7;
+    uint8_t ring = 255 - (p.radius >> 8);
+    uint8_t hue = ring * 5 + fold / 2 + offset;
+    uint8_t brightness = sin8(ring * 10 + fold + t);
+    leds[i] = CHSV(hue, 255, brightness);
   }
   offset += sp / 20;
 }
@@ -842,7 +995,7 @@ void styleKaleidoscope(uint8_t sp) {
 void styleCandleFlicker(uint8_t sp) {
   uint8_t base_hue = 20; // Warm orange
   
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     uint8_t flicker = random8(180, 255);
     uint8_t hue_variation = base_hue + random8(20) - 10;
     leds[i] = CHSV(hue_variation, 255, flicker);
@@ -850,19 +1003,19 @@ void styleCandleFlicker(uint8_t sp) {
   
   // Occasional brighter flickers
   if (random8() < (sp / 5 + 10)) {
-    leds[random8(NUM_LEDS)] = CHSV(base_hue, 200, 255);
+    leds[random16(numLeds)] = CHSV(base_hue, 200, 255);
   }
 }
 
 void styleColorDrips(uint8_t sp) {
   // Fade all pixels
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     leds[i].nscale8(240); // Slower fade for more visible trails
   }
   
   // Add new drips from multiple positions (much more frequent)
   if (random8() < (sp + 60)) { // Significantly increased frequency
-    uint8_t start_pos = random8(NUM_LEDS / 4); // Random starting position in top quarter
+    uint16_t start_pos = random16(numLeds / 4); // Random starting position in top quarter
     leds[start_pos] = CHSV(random8(), 255, 255);
   }
   
@@ -872,9 +1025,9 @@ void styleColorDrips(uint8_t sp) {
   }
   
   // Move drips down (faster movement)
-  static uint32_t lastMove = 0;
+  uint32_t& lastMove = patternState<MoveState>().lastMove;
   if (millis() - lastMove > (80 - sp)) { // Much faster dripping
-    for (int i = NUM_LEDS - 1; i > 0; i--) {
+    for (int i = numLeds - 1; i > 0; i--) {
       if (leds[i-1].r + leds[i-1].g + leds[i-1].b > 20) { // Lower threshold for movement
         leds[i] = leds[i-1];
         leds[i-1].nscale8(200); // More visible trail
@@ -885,9 +1038,11 @@ void styleColorDrips(uint8_t sp) {
 }
 
 void styleGalaxySpiral(uint8_t sp) {
-  for (int i = 0; i < NUM_LEDS; i++) {
-    uint8_t angle = (i * 4 + millis() / (60 - sp / 5)) % 255;
-    uint8_t radius = i * 255 / NUM_LEDS;
+  uint8_t t = millis() / (60 - sp / 5);
+  for (int i = 0; i < numLeds; i++) {
+    // Two arms, five turns from the axis out
+    uint8_t angle = (mapSpiral(mapPoints[i], 2, 5 * 256) >> 8) + t;
+    uint8_t radius = mapPoints[i].radius >> 8;
     
     uint8_t brightness = sin8(angle) * sin8(radius) / 255;
     uint8_t hue = angle / 2 + radius / 4;
@@ -897,10 +1052,10 @@ void styleGalaxySpiral(uint8_t sp) {
 }
 
 void stylePrism(uint8_t sp) {
-  static uint8_t rotation = 0;
+  uint8_t& rotation = patternState<HueState>().hue;
   
-  for (int i = 0; i < NUM_LEDS; i++) {
-    uint8_t segment = (i * 6) / NUM_LEDS; // 6 color segments
+  for (int i = 0; i < numLeds; i++) {
+    uint8_t segment = (i * 6) / numLeds; // 6 color segments
     uint8_t hue = (segment * 42 + rotation) % 255; // Spread across spectrum
     uint8_t brightness = sin8((i * 8 + millis() / (30 - sp / 10)) % 255);
     
@@ -910,13 +1065,20 @@ void stylePrism(uint8_t sp) {
 }
 
 void styleHeartbeat(uint8_t sp) {
-  static uint32_t lastBeat = 0;
-  static bool inBeat = false;
+  HeartbeatState& st = patternState<HeartbeatState>();
+  uint32_t& lastBeat = st.lastBeat;
+  bool& inBeat = st.inBeat;
   uint32_t now = millis();
   
   uint32_t beatInterval = 1200 - sp * 8; // Speed affects heart rate
   
-  if (now - lastBeat > beatInterval) {
+  if (beatLocked()) {
+    // Beat in time with the music
+    if (lastBeatMillis() != lastBeat) {
+      lastBeat = lastBeatMillis();
+      inBeat = true;
+    }
+  } else if (now - lastBeat > beatInterval) {
     lastBeat = now;
     inBeat = true;
   }
@@ -933,13 +1095,15 @@ void styleHeartbeat(uint8_t sp) {
     }
   }
   
-  fill_solid(leds, NUM_LEDS, CHSV(0, 255, brightness)); // Red heartbeat
+  fill_solid(leds, numLeds, CHSV(0, 255, brightness)); // Red heartbeat
 }
 
 void styleAuroraBoreal(uint8_t sp) {
-  for (int i = 0; i < NUM_LEDS; i++) {
-    uint8_t x = i * 255 / NUM_LEDS;
-    uint8_t t = millis() / (100 - sp);
+  // Curtains across the structure, leaning 30 degrees - a line reads them end to end
+  MapDir across = mapDir(0, 65536 / 12);
+  uint8_t t = millis() / (100 - sp);
+  for (int i = 0; i < numLeds; i++) {
+    uint8_t x = (mapProject(mapPoints[i], across) + 32768) >> 8;
     
     uint8_t green = inoise8(x, t) / 2 + 127;
     uint8_t blue = inoise8(x + 1000, t + 1000) / 3 + 85;
@@ -949,9 +1113,9 @@ void styleAuroraBoreal(uint8_t sp) {
   
   // Add occasional bright streaks
   if (random8() < (sp / 10 + 5)) {
-    uint8_t streak_pos = random8(NUM_LEDS - 10);
+    uint16_t streak_pos = random16(numLeds - 10);
     for (int i = 0; i < 8; i++) {
-      if (streak_pos + i < NUM_LEDS) {
+      if (streak_pos + i < numLeds) {
         leds[streak_pos + i] += CRGB(random8(50), random8(100, 255), random8(100, 200));
       }
     }
@@ -960,13 +1124,14 @@ void styleAuroraBoreal(uint8_t sp) {
 
 void styleMatrixCode(uint8_t sp) {
   // Fade background
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     leds[i].nscale8(230);
   }
   
   // Add falling code streams
-  static uint8_t streams[10] = {255, 255, 255, 255, 255, 255, 255, 255, 255, 255};
-  static uint32_t lastUpdate = 0;
+  MatrixCodeState& st = patternState<MatrixCodeState>();
+  uint16_t* streams = st.streams;
+  uint32_t& lastUpdate = st.lastUpdate;
   
   if (millis() - lastUpdate > (200 - sp * 2)) {
     for (int s = 0; s < 10; s++) {
@@ -975,8 +1140,8 @@ void styleMatrixCode(uint8_t sp) {
           streams[s] = 0; // Start new stream
         }
       } else {
-        uint8_t pos = streams[s] * NUM_LEDS / 255;
-        if (pos < NUM_LEDS) {
+        uint16_t pos = (uint32_t)streams[s] * numLeds / 255;
+        if (pos < numLeds) {
           leds[pos] = CHSV(96, 255, 255); // Bright green
           if (pos > 0) leds[pos-1] = CHSV(96, 255, 150);
           if (pos > 1) leds[pos-2] = CHSV(96, 255, 80);
@@ -991,7 +1156,7 @@ void styleMatrixCode(uint8_t sp) {
 }
 
 void styleCrystalCave(uint8_t sp) {
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     uint16_t noise1 = inoise16(i * 60, millis() / (40 - sp / 8));
     uint16_t noise2 = inoise16(i * 80 + 5000, millis() / (60 - sp / 6));
     
@@ -1003,13 +1168,17 @@ void styleCrystalCave(uint8_t sp) {
   
   // Add sparkle effect
   if (random8() < (sp / 8 + 10)) {
-    leds[random8(NUM_LEDS)] += CRGB(100, 100, 255);
+    leds[random16(numLeds)] += CRGB(100, 100, 255);
   }
 }
 
 void styleLavaFlow(uint8_t sp) {
-  for (int i = 0; i < NUM_LEDS; i++) {
-    uint8_t heat = inoise8(i * 40, millis() / (80 - sp));
+  // One 3D noise field rising through the structure - pixels that touch
+  // across turns of a pole glow together
+  uint16_t t = millis() / (80 - sp);
+  for (int i = 0; i < numLeds; i++) {
+    const MapPoint& p = mapPoints[i];
+    uint8_t heat = inoise8((p.x + 32768u) >> 2, ((p.y + 32768u) >> 2) - t, (p.z + 32768u) >> 2);
     
     // Create lava colors (black -> red -> orange -> yellow -> white)
     CRGB color;
@@ -1025,15 +1194,15 @@ void styleLavaFlow(uint8_t sp) {
 }
 
 void styleWaveform(uint8_t sp) {
-  static uint8_t phase = 0;
+  uint8_t& phase = patternState<HueState>().hue;
   
-  for (int i = 0; i < NUM_LEDS; i++) {
+  for (int i = 0; i < numLeds; i++) {
     uint8_t wave1 = sin8(i * 8 + phase);
     uint8_t wave2 = sin8(i * 12 + phase * 2);
     uint8_t wave3 = sin8(i * 16 + phase * 3);
     
     uint8_t combined = (wave1 + wave2 + wave3) / 3;
-    uint8_t hue = i * 255 / NUM_LEDS + phase;
+    uint8_t hue = i * 255 / numLeds + phase;
     
     leds[i] = CHSV(hue, 255, combined);
   }
@@ -1045,70 +1214,57 @@ void runTimed(void (*fn)()){
   static uint32_t lastT=0;
   uint32_t now=millis(), d=getTi()*15000;
   if(d==0||now-lastT>=d){ 
-    styleIdx=(styleIdx+1)%42; 
+    styleIdx=(styleIdx+1)%PATTERN_COUNT; 
     lastT=now; 
   }
   fn();
 }
 
+// ── Pattern Benchmark ─────────────────────────────────────────────────────────
+static const uint8_t PATTERN_BENCH_FRAMES = 25;
+
+// Every pattern for PATTERN_BENCH_FRAMES frames from fresh state: render time
+// and state size, then pattern RAM. Blocks for about a second and the live
+// pattern starts over afterwards - a bench command, not for a show.
+void benchmarkPatterns() {
+  uint8_t originalStyleIdx = styleIdx;
+  uint32_t totalUs = 0;
+  Serial.println("PATTERNS: idx name              state   avg us   max us");
+  for(uint8_t p = 0; p < PATTERN_COUNT; p++) {
+    styleIdx = p;
+    uint32_t sumUs = 0, maxUs = 0;
+    fill_solid(leds, numLeds, CRGB::Black);
+    for(uint8_t f = 0; f < PATTERN_BENCH_FRAMES; f++) {
+      uint32_t t0 = micros();
+      renderPattern(p);
+      uint32_t us = micros() - t0;
+      sumUs += us;
+      if(us > maxUs) maxUs = us;
+    }
+    totalUs += sumUs;
+    Serial.printf("  %3u %-16s %6u %8u %8u\n", p, STYLE_NAMES[p], PATTERNS[p].stateSize,
+      sumUs / PATTERN_BENCH_FRAMES, maxUs);
+    feedWatchdog();
+  }
+  styleIdx = originalStyleIdx;
+  fill_solid(leds, numLeds, CRGB::Black);
+  
+  Serial.printf("PATTERNS: avg %uus per frame over all patterns at %u LEDs\n", totalUs / (PATTERN_COUNT * PATTERN_BENCH_FRAMES), numLeds);
+  Serial.printf("PATTERNS: state arena %u bytes, peak %u in use, %u fresh starts (static state would be %u bytes)\n",
+    stateArena.capacity, stateArena.peak, stateArena.restarts, stateBytesTotal());
+  Serial.printf("PATTERNS: peak pattern RAM %u bytes (arena + %u crossfade buffer), heap free %u min %u\n",
+    stateArena.capacity + sizeof(CRGB) * MAX_LEDS, sizeof(CRGB) * MAX_LEDS, ESP.getFreeHeap(), ESP.getMinFreeHeap());
+}
+
 // ── Crossfade System Implementation ───────────────────────────────────────────
 void executePattern(uint8_t patternIndex, CRGB* buffer) {
-  // First clear the buffer
-  memset(buffer, 0, sizeof(CRGB) * NUM_LEDS);
-  
   // Store original styleIdx
   uint8_t originalStyleIdx = styleIdx;
   styleIdx = patternIndex;
   
-  // Execute the specific pattern directly into the buffer
-  switch(patternIndex) {
-    case 0: styleRainbow(getSpeed());      break;
-    case 1: styleChase(getSpeed());        break;
-    case 2: styleJuggle(getSpeed());       break;
-    case 3: styleRainbowGlitter(getSpeed()); break;
-    case 4: styleConfetti(getSpeed());     break;
-    case 5: styleBPM(getSpeed());          break;
-    case 6: styleFire(getSpeed());         break;
-    case 7: styleColorWheel(getSpeed());   break;
-    case 8: styleRandom(getSpeed());       break;
-    case 9: stylePulseWave(getSpeed());    break;
-    case 10: styleMeteorShower(getSpeed()); break;
-    case 11: styleColorSpiral(getSpeed());  break;
-    case 12: stylePlasmaField(getSpeed());  break;
-    case 13: styleSparkleStorm(getSpeed()); break;
-    case 14: styleAuroraWaves(getSpeed());  break;
-    case 15: styleOrganicFlow(getSpeed());  break;
-    case 16: styleWaveCollapse(getSpeed()); break;
-    case 17: styleColorDrift(getSpeed());   break;
-    case 18: styleLiquidRainbow(getSpeed()); break;
-    case 19: styleSineBreath(getSpeed());   break;
-    case 20: styleFractalNoise(getSpeed()); break;
-    case 21: styleRainbowStrobe(getSpeed()); break;
-    // NEW PATTERNS (20 additional patterns)
-    case 22: styleTwinkleStars(getSpeed()); break;
-    case 23: styleRainbowRipples(getSpeed()); break;
-    case 24: styleDNAHelix(getSpeed()); break;
-    case 25: styleNeonPulse(getSpeed()); break;
-    case 26: styleDigitalRain(getSpeed()); break;
-    case 27: stylePlasmaBalls(getSpeed()); break;
-    case 28: styleLightningStorm(getSpeed()); break;
-    case 29: styleKaleidoscope(getSpeed()); break;
-    case 30: styleCandleFlicker(getSpeed()); break;
-    case 31: styleColorDrips(getSpeed()); break;
-    case 32: styleGalaxySpiral(getSpeed()); break;
-    case 33: stylePrism(getSpeed()); break;
-    case 34: styleHeartbeat(getSpeed()); break;
-    case 35: styleAuroraBoreal(getSpeed()); break;
-    case 36: styleMatrixCode(getSpeed()); break;
-    case 37: styleCrystalCave(getSpeed()); break;
-    case 38: styleLavaFlow(getSpeed()); break;
-    case 39: styleWaveform(getSpeed()); break;
-    case 40: styleRainbow(getSpeed()); break; // Safe duplicate of pattern 0
-    case 41: styleConfetti(getSpeed()); break; // Safe duplicate of pattern 4
-  }
-  
-  // Copy the results from leds to our buffer
-  memcpy(buffer, leds, sizeof(CRGB) * NUM_LEDS);
+  // Patterns draw into leds (over whatever is there) - copy the result out
+  renderPattern(patternIndex);
+  if(buffer != leds) memcpy(buffer, leds, sizeof(CRGB) * numLeds);
   
   // Restore original styleIdx
   styleIdx = originalStyleIdx;
@@ -1120,8 +1276,7 @@ void runTimedWithCrossfade(void (*fn)()){
   static uint8_t currentPattern = 0;
   static uint8_t nextPattern = 1;
   static bool inCrossfade = false;
-  static CRGB buffer1[NUM_LEDS];
-  static CRGB buffer2[NUM_LEDS];
+  static CRGB fadeFrom[MAX_LEDS];   // The incoming pattern draws straight into leds
   static bool firstRun = true;
   
   uint32_t now = millis();
@@ -1132,7 +1287,7 @@ void runTimedWithCrossfade(void (*fn)()){
   if(firstRun) {
     lastPatternChange = now;
     currentPattern = styleIdx;
-    nextPattern = (currentPattern + 1) % 42;
+    nextPattern = (currentPattern + 1) % PATTERN_COUNT;
     firstRun = false;
   }
   
@@ -1140,7 +1295,7 @@ void runTimedWithCrossfade(void (*fn)()){
   if(!inCrossfade && (patternDuration == 0 || now - lastPatternChange >= (patternDuration - CROSSFADE_DURATION))) {
     inCrossfade = true;
     crossfadeStartTime = now;
-    nextPattern = (currentPattern + 1) % 42;
+    nextPattern = (currentPattern + 1) % PATTERN_COUNT;
   }
   
   if(inCrossfade) {
@@ -1159,34 +1314,20 @@ void runTimedWithCrossfade(void (*fn)()){
       // We're in crossfade - blend both patterns
       float crossfadeProgress = (float)crossfadeElapsed / CROSSFADE_DURATION;
       
-      // Generate current pattern in buffer1
-      executePattern(currentPattern, buffer1);
+      // Generate current pattern, set aside
+      executePattern(currentPattern, fadeFrom);
       
-      // Generate next pattern in buffer2  
-      executePattern(nextPattern, buffer2);
+      // Generate next pattern over it, in place
+      executePattern(nextPattern, leds);
       
       // Blend the two patterns into the main leds array
-      for(int i = 0; i < NUM_LEDS; i++) {
+      for(int i = 0; i < numLeds; i++) {
         // Smooth crossfade using ease-in-out curve
         float blend = crossfadeProgress * crossfadeProgress * (3.0f - 2.0f * crossfadeProgress);
         
-        leds[i].r = (uint8_t)(buffer1[i].r * (1.0f - blend) + buffer2[i].r * blend);
-        leds[i].g = (uint8_t)(buffer1[i].g * (1.0f - blend) + buffer2[i].g * blend);
-        leds[i].b = (uint8_t)(buffer1[i].b * (1.0f - blend) + buffer2[i].b * blend);
-      }
-      
-      // Apply music effect if this is the music function
-      if(fn == effectMusic) {
-        // Apply enhanced dramatic music scaling to the blended result
-        float enhancedMusicLevel = musicLevel * musicLevel; // Square for more contrast
-        const float MIN_BRIGHTNESS = 0.03f;  // 3% minimum  
-        const float MAX_BRIGHTNESS = 1.0f;   // 100% maximum
-        float finalLevel = MIN_BRIGHTNESS + (enhancedMusicLevel * (MAX_BRIGHTNESS - MIN_BRIGHTNESS));
-        
-        uint8_t musicScale = uint8_t(finalLevel * 255);
-        for(int i = 0; i < NUM_LEDS; i++) {
-          leds[i].nscale8(musicScale);
-        }
+        leds[i].r = (uint8_t)(fadeFrom[i].r * (1.0f - blend) + leds[i].r * blend);
+        leds[i].g = (uint8_t)(fadeFrom[i].g * (1.0f - blend) + leds[i].g * blend);
+        leds[i].b = (uint8_t)(fadeFrom[i].b * (1.0f - blend) + leds[i].b * blend);
       }
     }
   } else {
@@ -57,4 +57,12 @@ void runTimed(void (*fn)());
 void runTimedWithCrossfade(void (*fn)());
 void executePattern(uint8_t patternIndex, CRGB* buffer);
 
+// ── Pixel Map ─────────────────────────────────────────────────────────────────
+void initPixelMap();                     // Build this node's map (pixelMap) - after loadControls
+bool selectPixelMap(const char* name);   // Switch maps and rebuild - the caller saves the setting
+void printPixelMaps();
+
+// ── Diagnostics ───────────────────────────────────────────────────────────────
+void benchmarkPatterns();   // Render time and state size per pattern, then pattern RAM
+
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "persist.h"
+#include <string.h>
+
+void persistReset(PersistState& ps, uint32_t lifetimeWrites){
+  memset(&ps, 0, sizeof(ps));
+  ps.lifetimeWrites = lifetimeWrites;
+}
+
+uint32_t persistNoteChange(PersistState& ps, uint32_t nowMs){
+  if(!ps.dirty) {
+    ps.dirty = true;
+    ps.firstDirtyMs = nowMs;
+  }
+  ps.lastChangeMs = nowMs;
+  ps.changes++;
+  return persistDelayMs(ps, nowMs);
+}
+
+uint32_t persistDelayMs(const PersistState& ps, uint32_t nowMs){
+  if(!ps.dirty) return 0;
+  // Rest of the quiet period, capped by the deadline set by the first change
+  uint32_t quiet = nowMs - ps.lastChangeMs, held = nowMs - ps.firstDirtyMs;
+  uint32_t leftQuiet = quiet < PERSIST_QUIET_MS ? PERSIST_QUIET_MS - quiet : 0;
+  uint32_t leftMax = held < PERSIST_MAX_DELAY_MS ? PERSIST_MAX_DELAY_MS - held : 0;
+  return leftQuiet < leftMax ? leftQuiet : leftMax;
+}
+
+bool persistDue(const PersistState& ps, uint32_t nowMs){
+  if(!ps.dirty) return false;
+  return nowMs - ps.lastChangeMs >= PERSIST_QUIET_MS
+      || nowMs - ps.firstDirtyMs >= PERSIST_MAX_DELAY_MS;
+}
+
+uint32_t persistBeginWrite(PersistState& ps){
+  ps.dirty = false;
+  ps.writes++;
+  return ++ps.lifetimeWrites;
+}
+
+uint32_t persistCoalesced(const PersistState& ps){
+  return ps.changes > ps.writes ? ps.changes - ps.writes : 0;
+}
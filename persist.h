@@ -0,0 +1,49 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+// ── Deferred Settings Persistence ────────────────────────────────────────────
+// Settings changes only mark the RAM copy dirty. The write to flash happens
+// once the settings have been left alone for PERSIST_QUIET_MS - or at the
+// latest PERSIST_MAX_DELAY_MS after the first unsaved change, so a knob that
+// never settles still gets saved - and immediately before anything that would
+// lose RAM (OFF, OTA). A burst of button presses costs one NVS write instead
+// of one erase/program stall per press. Counters track how many changes were
+// absorbed and how many writes reached flash, for wear tracking.
+// Hardware-independent (the caller supplies the time and does the write).
+
+#include <stdint.h>
+
+static const uint32_t PERSIST_QUIET_MS     = 3000;    // Untouched this long - write
+static const uint32_t PERSIST_MAX_DELAY_MS = 20000;   // Never hold a change longer than this
+
+struct PersistState {
+  bool     dirty;
+  uint32_t firstDirtyMs;   // First change since the last write
+  uint32_t lastChangeMs;
+  // Wear tracking
+  uint32_t changes;        // persistNoteChange calls
+  uint32_t writes;         // Writes this boot
+  uint32_t lifetimeWrites; // Writes ever - loaded from and stored with the settings
+};
+
+void persistReset(PersistState& ps, uint32_t lifetimeWrites);
+
+// A setting changed in RAM - returns the delay until the write is due
+uint32_t persistNoteChange(PersistState& ps, uint32_t nowMs);
+
+// Whether a write is due now (false when clean)
+bool persistDue(const PersistState& ps, uint32_t nowMs);
+
+// Time left until the write is due, 0 when due now or clean. A timer armed for
+// persistNoteChange()'s delay can fire a little early (timers count from the
+// scheduler's last tick) - re-arm it for this instead of dropping the write.
+uint32_t persistDelayMs(const PersistState& ps, uint32_t nowMs);
+
+// Call just before writing - clears dirty, bumps the counters and returns the
+// lifetime write count to store with this write
+uint32_t persistBeginWrite(PersistState& ps);
+
+// Changes that didn't need a write of their own
+uint32_t persistCoalesced(const PersistState& ps);
+
+#endif
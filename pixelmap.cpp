@@ -0,0 +1,99 @@
+#include "pixelmap.h"
+#include <math.h>
+
+static const float MAP_PI = 3.14159265f;
+
+struct MapPos { float x, y, z; };
+
+// Centre of pixel i of a segment, in mm
+static MapPos segmentPoint(const MapSegment& s, uint16_t i){
+  float f = (i + 0.5f) / s.count;
+  if(s.shape == MAP_LINE) {
+    return {s.x + (s.x2 - s.x) * f, s.y + (s.y2 - s.y) * f, s.z + (s.z2 - s.z) * f};
+  }
+  float a = (s.startDeg + (s.endDeg - s.startDeg) * f) * MAP_PI / 180;
+  float u = s.radius * cosf(a), v = s.radius * sinf(a), w = s.rise * f;
+  if(s.axis == MAP_AXIS_Y) return {s.x + u, s.y + w, s.z + v};
+  return {s.x + u, s.y + v, s.z + w};
+}
+
+uint16_t mapPixels(const PixelMapDef& def){
+  uint32_t n = 0;
+  for(uint8_t i = 0; i < def.count; i++) n += def.segs[i].count;
+  return n > 0xFFFF ? 0xFFFF : (uint16_t)n;
+}
+
+// Calls fn(index, position) for every pixel of the map in order
+template<class F> static void forEachPixel(const MapSegment* segs, uint8_t n, F fn){
+  uint16_t idx = 0;
+  for(uint8_t s = 0; s < n; s++) {
+    for(uint16_t i = 0; i < segs[s].count; i++) fn(idx++, segmentPoint(segs[s], i));
+  }
+}
+
+bool mapBuild(const PixelMapDef& def, uint16_t numLeds, MapPoint* out){
+  if(!numLeds) return false;
+  bool fits = def.segs && mapPixels(def) == numLeds;
+  const MapSegment line = mapLine(numLeds, -(int16_t)numLeds, 0, 0, numLeds, 0, 0);
+  const MapSegment* segs = fits ? def.segs : &line;
+  uint8_t segCount = fits ? def.count : 1;
+  uint8_t polar = fits ? def.polarAxis : (uint8_t)MAP_AXIS_Z;
+
+  // Bounding box - centre and the largest half-extent
+  MapPos lo = {1e9f, 1e9f, 1e9f}, hi = {-1e9f, -1e9f, -1e9f};
+  forEachPixel(segs, segCount, [&](uint16_t, MapPos p){
+    lo = {fminf(lo.x, p.x), fminf(lo.y, p.y), fminf(lo.z, p.z)};
+    hi = {fmaxf(hi.x, p.x), fmaxf(hi.y, p.y), fmaxf(hi.z, p.z)};
+  });
+  MapPos c = {(lo.x + hi.x) / 2, (lo.y + hi.y) / 2, (lo.z + hi.z) / 2};
+  float half = fmaxf(fmaxf(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) / 2;
+  float scale = half > 0.001f ? MAP_ONE / half : 0;
+
+  // Q15 coordinates, polar angle, and the farthest pixel from the polar axis
+  float maxRadius = 0;
+  forEachPixel(segs, segCount, [&](uint16_t i, MapPos p){
+    float x = (p.x - c.x) * scale, y = (p.y - c.y) * scale, z = (p.z - c.z) * scale;
+    float v = polar == MAP_AXIS_Y ? z : y;
+    out[i] = {(int16_t)lrintf(x), (int16_t)lrintf(y), (int16_t)lrintf(z),
+              (uint16_t)(int32_t)lrintf(atan2f(v, x) * 32768 / MAP_PI), 0};
+    maxRadius = fmaxf(maxRadius, hypotf(x, v));
+  });
+
+  // Radius from the unrounded positions - a thin pole is only a few hundred
+  // Q15 steps across
+  if(maxRadius > 0) {
+    forEachPixel(segs, segCount, [&](uint16_t i, MapPos p){
+      float x = (p.x - c.x) * scale, v = ((polar == MAP_AXIS_Y ? p.z - c.z : p.y - c.y)) * scale;
+      out[i].radius = (uint16_t)lrintf(hypotf(x, v) * 65535 / maxRadius);
+    });
+  }
+  return fits;
+}
+
+MapDir mapDir(uint16_t azimuth, uint16_t elevation){
+  float az = azimuth * MAP_PI / 32768, el = elevation * MAP_PI / 32768;
+  return {(int16_t)lrintf(cosf(el) * cosf(az) * MAP_ONE), (int16_t)lrintf(sinf(el) * MAP_ONE),
+          (int16_t)lrintf(cosf(el) * sinf(az) * MAP_ONE)};
+}
+
+// Floor square root - shift-and-subtract without branches, starting at the
+// highest set bit (one NSAU on the ESP32)
+static uint32_t isqrt32(uint32_t v){
+  if(!v) return 0;
+  uint32_t root = 0, bit = 1u << ((31 - __builtin_clz(v)) & ~1u);
+  while(bit) {
+    uint32_t trial = root + bit;
+    uint32_t take = 0u - (uint32_t)(v >= trial);
+    v -= trial & take;
+    root = (root >> 1) + (bit & take);
+    bit >>= 2;
+  }
+  return root;
+}
+
+uint16_t mapDistance(const MapPoint& p, int16_t x, int16_t y, int16_t z){
+  // Halved so the sum of squares fits 32 bits, doubled back after the root
+  int32_t dx = ((int32_t)p.x - x) >> 1, dy = ((int32_t)p.y - y) >> 1, dz = ((int32_t)p.z - z) >> 1;
+  uint32_t d = isqrt32((uint32_t)(dx * dx) + (uint32_t)(dy * dy) + (uint32_t)(dz * dz)) << 1;
+  return d > 0xFFFF ? 0xFFFF : (uint16_t)d;
+}
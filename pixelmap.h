@@ -0,0 +1,92 @@
+#ifndef PIXELMAP_H
+#define PIXELMAP_H
+
+// ── Pixel Map ────────────────────────────────────────────────────────────────
+// Where every pixel of a node sits in space, so patterns can draw by position
+// instead of by index. A map is a short list of segments kept in flash:
+// straight runs and arcs (a strip wound round a pole is an arc with a rise,
+// an arch is a half circle), in mm and in logical pixel order. mapBuild()
+// turns it into a fixed-point table once at boot. x/y/z are scaled to the
+// map's largest half-extent about its centre (Q15, so shapes keep their
+// proportions), plus the angle and distance around the map's polar axis.
+// Per frame, patterns only do integer math on the table - projections for
+// waves in any direction, spiral phases, distances - never per-pixel trig.
+// Hardware-independent: the firmware (patterns.cpp) and
+// tools/pixelmap_bench.cpp share this.
+
+#include <stdint.h>
+
+static const int16_t MAP_ONE = 32767;   // Q15 1.0
+
+enum MapShape : uint8_t { MAP_LINE, MAP_ARC };
+enum MapAxis  : uint8_t {
+  MAP_AXIS_Y,   // Up - round a pole
+  MAP_AXIS_Z,   // Towards the viewer - an arch, or a line seen side on
+};
+
+struct MapSegment {
+  uint8_t  shape;
+  uint8_t  axis;               // MAP_ARC: the axis it turns around
+  uint16_t count;              // Pixels on this segment
+  int16_t  x, y, z;            // MAP_LINE start, MAP_ARC centre (mm)
+  int16_t  x2, y2, z2;         // MAP_LINE end
+  int16_t  radius;             // MAP_ARC (mm)
+  int16_t  startDeg, endDeg;   // MAP_ARC - more than 360 apart for a helix
+  int16_t  rise;               // MAP_ARC - travel along the axis from start to end (mm)
+};
+
+constexpr MapSegment mapLine(uint16_t count, int16_t x, int16_t y, int16_t z,
+                             int16_t x2, int16_t y2, int16_t z2){
+  return {MAP_LINE, MAP_AXIS_Y, count, x, y, z, x2, y2, z2, 0, 0, 0, 0};
+}
+
+constexpr MapSegment mapArc(uint16_t count, uint8_t axis, int16_t cx, int16_t cy, int16_t cz,
+                            int16_t radius, int16_t startDeg, int16_t endDeg, int16_t rise){
+  return {MAP_ARC, axis, count, cx, cy, cz, 0, 0, 0, radius, startDeg, endDeg, rise};
+}
+
+// A shape a node can be mounted as
+struct PixelMapDef {
+  const char*       name;
+  const MapSegment* segs;        // nullptr - a straight line of any length
+  uint8_t           count;
+  uint8_t           polarAxis;   // MapAxis that angle and radius are measured around
+};
+
+// One pixel, precomputed
+struct MapPoint {
+  int16_t  x, y, z;    // Q15, the map's centre is 0
+  uint16_t angle;      // Around the polar axis, a full turn = 65536
+  uint16_t radius;     // From the polar axis, 65535 = the farthest pixel
+};
+
+// Pixels def's segments place (0 for the line)
+uint16_t mapPixels(const PixelMapDef& def);
+
+// Fill out[0..numLeds). When def doesn't place exactly numLeds pixels, the
+// pixels go on a straight line along x instead and this returns false.
+bool     mapBuild(const PixelMapDef& def, uint16_t numLeds, MapPoint* out);
+
+// ── Sampling ─────────────────────────────────────────────────────────────────
+// Q15 unit vector - make it once per frame, use it for every pixel
+struct MapDir { int16_t x, y, z; };
+
+// azimuth round y from +x towards +z, elevation up from the x-z plane - full turn = 65536
+MapDir   mapDir(uint16_t azimuth, uint16_t elevation);
+
+// Position along d, Q15 - a plane wave through the structure is sin(mapProject() * k + t)
+static inline int16_t mapProject(const MapPoint& p, const MapDir& d){
+  int32_t dot = ((int32_t)p.x * d.x + (int32_t)p.y * d.y + (int32_t)p.z * d.z) >> 15;
+  return dot > 32767 ? 32767 : dot < -32768 ? -32768 : (int16_t)dot;
+}
+
+// Spiral phase, wrapping: arms turns per turn of the angle, plus twist
+// (8.8 turns) from the axis out to the farthest pixel
+static inline uint16_t mapSpiral(const MapPoint& p, uint8_t arms, int16_t twist){
+  return (uint16_t)(p.angle * arms + (((int32_t)p.radius * twist) >> 8));
+}
+
+// Distance to the point (x, y, z), Q15 - saturates at 65535
+uint16_t mapDistance(const MapPoint& p, int16_t x, int16_t y, int16_t z);
+
+#endif
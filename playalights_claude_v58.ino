@@ -12,8 +12,16 @@
 #include "networking.h"
 #include "audio.h"
 #include "ui.h"
+#include "storage.h"
 #include "ota.h"
+#include "output.h"
+#include "scheduler.h"
 #include "version.h"
+#include "stallrec.h"
+#include "esp_task_wdt.h"
+#if defined(__XTENSA__)
+#include <xtensa_context.h>
+#endif
 
 // ── Global Variable Definitions ───────────────────────────────────────────────
 Mode      currentMode      = AUTO;
@@ -21,26 +29,29 @@ FsmState  fsmState         = FOLLOWER;
 uint8_t   styleIdx         = 0;
 bool      freezeActive     = false;
 
-CRGB      leds[NUM_LEDS];
+CRGB      leds[MAX_LEDS];
+uint16_t  numLeds           = DEFAULT_LEDS;
+uint8_t   pixelMap          = 0;
 LGFX_Sprite canvas(&M5.Lcd);
 Preferences prefs;
+BootProfile bootProfile;
 
 // ── Global Brightness Control ────────────────────────────────────────────────
 uint8_t   globalBrightnessScale = 64;  // 25% of max brightness (64/255) - LOCAL CONTROL
 
 // ── Control Arrays ────────────────────────────────────────────────────────────
-uint8_t speedVals[MODE_COUNT][22], brightVals[MODE_COUNT][22],
-        ssensVals[MODE_COUNT][22], bsensVals[MODE_COUNT][22],
-        vsensVals[MODE_COUNT][22], decayVals[MODE_COUNT][22],
-        timeVals[MODE_COUNT][22];
+uint8_t speedVals[MODE_COUNT][PATTERN_COUNT], brightVals[MODE_COUNT][PATTERN_COUNT],
+        ssensVals[MODE_COUNT][PATTERN_COUNT], bsensVals[MODE_COUNT][PATTERN_COUNT],
+        vsensVals[MODE_COUNT][PATTERN_COUNT], decayVals[MODE_COUNT][PATTERN_COUNT],
+        timeVals[MODE_COUNT][PATTERN_COUNT];
 
 // ── Network Variables ─────────────────────────────────────────────────────────
 uint8_t  broadcastAddress[6] = {0xff,0xff,0xff,0xff,0xff,0xff};
-uint32_t masterSeq         = 0, chunkMask      = 0, lastRecvMillis = 0;
+uint32_t masterSeq         = 0, lastRecvMillis = 0;
 uint32_t electionStart     = 0, electionEnd    = 0;
 uint32_t myToken           = 0, highestTokenSeen = 0, myDelay = 0;
 bool     electionBroadcasted = false;
-uint32_t lastTokenBroadcast  = 0, lastHeartbeat      = 0, missedFrameCount   = 0;
+uint32_t lastTokenBroadcast  = 0, missedFrameCount   = 0;
 
 // ── OTA Coordination Variables ───────────────────────────────────────────────
 bool     otaSuspended        = false;  // Start active - controlled manually via serial commands
@@ -49,41 +60,132 @@ uint32_t otaSuspendDuration  = 300000; // No longer used - kept for compatibilit
 uint32_t bootupQuietTime     = 60000;  // Stay quiet for 60s after boot
 
 // ── Audio Variables ───────────────────────────────────────────────────────────
-float   soundMin      = 1.0f, soundMax      = 0.0f, musicLevel = 0.0f;
-bool    prevAbove     = false;
-uint32_t beatTimes[50];
-uint8_t  beatCount    = 0;
+float   musicLevel    = 0.0f;
+AudioFeatures audioFeatures = {};
 uint32_t lastBpmMillis= 0;
 bool    audioDetected = true;
 
 // ── Watchdog Variables ────────────────────────────────────────────────────────
-uint32_t lastWatchdogUpdate = 0;
-const uint32_t WATCHDOG_TIMEOUT = 30000;  // 30 seconds
+static const uint32_t TASK_WDT_TIMEOUT_MS = 10000;  // Above the longest legitimate block, a full-partition erase
+static const uint32_t STALL_TICK_US       = 10000;  // Sampler period
+RTC_NOINIT_ATTR StallRecord stallRecord;            // Survives the reset it explains
+static StallRecord lastRunStalls;
+static bool        lastRunKept = false;
+static uint8_t     lastResetReason = 0;
+static TaskHandle_t loopTask = nullptr;
+static portMUX_TYPE stallMux = portMUX_INITIALIZER_UNLOCKED;
 
 // ── System State Variables ────────────────────────────────────────────────────
-uint32_t lastSystemCheck = 0;
 const uint32_t SYSTEM_CHECK_INTERVAL = 5000; // Check system health every 5 seconds
 
+// ── Loop Stall Metric ─────────────────────────────────────────────────────────
+uint32_t maxLoopStallUs      = 0;  // Longest gap between loop() passes since boot
+uint32_t windowLoopStallUs   = 0;  // Longest gap since the last health report
+LoopHistogram loopHist;            // Pass times for the telemetry beacon's p99
+static uint32_t lastLoopMicros = 0;
+
 // ── Non-blocking OFF mode timing ──────────────────────────────────────────────
-static uint32_t lastOFFModeUpdate = 0;
 const uint32_t OFF_MODE_UPDATE_INTERVAL = 200; // Update OFF mode every 200ms
 
 void feedWatchdog() {
-  lastWatchdogUpdate = millis();
+  esp_task_wdt_reset();
 }
 
-void checkWatchdog() {
-  uint32_t now = millis();
-  if (now - lastWatchdogUpdate > WATCHDOG_TIMEOUT) {
-    if(DEBUG_SERIAL) Serial.println("WATCHDOG: System appears hung - restarting...");
-    ESP.restart();
+// Mark what loop() is doing - the sampler and the next boot's report read it
+static void loopPhase(LoopPhase phase) {
+  portENTER_CRITICAL(&stallMux);
+  stallPhase(stallRecord, phase, micros(), millis());
+  portEXIT_CRITICAL(&stallMux);
+}
+
+// Timer interrupt on the loop's core: where is the loop task right now?
+static void sampleStall() {
+  uint32_t pc = 0;
+#if defined(__XTENSA__)
+  // A TCB starts with the task's saved stack pointer, which points at the frame
+  // FreeRTOS saved on interrupt entry or its last switch - both hold the PC
+  if(loopTask) pc = (*(const XtExcFrame* const*)loopTask)->pc;
+#endif
+  portENTER_CRITICAL_ISR(&stallMux);
+  stallSample(stallRecord, micros(), millis(), pc);
+  portEXIT_CRITICAL_ISR(&stallMux);
+}
+
+static void printStallRun(const StallRecord& r, bool died) {
+  uint32_t pcs[STALL_PC_SAMPLES];
+  uint8_t n = stallSamples(r, pcs);
+  Serial.printf("  %s '%s' for %.1fms at %.1fs uptime", died ? "died in" : "now in",
+    LOOP_PHASE_NAMES[r.phase], stallPhaseUs(r) / 1000.0f, r.tickMs / 1000.0f);
+  if(n) Serial.print(", pc");
+  for(uint8_t i = 0; i < n; i++) Serial.printf(" 0x%08x", pcs[i]);
+  Serial.println();
+  const StallEvent* hist[STALL_HISTORY];
+  uint8_t h = stallHistory(r, hist);
+  for(uint8_t i = 0; i < h; i++) {
+    const StallEvent& e = *hist[i];
+    Serial.printf("  stall %9.1fs  %-8s %7.1fms", e.startMs / 1000.0f, LOOP_PHASE_NAMES[e.phase], e.durUs / 1000.0f);
+    if(e.pcCount) Serial.print("  pc");
+    for(uint8_t j = 0; j < e.pcCount; j++) Serial.printf(" 0x%08x", e.pc[j]);
+    Serial.println();
+  }
+}
+
+void printStallReport(bool thisRun) {
+  if(lastRunKept) {
+    Serial.printf("STALLS: previous run ended by %s reset (%u resets since power-on)\n",
+      telemetryResetName(lastResetReason), stallRecord.resets);
+    printStallRun(lastRunStalls, true);
+  } else {
+    Serial.printf("STALLS: no record of the previous run (%s reset)\n", telemetryResetName(lastResetReason));
+  }
+  if(!thisRun) return;
+  Serial.println("STALLS: this run");
+  portENTER_CRITICAL(&stallMux);
+  static StallRecord now;
+  memcpy(&now, &stallRecord, sizeof(now));
+  portEXIT_CRITICAL(&stallMux);
+  printStallRun(now, false);
+}
+
+// Hardware task watchdog on the loop task (render and network both run there),
+// plus the stall sampler. First thing in setup() so every feed counts.
+static void initWatchdog() {
+  loopTask = xTaskGetCurrentTaskHandle();
+  lastResetReason = esp_reset_reason();
+  lastRunKept = stallRecordBoot(stallRecord, lastRunStalls, lastResetReason != ESP_RST_POWERON);
+  
+  // Core 0's idle task stays watched, as the Arduino core sets it up
+  esp_task_wdt_config_t cfg = {TASK_WDT_TIMEOUT_MS, 1 << 0, true};
+  if(esp_task_wdt_reconfigure(&cfg) != ESP_OK) esp_task_wdt_init(&cfg);
+  esp_task_wdt_add(loopTask);
+  
+  hw_timer_t* sampler = timerBegin(1000000);
+  timerAttachInterrupt(sampler, sampleStall);
+  timerAlarm(sampler, STALL_TICK_US, true, 0);
+}
+
+void trackLoopStall() {
+  uint32_t nowUs = micros();
+  if (lastLoopMicros != 0) {
+    uint32_t gap = nowUs - lastLoopMicros;
+    if (gap > windowLoopStallUs) windowLoopStallUs = gap;
+    if (gap > maxLoopStallUs)    maxLoopStallUs = gap;
+    loopHistNote(loopHist, gap);
   }
+  lastLoopMicros = nowUs;
 }
 
-void checkSystemHealth() {
+// Runs every SYSTEM_CHECK_INTERVAL from the scheduler (AUTO mode only)
+void checkSystemHealth(void*) {
+  if (currentMode != AUTO) return;
   uint32_t now = millis();
-  if (now - lastSystemCheck < SYSTEM_CHECK_INTERVAL) return;
-  lastSystemCheck = now;
+  
+  // Report the worst loop() stall - anything near a frame period shows up as stutter
+  if(DEBUG_SERIAL) {
+    Serial.printf("HEALTH: max loop stall %.1fms (last %us), %.1fms since boot\n",
+      windowLoopStallUs / 1000.0f, SYSTEM_CHECK_INTERVAL / 1000, maxLoopStallUs / 1000.0f);
+  }
+  windowLoopStallUs = 0;
   
   // Check ESP-NOW peer status
   if (!esp_now_is_peer_exist(broadcastAddress)) {
@@ -122,7 +224,7 @@ void checkSystemHealth() {
         myDelay = random(0, ELECTION_JITTER);
         electionBroadcasted = false;
         missedFrameCount = 0;
-        chunkMask = 0;
+        resetFrameAssembly();
         stuckCounter = 0;
       }
     }
@@ -134,12 +236,59 @@ void checkSystemHealth() {
   }
 }
 
+// OFF mode - keep the dimmed status screen current without running the mesh
+void updateOFFMode(void*) {
+  if (currentMode != OFF) return;
+  if (shouldUpdateUI()) drawUI();   // Show OFF status on dimmed display
+}
+
+// ── Boot ──────────────────────────────────────────────────────────────────────
+static TimerId bootDeferTimer = TIMER_NONE;
+
+void printBootProfile() {
+  const BootProfile& bp = bootProfile;
+  Serial.println("BOOT PROFILE (ms since app start):");
+  for(int i = 0; i < bp.count; i++) {
+    const BootStage& st = bp.stages[i];
+    if(st.endUs) Serial.printf("  %-10s %7.1f -> %7.1f  (%.1f)\n", st.name,
+                               st.startUs / 1000.0f, st.endUs / 1000.0f, (st.endUs - st.startUs) / 1000.0f);
+    else         Serial.printf("  %-10s %7.1f -> running\n", st.name, st.startUs / 1000.0f);
+  }
+  Serial.printf("  stages total %.1fms\n", bootStagesUs(bp) / 1000.0f);
+  for(int m = 0; m < BOOT_MILESTONE_COUNT; m++) {
+    if(bp.milestoneUs[m]) Serial.printf("  %-20s %7.1f\n", BOOT_MILESTONE_NAMES[m], bp.milestoneUs[m] / 1000.0f);
+    else                  Serial.printf("  %-20s pending\n", BOOT_MILESTONE_NAMES[m]);
+  }
+  if(bootReached(bp, BOOT_FIRST_FRAME)) {
+    Serial.printf("  first frame as %s\n", bp.firstFrameAsLeader ? "leader" : "follower");
+  }
+}
+
+// Everything the first synced frame doesn't need - runs once that frame is
+// out, or BOOT_DEFER_MAX_MS after setup() if it takes longer
+static void finishBoot(void*) {
+  bootStageBegin(bootProfile, "audio", micros());
+  initAudio();
+  bootStageEnd(bootProfile, micros());
+  feedWatchdog();
+  if(DEBUG_SERIAL) printBootProfile();
+}
+
 // ── Setup ─────────────────────────────────────────────────────────────────────
 void setup(){
-  Serial.begin(115200);
+  if(CAPTURE_MODE) {
+    // Room for a few frames of capture records so loop() never waits on the port
+    Serial.setTxBufferSize(8192);
+    Serial.begin(CAPTURE_BAUD);
+  } else {
+    Serial.begin(115200);
+  }
   
   // Initialize watchdog
-  feedWatchdog();
+  initWatchdog();
+  
+  // Timers must exist before modules start scheduling work in their init
+  schedulerInit(millis());
   
   // Show startup info
   if(DEBUG_SERIAL) {
@@ -147,54 +296,66 @@ void setup(){
     Serial.printf("NeoPixel Controller v%s\n", FIRMWARE_VERSION);
     Serial.printf("Build: %s %s\n", BUILD_DATE, BUILD_TIME);
     Serial.println("=====================================");
+    if(lastRunKept) printStallReport(false);
   }
   
-  // Initialize M5 hardware
+  // Critical path first: power/board, radio listening, LEDs. Packets that
+  // arrive while the rest of setup runs wait in the receive ring. Settings
+  // come before the radio - the strip length sizes the receive path.
+  bootStageBegin(bootProfile, "m5", micros());
   M5.begin();
   feedWatchdog();
   
-  // Initialize all modules
+  bootStageBegin(bootProfile, "controls", micros());
   loadControls();
   feedWatchdog();
-  initUI();
-  feedWatchdog();
-  initAudio();
-  feedWatchdog();
-  initNetworking();
-  feedWatchdog();
   
-  // Initialize OTA (must be after networking for WiFi)
-  initOTA();
+  bootStageBegin(bootProfile, "espnow", micros());
+  initNetworking();
   feedWatchdog();
   
-  // Initialize FastLED
-  FastLED.addLeds<CHIPSET, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS)
-         .setCorrection(TypicalLEDStrip);
+  bootStageBegin(bootProfile, "leds", micros());
   // Start with default local brightness (25%)
   FastLED.setBrightness(globalBrightnessScale);
+  initLeds();
+  feedWatchdog();
+  
+  bootStageBegin(bootProfile, "map", micros());
+  initPixelMap();
+  feedWatchdog();
+  
+  bootStageBegin(bootProfile, "ui", micros());
+  initUI();
+  drawBootSplash();
+  bootStageEnd(bootProfile, micros());
   feedWatchdog();
+  
+  // Audio only matters once we're leading - start it off the critical path.
+  // OTA needs WiFi, which isn't checked until later; loop() starts it then.
+  bootDeferTimer = timerOnce(BOOT_DEFER_MAX_MS, finishBoot);
 
   // Initialize timing and state
   randomSeed(micros());
   lastRecvMillis     = millis();
   lastTokenBroadcast = millis();
-  lastHeartbeat      = millis();
-  lastSystemCheck    = millis();
   missedFrameCount   = 0;
   
+  // Periodic housekeeping runs from the scheduler instead of polling in loop()
+  timerEvery(SYSTEM_CHECK_INTERVAL, checkSystemHealth);
+  timerEvery(OFF_MODE_UPDATE_INTERVAL, updateOFFMode);
+  
   // Ensure we start in a clean state
   fsmState = FOLLOWER;
   currentMode = AUTO;
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
   
   // OTA Coordination: ESP-NOW suspension is now controlled manually via serial commands
   // No automatic boot quiet mode - use "SUSPEND_ESPNOW" and "RESUME_ESPNOW" commands
   
   if(DEBUG_SERIAL) {
-    Serial.printf("NeoPixel Controller v%s initialized - 42 patterns ready!\n", FIRMWARE_VERSION);
+    Serial.printf("NeoPixel Controller v%s initialized - %d patterns ready!\n", FIRMWARE_VERSION, PATTERN_COUNT);
     Serial.printf("Ready for OTA updates at: NeoNode-%06X.local\n", myToken);
-    Serial.println("Watchdog timer enabled (30s timeout)");
+    Serial.printf("Task watchdog enabled (%us timeout), stall sampler every %ums\n",
+      TASK_WDT_TIMEOUT_MS / 1000, STALL_TICK_US / 1000);
     Serial.printf("Local brightness: %d/255 (%.1f%%) - each node controls its own\n", 
       globalBrightnessScale, (globalBrightnessScale * 100.0f) / 255.0f);
     Serial.println("Button A: Short press = local brightness cycle, Long press = OFF/ON");
@@ -217,7 +378,7 @@ void handleSerialCommands(){
     static uint32_t lastFlash = 0;
     if(millis() - lastFlash > 100) { // Limit flash rate
       fill_solid(leds, 5, CRGB::Blue); // Flash first 5 LEDs blue
-      FastLED.show();
+      showLeds();
       lastFlash = millis();
     }
     
@@ -225,9 +386,48 @@ void handleSerialCommands(){
       // Command complete - process it
       commandBuffer.trim();
       
-      // No serial commands currently implemented
-      if(commandBuffer.length() > 0) {
-        Serial.println("[SERIAL] No commands available");
+      if(commandBuffer.equalsIgnoreCase("BOOT")) {
+        printBootProfile();
+      } else if(commandBuffer.equalsIgnoreCase("SETTINGS")) {
+        printStorageStats();
+      } else if(commandBuffer.equalsIgnoreCase("SAVE")) {
+        flushSettings("serial");
+      } else if(commandBuffer.equalsIgnoreCase("PATTERNS")) {
+        benchmarkPatterns();
+      } else if(commandBuffer.equalsIgnoreCase("STALLS")) {
+        printStallReport(true);
+      } else if(commandBuffer.equalsIgnoreCase("FLEET")) {
+        printFleetTable();
+      } else if(commandBuffer.equalsIgnoreCase("MESHOTA")) {
+        meshOtaStartSeed(false);
+      } else if(commandBuffer.equalsIgnoreCase("MESHOTA FULL")) {
+        meshOtaStartSeed(true);
+      } else if(commandBuffer.equalsIgnoreCase("LEDS")) {
+        printLedConfig();
+      } else if(commandBuffer.startsWith("LEDS ")) {
+        // Buffers, strips and the receive path are set up for one length - reboot into the new one
+        uint16_t n = commandBuffer.substring(5).toInt();
+        if(n == numLeds) {
+          Serial.printf("LEDS: already %u pixels\n", n);
+        } else if(saveStripLength(n)) {
+          Serial.printf("LEDS: %u pixels from the next boot - restarting\n", n);
+          Serial.flush();
+          ESP.restart();
+        } else {
+          Serial.printf("LEDS: strip length must be %u-%u\n", MIN_LEDS, MAX_LEDS);
+        }
+      } else if(commandBuffer.equalsIgnoreCase("MAP")) {
+        printPixelMaps();
+      } else if(commandBuffer.startsWith("MAP ")) {
+        // Tables are numLeds long already - rebuild in place, no reboot
+        if(selectPixelMap(commandBuffer.substring(4).c_str())) {
+          settingsChanged();
+          printPixelMaps();
+        } else {
+          Serial.println("MAP: no such map - MAP lists them");
+        }
+      } else if(commandBuffer.length() > 0) {
+        Serial.println("[SERIAL] Unknown command - available: BOOT, SETTINGS, SAVE, PATTERNS, STALLS, FLEET, LEDS [n], MAP [name], MESHOTA [FULL]");
       }
       
       commandBuffer = ""; // Clear buffer
@@ -247,39 +447,52 @@ void handleSerialCommands(){
 void loop(){
   // Feed watchdog at start of every loop
   feedWatchdog();
+  trackLoopStall();
   
+  loopPhase(PHASE_M5);
   M5.update();
   
   // Handle serial commands for OTA coordination
+  loopPhase(PHASE_SERIAL);
   handleSerialCommands();
   
   // Initialize OTA if WiFi becomes available (retry periodically)
+  loopPhase(PHASE_OTA);
   initOTA();
   
   // Handle OTA updates (highest priority, but only if WiFi connected)
   handleOTA();
   
   // Handle user input
+  loopPhase(PHASE_BUTTONS);
   handleButtons();
   
+  // Fire due timers (health checks, heartbeats, WiFi, deferred resets...)
+  loopPhase(PHASE_TIMERS);
+  schedulerRun(millis());
+  
   if(currentMode == OFF) {
-    // OFF mode - minimal processing for battery savings
-    uint32_t now = millis();
-    if (now - lastOFFModeUpdate >= OFF_MODE_UPDATE_INTERVAL) {
-      if (shouldUpdateUI()) drawUI();   // Show OFF status on dimmed display
-      lastOFFModeUpdate = now;
-    }
+    // OFF mode - minimal processing for battery savings (UI refresh runs on a timer)
+    loopPhase(PHASE_OUTSIDE);
     return;     // Skip all LED/networking processing
   }
   
   // AUTO mode - full functionality
+  loopPhase(PHASE_AUDIO);
+  serviceAudio();     // Analyse whatever the capture task has recorded since the last pass
+  loopPhase(PHASE_NETWORK);
   handleNetworking(); // This handles WiFi transitions gracefully
+  
+  // First synced frame is out - deferred boot work can have the CPU now
+  if(timerPending(bootDeferTimer) && bootReached(bootProfile, BOOT_FIRST_FRAME)) {
+    timerCancel(bootDeferTimer);
+    loopPhase(PHASE_SETUP);
+    finishBoot(nullptr);
+  }
+  loopPhase(PHASE_UI);
   if (shouldUpdateUI()) drawUI();  // Non-blocking UI updates
+  loopPhase(PHASE_BPM);
   updateBPM();
   
-  // Periodic system health checks
-  checkSystemHealth();
-  
-  // Check watchdog (will restart if hung)
-  checkWatchdog();
+  loopPhase(PHASE_OUTSIDE);
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "playout.h"
+#include <string.h>
+
+void playoutInit(Playout& po, uint8_t* slotA, uint8_t* slotB, uint8_t* slotC, uint16_t numLeds){
+  po.slot[0] = slotA;
+  po.slot[1] = slotB;
+  po.slot[2] = slotC;
+  po.numLeds = numLeds;
+  playoutReset(po);
+  po.stats = {};
+}
+
+void playoutReset(Playout& po){
+  po.newest = 0;
+  po.count = 0;
+  po.offsetUs = 0;
+  po.synced = false;
+  po.intervalUs = 0;
+}
+
+void playoutPush(Playout& po, const uint8_t* rgb, uint32_t leaderUs, uint32_t localUs){
+  if(po.count) {
+    int32_t step = (int32_t)(leaderUs - po.stampUs[po.newest]);
+    if(step < -(int32_t)PLAYOUT_MAX_GAP_US || step > (int32_t)PLAYOUT_MAX_GAP_US) {
+      playoutReset(po);                            // Another leader's clock, or a restarted one
+    } else if(step <= 0) {
+      return;                                      // Not newer than what we have
+    } else if(!po.intervalUs) {
+      po.intervalUs = step;
+    } else if((uint32_t)step < po.intervalUs * 5 / 2) {
+      // Lost frames show up as double steps - leave those out
+      po.intervalUs += (step - (int32_t)po.intervalUs) / 8;
+    }
+  }
+
+  uint8_t s = po.count ? (po.newest + 1) % PLAYOUT_SLOTS : 0;
+  memcpy(po.slot[s], rgb, (uint32_t)po.numLeds * 3);
+  po.stampUs[s] = leaderUs;
+  po.newest = s;
+  if(po.count < PLAYOUT_SLOTS) po.count++;
+  po.stats.frames++;
+
+  int32_t transit = (int32_t)(localUs - leaderUs);
+  if(!po.synced || transit < po.offsetUs) po.offsetUs = transit;
+  else po.offsetUs += PLAYOUT_OFFSET_LEAK_US;
+  po.synced = true;
+}
+
+// Slot of the frame `back` places behind the newest
+static uint8_t olderSlot(const Playout& po, uint8_t back){
+  return (po.newest + PLAYOUT_SLOTS - back) % PLAYOUT_SLOTS;
+}
+
+const uint8_t* playoutNewest(const Playout& po){
+  return po.count ? po.slot[po.newest] : nullptr;
+}
+
+uint32_t playoutDelayUs(const Playout& po, uint32_t extraUs){
+  return po.intervalUs + po.intervalUs / 4 + PLAYOUT_JITTER_US + extraUs;
+}
+
+PlayoutKind playoutRender(Playout& po, uint32_t localUs, uint32_t extraUs, uint8_t* out){
+  if(!po.count) return PLAYOUT_EMPTY;
+  uint32_t bytes = (uint32_t)po.numLeds * 3;
+  const uint8_t* b = po.slot[po.newest];
+  if(po.count < 2) {
+    memcpy(out, b, bytes);
+    po.stats.held++;
+    return PLAYOUT_HOLD;
+  }
+
+  // Where the display is on the leader's clock. The delay is over one
+  // interval, so right after a frame arrives that is before the one ahead of
+  // it - blend the older pair then, the newest pair once the display is past
+  // the middle frame.
+  uint32_t target = localUs - po.offsetUs - playoutDelayUs(po, extraUs);
+  uint8_t sa = olderSlot(po, 1), sb = po.newest;
+  if(po.count > 2 && (int32_t)(target - po.stampUs[sa]) < 0) {
+    sb = sa;
+    sa = olderSlot(po, 2);
+  }
+  b = po.slot[sb];
+  const uint8_t* a = po.slot[sa];
+
+  // As a Q8 fraction from the older frame (0) to the newer (256)
+  uint32_t span = po.stampUs[sb] - po.stampUs[sa];
+  int32_t into = (int32_t)(target - po.stampUs[sa]);
+  const uint32_t maxAlpha = 256 + PLAYOUT_EXTRAP_MAX;
+  uint32_t alpha = into <= 0 ? 0 : (uint32_t)into >= span * 2 ? maxAlpha : (uint32_t)into * 256 / span;
+  if(alpha > maxAlpha) alpha = maxAlpha;
+
+  // Before the older frame the display stands still - held, not blended
+  PlayoutKind kind = alpha == 0 || alpha == maxAlpha ? PLAYOUT_HOLD : alpha <= 256 ? PLAYOUT_BLEND : PLAYOUT_EXTRAP;
+  if(kind == PLAYOUT_BLEND) po.stats.blended++;
+  else if(kind == PLAYOUT_EXTRAP) po.stats.extrapolated++;
+  else po.stats.held++;
+
+  if(alpha == 0)   { memcpy(out, a, bytes); return kind; }
+  if(alpha == 256) { memcpy(out, b, bytes); return kind; }
+  for(uint32_t i = 0; i < bytes; i++) {
+    int32_t v = a[i] + (((int32_t)b[i] - a[i]) * (int32_t)alpha >> 8);
+    out[i] = v < 0 ? 0 : v > 255 ? 255 : (uint8_t)v;
+  }
+  return kind;
+}
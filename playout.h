@@ -0,0 +1,75 @@
+#ifndef PLAYOUT_H
+#define PLAYOUT_H
+
+// ── Frame Playout ────────────────────────────────────────────────────────────
+// Decouples what a node shows from when frames arrive. Complete frames go into
+// a three-deep history, stamped with the leader's render time. The node then
+// draws at its own steady rate, a little over one frame interval behind the
+// leader, blending the two frames either side of that moment - while a frame
+// is on time that is the older pair, so the newest is there before the display
+// needs it. A late frame doesn't freeze the
+// strip: the display runs on past the newest frame along the same motion for
+// up to PLAYOUT_EXTRAP_MAX of an interval, then holds. So a leader sending
+// 25fps still shows as smooth motion at the display rate.
+//
+// Leader time maps onto the local clock through the fastest transit seen
+// (local receive time - leader timestamp). That absorbs the clock offset and
+// the radio's fixed delay, and creeps up by PLAYOUT_OFFSET_LEAK_US per frame so
+// crystal drift can't wedge it. The leader feeds its own frames in with its
+// own clock, so it shows each frame when the followers do.
+// Hardware-independent: the firmware (networking.cpp) and tools/replay.cpp
+// share this.
+
+#include <stdint.h>
+
+static const uint16_t PLAYOUT_EXTRAP_MAX     = 128;     // Q8 of an interval past the newest frame - half a frame
+static const uint32_t PLAYOUT_JITTER_US      = 4000;    // Late arrival allowed for before extrapolating
+static const uint32_t PLAYOUT_OFFSET_LEAK_US = 20;      // Per frame - far above 20ppm crystal drift
+static const uint32_t PLAYOUT_MAX_GAP_US     = 250000;  // Frames further apart, either way, aren't one motion or one clock - start over
+static const uint8_t  PLAYOUT_SLOTS          = 3;       // The pair being shown plus the next frame
+
+enum PlayoutKind : uint8_t {
+  PLAYOUT_EMPTY,     // Nothing to show yet - out untouched
+  PLAYOUT_HOLD,      // A frame as-is: only one frame so far, the display before the oldest, or
+                     // extrapolated as far as allowed
+  PLAYOUT_BLEND,     // Between two frames
+  PLAYOUT_EXTRAP,    // Past the newest frame, along the last motion
+};
+
+struct PlayoutStats {
+  uint32_t blended, extrapolated, held;   // Display frames of each kind
+  uint32_t frames;                        // Frames pushed
+};
+
+struct Playout {
+  uint8_t*  slot[PLAYOUT_SLOTS];      // numLeds x 3 bytes each
+  uint16_t  numLeds;
+  uint8_t   newest;                   // Slot of the newest frame
+  uint8_t   count;                    // Frames held, 0-PLAYOUT_SLOTS
+  uint32_t  stampUs[PLAYOUT_SLOTS];   // Leader render time of each slot
+  int32_t   offsetUs;        // Local - leader time, fastest transit seen
+  bool      synced;          // offsetUs is set
+  uint32_t  intervalUs;      // Smoothed leader frame interval, 0 until two frames
+  PlayoutStats stats;
+};
+
+void playoutInit(Playout& po, uint8_t* slotA, uint8_t* slotB, uint8_t* slotC, uint16_t numLeds);
+
+// Forget the history and the clock mapping - a new leader, an FSM change
+void playoutReset(Playout& po);
+
+// A complete frame: leaderUs is its render time on the leader's clock, localUs
+// when it completed here (both the same on the leader itself). Copied in.
+void playoutPush(Playout& po, const uint8_t* rgb, uint32_t leaderUs, uint32_t localUs);
+
+// The newest frame pushed, nullptr when empty
+const uint8_t* playoutNewest(const Playout& po);
+
+// Delay from the leader's render time to the display, extraUs included
+uint32_t playoutDelayUs(const Playout& po, uint32_t extraUs);
+
+// Draw the frame due at local time localUs into out (numLeds x 3). extraUs
+// delays the display further - relay mode lines hop levels up with it.
+PlayoutKind playoutRender(Playout& po, uint32_t localUs, uint32_t extraUs, uint8_t* out);
+
+#endif
@@ -0,0 +1,154 @@
+#include "protocol.h"
+#include <string.h>
+
+// v1 message types (see config.h) - duplicated here to keep this file portable
+static const uint8_t V1_RAW   = 0x00;
+static const uint8_t V1_TOKEN = 0x01;
+
+// CRC-16/CCITT-FALSE, nibble table - 32 bytes of flash, two lookups per byte
+static const uint16_t CRC16_NIBBLE[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint16_t protoCrc16(const uint8_t* data, int len, uint16_t crc){
+  for(int i = 0; i < len; i++){
+    crc = (crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ CRC16_NIBBLE[(crc >> 12) ^ (data[i] & 0x0F)];
+  }
+  return crc;
+}
+
+// CRC covers the header up to the CRC field, then the payload
+static uint16_t packetCrc(const uint8_t* buf, int len){
+  uint16_t crc = protoCrc16(buf, PROTO_HEADER_LEN - 2);
+  return protoCrc16(buf + PROTO_HEADER_LEN, len - PROTO_HEADER_LEN, crc);
+}
+
+int protoBuildV2(uint8_t* buf, uint8_t kind, uint8_t flags, uint32_t token,
+                 uint16_t frameId, uint8_t chunkIdx, uint8_t chunkCount,
+                 uint32_t timestampUs, uint16_t offset,
+                 const uint8_t* payload, uint16_t payloadLen){
+  buf[0] = PROTO_TYPE_V2;
+  buf[1] = PROTO_VERSION;
+  buf[2] = kind;
+  buf[3] = flags;
+  memcpy(buf + 4,  &token, 4);
+  memcpy(buf + 8,  &frameId, 2);
+  buf[10] = chunkIdx;
+  buf[11] = chunkCount;
+  memcpy(buf + 12, &timestampUs, 4);
+  memcpy(buf + 16, &offset, 2);
+  if(payloadLen && payload != buf + PROTO_HEADER_LEN) memcpy(buf + PROTO_HEADER_LEN, payload, payloadLen);
+
+  int len = PROTO_HEADER_LEN + payloadLen;
+  uint16_t crc = packetCrc(buf, len);
+  memcpy(buf + 18, &crc, 2);
+  return len;
+}
+
+static ParseResult parseV2(const uint8_t* data, int len, PacketInfo& info){
+  if(len < PROTO_HEADER_LEN) return PARSE_IGNORED;
+  if(data[1] != PROTO_VERSION) return PARSE_BAD_VERSION;
+
+  uint16_t crc;
+  memcpy(&crc, data + 18, 2);
+  if(crc != packetCrc(data, len)) return PARSE_BAD_CRC;
+
+  uint16_t frameId;
+  info.version    = 2;
+  info.kind       = data[2];
+  info.flags      = data[3];
+  info.v2Capable  = true;
+  memcpy(&info.token, data + 4, 4);
+  memcpy(&frameId, data + 8, 2);
+  info.frameId    = frameId;
+  info.chunkIdx   = data[10];
+  info.chunkCount = data[11];
+  memcpy(&info.timestampUs, data + 12, 4);
+  memcpy(&info.offset, data + 16, 2);
+  info.payload    = data + PROTO_HEADER_LEN;
+  info.payloadLen = len - PROTO_HEADER_LEN;
+  return PARSE_OK;
+}
+
+ParseResult protoParse(const uint8_t* data, int len, PacketInfo& info){
+  if(len < 1) return PARSE_IGNORED;
+  memset(&info, 0, sizeof(info));
+
+  if(data[0] == PROTO_TYPE_V2) return parseV2(data, len, info);
+
+  info.version = 1;
+  if(data[0] == V1_TOKEN && len >= 5) {
+    info.kind  = PKT_HEARTBEAT;
+    info.flags = PROTO_FLAG_LEADER;   // v1 can't tell bids from heartbeats - treat all as heartbeats
+    memcpy(&info.token, data + 1, 4);
+    if(len >= 9) memcpy(&info.frameId, data + 5, 4);
+    info.v2Capable = (len >= 10 && data[9] == PROTO_V2_CAPABLE_MARK);
+    return PARSE_OK;
+  }
+
+  if(data[0] == V1_RAW && len >= PROTO_V1_HEADER_LEN) {
+    info.kind  = PKT_PIXELS;
+    info.flags = PROTO_FLAG_LEADER;
+    memcpy(&info.frameId, data + 1, 4);
+    memcpy(&info.token, data + 5, 4);
+    info.chunkIdx   = data[9];
+    info.offset     = (uint16_t)data[9] * PROTO_V1_LEDS_PER_CHUNK;
+    info.payload    = data + PROTO_V1_HEADER_LEN;
+    int payloadLen  = len - PROTO_V1_HEADER_LEN;
+    // A trailing mark byte leaves the RGB payload one byte short of a multiple of 3
+    if(payloadLen % 3 == 1 && data[len - 1] == PROTO_V2_CAPABLE_MARK) {
+      info.v2Capable = true;
+      payloadLen--;
+    }
+    info.payloadLen = payloadLen;
+    return PARSE_OK;
+  }
+
+  return PARSE_IGNORED;
+}
+
+bool protoFromLegacyPeer(const PacketInfo& info, uint32_t myToken){
+  return info.version == 1 && !info.v2Capable && info.token != myToken;
+}
+
+uint8_t protoPixelBytes(uint8_t flags){
+  return (flags & PROTO_FLAG_RGB565) ? 2 : 3;
+}
+
+int protoEncodePixels(uint8_t flags, const uint8_t* rgb, int count, uint8_t* out){
+  if(!(flags & PROTO_FLAG_RGB565)) {
+    memcpy(out, rgb, count * 3);
+    return count * 3;
+  }
+  for(int i = 0; i < count; i++, rgb += 3){
+    uint16_t v = ((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3);
+    out[i*2]     = v & 0xFF;
+    out[i*2 + 1] = v >> 8;
+  }
+  return count * 2;
+}
+
+void protoDecodePixels(uint8_t flags, const uint8_t* in, int count, uint8_t* rgb){
+  if(!(flags & PROTO_FLAG_RGB565)) {
+    memcpy(rgb, in, count * 3);
+    return;
+  }
+  for(int i = 0; i < count; i++, rgb += 3){
+    uint16_t v = in[i*2] | (in[i*2 + 1] << 8);
+    // Replicate the top bits into the gap so full-scale stays full-scale
+    uint8_t r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+  }
+}
+
+uint32_t protoAirtimeUs(uint16_t len, uint16_t rateKbps){
+  uint32_t bits = (uint32_t)(len + PROTO_AIR_FRAME_BYTES) * 8;
+  if(rateKbps <= 11000) return PROTO_AIR_ACCESS_US + 192 + (bits * 1000 + rateKbps - 1) / rateKbps;
+  // OFDM: 20us preamble, 4us symbols, 22 service/tail bits
+  uint32_t bitsPerSymbol = rateKbps * 4 / 1000;
+  return PROTO_AIR_ACCESS_US + 20 + 4 * ((22 + bits + bitsPerSymbol - 1) / bitsPerSymbol);
+}
@@ -0,0 +1,110 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// ── Wire Protocol ────────────────────────────────────────────────────────────
+// Framing for everything the mesh sends over ESP-NOW. Hardware-independent so
+// the host tools can encode/decode the same bytes the firmware does.
+//
+// v1 (legacy) - first byte is the message type, no version, no integrity check:
+//   RAW   [0x00][seq4][token4][chunkIdx][rgb...]          75 LEDs per chunk
+//   TOKEN [0x01][token4][seq4]                            election bid / heartbeat
+//
+// v2 - fixed 20-byte header, CRC-16 over header + payload:
+//   [0x05][version][kind][flags][token4][frameId2][chunkIdx][chunkCount]
+//   [timestampUs4][offset2][crc2][payload...]
+//
+// v1 nodes ignore type 0x05, and v2 nodes parse both, so a fleet can be
+// upgraded node by node: a v2 node that hears a v1-only peer speaks v1 from
+// then until it reboots. A v1 follower only listens - it is heard once, when it
+// bids in an election - so a hold that lapsed after a quiet spell would leave
+// it unable to decode the frames. v2 nodes talking v1 append
+// PROTO_V2_CAPABLE_MARK after the v1 packet (v1 parsers ignore trailing bytes)
+// so they don't put each other in legacy mode.
+//
+// Heartbeats ride on pixel packets: every v2 packet from a leader carries
+// PROTO_FLAG_LEADER and its token, so a separate heartbeat is only sent when
+// the leader has nothing else to send. PKT_AUDIO (musiclink.h) goes out at
+// ~100Hz between pixel frames, frameId counting audio packets. PKT_OTA_* carry
+// firmware images between nodes (meshota.h) and are never relayed.
+
+#include <stdint.h>
+
+static const uint8_t  PROTO_TYPE_V2          = 0x05;   // First byte of every v2 packet
+static const uint8_t  PROTO_VERSION          = 2;
+static const uint8_t  PROTO_HEADER_LEN       = 20;
+static const uint8_t  PROTO_V1_HEADER_LEN    = 10;     // v1 RAW header
+static const uint8_t  PROTO_V1_LEDS_PER_CHUNK = 75;
+static const uint8_t  PROTO_V2_CAPABLE_MARK  = 0xA2;   // Trailer on v1 packets from v2 nodes
+static const uint16_t PROTO_MAX_PACKET       = 250;    // ESP_NOW_MAX_DATA_LEN
+
+// v2 packet kinds
+enum PacketKind : uint8_t {
+  PKT_PIXELS     = 0,  // Pixel payload for LEDs starting at offset (encoding in flags)
+  PKT_HEARTBEAT  = 1,  // No payload - leader keepalive or election bid
+  PKT_REPORT     = 2,  // Follower receive report (feedback.h)
+  PKT_AUDIO      = 3,  // Leader audio features, ~100Hz (musiclink.h)
+  PKT_OTA_OFFER  = 4,  // Mesh firmware distribution (meshota.h) - seed announces an image
+  PKT_OTA_DATA   = 5,  //   one image chunk, frameId = chunk index
+  PKT_OTA_STATUS = 6,  //   receiver progress + repair request
+  PKT_OTA_COMMIT = 7,  //   switch to the new image
+  PKT_TELEMETRY  = 8,  // Node health beacon, every node (telemetry.h)
+};
+
+// v2 flags
+static const uint8_t PROTO_FLAG_LEADER = 0x01;   // Sender is leader - packet doubles as heartbeat
+static const uint8_t PROTO_FLAG_FEC    = 0x02;   // Frame ends with an XOR parity chunk (chunkIdx == chunkCount,
+                                                 // offset = LEDs per chunk) that can rebuild one lost chunk
+static const uint8_t PROTO_FLAG_RGB565 = 0x04;   // Pixels packed 5-6-5, 2 bytes per LED instead of 3
+
+// Either wire version, normalised for the receive path
+struct PacketInfo {
+  uint8_t        version;      // 1 or 2
+  uint8_t        kind;         // PacketKind (v1 RAW -> PKT_PIXELS, v1 TOKEN -> PKT_HEARTBEAT)
+  uint8_t        flags;
+  bool           v2Capable;    // v2 sender (v1 packets only - true when the trailer mark is present)
+  uint32_t       token;
+  uint32_t       frameId;      // v2 frame counter, v1 chunk sequence number
+  uint8_t        chunkIdx;
+  uint8_t        chunkCount;   // 0 when unknown (v1)
+  uint32_t       timestampUs;  // Leader clock at render (v2 only)
+  uint16_t       offset;       // First LED of a pixel payload
+  const uint8_t* payload;
+  uint16_t       payloadLen;
+};
+
+enum ParseResult : uint8_t {
+  PARSE_OK = 0,
+  PARSE_IGNORED,       // Not a protocol packet we handle (other types, truncated)
+  PARSE_BAD_VERSION,   // v2 framing, unsupported version
+  PARSE_BAD_CRC,       // Corrupted - must not reach the LEDs
+};
+
+uint16_t    protoCrc16(const uint8_t* data, int len, uint16_t crc = 0xFFFF);
+
+// Parse a received packet (relay wrapper already removed)
+ParseResult protoParse(const uint8_t* data, int len, PacketInfo& info);
+
+// True when a parsed packet comes from a v1-only node - not from a v2 node
+// talking v1, and not our own packet relayed back
+bool        protoFromLegacyPeer(const PacketInfo& info, uint32_t myToken);
+
+// Build a v2 packet in buf (at least PROTO_HEADER_LEN + payloadLen bytes).
+// Returns the packet length, CRC filled in.
+int         protoBuildV2(uint8_t* buf, uint8_t kind, uint8_t flags, uint32_t token,
+                         uint16_t frameId, uint8_t chunkIdx, uint8_t chunkCount,
+                         uint32_t timestampUs, uint16_t offset,
+                         const uint8_t* payload, uint16_t payloadLen);
+
+// Pixel payload encoding selected by PROTO_FLAG_RGB565
+uint8_t     protoPixelBytes(uint8_t flags);
+int         protoEncodePixels(uint8_t flags, const uint8_t* rgb, int count, uint8_t* out);
+void        protoDecodePixels(uint8_t flags, const uint8_t* in, int count, uint8_t* rgb);
+
+// Airtime of one ESP-NOW broadcast of len bytes: the payload inside an 802.11
+// action frame, the PHY preamble (long for DSSS rates up to 11Mbps, OFDM
+// above) and the channel access wait before it
+static const uint8_t  PROTO_AIR_FRAME_BYTES = 43;    // MAC header, action + vendor element, FCS
+static const uint16_t PROTO_AIR_ACCESS_US   = 100;   // DIFS plus the mean broadcast backoff
+uint32_t    protoAirtimeUs(uint16_t len, uint16_t rateKbps);
+
+#endif
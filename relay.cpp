@@ -0,0 +1,105 @@
+#include "relay.h"
+#include <string.h>
+
+void relayCacheReset(RelayCache& cache){
+  memset(cache.keys, 0, sizeof(cache.keys));
+  cache.next = 0;
+}
+
+uint32_t relayKey(const uint8_t* packet, int len){
+  // FNV-1a over the frame header - the payload adds nothing to uniqueness
+  uint32_t h = 2166136261u;
+  int n = len < RELAY_KEY_BYTES ? len : RELAY_KEY_BYTES;
+  for(int i = 0; i < n; i++){
+    h ^= packet[i];
+    h *= 16777619u;
+  }
+  return h ? h : 1;  // 0 marks an empty cache slot
+}
+
+bool relayCacheInsert(RelayCache& cache, uint32_t key){
+  for(int i = 0; i < RELAY_CACHE_SIZE; i++){
+    if(cache.keys[i] == key) return false;
+  }
+  cache.keys[cache.next] = key;
+  cache.next = (cache.next + 1) % RELAY_CACHE_SIZE;
+  return true;
+}
+
+static void clearWindow(RelayRole& role, uint32_t nowMs){
+  role.windowStart = nowMs;
+  role.firstCopies = 0;
+  memset(role.firstAtHops, 0, sizeof(role.firstAtHops));
+  memset(role.copiesAtHops, 0, sizeof(role.copiesAtHops));
+  role.rssiSum = 0;
+}
+
+void relayRoleReset(RelayRole& role, uint32_t nowMs){
+  role.active = false;
+  role.level = role.peers16 = 0;
+  clearWindow(role, nowMs);
+}
+
+static uint8_t hopIndex(uint8_t hops){
+  return hops > RELAY_MAX_HOPS ? RELAY_MAX_HOPS : hops;
+}
+
+static void countUp(uint16_t& counter){
+  if(counter < 0xFFFF) counter++;
+}
+
+void relayNoteFirstCopy(RelayRole& role, int8_t rssi, uint8_t hops){
+  countUp(role.firstCopies);
+  countUp(role.firstAtHops[hopIndex(hops)]);
+  countUp(role.copiesAtHops[hopIndex(hops)]);
+  role.rssiSum += rssi;
+}
+
+void relayNoteExtraCopy(RelayRole& role, uint8_t hops){
+  countUp(role.copiesAtHops[hopIndex(hops)]);
+}
+
+// Odds of 1 in 2 at the edge of the cell up to 1 in 16 next to the sender -
+// or the other way round for stepping back
+static uint32_t rssiOdds(const RelayRole& role, bool edgeFirst){
+  int rssi = role.rssiSum / role.firstCopies;
+  if(rssi < RELAY_RSSI_WEAK)   rssi = RELAY_RSSI_WEAK;
+  if(rssi > RELAY_RSSI_STRONG) rssi = RELAY_RSSI_STRONG;
+  uint32_t strength = (uint32_t)(rssi - RELAY_RSSI_WEAK), span = (uint32_t)(RELAY_RSSI_STRONG - RELAY_RSSI_WEAK);
+  return 2 + 14 * (edgeFirst ? strength : span - strength) / span;
+}
+
+bool relayUpdateRole(RelayRole& role, uint32_t nowMs, uint32_t random){
+  if(nowMs - role.windowStart < RELAY_WINDOW_MS) return false;
+
+  bool wasActive = role.active;
+  if(role.firstCopies > 0) {
+    // Our level, and the copies forwarded by relays on it - one hop deeper
+    uint8_t level = 0;
+    for(uint8_t h = 1; h <= RELAY_MAX_HOPS; h++)
+      if(role.firstAtHops[h] > role.firstAtHops[level]) level = h;
+    uint32_t peers = level < RELAY_MAX_HOPS ? role.copiesAtHops[level + 1] : 0;
+    uint32_t peers16 = (peers << 4) / role.firstCopies;
+    role.level = level;
+    role.peers16 = peers16 > 0xFF ? 0xFF : peers16;
+
+    if(level >= RELAY_MAX_HOPS) {
+      // Our copies would go past the hop limit - nothing to forward
+      role.active = false;
+    } else if(!role.active && peers16 < RELAY_PEERS_QUIET) {
+      if(random % rssiOdds(role, true) == 0) role.active = true;
+    } else if(role.active && peers16 >= RELAY_PEERS_ENOUGH) {
+      // A peer covers this neighbourhood - the relay nearest the sender
+      // (least reach) is the likeliest to go, so they don't all retire together
+      if(random % rssiOdds(role, false) == 0) role.active = false;
+    }
+  }
+
+  clearWindow(role, nowMs);
+  return role.active != wasActive;
+}
+
+uint32_t relayPresentDelayMs(uint8_t hops){
+  if(hops > RELAY_MAX_HOPS) hops = RELAY_MAX_HOPS;
+  return (RELAY_MAX_HOPS - hops) * RELAY_HOP_LATENCY_MS;
+}
@@ -0,0 +1,73 @@
+#ifndef RELAY_H
+#define RELAY_H
+
+// ── Multi-hop Relay Core ─────────────────────────────────────────────────────
+// Hardware-independent relay logic shared by the firmware (networking.cpp) and
+// the host simulator (tools/relay_sim.cpp). Keep this file free of Arduino,
+// FastLED and ESP-IDF includes so it builds with a plain g++.
+//
+// Relay selection is a sticky, self-pruning election rather than a per-packet
+// decision. Every follower learns its hop level - the hop count most of its
+// frames arrive with - and counts the copies relayed by its peers, the relays
+// on that same level (they forward with one hop more). A node that hears
+// fewer than two peers volunteers, edge-of-cell nodes (weak RSSI) with a much
+// higher probability than nodes next to the sender. A relay that hears two
+// peers steps back, the ones next to the sender first, so the edge relays that
+// reach furthest stay. About two relays per level and neighbourhood survive -
+// one for reach, one so a lost copy usually has a second chance - so the relay
+// set follows the area to cover, not the number of nodes, and airtime per
+// frame scales with the number of hops.
+
+#include <stdint.h>
+
+static const uint8_t  RELAY_MAX_HOPS        = 3;     // Frames are not re-broadcast beyond this many hops
+static const uint8_t  RELAY_PEERS_QUIET     = 18;    // Peer copies per frame x16 below this - fewer than two peers, volunteer
+static const uint8_t  RELAY_PEERS_ENOUGH    = 26;    // Peer copies per frame x16 from this - two peers cover it, step back
+static const uint32_t RELAY_WINDOW_MS       = 500;   // Role is re-evaluated once per window
+static const uint32_t RELAY_JITTER_US       = 600;   // Random hold before forwarding, desyncs relays
+static const int8_t   RELAY_RSSI_WEAK       = -90;   // dBm - edge of cell, most eager to relay
+static const int8_t   RELAY_RSSI_STRONG     = -40;   // dBm - next to the sender, least eager
+static const uint32_t RELAY_HOP_LATENCY_MS  = 4;     // Jitter, carrier sense, airtime and ring wait per hop (see relay_sim)
+static const uint8_t  RELAY_CACHE_SIZE      = 64;    // Seen-frame keys (~200ms of traffic at 50fps)
+static const uint8_t  RELAY_KEY_BYTES       = 12;    // v1: type+seq+token+chunk; v2: type..frame id+chunk
+
+// Seen-frame dedupe cache - a plain ring of frame keys, oldest overwritten first
+struct RelayCache {
+  uint32_t keys[RELAY_CACHE_SIZE];
+  uint8_t  next;
+};
+
+// Per-node relay election state
+struct RelayRole {
+  bool     active;         // Currently re-broadcasting frames
+  uint8_t  level;          // Hop count most frames arrived with last window
+  uint8_t  peers16;        // Peer relay copies per frame last window, x16
+  uint32_t windowStart;    // ms
+  uint16_t firstCopies;    // Frames heard this window
+  uint16_t firstAtHops[RELAY_MAX_HOPS + 1];    // ...by the hop count of their first copy
+  uint16_t copiesAtHops[RELAY_MAX_HOPS + 1];   // Every copy heard this window, by hop count
+  int32_t  rssiSum;        // Sum of first-copy RSSI, for the edge-of-cell weighting
+};
+
+void     relayCacheReset(RelayCache& cache);
+uint32_t relayKey(const uint8_t* packet, int len);
+
+// Returns true if the key was new (and records it), false for a duplicate
+bool     relayCacheInsert(RelayCache& cache, uint32_t key);
+
+void     relayRoleReset(RelayRole& role, uint32_t nowMs);
+
+// Pixel frames only - other traffic says nothing about who relays the frames.
+// hops is the relay depth the copy arrived with (0 = from the leader).
+void     relayNoteFirstCopy(RelayRole& role, int8_t rssi, uint8_t hops);
+void     relayNoteExtraCopy(RelayRole& role, uint8_t hops);
+
+// Closes the window once RELAY_WINDOW_MS has passed and decides whether to
+// volunteer or step back. Returns true when the role changed.
+bool     relayUpdateRole(RelayRole& role, uint32_t nowMs, uint32_t random);
+
+// How long a node that received a frame over `hops` relays should hold it so
+// that every hop level presents the frame at the same moment as the farthest one
+uint32_t relayPresentDelayMs(uint8_t hops);
+
+#endif
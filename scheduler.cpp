@@ -0,0 +1,137 @@
+#include "scheduler.h"
+
+static const uint8_t SCHED_NIL = 0xFF;
+
+struct SchedTimer {
+  TimerCallback cb;
+  void*    arg;
+  uint32_t due;       // Tick (ms) the timer fires on
+  uint32_t period;    // 0 = one-shot
+  uint8_t  gen;       // Bumped on every reuse so stale handles don't match
+  uint8_t  next;      // Next timer in the same wheel slot
+  bool     active;
+  bool     linked;    // In a wheel slot (false while schedulerRun has it detached)
+};
+
+static SchedTimer timers[SCHED_MAX_TIMERS];
+static uint8_t    wheel[SCHED_WHEEL_SLOTS];   // Head of each slot's list
+static uint32_t   currentTick = 0;            // Last tick processed
+static uint8_t    activeCount = 0, peakCount = 0;
+
+static void link(uint8_t idx){
+  uint8_t slot = timers[idx].due & (SCHED_WHEEL_SLOTS - 1);
+  timers[idx].next = wheel[slot];
+  timers[idx].linked = true;
+  wheel[slot] = idx;
+}
+
+static void unlink(uint8_t idx){
+  if(!timers[idx].linked) return;
+  timers[idx].linked = false;
+  uint8_t slot = timers[idx].due & (SCHED_WHEEL_SLOTS - 1);
+  for(uint8_t* p = &wheel[slot]; *p != SCHED_NIL; p = &timers[*p].next){
+    if(*p == idx){
+      *p = timers[idx].next;
+      return;
+    }
+  }
+}
+
+static TimerId handleOf(uint8_t idx){
+  return ((TimerId)timers[idx].gen << 8) | (idx + 1);
+}
+
+static int findTimer(TimerId id){
+  if(id == TIMER_NONE) return -1;
+  int idx = (id & 0xFF) - 1;
+  if(idx < 0 || idx >= SCHED_MAX_TIMERS) return -1;
+  if(!timers[idx].active || timers[idx].gen != (id >> 8)) return -1;
+  return idx;
+}
+
+void schedulerInit(uint32_t nowMs){
+  for(int i = 0; i < SCHED_MAX_TIMERS; i++){
+    timers[i].active = timers[i].linked = false;
+    timers[i].gen = 1;
+  }
+  for(int s = 0; s < SCHED_WHEEL_SLOTS; s++) wheel[s] = SCHED_NIL;
+  currentTick = nowMs;
+  activeCount = peakCount = 0;
+}
+
+TimerId timerEveryAfter(uint32_t firstDelayMs, uint32_t periodMs, TimerCallback cb, void* arg){
+  for(uint8_t i = 0; i < SCHED_MAX_TIMERS; i++){
+    SchedTimer &t = timers[i];
+    if(t.active) continue;
+    t.cb = cb;
+    t.arg = arg;
+    t.period = periodMs;
+    // Never land on a tick that has already been processed
+    t.due = currentTick + (firstDelayMs ? firstDelayMs : 1);
+    t.gen = (t.gen == 0xFF) ? 1 : t.gen + 1;
+    t.active = true;
+    link(i);
+    if(++activeCount > peakCount) peakCount = activeCount;
+    return handleOf(i);
+  }
+  return TIMER_NONE;  // Pool exhausted - raise SCHED_MAX_TIMERS
+}
+
+TimerId timerOnce(uint32_t delayMs, TimerCallback cb, void* arg){
+  return timerEveryAfter(delayMs, 0, cb, arg);
+}
+
+TimerId timerEvery(uint32_t periodMs, TimerCallback cb, void* arg){
+  return timerEveryAfter(periodMs, periodMs, cb, arg);
+}
+
+void timerCancel(TimerId id){
+  int idx = findTimer(id);
+  if(idx < 0) return;
+  unlink(idx);
+  timers[idx].active = false;
+  activeCount--;
+}
+
+bool timerPending(TimerId id){
+  return findTimer(id) >= 0;
+}
+
+void schedulerRun(uint32_t nowMs){
+  // Walk every tick since the last run - a stalled loop() catches up in order
+  while((int32_t)(nowMs - currentTick) > 0){
+    currentTick++;
+    uint8_t slot = currentTick & (SCHED_WHEEL_SLOTS - 1);
+
+    // Detach the slot first so callbacks can schedule into it, cancel timers
+    // we have not reached yet, or reuse their pool entries
+    uint8_t due[SCHED_MAX_TIMERS], n = 0;
+    for(uint8_t idx = wheel[slot]; idx != SCHED_NIL; idx = timers[idx].next){
+      timers[idx].linked = false;
+      due[n++] = idx;
+    }
+    wheel[slot] = SCHED_NIL;
+
+    for(uint8_t k = 0; k < n; k++){
+      SchedTimer &t = timers[due[k]];
+      if(!t.active || t.linked) continue;   // Cancelled, or reused, by an earlier callback
+
+      if(t.due != currentTick) {
+        link(due[k]);                       // Belongs to a later revolution
+      } else if(t.period) {
+        // Periodic: keep the phase, but don't replay periods missed in a stall
+        t.due += t.period;
+        while((int32_t)(nowMs - t.due) >= 0) t.due += t.period;
+        link(due[k]);
+        t.cb(t.arg);
+      } else {
+        t.active = false;
+        activeCount--;
+        t.cb(t.arg);
+      }
+    }
+  }
+}
+
+uint8_t schedulerActiveTimers(){ return activeCount; }
+uint8_t schedulerPeakTimers(){ return peakCount; }
@@ -0,0 +1,44 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+// ── Cooperative Timer Scheduler ──────────────────────────────────────────────
+// Hashed timer wheel with one-shot and periodic callbacks, run from loop() by
+// schedulerRun(). Replaces blocking delay() calls and per-module "lastX"
+// polling: work that has to happen later is scheduled instead of waited for,
+// so loop() latency is bounded by the longest callback.
+//
+// 1ms ticks, SCHED_WHEEL_SLOTS slots - a timer further out than one revolution
+// simply stays in its slot for more revolutions. Timers live in a fixed pool,
+// nothing is allocated. Hardware-independent (the caller supplies the time).
+
+#include <stdint.h>
+
+static const uint8_t SCHED_MAX_TIMERS  = 24;
+static const uint8_t SCHED_WHEEL_SLOTS = 64;   // Power of two
+
+typedef void (*TimerCallback)(void* arg);
+
+// Handle to a scheduled timer. 0 is never a valid handle, and a handle goes
+// stale once its one-shot fires or it is cancelled, so cancelling late is safe.
+typedef uint16_t TimerId;
+static const TimerId TIMER_NONE = 0;
+
+void    schedulerInit(uint32_t nowMs);
+
+// Fire every timer that is due, in due order. Callbacks may schedule or cancel timers.
+void    schedulerRun(uint32_t nowMs);
+
+TimerId timerOnce(uint32_t delayMs, TimerCallback cb, void* arg = nullptr);
+TimerId timerEvery(uint32_t periodMs, TimerCallback cb, void* arg = nullptr);
+
+// Periodic timer whose first firing is after firstDelayMs instead of one period
+TimerId timerEveryAfter(uint32_t firstDelayMs, uint32_t periodMs, TimerCallback cb, void* arg = nullptr);
+
+void    timerCancel(TimerId id);
+bool    timerPending(TimerId id);
+
+// Timers in use, and the most ever in use (pool sizing)
+uint8_t schedulerActiveTimers();
+uint8_t schedulerPeakTimers();
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+// ── SHA-256 ──────────────────────────────────────────────────────────────────
+// Plain FIPS 180-4 SHA-256, streaming. Used to verify firmware images received
+// over the mesh (meshota.h) - the host simulator and delta tool hash with the
+// exact same code. Hardware-independent.
+
+#include <stdint.h>
+#include <stddef.h>
+
+static const int SHA256_LEN = 32;
+
+struct Sha256 {
+  uint32_t state[8];
+  uint64_t bytes;
+  uint8_t  buf[64];
+  uint8_t  bufLen;
+};
+
+void sha256Init(Sha256& s);
+void sha256Update(Sha256& s, const uint8_t* data, size_t len);
+void sha256Final(Sha256& s, uint8_t out[SHA256_LEN]);
+
+// One-shot convenience
+void sha256(const uint8_t* data, size_t len, uint8_t out[SHA256_LEN]);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+// ── Lock-free Single-Producer/Single-Consumer Ring ───────────────────────────
+// Fixed-size ring of preallocated slots. The producer (e.g. the ESP-NOW receive
+// callback in the WiFi task) fills a slot in place and publishes it; the
+// consumer (loop()) reads it in place and releases it. Head and tail are each
+// written by one side only, so acquire/release ordering is all the
+// synchronisation needed - no locks, no allocation, no copies beyond the fill.
+// Hardware-independent so host tools can use it too.
+
+#include <stdint.h>
+#include <atomic>
+
+template<typename T, uint32_t N>
+struct SpscRing {
+  static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+  // Producer side: returns the slot to fill, or nullptr when full (counted as overflow)
+  T* beginWrite(){
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) >= N){
+      overflows.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &slots[h & (N - 1)];
+  }
+  void commitWrite(){
+    uint32_t h = head.load(std::memory_order_relaxed) + 1;
+    head.store(h, std::memory_order_release);
+    uint32_t used = h - tail.load(std::memory_order_relaxed);
+    if(used > highWater.load(std::memory_order_relaxed)) highWater.store(used, std::memory_order_relaxed);
+  }
+
+  // Consumer side: peek at the oldest slot (nullptr when empty), then pop it
+  const T* peek() const {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if(t == head.load(std::memory_order_acquire)) return nullptr;
+    return &slots[t & (N - 1)];
+  }
+  void pop(){
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+  // Consumer side only - drops everything currently queued
+  void clear(){
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  uint32_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  std::atomic<uint32_t> head{0}, tail{0};
+  std::atomic<uint32_t> overflows{0};   // Writes refused because the consumer fell behind
+  std::atomic<uint32_t> highWater{0};   // Deepest the ring has ever been
+  T slots[N];
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "stallrec.h"
+#include <string.h>
+
+const char* LOOP_PHASE_NAMES[LOOP_PHASE_COUNT] = {
+  "setup", "outside", "m5", "serial", "ota", "buttons", "timers", "audio", "network", "ui", "bpm"
+};
+
+static bool plausible(const StallRecord& r){
+  return r.magic == STALL_MAGIC && r.phase < LOOP_PHASE_COUNT
+      && r.pcCount <= STALL_PC_SAMPLES && r.pcNext < STALL_PC_SAMPLES
+      && r.historyCount <= STALL_HISTORY && r.historyNext < STALL_HISTORY;
+}
+
+bool stallRecordBoot(StallRecord& r, StallRecord& last, bool keepLast){
+  // RTC memory holds noise after power-on - only trust it across a reset
+  bool kept = keepLast && plausible(r);
+  if(kept) memcpy(&last, &r, sizeof(r));
+  uint16_t resets = kept ? r.resets + 1 : 0;
+  memset(&r, 0, sizeof(r));
+  r.magic = STALL_MAGIC;
+  r.resets = resets;
+  r.phase = PHASE_SETUP;
+  return kept;
+}
+
+void stallPhase(StallRecord& r, uint8_t phase, uint32_t nowUs, uint32_t nowMs){
+  uint32_t dur = nowUs - r.phaseStartUs;
+  // setup() is slow by design and the boot profile already times it
+  if(dur >= STALL_LOG_US && r.phase != PHASE_SETUP) {
+    StallEvent& e = r.history[r.historyNext];
+    e.startMs = r.phaseStartMs;
+    e.durUs = dur;
+    e.phase = r.phase;
+    e.pcCount = stallSamples(r, e.pc);
+    r.historyNext = (r.historyNext + 1) % STALL_HISTORY;
+    if(r.historyCount < STALL_HISTORY) r.historyCount++;
+  }
+  r.phase = phase;
+  r.phaseStartUs = nowUs;
+  r.phaseStartMs = nowMs;
+  r.pcCount = 0;
+  r.pcNext = 0;
+}
+
+void stallSample(StallRecord& r, uint32_t nowUs, uint32_t nowMs, uint32_t pc){
+  r.tickUs = nowUs;
+  r.tickMs = nowMs;
+  if(nowUs - r.phaseStartUs < STALL_SAMPLE_US) return;
+  r.pc[r.pcNext] = pc;
+  r.pcNext = (r.pcNext + 1) % STALL_PC_SAMPLES;
+  if(r.pcCount < STALL_PC_SAMPLES) r.pcCount++;
+}
+
+uint32_t stallPhaseUs(const StallRecord& r){
+  // The tick can predate the phase by up to one sampler period
+  int32_t us = (int32_t)(r.tickUs - r.phaseStartUs);
+  return us > 0 ? us : 0;
+}
+
+uint8_t stallSamples(const StallRecord& r, uint32_t out[STALL_PC_SAMPLES]){
+  uint8_t first = (r.pcNext + STALL_PC_SAMPLES - r.pcCount) % STALL_PC_SAMPLES;
+  for(uint8_t i = 0; i < r.pcCount; i++) out[i] = r.pc[(first + i) % STALL_PC_SAMPLES];
+  return r.pcCount;
+}
+
+uint8_t stallHistory(const StallRecord& r, const StallEvent* out[STALL_HISTORY]){
+  uint8_t first = (r.historyNext + STALL_HISTORY - r.historyCount) % STALL_HISTORY;
+  for(uint8_t i = 0; i < r.historyCount; i++) out[i] = &r.history[(first + i) % STALL_HISTORY];
+  return r.historyCount;
+}
@@ -0,0 +1,83 @@
+#ifndef STALLREC_H
+#define STALLREC_H
+
+// ── Stall Forensics ──────────────────────────────────────────────────────────
+// The task watchdog resets a node whose loop() stops coming round, but the
+// reset alone says nothing about why. loop() marks which phase it is in, and a
+// sampler interrupt notes where the loop task's program counter is whenever a
+// phase overruns STALL_SAMPLE_US. The record lives in RTC memory, which keeps
+// its contents through watchdog, panic and software resets (not power loss), so
+// the next boot can print the phase the node died in, the code it was stuck in
+// and the long stalls that led up to it. PCs resolve with addr2line against
+// the build's .elf.
+// Hardware-independent: the caller supplies times and PC values.
+
+#include <stdint.h>
+
+static const uint32_t STALL_MAGIC      = 0x314C5453;   // "STL1"
+static const uint32_t STALL_SAMPLE_US  = 20000;        // A phase longer than a frame period starts sampling
+static const uint32_t STALL_LOG_US     = 50000;        // Phases at least this long go in the history
+static const uint8_t  STALL_PC_SAMPLES = 8;            // Latest samples kept per phase
+static const uint8_t  STALL_HISTORY    = 6;
+
+enum LoopPhase : uint8_t {
+  PHASE_SETUP = 0,
+  PHASE_OUTSIDE,      // Between loop() passes - Arduino core, or other tasks hogging the core
+  PHASE_M5,
+  PHASE_SERIAL,
+  PHASE_OTA,
+  PHASE_BUTTONS,
+  PHASE_TIMERS,
+  PHASE_AUDIO,
+  PHASE_NETWORK,      // Receive, assembly, presentation and the leader's render
+  PHASE_UI,
+  PHASE_BPM,
+  LOOP_PHASE_COUNT
+};
+
+extern const char* LOOP_PHASE_NAMES[LOOP_PHASE_COUNT];
+
+struct StallEvent {
+  uint32_t startMs;                    // Uptime when the phase began
+  uint32_t durUs;
+  uint8_t  phase;
+  uint8_t  pcCount;
+  uint32_t pc[STALL_PC_SAMPLES];       // Oldest first
+};
+
+struct StallRecord {
+  uint32_t   magic;
+  uint16_t   resets;                   // Resets survived since power-on
+  // Live state - left as it was when the node went down
+  uint8_t    phase;
+  uint32_t   phaseStartUs, phaseStartMs;
+  uint32_t   tickUs, tickMs;           // Sampler's last tick
+  uint8_t    pcCount, pcNext;
+  uint32_t   pc[STALL_PC_SAMPLES];     // Ring of the current phase's samples
+  // Completed phases of at least STALL_LOG_US, a ring
+  StallEvent history[STALL_HISTORY];
+  uint8_t    historyCount, historyNext;
+};
+
+// Call once at boot. With keepLast (anything but a power-on reset) and a
+// plausible record, copies the previous run into last and returns true.
+// Either way r then starts over for this run.
+bool stallRecordBoot(StallRecord& r, StallRecord& last, bool keepLast);
+
+// Enter phase - closes the one running, logging it if it was long
+void stallPhase(StallRecord& r, uint8_t phase, uint32_t nowUs, uint32_t nowMs);
+
+// Sampler tick; pc is where the loop task is (0 = unknown)
+void stallSample(StallRecord& r, uint32_t nowUs, uint32_t nowMs, uint32_t pc);
+
+// Time the current phase had run at the last tick - for a dead record, how
+// long it was stuck before the reset
+uint32_t stallPhaseUs(const StallRecord& r);
+
+// Current phase's samples oldest first; returns the count
+uint8_t stallSamples(const StallRecord& r, uint32_t out[STALL_PC_SAMPLES]);
+
+// History oldest first; returns the count
+uint8_t stallHistory(const StallRecord& r, const StallEvent* out[STALL_HISTORY]);
+
+#endif
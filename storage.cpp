@@ -0,0 +1,253 @@
+#include "storage.h"
+#include "persist.h"
+#include "protocol.h"   // protoCrc16
+#include "scheduler.h"
+
+// ── Settings Blob ─────────────────────────────────────────────────────────────
+// Everything persistent lives in one NVS blob ("ctl"), written in one go:
+//   [0] version  [1] pattern count  [2] mode count  [3] local brightness
+//   [4..7] lifetime writes  [8..9] strip length  [10] pixel map
+//   [11..] per mode, 7 x count values field by field  [..] CRC16
+// One getBytes at boot, one putBytes per deferred write. The stored counts let
+// a build with more (or fewer) patterns keep every setting both have in common.
+// Version 3 blobs are the same without the pixel map, version 2 without the
+// strip length either.
+static const char*   SETTINGS_KEY         = "ctl";
+static const uint8_t SETTINGS_VERSION     = 4;
+static const int     SETTINGS_HEADER_LEN  = 11;
+static const uint8_t SETTINGS_V3_VERSION  = 3;
+static const int     SETTINGS_V3_HEADER_LEN = 10;
+static const uint8_t SETTINGS_V2_VERSION  = 2;
+static const int     SETTINGS_V2_HEADER_LEN = 8;
+static const uint8_t SETTINGS_DEFAULT_BRIGHT = 64;   // 25%
+
+// Earlier layouts, read once to migrate
+static const uint8_t CONTROLS_V1_VERSION  = 1;       // Per-mode "ctl<m>" blobs + "globalBright" key
+static const uint8_t CONTROLS_LEGACY_PATTERNS = 22;  // Columns in the original "<m><i><f>" keys
+
+struct ControlField {
+  uint8_t (*vals)[PATTERN_COUNT];
+  char    key;      // Letter used by the original per-key layout
+  uint8_t def;
+};
+static const ControlField CONTROL_FIELDS[] = {
+  { speedVals,  'S', 5 },
+  { brightVals, 'B', 9 },
+  { ssensVals,  'X', 5 },
+  { bsensVals,  'Y', 5 },
+  { vsensVals,  'V', 5 },
+  { decayVals,  'D', 5 },
+  { timeVals,   'T', 1 },
+};
+static const int CONTROL_FIELD_COUNT = sizeof(CONTROL_FIELDS) / sizeof(CONTROL_FIELDS[0]);
+static const size_t SETTINGS_LEN = SETTINGS_HEADER_LEN + MODE_COUNT * CONTROL_FIELD_COUNT * PATTERN_COUNT + 2;
+
+static PersistState persist;
+static TimerId      persistTimer = TIMER_NONE;
+static uint32_t     lastWriteUs = 0;   // How long the last putBytes stalled loop()
+static uint16_t     storedLeds = DEFAULT_LEDS;   // numLeds after the next reboot
+
+static void writeSettings(){
+  uint8_t blob[SETTINGS_LEN];
+  uint32_t lifetime = persistBeginWrite(persist);
+  blob[0] = SETTINGS_VERSION;
+  blob[1] = PATTERN_COUNT;
+  blob[2] = MODE_COUNT;
+  blob[3] = globalBrightnessScale;
+  memcpy(blob + 4, &lifetime, 4);
+  memcpy(blob + 8, &storedLeds, 2);
+  blob[10] = pixelMap;
+  uint8_t* p = blob + SETTINGS_HEADER_LEN;
+  for(int m = 0; m < MODE_COUNT; ++m)
+    for(int f = 0; f < CONTROL_FIELD_COUNT; ++f, p += PATTERN_COUNT)
+      memcpy(p, CONTROL_FIELDS[f].vals[m], PATTERN_COUNT);
+  uint16_t crc = protoCrc16(blob, p - blob);
+  memcpy(p, &crc, 2);
+
+  uint32_t start = micros();
+  prefs.putBytes(SETTINGS_KEY, blob, sizeof(blob));
+  lastWriteUs = micros() - start;
+}
+
+// Largest blob worth reading - the largest pattern count a blob can record.
+// Read into a buffer sized to the stored blob and freed again: only boot needs it.
+static const size_t SETTINGS_MAX_LEN = SETTINGS_HEADER_LEN + MODE_COUNT * CONTROL_FIELD_COUNT * 255 + 2;
+
+// Reads key's blob into a new[] buffer of *len bytes, nullptr when missing,
+// shorter than minLen or too long
+static uint8_t* readBlob(const char* key, size_t minLen, size_t* len){
+  *len = prefs.getBytesLength(key);
+  if(*len < minLen || *len > SETTINGS_MAX_LEN) return nullptr;
+  uint8_t* buf = new uint8_t[*len];
+  if(prefs.getBytes(key, buf, *len) == *len) return buf;
+  delete[] buf;
+  return nullptr;
+}
+
+// Header bytes of a blob version this build reads, 0 for any other
+static int settingsHeaderLen(uint8_t version){
+  switch(version) {
+    case SETTINGS_VERSION:    return SETTINGS_HEADER_LEN;
+    case SETTINGS_V3_VERSION: return SETTINGS_V3_HEADER_LEN;
+    case SETTINGS_V2_VERSION: return SETTINGS_V2_HEADER_LEN;
+    default:                  return 0;
+  }
+}
+
+// Returns false when there is no usable blob. Sets *rewrite when the stored
+// layout differs from this build's and should be written back.
+static bool parseSettingsBlob(const uint8_t* blob, size_t len, bool* rewrite){
+  uint8_t version = blob[0], count = blob[1], modes = blob[2];
+  int headerLen = settingsHeaderLen(version);
+  if(!headerLen || len != headerLen + (size_t)modes * CONTROL_FIELD_COUNT * count + 2) return false;
+  uint16_t crc;
+  memcpy(&crc, blob + len - 2, 2);
+  if(crc != protoCrc16(blob, len - 2)) {
+    if(DEBUG_SERIAL) Serial.println("SETTINGS: CRC mismatch - using defaults");
+    return false;
+  }
+
+  globalBrightnessScale = blob[3];
+  uint32_t lifetime;
+  memcpy(&lifetime, blob + 4, 4);
+  persistReset(persist, lifetime);
+  if(version != SETTINGS_V2_VERSION) memcpy(&storedLeds, blob + 8, 2);
+  if(version == SETTINGS_VERSION) pixelMap = blob[10];
+
+  uint8_t common = count < PATTERN_COUNT ? count : PATTERN_COUNT;
+  const uint8_t* p = blob + headerLen;
+  for(int m = 0; m < modes; ++m)
+    for(int f = 0; f < CONTROL_FIELD_COUNT; ++f, p += count)
+      if(m < MODE_COUNT) memcpy(CONTROL_FIELDS[f].vals[m], p, common);
+  *rewrite = (version != SETTINGS_VERSION || count != PATTERN_COUNT || modes != MODE_COUNT);
+  return true;
+}
+
+static bool loadSettingsBlob(bool* rewrite){
+  size_t len;
+  uint8_t* buf = readBlob(SETTINGS_KEY, SETTINGS_V2_HEADER_LEN + 2, &len);
+  if(!buf) return false;
+  bool ok = parseSettingsBlob(buf, len, rewrite);
+  delete[] buf;
+  return ok;
+}
+
+// Per-mode "ctl<m>" blobs: [0] version [1] count [2..] 7 x count [..] CRC16
+static bool parseV1Controls(int m, const uint8_t* blob, size_t len){
+  uint8_t count = blob[1];
+  if(blob[0] != CONTROLS_V1_VERSION || len != 2 + (size_t)CONTROL_FIELD_COUNT * count + 2) return false;
+  uint16_t crc;
+  memcpy(&crc, blob + len - 2, 2);
+  if(crc != protoCrc16(blob, len - 2)) return false;
+
+  uint8_t common = count < PATTERN_COUNT ? count : PATTERN_COUNT;
+  for(int f = 0; f < CONTROL_FIELD_COUNT; ++f)
+    memcpy(CONTROL_FIELDS[f].vals[m], blob + 2 + f * count, common);
+  return true;
+}
+
+static bool migrateV1Controls(int m){
+  char k[8];
+  snprintf(k, 8, "ctl%d", m);
+  size_t len;
+  uint8_t* buf = readBlob(k, 4, &len);
+  if(!buf) return false;
+  prefs.remove(k);
+  bool ok = parseV1Controls(m, buf, len);
+  delete[] buf;
+  return ok;
+}
+
+// Original one-key-per-value layout - read what's there, then drop the keys
+// so the namespace doesn't keep paying for 308 entries nobody reads
+static void migrateLegacyControls(int m){
+  char k[8];
+  for(int i = 0; i < CONTROLS_LEGACY_PATTERNS; ++i){
+    for(int f = 0; f < CONTROL_FIELD_COUNT; ++f){
+      snprintf(k, 8, "%d%d%c", m, i, CONTROL_FIELDS[f].key);
+      if(!prefs.isKey(k)) continue;
+      CONTROL_FIELDS[f].vals[m][i] = prefs.getUChar(k, CONTROL_FIELDS[f].def);
+      prefs.remove(k);
+    }
+  }
+}
+
+void loadControls(){
+  prefs.begin("npref", false);
+
+  for(int m = 0; m < MODE_COUNT; ++m)
+    for(int f = 0; f < CONTROL_FIELD_COUNT; ++f)
+      memset(CONTROL_FIELDS[f].vals[m], CONTROL_FIELDS[f].def, PATTERN_COUNT);
+  globalBrightnessScale = SETTINGS_DEFAULT_BRIGHT;
+  storedLeds = DEFAULT_LEDS;
+  pixelMap = 0;
+  persistReset(persist, 0);
+
+  bool rewrite = false;
+  if(!loadSettingsBlob(&rewrite)) {
+    // Older layouts: local brightness had its own key, controls were per mode
+    globalBrightnessScale = prefs.getUChar("globalBright", SETTINGS_DEFAULT_BRIGHT);
+    if(prefs.isKey("globalBright")) prefs.remove("globalBright");
+    for(int m = 0; m < MODE_COUNT; ++m)
+      if(!migrateV1Controls(m)) migrateLegacyControls(m);
+    rewrite = true;
+    if(DEBUG_SERIAL) Serial.println("SETTINGS: initialised from older layout/defaults");
+  }
+  if(storedLeds < MIN_LEDS || storedLeds > MAX_LEDS) {
+    if(DEBUG_SERIAL) Serial.printf("SETTINGS: strip length %u outside %u-%u - using %u\n",
+      storedLeds, MIN_LEDS, MAX_LEDS, DEFAULT_LEDS);
+    storedLeds = DEFAULT_LEDS;
+    rewrite = true;
+  }
+  numLeds = storedLeds;
+  if(pixelMap >= PIXEL_MAP_COUNT) {
+    if(DEBUG_SERIAL) Serial.printf("SETTINGS: pixel map %u not in this build - using \"%s\"\n",
+      pixelMap, PIXEL_MAPS[0].name);
+    pixelMap = 0;
+    rewrite = true;
+  }
+  if(rewrite) writeSettings();
+}
+
+static void persistTimerFired(void*){
+  persistTimer = TIMER_NONE;
+  if(!persist.dirty) return;
+  uint32_t left = persistDelayMs(persist, millis());
+  if(left) {
+    persistTimer = timerOnce(left, persistTimerFired);
+    return;
+  }
+  flushSettings("quiet");
+}
+
+void settingsChanged(){
+  // Re-arm on every change - the write waits for the knob to stop moving
+  uint32_t delayMs = persistNoteChange(persist, millis());
+  timerCancel(persistTimer);
+  persistTimer = timerOnce(delayMs, persistTimerFired);
+}
+
+void flushSettings(const char* why){
+  if(!persist.dirty) return;
+  timerCancel(persistTimer);
+  persistTimer = TIMER_NONE;
+  writeSettings();
+  if(DEBUG_SERIAL) {
+    Serial.printf("SETTINGS: saved (%s) in %uus - %u changes, %u writes this boot, %u lifetime\n",
+      why, lastWriteUs, persist.changes, persist.writes, persist.lifetimeWrites);
+  }
+}
+
+bool saveStripLength(uint16_t n){
+  if(n < MIN_LEDS || n > MAX_LEDS) return false;
+  storedLeds = n;
+  settingsChanged();
+  flushSettings("strip length");
+  return true;
+}
+
+void printStorageStats(){
+  Serial.printf("SETTINGS: %s, %u changes -> %u writes (%u coalesced), %u lifetime writes, last write %uus\n",
+    persist.dirty ? "unsaved changes" : "clean", persist.changes, persist.writes,
+    persistCoalesced(persist), persist.lifetimeWrites, lastWriteUs);
+}
@@ -0,0 +1,13 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "config.h"
+
+// ── Settings Storage ──────────────────────────────────────────────────────────
+void loadControls();              // Open NVS and load (or migrate) every setting, numLeds included
+void settingsChanged();           // A control or the local brightness changed - write later (persist.h)
+void flushSettings(const char* why);  // Write now if anything is unsaved - before OFF, OTA, reboot
+bool saveStripLength(uint16_t n); // Store a new numLeds (MIN_LEDS..MAX_LEDS) - takes effect at the next boot
+void printStorageStats();
+
+#endif
@@ -0,0 +1,84 @@
+#include "striplayout.h"
+#include <string.h>
+
+bool stripLayoutValid(const StripConfig* strips, uint8_t n, uint16_t total){
+  if(n == 0 || n > STRIP_MAX_CHANNELS) return false;
+  uint32_t covered = 0;
+  for(uint8_t i = 0; i < n; i++) {
+    const StripConfig& s = strips[i];
+    if(s.count == 0 || (uint32_t)s.logicalStart + s.count > total) return false;
+    for(uint8_t j = 0; j < i; j++) {
+      const StripConfig& o = strips[j];
+      if(s.pin == o.pin) return false;
+      if(s.logicalStart < o.logicalStart + o.count && o.logicalStart < s.logicalStart + s.count) return false;
+    }
+    covered += s.count;
+  }
+  // No overlaps, so covering total pixels means covering each one once
+  return covered == total;
+}
+
+bool stripLayoutFit(const StripConfig* in, uint8_t n, uint16_t total, StripConfig* out){
+  if(n == 0 || n > STRIP_MAX_CHANNELS) return false;
+  uint8_t last = 0;
+  for(uint8_t i = 0; i < n; i++) {
+    out[i] = in[i];
+    if(in[i].logicalStart > in[last].logicalStart) last = i;
+  }
+  if(out[last].logicalStart >= total) return false;
+  out[last].count = total - out[last].logicalStart;
+  return stripLayoutValid(out, n, total);
+}
+
+bool stripLayoutDirect(const StripConfig* strips, uint8_t n){
+  uint16_t next = 0;
+  for(uint8_t i = 0; i < n; i++) {
+    if(strips[i].reversed || strips[i].logicalStart != next) return false;
+    next += strips[i].count;
+  }
+  return true;
+}
+
+uint16_t stripPhysicalStart(const StripConfig* strips, uint8_t i){
+  uint16_t start = 0;
+  for(uint8_t j = 0; j < i; j++) start += strips[j].count;
+  return start;
+}
+
+void stripRemap(const StripConfig* strips, uint8_t n, const uint8_t* logical, uint8_t* physical){
+  for(uint8_t i = 0; i < n; i++) {
+    const StripConfig& s = strips[i];
+    const uint8_t* src = logical + (uint32_t)s.logicalStart * STRIP_PIXEL_BYTES;
+    if(!s.reversed) {
+      memcpy(physical, src, (uint32_t)s.count * STRIP_PIXEL_BYTES);
+    } else {
+      const uint8_t* from = src + (uint32_t)(s.count - 1) * STRIP_PIXEL_BYTES;
+      for(uint16_t p = 0; p < s.count; p++, from -= STRIP_PIXEL_BYTES) {
+        memcpy(physical + (uint32_t)p * STRIP_PIXEL_BYTES, from, STRIP_PIXEL_BYTES);
+      }
+    }
+    physical += (uint32_t)s.count * STRIP_PIXEL_BYTES;
+  }
+}
+
+uint16_t stripLogicalIndex(const StripConfig* strips, uint8_t n, uint16_t p){
+  for(uint8_t i = 0; i < n; i++) {
+    const StripConfig& s = strips[i];
+    if(p < s.count) return s.reversed ? s.logicalStart + s.count - 1 - p : s.logicalStart + p;
+    p -= s.count;
+  }
+  return 0xFFFF;
+}
+
+uint32_t stripWireUs(uint16_t count){
+  return (uint32_t)count * 24 * STRIP_BIT_NS / 1000 + STRIP_LATCH_US;
+}
+
+uint32_t stripFrameUs(const StripConfig* strips, uint8_t n){
+  uint32_t longest = 0;
+  for(uint8_t i = 0; i < n; i++) {
+    uint32_t us = stripWireUs(strips[i].count);
+    if(us > longest) longest = us;
+  }
+  return longest;
+}
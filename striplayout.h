@@ -0,0 +1,59 @@
+#ifndef STRIPLAYOUT_H
+#define STRIPLAYOUT_H
+
+// ── Strip Layout ─────────────────────────────────────────────────────────────
+// A node can drive several strips, each on its own pin and output channel. On
+// the ESP32 every strip gets an RMT channel and FastLED.show() starts them all
+// before waiting, so they clock out at the same time. A frame then takes as
+// long as the longest strip, not the sum of all of them. Patterns still draw
+// into one continuous logical buffer. Each strip shows a contiguous run of it,
+// optionally reversed for a strip fed from the far end, and the output stage
+// copies the runs into the strips' physical buffer. When the strips are
+// in-order and unreversed the logical buffer is the physical one and nothing
+// is copied.
+// Hardware-independent: the firmware (output.cpp) and tools/strips_sim.cpp
+// share this.
+
+#include <stdint.h>
+
+static const uint8_t  STRIP_MAX_CHANNELS = 8;      // ESP32 RMT channels
+static const uint8_t  STRIP_PIXEL_BYTES  = 3;      // CRGB
+static const uint32_t STRIP_BIT_NS       = 1250;   // WS2812B at 800kHz
+static const uint32_t STRIP_LATCH_US     = 300;    // Reset gap - newer WS2812Bs need >280us
+
+struct StripConfig {
+  uint8_t  pin;
+  uint16_t logicalStart;   // First logical pixel this strip shows
+  uint16_t count;
+  bool     reversed;       // Pixel 0 of the strip shows logicalStart + count - 1
+};
+
+// Every logical pixel in [0, total) on exactly one strip, at most
+// STRIP_MAX_CHANNELS strips, none empty
+bool stripLayoutValid(const StripConfig* strips, uint8_t n, uint16_t total);
+
+// Copy of a layout for a strip total pixels long: the strip showing the end of
+// the logical strip (highest logicalStart) takes whatever the others leave.
+// False when that leaves it nothing or the result isn't valid.
+bool stripLayoutFit(const StripConfig* in, uint8_t n, uint16_t total, StripConfig* out);
+
+// True when the physical order is the logical one - strips in logical order,
+// none reversed - and the strips can point straight into the logical buffer
+bool stripLayoutDirect(const StripConfig* strips, uint8_t n);
+
+// Offset of strip i's pixels in the physical buffer (strips back to back)
+uint16_t stripPhysicalStart(const StripConfig* strips, uint8_t i);
+
+// Logical -> physical copy of STRIP_PIXEL_BYTES pixels
+void stripRemap(const StripConfig* strips, uint8_t n, const uint8_t* logical, uint8_t* physical);
+
+// Physical pixel p (strip order) -> logical pixel it shows
+uint16_t stripLogicalIndex(const StripConfig* strips, uint8_t n, uint16_t p);
+
+// Time to clock count pixels out of one channel, latch included
+uint32_t stripWireUs(uint16_t count);
+
+// Frame time with every channel running at once - the slowest strip
+uint32_t stripFrameUs(const StripConfig* strips, uint8_t n);
+
+#endif
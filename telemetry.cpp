@@ -0,0 +1,160 @@
+#include "telemetry.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ── Loop time distribution ──
+
+static uint8_t loopBucket(uint32_t us){
+  if(us < 8) return us;
+  uint8_t msb = 31 - __builtin_clz(us);
+  uint32_t b = 8 + (msb - 3) * 4 + ((us >> (msb - 2)) & 3);
+  return b < LOOP_HIST_BUCKETS ? b : LOOP_HIST_BUCKETS - 1;
+}
+
+static uint32_t bucketTop(uint8_t b){
+  if(b < 8) return b;
+  uint8_t msb = 3 + (b - 8) / 4, sub = (b - 8) % 4;
+  return ((uint32_t)(5 + sub) << (msb - 2)) - 1;
+}
+
+void loopHistReset(LoopHistogram& h){
+  memset(&h, 0, sizeof(h));
+}
+
+void loopHistNote(LoopHistogram& h, uint32_t us){
+  h.bucket[loopBucket(us)]++;
+  h.count++;
+}
+
+uint32_t loopHistPercentile(const LoopHistogram& h, uint16_t permille){
+  if(!h.count) return 0;
+  uint64_t want = ((uint64_t)h.count * permille + 999) / 1000, seen = 0;
+  for(uint8_t b = 0; b < LOOP_HIST_BUCKETS; b++) {
+    seen += h.bucket[b];
+    if(seen >= want) return bucketTop(b);
+  }
+  return bucketTop(LOOP_HIST_BUCKETS - 1);
+}
+
+// ── Beacon ──
+
+int telemetryEncode(const TelemetryBeacon& b, uint8_t* out){
+  memcpy(out + 0, b.version, 3);
+  out[3] = b.role;
+  out[4] = b.resetReason;
+  out[5] = b.brightness;
+  out[6] = (uint8_t)b.rssi;
+  memcpy(out + 7,  &b.uptimeS, 4);
+  memcpy(out + 11, &b.freeHeap, 4);
+  memcpy(out + 15, &b.minFreeHeap, 4);
+  memcpy(out + 19, &b.loopP99Us, 2);
+  memcpy(out + 21, &b.loopMaxMs, 2);
+  memcpy(out + 23, &b.framesShown, 4);
+  memcpy(out + 27, &b.framesDropped, 4);
+  return TELEMETRY_BEACON_LEN;
+}
+
+bool telemetryDecode(const uint8_t* in, int len, TelemetryBeacon& b){
+  if(len < TELEMETRY_BEACON_LEN) return false;
+  memcpy(b.version, in + 0, 3);
+  b.role = in[3];
+  b.resetReason = in[4];
+  b.brightness = in[5];
+  b.rssi = (int8_t)in[6];
+  memcpy(&b.uptimeS,       in + 7, 4);
+  memcpy(&b.freeHeap,      in + 11, 4);
+  memcpy(&b.minFreeHeap,   in + 15, 4);
+  memcpy(&b.loopP99Us,     in + 19, 2);
+  memcpy(&b.loopMaxMs,     in + 21, 2);
+  memcpy(&b.framesShown,   in + 23, 4);
+  memcpy(&b.framesDropped, in + 27, 4);
+  return true;
+}
+
+void telemetryParseVersion(const char* version, uint8_t out[3]){
+  memset(out, 0, 3);
+  for(int i = 0; i < 3 && version && *version; i++) {
+    out[i] = (uint8_t)strtoul(version, (char**)&version, 10);
+    if(*version == '.') version++;
+  }
+}
+
+static const char* RESET_NAMES[] = {"?", "power", "ext", "sw", "panic", "int wdt", "task wdt", "wdt",
+                                    "sleep", "brownout", "sdio"};
+
+const char* telemetryResetName(uint8_t reason){
+  return reason < sizeof(RESET_NAMES) / sizeof(RESET_NAMES[0]) ? RESET_NAMES[reason] : "?";
+}
+
+uint32_t telemetrySlotOffsetMs(uint32_t token){
+  // Different token bits from the report slot, so the two don't line up
+  return ((token >> 8) % TELEMETRY_SLOTS) * (TELEMETRY_BEACON_MS / TELEMETRY_SLOTS);
+}
+
+// ── Fleet table ──
+
+void fleetReset(FleetTable& t){
+  memset(&t, 0, sizeof(t));
+}
+
+void fleetNote(FleetTable& t, uint32_t token, const TelemetryBeacon& b, uint32_t nowMs){
+  // Same node, else a free slot, else the stalest entry
+  int slot = -1, freeSlot = -1, stalest = 0;
+  for(int i = 0; i < TELEMETRY_MAX_NODES && slot < 0; i++) {
+    if(t.nodes[i].token == token) slot = i;
+    else if(t.nodes[i].token == 0) { if(freeSlot < 0) freeSlot = i; }
+    else if(nowMs - t.nodes[i].lastMs > nowMs - t.nodes[stalest].lastMs) stalest = i;
+  }
+  bool known = slot >= 0;
+  if(!known) {
+    slot = (freeSlot >= 0) ? freeSlot : stalest;
+    memset(&t.nodes[slot], 0, sizeof(FleetEntry));
+  }
+  FleetEntry& e = t.nodes[slot];
+  const TelemetryBeacon& prev = e.beacon;
+
+  if(known && b.uptimeS < prev.uptimeS) {
+    // Rebooted - counters and the heap baseline start over
+    e.reboots++;
+    known = false;
+  }
+  if(!known || b.uptimeS < TELEMETRY_SETTLE_S) {
+    e.baseMinHeap = b.minFreeHeap;
+    e.baseUptimeS = b.uptimeS;
+  }
+  if(!known) {
+    e.dropPermille = 0;
+  } else {
+    uint32_t shown = b.framesShown - prev.framesShown, dropped = b.framesDropped - prev.framesDropped;
+    e.dropPermille = shown + dropped ? dropped * 1000 / (shown + dropped) : 0;
+  }
+  e.token = token;
+  e.lastMs = nowMs;
+  e.beacon = b;
+  e.beacons++;
+}
+
+uint8_t fleetFlags(const FleetEntry& e, uint32_t nowMs){
+  const TelemetryBeacon& b = e.beacon;
+  uint8_t f = 0;
+  if(nowMs - e.lastMs > TELEMETRY_STALE_MS) f |= FLEET_STALE;
+  if(b.freeHeap < TELEMETRY_LOW_HEAP) f |= FLEET_LOW_HEAP;
+  // The low-water mark settles within minutes of boot; one that keeps falling is a leak
+  if((b.uptimeS - e.baseUptimeS) * 1000ull >= TELEMETRY_LEAK_MIN_MS
+     && e.baseMinHeap > b.minFreeHeap + TELEMETRY_LEAK_BYTES) f |= FLEET_LEAK;
+  if(e.dropPermille >= TELEMETRY_DROP_PERMILLE || (b.rssi && b.rssi < TELEMETRY_WEAK_RSSI)) f |= FLEET_BAD_LINK;
+  if(b.loopP99Us >= TELEMETRY_SLOW_LOOP_US) f |= FLEET_SLOW_LOOP;
+  if(e.reboots) f |= FLEET_REBOOTED;
+  return f;
+}
+
+uint8_t fleetSorted(const FleetTable& t, uint8_t order[TELEMETRY_MAX_NODES]){
+  uint8_t n = 0;
+  for(uint8_t i = 0; i < TELEMETRY_MAX_NODES; i++) {
+    if(!t.nodes[i].token) continue;
+    uint8_t j = n++;
+    while(j > 0 && t.nodes[order[j - 1]].token > t.nodes[i].token) { order[j] = order[j - 1]; j--; }
+    order[j] = i;
+  }
+  return n;
+}
@@ -0,0 +1,100 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+// ── Fleet Telemetry ──────────────────────────────────────────────────────────
+// Every node broadcasts a compact PKT_TELEMETRY beacon once per
+// TELEMETRY_BEACON_MS in its own token-derived slot: firmware version, heap,
+// loop time, frames shown / dropped, link RSSI, uptime and brightness. Every
+// node keeps the latest beacon per sender in a FleetTable - whichever one you
+// plug into (normally the leader) can dump the whole fleet over serial and
+// point at the node with a bad link or a shrinking heap. Frame counters are
+// totals since boot so a lost beacon costs resolution, not accuracy.
+// Hardware-independent.
+
+#include <stdint.h>
+
+static const uint32_t TELEMETRY_BEACON_MS      = 5000;
+static const uint8_t  TELEMETRY_SLOTS          = 50;      // 100ms slots within the period
+static const uint32_t TELEMETRY_STALE_MS       = 3 * TELEMETRY_BEACON_MS;
+static const uint8_t  TELEMETRY_MAX_NODES      = 32;
+static const uint32_t TELEMETRY_LOW_HEAP       = 10000;   // Same line as checkSystemHealth()
+static const uint32_t TELEMETRY_LEAK_BYTES     = 8192;    // Heap low-water fallen this far...
+static const uint32_t TELEMETRY_LEAK_MIN_MS    = 600000;  // ...over at least this long
+static const uint32_t TELEMETRY_SETTLE_S       = 300;     // Heap use still growing normally (WiFi etc.) until then
+static const uint16_t TELEMETRY_DROP_PERMILLE  = 50;      // Frame loss that marks a bad link
+static const int8_t   TELEMETRY_WEAK_RSSI      = -85;     // dBm
+static const uint32_t TELEMETRY_SLOW_LOOP_US   = 20000;   // p99 above a frame period shows as stutter
+
+// ── Loop time distribution ──
+// Log-scale buckets, 4 per octave (within ~19%) up to ~130ms; cheap enough to
+// note every loop() pass.
+static const uint8_t LOOP_HIST_BUCKETS = 64;
+
+struct LoopHistogram {
+  uint32_t bucket[LOOP_HIST_BUCKETS];
+  uint32_t count;
+};
+
+void     loopHistReset(LoopHistogram& h);
+void     loopHistNote(LoopHistogram& h, uint32_t us);
+uint32_t loopHistPercentile(const LoopHistogram& h, uint16_t permille);   // Upper edge of the bucket, us
+
+// ── Beacon ──
+enum TelemetryRole : uint8_t { TELEM_FOLLOWER = 0, TELEM_LEADER, TELEM_ELECT, TELEM_OFF };
+
+struct TelemetryBeacon {
+  uint8_t  version[3];         // major.minor.patch
+  uint8_t  role;               // TelemetryRole
+  uint8_t  resetReason;        // esp_reset_reason() at boot
+  uint8_t  brightness;         // Local brightness scale
+  int8_t   rssi;               // Mean RSSI of leader frames, 0 when none
+  uint32_t uptimeS;
+  uint32_t freeHeap;
+  uint32_t minFreeHeap;        // Low-water mark since boot
+  uint16_t loopP99Us;          // Over the last beacon period, clamped
+  uint16_t loopMaxMs;
+  uint32_t framesShown;        // Since boot
+  uint32_t framesDropped;      // Since boot - frames that never completed
+};
+static const uint8_t TELEMETRY_BEACON_LEN = 3 + 1 + 1 + 1 + 1 + 4 + 4 + 4 + 2 + 2 + 4 + 4;
+
+int  telemetryEncode(const TelemetryBeacon& b, uint8_t* out);
+bool telemetryDecode(const uint8_t* in, int len, TelemetryBeacon& b);
+void telemetryParseVersion(const char* version, uint8_t out[3]);   // "1.1.48" -> {1,1,48}
+const char* telemetryResetName(uint8_t reason);                   // esp_reset_reason() code -> "task wdt"
+
+// Delay of this node's beacon slot within TELEMETRY_BEACON_MS
+uint32_t telemetrySlotOffsetMs(uint32_t token);
+
+// ── Fleet table ──
+enum FleetFlag : uint8_t {
+  FLEET_STALE     = 0x01,   // No beacon for TELEMETRY_STALE_MS
+  FLEET_LOW_HEAP  = 0x02,
+  FLEET_LEAK      = 0x04,   // Heap low-water still falling well after boot
+  FLEET_BAD_LINK  = 0x08,   // Dropping frames, or weak RSSI
+  FLEET_SLOW_LOOP = 0x10,
+  FLEET_REBOOTED  = 0x20,   // Uptime went backwards since we first heard it
+};
+
+struct FleetEntry {
+  uint32_t        token;
+  uint32_t        lastMs;
+  TelemetryBeacon beacon;
+  uint32_t        baseMinHeap;     // Low-water once it settled after boot (or when first heard)
+  uint32_t        baseUptimeS;
+  uint16_t        dropPermille;    // Between the last two beacons
+  uint16_t        beacons;
+  uint8_t         reboots;
+};
+
+struct FleetTable {
+  FleetEntry nodes[TELEMETRY_MAX_NODES];
+};
+
+void    fleetReset(FleetTable& t);
+void    fleetNote(FleetTable& t, uint32_t token, const TelemetryBeacon& b, uint32_t nowMs);
+uint8_t fleetFlags(const FleetEntry& e, uint32_t nowMs);
+// Entries in use, sorted by token into order[] - returns the count
+uint8_t fleetSorted(const FleetTable& t, uint8_t order[TELEMETRY_MAX_NODES]);
+
+#endif
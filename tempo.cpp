@@ -0,0 +1,82 @@
+#include "tempo.h"
+#include <math.h>
+#include <string.h>
+
+void tempoInit(TempoTracker& t, float hopMs){
+  memset(&t, 0, sizeof(t));
+  t.hopMs = hopMs;
+  t.minLag = (uint16_t)(60000.0f / TEMPO_MAX_BPM / hopMs);
+  t.maxLag = (uint16_t)ceilf(60000.0f / TEMPO_MIN_BPM / hopMs);
+  if(t.minLag < 2) t.minLag = 2;
+  if(t.maxLag > TEMPO_MAX_LAG) t.maxLag = TEMPO_MAX_LAG;
+  t.decay = expf(-hopMs / (TEMPO_ACF_SECONDS * 1000.0f));
+  for(int l = t.minLag; l <= t.maxLag; l++){
+    float oct = log2f(60000.0f / (l * hopMs) / TEMPO_PRIOR_BPM) / TEMPO_PRIOR_OCT;
+    t.prior[l] = expf(-0.5f * oct * oct);
+  }
+  t.period = 60000.0f / TEMPO_PRIOR_BPM / hopMs;
+  t.bpm = TEMPO_PRIOR_BPM;
+}
+
+// Strongest prior-weighted lag, refined to a fraction of a hop. Confidence is
+// how far that peak stands above the average lag - slow level drifts correlate
+// at every lag and so score nothing
+static float bestLag(const TempoTracker& t, float& conf){
+  int best = t.minLag;
+  float bestScore = -1e30f, sum = 0;
+  for(int l = t.minLag; l <= t.maxLag; l++){
+    float s = t.acf[l] * t.prior[l];
+    sum += t.acf[l];
+    if(s > bestScore) { bestScore = s; best = l; }
+  }
+  float mean = sum / (t.maxLag - t.minLag + 1);
+  conf = t.acf[0] > 0 ? (t.acf[best] - mean) / t.acf[0] : 0;
+  if(conf < 0) conf = 0;
+  float lag = best;
+  if(best > t.minLag && best < t.maxLag) {
+    float a = t.acf[best - 1], b = t.acf[best], c = t.acf[best + 1];
+    float den = a - 2 * b + c;
+    if(den < 0) lag += 0.5f * (a - c) / den;
+  }
+  return lag;
+}
+
+void tempoUpdate(TempoTracker& t, float strength, bool onset){
+  // Onset strength about its running mean - noise then correlates with nothing
+  // (rectifying it would leave a 1/pi floor that reads as a weak tempo everywhere)
+  t.strengthMean += (strength - t.strengthMean) * 0.02f;
+  float x = strength - t.strengthMean;
+  t.head = (t.head + 1) & (TEMPO_HISTORY - 1);
+  t.strength[t.head] = x;
+
+  t.acf[0] = t.acf[0] * t.decay + x * x;
+  for(int l = t.minLag; l <= t.maxLag; l++){
+    t.acf[l] = t.acf[l] * t.decay + x * t.strength[(t.head - l) & (TEMPO_HISTORY - 1)];
+  }
+  t.hops++;
+
+  float lag = bestLag(t, t.confidence);
+
+  // Beat clock - free-runs at its period, pulled towards onsets near a beat
+  t.beat = false;
+  t.phase += 1.0f / t.period;
+  if(t.phase >= 1.0f) {
+    t.phase -= 1.0f;
+    t.beat = true;
+    t.beats++;
+    // Follow the estimate a little every beat; jump on a clear tempo change
+    float ratio = lag / t.period;
+    if(ratio > 1.15f || ratio < 0.87f) {
+      if(tempoLocked(t)) t.period = lag;
+    } else {
+      t.period += (lag - t.period) * TEMPO_PERIOD_GAIN;
+    }
+  }
+  if(onset && tempoLocked(t)) {
+    // The detector reports an onset one hop after it happened
+    float at = t.phase - 1.0f / t.period;
+    float err = at > 0.5f ? at - 1.0f : (at < -0.5f ? at + 1.0f : at);   // Before (<0) or after (>0) the clock's beat
+    if(fabsf(err) < 0.25f) t.phase -= err * TEMPO_PHASE_GAIN;  // Partial correction never wraps
+  }
+  t.bpm = 60000.0f / (t.period * t.hopMs);
+}
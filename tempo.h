@@ -0,0 +1,55 @@
+#ifndef TEMPO_H
+#define TEMPO_H
+
+// ── Tempo & Beat-phase Tracking ──────────────────────────────────────────────
+// Fed once per analysis hop with the onset strength (spectral flux above the
+// detector's threshold) and the onset flag from onset.h. Keeps a short ring of onset strength and an
+// exponentially-decaying autocorrelation for every candidate beat period, so
+// each hop costs one multiply-add per lag - no windows to rescan, nothing
+// thrown away. The strongest period (weighted towards ~120 BPM to avoid
+// octave errors) steers a phase-locked beat clock that onsets pull into line.
+// Hardware-independent.
+
+#include <stdint.h>
+
+static const uint16_t TEMPO_MIN_BPM     = 60;
+static const uint16_t TEMPO_MAX_BPM     = 200;
+static const uint16_t TEMPO_MAX_LAG     = 100;     // Hops - 60 BPM at 10ms hops
+static const uint16_t TEMPO_HISTORY     = 128;     // Onset-strength ring (power of two, > TEMPO_MAX_LAG)
+static const float    TEMPO_ACF_SECONDS = 6.0f;    // Autocorrelation memory
+static const float    TEMPO_PRIOR_BPM   = 120.0f;  // Centre of the tempo prior...
+static const float    TEMPO_PRIOR_OCT   = 1.0f;    // ...and its width in octaves
+static const float    TEMPO_LOCK_CONF   = 0.35f;   // Confidence needed to call it music (audio_eval: speech locks below 0.35, music fails above 0.4)
+static const float    TEMPO_PHASE_GAIN  = 0.25f;   // Share of the phase error an onset corrects
+static const float    TEMPO_PERIOD_GAIN = 0.2f;    // Per-beat slew of the clock towards the estimate
+
+struct TempoTracker {
+  float    hopMs;
+  uint16_t minLag, maxLag;
+
+  float    strength[TEMPO_HISTORY];   // Mean-removed onset strength per hop
+  uint16_t head;
+  float    strengthMean;
+  float    acf[TEMPO_MAX_LAG + 1];    // Running autocorrelation per lag, [0] = energy
+  float    prior[TEMPO_MAX_LAG + 1];
+  float    decay;
+
+  // Outputs
+  float    bpm;             // Current tempo estimate
+  float    confidence;      // Normalised autocorrelation at that period, 0..1
+  float    period;          // Beat clock period in hops
+  float    phase;           // 0 at the beat, rising to 1 just before the next
+  bool     beat;            // A beat fell in the last hop
+  uint32_t beats;           // Beats since init
+  uint32_t hops;
+};
+
+void tempoInit(TempoTracker& t, float hopMs);
+
+// One analysis hop - strength is how far the spectral flux rose above the onset
+// threshold (0 most hops), onset the detector's peak-picked decision
+void tempoUpdate(TempoTracker& t, float strength, bool onset);
+
+inline bool tempoLocked(const TempoTracker& t){ return t.confidence >= TEMPO_LOCK_CONF; }
+
+#endif
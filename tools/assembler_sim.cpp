@@ -0,0 +1,110 @@
+// ── Frame Assembly Simulator ─────────────────────────────────────────────────
+// Host-side check of the follower's frame assembly (assembler.cpp) across
+// leader changes. A leader streams v2 frames built with protocol.cpp, every
+// one followed by a relayed copy of the frame before it, and part-way through
+// the stream changes:
+//   - the leader reboots: same token, frame ids and clock start from zero
+//   - another node takes over: new token, frame ids a little behind the old ones
+//   - the frame id wraps: 16-bit ids run past 65535
+// Each scenario checks that late copies never replace the frame in progress
+// and that the first frame after the change completes straight away - not
+// after ASM_STALE_FRAMES frames of a frozen strip.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o assembler_sim tools/assembler_sim.cpp assembler.cpp protocol.cpp
+// Run:
+//   ./assembler_sim
+
+#include "../assembler.h"
+#include <stdio.h>
+#include <string.h>
+
+static const uint16_t NUM_LEDS       = 150;
+static const uint8_t  LEDS_PER_CHUNK = 75;
+static const uint8_t  CHUNKS         = 2;
+static const uint32_t FRAME_US       = 40000;   // 25fps on the air
+static const int      FRAMES         = 60;      // Per leader, before and after the change
+
+// One leader's stream
+struct Leader {
+  uint32_t token;
+  uint16_t frameId;
+  uint32_t clockUs;
+};
+
+struct Counts {
+  int completed, late;   // Frames completed, late copies that completed one
+};
+
+static uint8_t rgb[NUM_LEDS * 3];
+
+// Every chunk of one frame, then a relayed copy of the frame before it
+static void sendFrame(FrameAssembler& fa, const Leader& ld, uint32_t rxUs, Counts& c){
+  uint8_t buf[PROTO_MAX_PACKET];
+  for(int pass = 0; pass < 2; pass++) {
+    uint16_t id = pass ? ld.frameId - 1 : ld.frameId;
+    uint32_t stamp = pass ? ld.clockUs - FRAME_US : ld.clockUs;
+    for(uint8_t ch = 0; ch < CHUNKS; ch++) {
+      int len = protoBuildV2(buf, PKT_PIXELS, PROTO_FLAG_LEADER, ld.token, id, ch, CHUNKS, stamp,
+                             ch * LEDS_PER_CHUNK, rgb + ch * LEDS_PER_CHUNK * 3, LEDS_PER_CHUNK * 3);
+      PacketInfo pkt;
+      if(protoParse(buf, len, pkt) != PARSE_OK) continue;
+      if(asmAddChunk(fa, pkt, pass, rxUs)) {
+        if(pass) c.late++;
+        else c.completed++;
+      }
+    }
+  }
+}
+
+static void stream(FrameAssembler& fa, Leader& ld, int frames, uint32_t& rxUs, Counts& c){
+  for(int f = 0; f < frames; f++) {
+    sendFrame(fa, ld, rxUs, c);
+    ld.frameId++;
+    ld.clockUs += FRAME_US;
+    rxUs += FRAME_US;
+  }
+}
+
+struct Scenario {
+  const char* name;
+  Leader      before, after;   // Streams either side of the change
+};
+
+static bool run(const Scenario& sc){
+  FrameAssembler fa;
+  asmInit(fa, rgb, NUM_LEDS);
+  Leader a = sc.before, b = sc.after;
+  uint32_t rxUs = 1000000;
+  Counts first = {}, second = {};
+  stream(fa, a, FRAMES, rxUs, first);
+  // The new stream's first frame must complete at once
+  Counts change = {};
+  sendFrame(fa, b, rxUs, change);
+  b.frameId++;
+  b.clockUs += FRAME_US;
+  rxUs += FRAME_US;
+  stream(fa, b, FRAMES - 1, rxUs, second);
+
+  int completed = first.completed + change.completed + second.completed;
+  int late = first.late + change.late + second.late;
+  bool ok = change.completed == 1 && completed == 2 * FRAMES && late == 0;
+  printf("%-22s %7d %9s %6d  %s\n", sc.name, completed, change.completed ? "yes" : "NO", late, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+int main(){
+  const Scenario scenarios[] = {
+    // Rebooted: ids from 0 again, its clock 1.5s into the new boot
+    {"leader reboot",      {0x300000, 0, 8000000},        {0x300000, 0, 1500000}},
+    // The next node up takes over with ids 40 behind the old leader's
+    {"leader hand-over",   {0x300000, 1000, 8000000},     {0x200000, 1020, 12000000}},
+    // One leader running past the 16-bit id
+    {"frame id wrap",      {0x300000, 65500, 8000000},    {0x300000, 24, 10400000}},
+  };
+  bool ok = true;
+  printf("%-22s %7s %9s %6s  %s\n", "scenario", "frames", "at once", "late", "check");
+  for(const Scenario& sc : scenarios) ok &= run(sc);
+  printf("\nFrame assembly %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,515 @@
+// ── Audio Detector Benchmark ─────────────────────────────────────────────────
+// Runs the firmware's music detector (music.cpp: onset.cpp, tempo.cpp, fft.cpp)
+// and the legacy amplitude detector it replaced (legacy_audio.h - the old
+// detectAudioFrame()/updateBPM() verbatim) over a corpus of WAV files and
+// scores both:
+//   - onset precision/recall/F within ONSET_TOLERANCE_MS
+//   - tempo error against the annotated beats (median of the estimates made
+//     while audioDetected, per clip), and how many clips are within 4%
+//   - audioDetected rate on music, and the false-positive rate on clips with
+//     no beat (speech, crowd noise, held chords)
+//   - CPU time per 240-sample block and per second of audio on this machine,
+//     for the detector as it runs on the node (decimated to 11kHz first) and
+//     at the full input rate ("fullrate", the analysis before decimate.h)
+// so thresholds can be tuned against numbers instead of a speaker in a room.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o audio_eval tools/audio_eval.cpp music.cpp onset.cpp tempo.cpp fft.cpp decimate.cpp
+// Run:
+//   ./audio_eval corpus/ [more.wav ...]    directories are scanned for *.wav
+//   ./audio_eval --synth dir               write a labelled synthetic corpus to dir/ (created if
+//                                          missing) to try it
+//
+// WAV: 16-bit PCM, mono or stereo (channels are averaged); 44.1kHz is what the
+// legacy detector assumes. Sidecars next to each clip, one time in seconds
+// per line (extra columns and #comments ignored):
+//   clip.beats  beat times - REQUIRED. An empty file marks a clip with no beat
+//               (speech/noise): anything audioDetected there is a false positive
+//   clip.txt    onset times - optional. An empty file means "no onsets here"
+
+#include "../music.h"
+#include "legacy_audio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+static const uint32_t FIRMWARE_SR        = 44100;   // MIC_SR
+static const double   ONSET_TOLERANCE_MS = 50;      // MIREX convention
+static const double   TEMPO_TOLERANCE    = 0.04;    // MIREX "accuracy 1"
+static const uint32_t BENCH_BLOCK        = 240;     // The legacy record size
+static const double   BENCH_WARMUP_MS    = 5000;    // Both detectors need a few seconds of history
+
+struct Wav {
+  uint32_t sampleRate = 0;
+  std::vector<int16_t> samples;
+};
+
+static bool readWav(const char* path, Wav& w){
+  FILE* f = fopen(path, "rb");
+  if(!f) { perror(path); return false; }
+  uint8_t hdr[12];
+  if(fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+    fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+    fclose(f);
+    return false;
+  }
+  uint16_t channels = 0, bits = 0;
+  uint8_t ck[8];
+  while(fread(ck, 1, 8, f) == 8) {
+    uint32_t size;
+    memcpy(&size, ck + 4, 4);
+    if(!memcmp(ck, "fmt ", 4)) {
+      uint8_t fmt[16];
+      if(size < 16 || fread(fmt, 1, 16, f) != 16) break;
+      memcpy(&channels, fmt + 2, 2);
+      memcpy(&w.sampleRate, fmt + 4, 4);
+      memcpy(&bits, fmt + 14, 2);
+      fseek(f, size - 16 + (size & 1), SEEK_CUR);
+    } else if(!memcmp(ck, "data", 4)) {
+      if(bits != 16 || !channels) break;
+      std::vector<int16_t> raw(size / 2);
+      size_t got = fread(raw.data(), 2, raw.size(), f);
+      w.samples.resize(got / channels);
+      for(size_t i = 0; i < w.samples.size(); i++) {
+        int32_t sum = 0;
+        for(int c = 0; c < channels; c++) sum += raw[i * channels + c];
+        w.samples[i] = (int16_t)(sum / channels);
+      }
+      fclose(f);
+      return true;
+    } else {
+      fseek(f, size + (size & 1), SEEK_CUR);
+    }
+  }
+  fprintf(stderr, "%s: needs 16-bit PCM\n", path);
+  fclose(f);
+  return false;
+}
+
+static bool writeWav(const std::string& path, const std::vector<int16_t>& s, uint32_t sr){
+  FILE* f = fopen(path.c_str(), "wb");
+  if(!f) { perror(path.c_str()); return false; }
+  uint32_t data = s.size() * 2, riff = 36 + data, fmtLen = 16, rate2 = sr * 2;
+  uint16_t pcm = 1, ch = 1, align = 2, bits = 16;
+  fwrite("RIFF", 1, 4, f); fwrite(&riff, 4, 1, f); fwrite("WAVE", 1, 4, f);
+  fwrite("fmt ", 1, 4, f); fwrite(&fmtLen, 4, 1, f);
+  fwrite(&pcm, 2, 1, f); fwrite(&ch, 2, 1, f); fwrite(&sr, 4, 1, f); fwrite(&rate2, 4, 1, f);
+  fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+  fwrite("data", 1, 4, f); fwrite(&data, 4, 1, f);
+  fwrite(s.data(), 2, s.size(), f);
+  fclose(f);
+  return true;
+}
+
+static std::vector<double> readLabels(const std::string& path, bool& found){
+  std::vector<double> t;
+  FILE* f = fopen(path.c_str(), "r");
+  found = (f != nullptr);
+  if(!f) return t;
+  char line[256];
+  while(fgets(line, sizeof(line), f)) {
+    if(line[0] == '#') continue;
+    char* end;
+    double v = strtod(line, &end);
+    if(end != line) t.push_back(v);
+  }
+  fclose(f);
+  return t;
+}
+
+static std::string sidecarPath(const std::string& wav, const char* ext){
+  size_t dot = wav.rfind('.');
+  return (dot == std::string::npos ? wav : wav.substr(0, dot)) + ext;
+}
+
+// Greedy one-to-one matching of detections to labels within the tolerance
+static void score(const std::vector<double>& det, const std::vector<double>& ref, int& tp, int& fp, int& fn){
+  std::vector<bool> used(ref.size(), false);
+  tp = 0;
+  for(double d : det) {
+    int best = -1;
+    double bestErr = ONSET_TOLERANCE_MS / 1000.0;
+    for(size_t i = 0; i < ref.size(); i++) {
+      double e = fabs(d - ref[i]);
+      if(!used[i] && e <= bestErr) { bestErr = e; best = (int)i; }
+    }
+    if(best >= 0) { used[best] = true; tp++; }
+  }
+  fp = (int)det.size() - tp;
+  fn = (int)ref.size() - tp;
+}
+
+static double median(std::vector<double> v){
+  if(v.empty()) return NAN;
+  std::sort(v.begin(), v.end());
+  return v.size() & 1 ? v[v.size() / 2] : (v[v.size() / 2 - 1] + v[v.size() / 2]) / 2;
+}
+
+// Reference tempo from beat annotations - the median inter-beat interval
+static double referenceBpm(const std::vector<double>& beats){
+  std::vector<double> ibi;
+  for(size_t i = 1; i < beats.size(); i++) ibi.push_back(beats[i] - beats[i - 1]);
+  double m = median(ibi);
+  return m > 0 ? 60.0 / m : NAN;
+}
+
+// What one detector made of one clip
+struct Run {
+  std::vector<double> onsets;     // Seconds
+  std::vector<double> bpm;        // Tempo estimates after warm-up, one per decision
+  uint32_t decisions = 0, detected = 0;   // audioDetected samples after warm-up, and how many were true
+  double   ns = 0;                // Time inside the detector
+  uint64_t blocks = 0;            // 240-sample blocks it covered
+};
+
+// The firmware's detector (music.cpp), fed in BENCH_BLOCK-sample blocks -
+// decimated as on the node, or analysed at the full input rate as before
+static void runCurrent(const Wav& w, Run& r, bool decimate){
+  static MusicDetector m;
+  musicInit(m, w.sampleRate, decimate);
+  double delayS = decimate ? (DECIM_TAPS - 1) / 2.0 / w.sampleRate : 0;   // FIR group delay
+
+  uint32_t lastBeats = 0;
+  for(size_t pos = 0; pos + BENCH_BLOCK <= w.samples.size(); pos += BENCH_BLOCK) {
+    uint32_t endMs = (uint64_t)(pos + BENCH_BLOCK) * 1000 / w.sampleRate;
+    auto t0 = std::chrono::steady_clock::now();
+    int hops = musicFeed(m, w.samples.data() + pos, BENCH_BLOCK, endMs);
+    bool detected = musicUpdate(m);
+    r.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    r.blocks++;
+    if(!hops) continue;
+
+    if(m.features.onset) {
+      // The onset belongs to the previous hop - time it at that window's centre
+      uint32_t hop0 = m.features.hop - 1;
+      r.onsets.push_back(((double)hop0 * m.analyzer.hopLen - m.analyzer.n / 2.0) / m.analyzer.sampleRate - delayS);
+    }
+    if(endMs < BENCH_WARMUP_MS) continue;
+    r.decisions++;
+    if(detected) r.detected++;
+    if(m.tempo.beats != lastBeats && detected) r.bpm.push_back(m.tempo.bpm);
+    lastBeats = m.tempo.beats;
+  }
+}
+
+// The old detector (legacy_audio.h), called exactly as the leader called it:
+// detectAudioFrame() once per frame, updateBPM() after it
+static void runLegacy(const Wav& w, Run& r){
+  legacy::reset();
+  legacy::M5.Mic.src = w.samples.data();
+  legacy::M5.Mic.len = w.samples.size();
+  uint32_t durMs = (uint64_t)w.samples.size() * 1000 / w.sampleRate;
+  for(uint32_t t = legacy::FRAME_DELAY_MS; t <= durMs; t += legacy::FRAME_DELAY_MS) {
+    legacy::nowMs = t;
+    legacy::M5.Mic.pos = (uint64_t)t * w.sampleRate / 1000;
+
+    bool wasAbove = legacy::prevAbove;
+    auto t0 = std::chrono::steady_clock::now();
+    legacy::detectAudioFrame();
+    r.ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    r.blocks++;
+    if(legacy::prevAbove && !wasAbove) {
+      // Beat time is the end of the record - centre it on the block instead
+      r.onsets.push_back((t - legacy::MIC_BUF_LEN * 500.0 / w.sampleRate) / 1000.0);
+    }
+
+    // updateBPM() keeps its count to itself - take it the same way just before
+    bool window = t - legacy::lastBpmMillis >= legacy::BPM_WINDOW;
+    int cnt = 0;
+    if(window) for(int i = 0; i < legacy::beatCount; i++) if(legacy::beatTimes[i] >= t - legacy::BPM_WINDOW) cnt++;
+    legacy::updateBPM();
+    if(!window) continue;
+    // Its decision holds for the whole next window
+    r.decisions++;
+    if(legacy::audioDetected) { r.detected++; r.bpm.push_back(cnt * (60000.0 / legacy::BPM_WINDOW)); }
+  }
+}
+
+struct Totals {
+  int tp = 0, fp = 0, fn = 0;
+  int onsetClips = 0;                 // Clips with onset labels
+  std::vector<double> tempoErr;       // Per music clip, percent
+  int tempoOk = 0, tempoScored = 0;   // Within TEMPO_TOLERANCE
+  uint64_t musicDecisions = 0, musicDetected = 0;
+  uint64_t otherDecisions = 0, otherDetected = 0;
+  double ns = 0;
+  uint64_t blocks = 0;
+  double audioS = 0;                  // Seconds of audio run through
+};
+
+static void report(const char* who, const char* name, const Run& r, bool scoreOnsets, const std::vector<double>& ref,
+                   double refBpm, double audioS, Totals& tot){
+  char onsets[64] = "     -      -      -", tempo[32] = "     -", det[16];
+  if(scoreOnsets) {
+    int tp, fp, fn;
+    score(r.onsets, ref, tp, fp, fn);
+    tot.tp += tp; tot.fp += fp; tot.fn += fn;
+    tot.onsetClips++;
+    double P = r.onsets.empty() ? 1 : (double)tp / r.onsets.size();
+    double R = ref.empty() ? 1 : (double)tp / ref.size();
+    snprintf(onsets, sizeof(onsets), "%6.3f %6.3f %6.3f", P, R, (P + R) > 0 ? 2 * P * R / (P + R) : 0);
+  }
+  bool music = !std::isnan(refBpm);
+  if(music) {
+    // No estimate at all is scored as fully wrong
+    double est = median(r.bpm);
+    double err = std::isnan(est) ? 100 : fabs(est - refBpm) / refBpm * 100;
+    tot.tempoErr.push_back(err);
+    tot.tempoScored++;
+    if(err <= TEMPO_TOLERANCE * 100) tot.tempoOk++;
+    if(!std::isnan(est)) snprintf(tempo, sizeof(tempo), "%6.1f", est);
+    tot.musicDecisions += r.decisions; tot.musicDetected += r.detected;
+  } else {
+    tot.otherDecisions += r.decisions; tot.otherDetected += r.detected;
+  }
+  snprintf(det, sizeof(det), "%5.1f%%", r.decisions ? 100.0 * r.detected / r.decisions : 0.0);
+  tot.ns += r.ns;
+  tot.blocks += r.blocks;
+  tot.audioS += audioS;
+  printf("%-8s %-24s %5s %s %6s %6s %8.0f\n", who, name, music ? "music" : "other", onsets,
+         tempo, det, r.blocks ? r.ns / r.blocks : 0);
+}
+
+static void summary(const char* who, const Totals& t){
+  int found = t.tp + t.fp, labels = t.tp + t.fn;
+  double P = found ? (double)t.tp / found : 1, R = labels ? (double)t.tp / labels : 1;
+  // Nothing labelled scores nothing - not a perfect 1.000
+  char onsets[48] = "no onset labels";
+  if(t.onsetClips)
+    snprintf(onsets, sizeof(onsets), "P=%.3f R=%.3f F=%.3f", P, R, (P + R) > 0 ? 2 * P * R / (P + R) : 0);
+  char tempo[64] = "no music clips";
+  if(!t.tempoErr.empty())
+    snprintf(tempo, sizeof(tempo), "median err %.1f%%, %d/%d within %.0f%%",
+             median(t.tempoErr), t.tempoOk, t.tempoScored, TEMPO_TOLERANCE * 100);
+  printf("%-8s onsets %s | tempo %s | "
+         "audioDetected on music %.1f%%, on speech/noise %.1f%% | %.0fns per %u-sample block, %.0fus per second of audio\n",
+         who, onsets, tempo,
+         t.musicDecisions ? 100.0 * t.musicDetected / t.musicDecisions : 0.0,
+         t.otherDecisions ? 100.0 * t.otherDetected / t.otherDecisions : 0.0,
+         t.blocks ? t.ns / t.blocks : 0.0, BENCH_BLOCK, t.audioS > 0 ? t.ns / 1000 / t.audioS : 0.0);
+}
+
+// Arguments may be WAV files or directories of them
+static std::vector<std::string> collect(int argc, char** argv){
+  std::vector<std::string> files;
+  for(int i = 1; i < argc; i++) {
+    DIR* d = opendir(argv[i]);
+    if(!d) { files.push_back(argv[i]); continue; }
+    std::vector<std::string> found;
+    while(dirent* e = readdir(d)) {
+      std::string n = e->d_name;
+      if(n.size() > 4 && (n.compare(n.size() - 4, 4, ".wav") == 0 || n.compare(n.size() - 4, 4, ".WAV") == 0))
+        found.push_back(std::string(argv[i]) + "/" + n);
+    }
+    closedir(d);
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+  }
+  return files;
+}
+
+static int evaluate(int argc, char** argv){
+  Totals cur, full, old;
+  int clips = 0, scored = 0;
+  printf("%-8s %-24s %5s %6s %6s %6s %6s %6s %8s\n",
+         "", "file", "class", "P", "R", "F", "bpm", "music", "ns/blk");
+
+  for(const std::string& path : collect(argc, argv)) {
+    clips++;
+    Wav w;
+    if(!readWav(path.c_str(), w)) continue;
+    bool haveBeats, haveOnsets;
+    std::vector<double> beats = readLabels(sidecarPath(path, ".beats"), haveBeats);
+    std::vector<double> ref = readLabels(sidecarPath(path, ".txt"), haveOnsets);
+    if(!haveBeats) { fprintf(stderr, "%s: no beat file %s - skipped\n", path.c_str(), sidecarPath(path, ".beats").c_str()); continue; }
+    double refBpm = beats.size() >= 2 ? referenceBpm(beats) : NAN;
+    scored++;
+
+    const char* name = strrchr(path.c_str(), '/') ? strrchr(path.c_str(), '/') + 1 : path.c_str();
+    double audioS = (double)w.samples.size() / w.sampleRate;
+    Run a, f, b;
+    runCurrent(w, a, true);
+    runCurrent(w, f, false);
+    runLegacy(w, b);
+    report("current", name, a, haveOnsets, ref, refBpm, audioS, cur);
+    report("fullrate", name, f, haveOnsets, ref, refBpm, audioS, full);
+    report("legacy",  name, b, haveOnsets, ref, refBpm, audioS, old);
+    if(!std::isnan(refBpm)) printf("%-8s %-24s %5s %20s %6.1f\n", "ref", "", "", "", refBpm);
+  }
+
+  if(!scored) {
+    fprintf(stderr, clips ? "\nNo clip could be scored - every one needs a readable WAV and a .beats file\n"
+                          : "\nNo WAV files found\n");
+    return 1;
+  }
+  printf("\nOnsets within +-%.0fms; tempo and audioDetected from %.0fs in\n", ONSET_TOLERANCE_MS, BENCH_WARMUP_MS / 1000.0);
+  summary("current", cur);
+  summary("fullrate", full);
+  summary("legacy", old);
+  return 0;
+}
+
+// ── Synthetic labelled clips ─────────────────────────────────────────────────
+struct Synth {
+  std::vector<double> buf;
+  std::vector<double> onsets;
+  std::vector<double> beats;    // Empty: a clip with no beat
+  bool     labelOnsets = true;  // Write clip.txt (speech has no agreed onsets)
+  uint32_t sr;
+  uint32_t seed = 1;
+  double noise(){   // xorshift32 - an LCG's low bits repeat every few hops and fake a rhythm
+    seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+    return (seed / 4294967296.0) * 2 - 1;
+  }
+  double uniform(double lo, double hi){ return lo + (noise() + 1) / 2 * (hi - lo); }
+  void kick(double t, double amp){
+    size_t s0 = t * sr;
+    for(size_t i = 0; i < sr * 0.25 && s0 + i < buf.size(); i++) {
+      double x = (double)i / sr, f = 50 + 90 * exp(-x * 30);
+      buf[s0 + i] += amp * exp(-x * 12) * sin(2 * M_PI * f * x);
+    }
+    onsets.push_back(t);
+  }
+  void hat(double t, double amp){
+    size_t s0 = t * sr;
+    double hp = 0, prev = 0;
+    for(size_t i = 0; i < sr * 0.06 && s0 + i < buf.size(); i++) {
+      double n = noise();
+      hp = 0.9 * (hp + n - prev);   // Crude high-pass
+      prev = n;
+      buf[s0 + i] += amp * exp(-(double)i / sr * 60) * hp;
+    }
+    onsets.push_back(t);
+  }
+  void tone(double t0, double t1, double hz, double amp, bool label){
+    for(size_t i = t0 * sr; i < t1 * sr && i < buf.size(); i++) {
+      double x = (double)i / sr - t0, env = fmin(1.0, fmin(x / 0.005, (t1 - t0 - x) / 0.03));
+      buf[i] += amp * env * sin(2 * M_PI * hz * x);
+    }
+    if(label) onsets.push_back(t0);
+  }
+  // A voiced syllable: gliding pitch, harmonics shaped by two formants
+  void syllable(double t0, double len, double amp){
+    double f0 = uniform(100, 180), glide = uniform(-0.3, 0.2);
+    double f1 = uniform(300, 800), f2 = uniform(900, 2400), phase = 0;
+    for(size_t i = t0 * sr; i < (t0 + len) * sr && i < buf.size(); i++) {
+      double x = (double)i / sr - t0, env = sin(M_PI * x / len);
+      double f = f0 * (1 + glide * x / len);
+      phase += 2 * M_PI * f / sr;
+      double v = 0;
+      for(int h = 1; h * f < 4000; h++) {
+        double hf = h * f;
+        double g = exp(-pow((hf - f1) / 150, 2)) + 0.5 * exp(-pow((hf - f2) / 250, 2)) + 0.02;
+        v += g * sin(h * phase);
+      }
+      buf[i] += amp * env * v / 4;
+    }
+  }
+  void hiss(double amp){ for(double& v : buf) v += amp * noise(); }
+  bool writeTimes(const std::string& path, const char* what, const std::vector<double>& t){
+    FILE* f = fopen(path.c_str(), "w");
+    if(!f) return false;
+    fprintf(f, "# %s times (s)\n", what);
+    for(double v : t) fprintf(f, "%.4f\n", v);
+    fclose(f);
+    return true;
+  }
+  bool write(const std::string& dir, const char* name){
+    std::vector<int16_t> s(buf.size());
+    for(size_t i = 0; i < buf.size(); i++) s[i] = (int16_t)fmax(-32768, fmin(32767, buf[i] * 32767));
+    std::string base = dir + "/" + name;
+    if(!writeWav(base + ".wav", s, sr)) return false;
+    // Events closer than the scoring tolerance are one onset to a listener
+    std::sort(onsets.begin(), onsets.end());
+    std::vector<double> merged;
+    for(double t : onsets) if(merged.empty() || t - merged.back() > ONSET_TOLERANCE_MS / 1000.0) merged.push_back(t);
+    onsets = merged;
+    if(labelOnsets && !writeTimes(base + ".txt", "onset", onsets)) return false;
+    if(!writeTimes(base + ".beats", "beat", beats)) return false;
+    printf("  %s.wav (%zu onsets, %zu beats)\n", base.c_str(), labelOnsets ? onsets.size() : 0, beats.size());
+    return true;
+  }
+};
+
+static int synth(const char* dir){
+  if(mkdir(dir, 0755) != 0 && errno != EEXIST) { perror(dir); return 1; }
+  printf("Writing synthetic clips to %s/:\n", dir);
+  bool ok = true;
+  {
+    // Four-on-the-floor at 124 BPM with off-beat hats over a pad and hiss
+    Synth s; s.sr = FIRMWARE_SR; s.buf.assign(s.sr * 20, 0);
+    double beat = 60.0 / 124;
+    for(double t = 0.5; t < 19.5; t += beat) { s.kick(t, 0.6); s.hat(t + beat / 2, 0.15); s.beats.push_back(t); }
+    s.tone(0.5, 19.5, 220, 0.05, true);
+    s.hiss(0.01);
+    ok &= s.write(dir, "dance_124");
+  }
+  {
+    // Loud and steady - a held chord with heavy noise, nothing should fire after the attack
+    Synth s; s.sr = FIRMWARE_SR; s.buf.assign(s.sr * 15, 0);
+    s.tone(0.3, 15, 110, 0.25, true);
+    s.tone(0.3, 15, 165, 0.2, false);
+    s.tone(0.3, 15, 277, 0.15, false);
+    s.hiss(0.2);
+    ok &= s.write(dir, "loud_steady");
+  }
+  {
+    // Quiet sparse melody at 90 BPM, notes at varying velocity
+    Synth s; s.sr = FIRMWARE_SR; s.buf.assign(s.sr * 20, 0);
+    const double notes[] = {262, 330, 392, 523, 440, 349};
+    double beat = 60.0 / 90;
+    int k = 0;
+    for(double t = 0.5; t < 19; t += beat, k++) {
+      s.tone(t, t + beat * 0.8, notes[k % 6], 0.02 + 0.03 * (k % 3), true);
+      s.beats.push_back(t);
+    }
+    s.hiss(0.003);
+    ok &= s.write(dir, "melody_90");
+  }
+  {
+    // Someone talking near the node: 3-6 syllables a second in phrases with pauses
+    Synth s; s.sr = FIRMWARE_SR; s.buf.assign(s.sr * 20, 0); s.seed = 7;
+    s.labelOnsets = false;
+    for(double t = 0.3; t < 19.5; ) {
+      int words = 4 + (int)s.uniform(0, 8);
+      for(int i = 0; i < words && t < 19.5; i++) {
+        double len = s.uniform(0.08, 0.25);
+        s.syllable(t, len, s.uniform(0.1, 0.4));
+        t += len + s.uniform(0.02, 0.12);
+      }
+      t += s.uniform(0.3, 0.9);
+    }
+    s.hiss(0.005);
+    ok &= s.write(dir, "speech");
+  }
+  {
+    // Crowd/fan noise - low-passed, slowly swelling and fading, no onsets at all
+    Synth s; s.sr = FIRMWARE_SR; s.buf.assign(s.sr * 20, 0); s.seed = 11;
+    double lp = 0, gain = 0.3, target = 0.3;
+    for(size_t i = 0; i < s.buf.size(); i++) {
+      if(i % (s.sr / 2) == 0) target = s.uniform(0.15, 0.6);
+      gain += (target - gain) * 2.0 / s.sr;
+      lp += 0.15 * (s.noise() - lp);
+      s.buf[i] = gain * lp * 2;
+    }
+    ok &= s.write(dir, "crowd_noise");
+  }
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+  if(argc >= 3 && !strcmp(argv[1], "--synth")) return synth(argv[2]);
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s corpus/ | clip.wav [...] | --synth dir\n", argv[0]);
+    return 1;
+  }
+  return evaluate(argc, argv);
+}
@@ -0,0 +1,145 @@
+#ifndef LEGACY_AUDIO_H
+#define LEGACY_AUDIO_H
+
+// ── Legacy Detector (reference) ──────────────────────────────────────────────
+// The amplitude-threshold detector the firmware used before onset.h and
+// tempo.h replaced it: detectAudioFrame() and updateBPM() below are copied
+// verbatim from that audio.cpp, with just enough Arduino/M5 shimmed around
+// them to run on a simulated clock. tools/audio_eval.cpp drives them exactly
+// as the leader did - one 240-sample record per FRAME_DELAY_MS frame,
+// updateBPM() every pass - so old and new are scored on the same corpus.
+// Host-only; not part of the sketch.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+
+namespace legacy {
+
+using std::min;
+using std::max;
+template<typename T> static T constrain(T v, T lo, T hi){ return v < lo ? lo : (v > hi ? hi : v); }
+
+// config.h of the day
+static constexpr size_t   MIC_BUF_LEN    = 240;
+static constexpr float    SMOOTH         = 0.995f;
+static constexpr uint32_t BPM_WINDOW     = 5000;
+static constexpr uint32_t FRAME_DELAY_MS = 20;
+#define LEGACY_DEBUG_BPM 0
+
+// Globals of the day (initial values from the .ino)
+static float    soundMin = 1.0f, soundMax = 0.0f, musicLevel = 0.0f;
+static bool     prevAbove = false;
+static uint32_t beatTimes[50];
+static uint8_t  beatCount = 0;
+static uint32_t lastBpmMillis = 0;
+static bool     audioDetected = true;
+
+// Host clock and mic: record() hands back the MIC_BUF_LEN samples ending now
+static uint32_t nowMs = 0;
+static uint32_t millis(){ return nowMs; }
+static struct {
+  struct {
+    const int16_t* src = nullptr;
+    size_t pos = 0, len = 0;
+    bool record(int16_t* buf, size_t n){
+      if(pos < n || pos > len) return false;
+      memcpy(buf, src + pos - n, n * sizeof(int16_t));
+      return true;
+    }
+  } Mic;
+} M5;
+static struct { template<typename... A> void printf(const char* f, A... a){ ::printf(f, a...); } } Serial;
+
+static void reset(){
+  soundMin = 1.0f; soundMax = 0.0f; musicLevel = 0.0f;
+  prevAbove = false;
+  beatCount = 0;
+  lastBpmMillis = nowMs = 0;
+  audioDetected = true;
+}
+
+#define DEBUG_BPM LEGACY_DEBUG_BPM
+// ---- verbatim from audio.cpp (before the spectral analyser) ----
+void detectAudioFrame(){
+  static int16_t micBuf[MIC_BUF_LEN];
+  if(!M5.Mic.record(micBuf, MIC_BUF_LEN)) return;
+  
+  long sum = 0; 
+  for(auto &v : micBuf) sum += abs(v);
+  float raw = float(sum) / MIC_BUF_LEN / 32767.0f;
+  
+  soundMin = min(raw, SMOOTH * soundMin + (1 - SMOOTH) * raw);
+  soundMax = max(raw, SMOOTH * soundMax + (1 - SMOOTH) * raw);
+  
+  // Adaptive sensitivity for high volume environments
+  float dynamicRange = soundMax - soundMin;
+  const float MIN_DYNAMIC_RANGE = 0.08f;  // Minimum range for reliable beat detection
+  const float HIGH_VOLUME_THRESHOLD = 0.7f;  // When average level indicates high volume environment
+  
+  float adaptedMin = soundMin;
+  float adaptedMax = soundMax;
+  float beatThreshold = 0.6f;  // Default threshold
+  
+  // Detect high volume saturation scenario
+  bool highVolumeEnvironment = (soundMin > HIGH_VOLUME_THRESHOLD) || (dynamicRange < MIN_DYNAMIC_RANGE);
+  
+  if(highVolumeEnvironment) {
+    // In high volume environments, expand the dynamic range artificially
+    if(dynamicRange < MIN_DYNAMIC_RANGE) {
+      float expansion = (MIN_DYNAMIC_RANGE - dynamicRange) * 0.5f;
+      adaptedMin = max(0.0f, soundMin - expansion);
+      adaptedMax = min(1.0f, soundMax + expansion);
+    }
+    
+    // Lower beat detection threshold in high volume environments
+    beatThreshold = 0.35f;
+    
+    if(DEBUG_BPM && millis() % 2000 < 50) {
+      Serial.printf("HIGH-VOL: range=%.3f->%.3f, thresh=%.2f, raw=%.3f\n", 
+        dynamicRange, adaptedMax - adaptedMin, beatThreshold, raw);
+    }
+  }
+  
+  musicLevel = constrain((raw - adaptedMin) / (adaptedMax - adaptedMin + 1e-6f), 0.0f, 1.0f);
+  
+  bool above = (musicLevel > beatThreshold);
+  if(above && !prevAbove){
+    uint32_t t = millis();
+    if(beatCount < 50) {
+      beatTimes[beatCount++] = t;
+    } else { 
+      memmove(beatTimes, beatTimes + 1, 49 * sizeof(uint32_t)); 
+      beatTimes[49] = t; 
+    }
+  }
+  prevAbove = above;
+}
+
+void updateBPM(){
+  uint32_t now = millis();
+  if(now - lastBpmMillis >= BPM_WINDOW){
+    int cnt = 0; 
+    uint32_t cutoff = now - BPM_WINDOW;
+    for(int i = 0; i < beatCount; i++) {
+      if(beatTimes[i] >= cutoff) cnt++;
+    }
+    
+    float bpm = cnt * (60000.0f / float(BPM_WINDOW));
+    audioDetected = (cnt >= 4 && bpm >= 30.0f && bpm <= 300.0f);
+    lastBpmMillis += BPM_WINDOW; 
+    beatCount = 0;
+    
+    if(DEBUG_BPM) {
+      Serial.printf("BPM: %d→%.1f [%s]\n", cnt, bpm, audioDetected ? "Music" : "Bg");
+    }
+  }
+}
+// ---- end verbatim ----
+#undef DEBUG_BPM
+
+}  // namespace legacy
+
+#endif
@@ -0,0 +1,143 @@
+// ── Mixed-Fleet Protocol Simulator ───────────────────────────────────────────
+// Host-side check of the v1/v2 fallback: a v2 leader, a v2 follower and, in
+// some runs, a v1-only follower share the air for ten minutes. Every packet is
+// built and parsed with protocol.cpp, and every v2 node runs the legacy latch
+// from networking.cpp (protoFromLegacyPeer -> speak v1 until reboot). The v1
+// follower does what the old firmware does: it only decodes v1 RAW frames,
+// stays silent while they arrive, and bids (a v1 TOKEN) at boot and whenever
+// no frame has come for LEADER_TIMEOUT_MS - each of those after boot is a
+// fleet-wide glitch (re-election, dark strip).
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o legacy_sim tools/legacy_sim.cpp protocol.cpp
+// Run:
+//   ./legacy_sim          v2 only, v2 with v1-capable marks, a silent v1 follower
+
+#include "../protocol.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+static const uint32_t RUN_MS            = 600000;
+static const uint32_t FRAME_MS          = 40;       // 25fps on the air
+static const uint32_t REPORT_MS         = 1000;     // v2 follower receive report
+static const uint32_t LEADER_TIMEOUT_MS = 1500;     // config.h LEADER_TIMEOUT
+static const uint8_t  V1_RAW            = 0x00;     // config.h MSGTYPE_RAW
+static const uint8_t  V1_TOKEN          = 0x01;     // config.h MSGTYPE_TOKEN
+static const int      NUM_LEDS          = 150;
+
+// A v2 node's wire state, as networking.cpp keeps it
+struct V2Node {
+  uint32_t token;
+  bool     legacyPeerHeard;
+  uint32_t v1Sent, v2Sent;
+};
+
+static bool speakV1(const V2Node& n){ return n.legacyPeerHeard; }
+
+static void hear(V2Node& n, const std::vector<uint8_t>& pkt){
+  PacketInfo info;
+  if(protoParse(pkt.data(), (int)pkt.size(), info) != PARSE_OK) return;
+  if(!n.legacyPeerHeard && protoFromLegacyPeer(info, n.token)) n.legacyPeerHeard = true;
+}
+
+// One pixel chunk from the leader, framed the way sendRaw() frames it
+static std::vector<uint8_t> leaderChunk(V2Node& n, uint16_t frameId, uint32_t nowMs){
+  static const uint8_t rgb[NUM_LEDS * 3] = {};
+  std::vector<uint8_t> buf(PROTO_MAX_PACKET);
+  if(speakV1(n)) {
+    uint32_t seq = frameId;
+    buf[0] = V1_RAW;
+    memcpy(&buf[1], &seq, 4);
+    memcpy(&buf[5], &n.token, 4);
+    buf[9] = 0;
+    memcpy(&buf[PROTO_V1_HEADER_LEN], rgb, PROTO_V1_LEDS_PER_CHUNK * 3);
+    buf[PROTO_V1_HEADER_LEN + PROTO_V1_LEDS_PER_CHUNK * 3] = PROTO_V2_CAPABLE_MARK;
+    buf.resize(PROTO_V1_HEADER_LEN + PROTO_V1_LEDS_PER_CHUNK * 3 + 1);
+    n.v1Sent++;
+  } else {
+    int len = protoBuildV2(buf.data(), PKT_PIXELS, PROTO_FLAG_LEADER, n.token, frameId, 0, 1,
+                           nowMs * 1000, 0, rgb, PROTO_V1_LEDS_PER_CHUNK * 3);
+    buf.resize(len);
+    n.v2Sent++;
+  }
+  return buf;
+}
+
+static std::vector<uint8_t> v1Token(uint32_t token, bool v2Mark){
+  std::vector<uint8_t> buf(10, 0);
+  buf[0] = V1_TOKEN;
+  memcpy(&buf[1], &token, 4);
+  if(v2Mark) buf[9] = PROTO_V2_CAPABLE_MARK;
+  else buf.resize(9);
+  return buf;
+}
+
+struct Scenario {
+  const char* name;
+  bool        v1Follower;      // A v1-only follower bids at boot, then only listens
+  bool        markedBid;       // The v2 follower bids once in v1 with the v2-capable mark
+  bool        expectV1;        // The leader should end up speaking v1
+};
+
+static bool run(const Scenario& sc){
+  V2Node leader = {0x300000, false, 0, 0}, follower = {0x200000, false, 0, 0};
+  uint32_t v1LastFrame = 0, v1Bids = 0, v1Frames = 0, longestGap = 0;
+  uint16_t frameId = 0;
+
+  // Boot: the election - whoever is there bids once
+  if(sc.v1Follower) {
+    std::vector<uint8_t> bid = v1Token(0x100000, false);
+    hear(leader, bid);
+    hear(follower, bid);
+    v1Bids++;
+  }
+  if(sc.markedBid) hear(leader, v1Token(follower.token, true));
+
+  for(uint32_t nowMs = 0; nowMs < RUN_MS; nowMs++) {
+    if(nowMs % FRAME_MS == 0) {
+      std::vector<uint8_t> chunk = leaderChunk(leader, frameId++, nowMs);
+      hear(follower, chunk);
+      PacketInfo info;
+      if(sc.v1Follower && chunk[0] == V1_RAW && protoParse(chunk.data(), (int)chunk.size(), info) == PARSE_OK) {
+        if(v1Frames) longestGap = std::max(longestGap, nowMs - v1LastFrame);
+        v1LastFrame = nowMs;
+        v1Frames++;
+      }
+    }
+    // The v2 follower reports in v2 only - it says nothing while speaking v1
+    if(nowMs % REPORT_MS == 0 && !speakV1(follower)) {
+      uint8_t buf[PROTO_HEADER_LEN];
+      int len = protoBuildV2(buf, PKT_REPORT, 0, follower.token, 0, 0, 0, nowMs * 1000, 0, nullptr, 0);
+      hear(leader, std::vector<uint8_t>(buf, buf + len));
+    }
+    // The v1 follower goes dark and bids when frames stop
+    if(sc.v1Follower && nowMs - v1LastFrame > LEADER_TIMEOUT_MS) {
+      std::vector<uint8_t> bid = v1Token(0x100000, false);
+      hear(leader, bid);
+      hear(follower, bid);
+      v1Bids++;
+      v1LastFrame = nowMs;
+    }
+  }
+
+  bool ok = speakV1(leader) == sc.expectV1 && (sc.expectV1 ? leader.v2Sent == 0 : leader.v1Sent == 0)
+         && (!sc.v1Follower || (v1Bids == 1 && longestGap <= FRAME_MS));
+  printf("%-26s %8u %8u %8u %9u  %s\n", sc.name, leader.v1Sent, leader.v2Sent, v1Bids, longestGap,
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+int main(){
+  const Scenario scenarios[] = {
+    {"v2 only",                    false, false, false},
+    {"v2, v1 bid with v2 mark",    false, true,  false},
+    {"silent v1 follower",         true,  false, true},
+  };
+  bool ok = true;
+  printf("%-26s %8s %8s %8s %9s  %s\n", "scenario", "v1 sent", "v2 sent", "v1 bids", "v1 gap ms", "check");
+  for(const Scenario& sc : scenarios) ok &= run(sc);
+  printf("\nMixed fleet %s over %us\n", ok ? "ok" : "FAILED", RUN_MS / 1000);
+  return ok ? 0 : 1;
+}
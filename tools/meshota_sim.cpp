@@ -0,0 +1,235 @@
+// ── Mesh OTA Simulator ───────────────────────────────────────────────────────
+// Host-side simulation of firmware distribution over ESP-NOW, running the exact
+// seed / receiver state machines from meshota.cpp and verifying every image
+// with sha256.cpp. One seed broadcasts a random image to N receivers; each
+// receiver keeps the image in RAM the way the firmware keeps it in its
+// inactive OTA partition.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o meshota_sim tools/meshota_sim.cpp meshota.cpp sha256.cpp
+// Run:
+//   ./meshota_sim                       12 nodes, 1.25MB image, per-node breakdown
+//   ./meshota_sim 25 [seed] [imageKB]   other fleet sizes / images
+//   ./meshota_sim sweep                 fleet size x loss sweep
+//
+// Radio model: 1ms steps. Every receiver has its own independent loss, with
+// Gilbert-Elliott bursts on top (one every ~2s, 80ms long on average, 90% loss
+// while they last). Status packets back to the seed see the same loss.
+// Receivers are deaf while erasing their partition (~150ms per 64KB) and while
+// hashing the finished image. One receiver powers up late, mid-transfer, and
+// one has a flaky flash write that the firmware's read-back catches; whatever
+// a node finally commits is compared byte for byte with the seed's image.
+//
+// The serial column is a rough reference for deploy_nodes.sh: one WiFi
+// ArduinoOTA upload after another at WIFI_OTA_KBPS plus a fixed per-node
+// connect / reboot overhead, ignoring retries.
+
+#include "../meshota.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const double   WIFI_OTA_KBPS      = 45.0;     // Typical ArduinoOTA throughput to a StickC
+static const double   WIFI_NODE_OVERHEAD = 12.0;     // s - resolve, connect, auth, reboot per node
+static const uint32_t ERASE_MS_PER_64K   = 150;      // Block erase, typical for the StickC flash
+static const uint32_t HASH_MS_PER_64K    = 8;        // Read back + SHA-256 on the ESP32
+static const uint32_t MAX_SIM_MS         = 600000;
+
+static uint32_t rng = 1;
+static uint32_t nextRand(){ rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; }
+static double   uniform(){ return (nextRand() & 0xFFFFFF) / double(0x1000000); }
+
+struct Node {
+  OtaReceiver rx;
+  std::vector<uint8_t> image;    // Stands in for the inactive partition
+  double   loss;                 // Base loss rate
+  bool     burst;                // In a loss burst
+  uint32_t joinMs;               // Powered up
+  uint32_t busyUntil;            // Erasing / hashing - deaf
+  bool     flakyWrite;           // A few writes don't read back correctly
+  uint8_t  badWrites;
+  uint32_t committedMs;
+  uint32_t chunksWritten;
+};
+
+// Bursts come and go with time, not with traffic
+static void stepChannel(Node& n){
+  if(n.burst) { if(uniform() < 1.0 / 80) n.burst = false; }
+  else if(uniform() < 1.0 / 2000) n.burst = true;
+}
+
+static bool delivered(Node& n){
+  return uniform() >= (n.burst ? 0.9 : n.loss);
+}
+
+struct Result {
+  uint32_t doneMs;               // Seed finished (commit sent)
+  uint32_t lastCommitMs;
+  int      verified, failed, stuck;
+  uint32_t offers, data, repairs, status;
+};
+
+static Result simulate(int n, double meanLoss, uint32_t imageBytes, uint32_t seed, bool verbose){
+  rng = seed * 2654435761u + 1;
+  std::vector<uint8_t> image(imageBytes);
+  for(uint8_t& b : image) b = nextRand();
+  uint8_t sha[SHA256_LEN];
+  sha256(image.data(), image.size(), sha);
+
+  OtaOffer offer;
+  otaOfferInit(offer, 0x5EED0000 | (seed & 0xFFFF), imageBytes, "v1.1.46", sha);
+  OtaSender seedTx;
+  otaTxStart(seedTx, offer, 0);
+
+  std::vector<Node> nodes(n);
+  for(int i = 0; i < n; i++) {
+    Node& nd = nodes[i];
+    otaRxInit(nd.rx, 0x100000 + i * 7919);
+    nd.image.assign(imageBytes, 0xFF);
+    nd.loss = meanLoss * (0.25 + 1.5 * uniform());
+    nd.burst = false;
+    nd.joinMs = 0;
+    nd.busyUntil = 0;
+    nd.flakyWrite = false;
+    nd.badWrites = 0;
+    nd.committedMs = 0;
+    nd.chunksWritten = 0;
+  }
+  if(n > 2) nodes[n - 1].joinMs = OTA_ANNOUNCE_MS + offer.chunkCount * OTA_TX_INTERVAL_MS / 2;   // Power-cycled mid-pass
+  if(n > 3) nodes[n - 2].flakyWrite = true;
+
+  Result res = {};
+  uint32_t eraseMs = (imageBytes / 65536 + 1) * ERASE_MS_PER_64K;
+  uint32_t hashMs  = (imageBytes / 65536 + 1) * HASH_MS_PER_64K;
+
+  for(uint32_t now = 0; now < MAX_SIM_MS; now++) {
+    // Seed
+    if(now % OTA_TX_INTERVAL_MS == 0 && seedTx.active) {
+      uint16_t idx = 0;
+      OtaTxKind kind = otaTxNext(seedTx, now, &idx);
+      if(kind == OTA_TX_DONE) { res.doneMs = now; }
+      for(Node& nd : nodes) {
+        if(kind == OTA_TX_NONE || kind == OTA_TX_DONE) break;
+        if(now < nd.joinMs || now < nd.busyUntil || nd.committedMs || !delivered(nd)) continue;
+        if(kind == OTA_TX_OFFER) {
+          if(otaRxOffer(nd.rx, offer, 3 << 20, "v1.1.45", now) == OTA_OFFER_START) nd.busyUntil = now + eraseMs;
+        } else if(kind == OTA_TX_DATA) {
+          uint16_t len = otaChunkLen(offer, idx);
+          if(otaRxChunk(nd.rx, offer.session, idx, len, now)) {
+            uint32_t off = otaChunkOffset(offer, idx);
+            memcpy(nd.image.data() + off, image.data() + off, len);
+            nd.chunksWritten++;
+            if(nd.flakyWrite && nd.badWrites < 3 && uniform() < 0.001) {
+              // Read-back after the write catches it - the chunk is simply requested again
+              nd.image[off] ^= 0x40;
+              nd.badWrites++;
+              otaRxChunkBad(nd.rx, idx);
+            }
+          }
+        } else if(kind == OTA_TX_COMMIT) {
+          if(otaRxCommit(nd.rx, offer.session, now)) nd.committedMs = now;
+        }
+      }
+    }
+
+    // Receivers
+    for(Node& nd : nodes) {
+      stepChannel(nd);
+      if(now < nd.joinMs || now < nd.busyUntil || nd.committedMs) continue;
+      if(otaRxComplete(nd.rx)) {
+        // Last status before going quiet to hash, as the firmware does
+        OtaStatus st;
+        otaRxStatusFill(nd.rx, st);
+        if(delivered(nd)) otaTxNoteStatus(seedTx, nd.rx.token, st, now);
+        uint8_t got[SHA256_LEN];
+        sha256(nd.image.data(), nd.image.size(), got);
+        nd.busyUntil = now + hashMs;
+        if(!otaRxVerify(nd.rx, got, now + hashMs) && nd.rx.state == OTA_RX_RECEIVING) {
+          std::fill(nd.image.begin(), nd.image.end(), 0xFF);
+          nd.busyUntil += eraseMs;
+        }
+        continue;
+      }
+      if(otaRxShouldSelfCommit(nd.rx, now)) { nd.committedMs = now; continue; }
+      OtaStatus st;
+      if(otaRxStatusDue(nd.rx, st, now) && delivered(nd)) {
+        uint8_t buf[OTA_STATUS_LEN];
+        otaStatusEncode(st, buf);
+        OtaStatus back;
+        otaStatusDecode(buf, sizeof(buf), back);
+        otaTxNoteStatus(seedTx, nd.rx.token, back, now);
+      }
+    }
+
+    bool allSettled = !seedTx.active;
+    for(Node& nd : nodes) if(!nd.committedMs && nd.rx.state != OTA_RX_FAILED) allSettled = false;
+    if(allSettled) break;
+  }
+
+  for(Node& nd : nodes) {
+    if(nd.committedMs) {
+      // What the node would boot - must match the seed's image exactly
+      if(memcmp(nd.image.data(), image.data(), imageBytes) == 0) res.verified++;
+      else res.failed++;
+      if(nd.committedMs > res.lastCommitMs) res.lastCommitMs = nd.committedMs;
+    } else if(nd.rx.state == OTA_RX_FAILED) res.failed++;
+    else res.stuck++;
+  }
+  res.offers = seedTx.offersSent;
+  res.data = seedTx.dataSent;
+  res.repairs = seedTx.repairsSent;
+  res.status = seedTx.statusHeard;
+
+  if(verbose) {
+    printf("%-8s %6s %6s %9s %8s %8s  %s\n", "node", "loss", "join s", "written", "attempts", "commit s", "state");
+    for(int i = 0; i < n; i++) {
+      const Node& nd = nodes[i];
+      static const char* STATES[] = {"idle", "receiving", "verified", "failed", "current"};
+      printf("%06X %7.1f%% %6.1f %9u %8u %8.1f  %s%s\n", nd.rx.token, nd.loss * 100, nd.joinMs / 1000.0,
+             nd.chunksWritten, nd.rx.attempts, nd.committedMs / 1000.0, STATES[nd.rx.state],
+             nd.badWrites ? " (bad writes re-fetched)" : "");
+    }
+    printf("\n");
+  }
+  return res;
+}
+
+static void printHeader(){
+  printf("%5s %6s %8s  %9s %8s %8s %6s  %8s %9s  %s\n",
+         "nodes", "loss", "image", "mesh s", "data", "repairs", "status", "ok/fail", "serial s", "speedup");
+}
+
+static void printRow(int n, double loss, uint32_t imageBytes, const Result& r){
+  double serial = n * (imageBytes / 1024.0 / WIFI_OTA_KBPS + WIFI_NODE_OVERHEAD);
+  double mesh = r.lastCommitMs / 1000.0;
+  printf("%5d %5.1f%% %7uK  %9.1f %8u %8u %6u  %3d/%-4d %9.0f  %5.1fx%s\n",
+         n, loss * 100, imageBytes / 1024, mesh, r.data, r.repairs, r.status,
+         r.verified, r.failed, serial, mesh > 0 ? serial / mesh : 0.0, r.stuck ? "  STUCK" : "");
+}
+
+int main(int argc, char** argv){
+  uint32_t imageBytes = 1280 * 1024;
+
+  if(argc >= 2 && !strcmp(argv[1], "sweep")) {
+    printHeader();
+    const int    sizes[]  = {6, 12, 25, 32};
+    const double losses[] = {0.02, 0.10, 0.25};
+    for(double loss : losses)
+      for(int n : sizes)
+        printRow(n, loss, imageBytes, simulate(n, loss, imageBytes, 1, false));
+    return 0;
+  }
+
+  int n = argc > 1 ? atoi(argv[1]) : 12;
+  uint32_t seed = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1;
+  if(argc > 3) imageBytes = atoi(argv[3]) * 1024;
+  if(n < 1 || n > OTA_MAX_RECEIVERS || imageBytes > (uint32_t)OTA_MAX_CHUNKS * OTA_CHUNK_BYTES) {
+    fprintf(stderr, "1..%d nodes, image up to %uKB\n", OTA_MAX_RECEIVERS, OTA_MAX_CHUNKS * OTA_CHUNK_BYTES / 1024);
+    return 1;
+  }
+  Result r = simulate(n, 0.08, imageBytes, seed, true);
+  printHeader();
+  printRow(n, 0.08, imageBytes, r);
+  return r.failed || r.stuck ? 2 : 0;
+}
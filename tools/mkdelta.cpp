@@ -0,0 +1,323 @@
+// ── Firmware Delta Tool ──────────────────────────────────────────────────────
+// Writes a delta.h patch that turns the firmware image a node runs into a new
+// build, then applies it with the firmware's own streaming decoder (fed in
+// odd-sized pieces, through the same 512-byte buffers) to prove it rebuilds
+// the new image exactly before anything is uploaded.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o mkdelta tools/mkdelta.cpp delta.cpp sha256.cpp
+// Run:
+//   ./mkdelta old.bin new.bin patch.pld   old.bin = the build the node reports
+//   ./mkdelta --selftest                  synthetic image with a typical edit
+//
+// deploy_nodes.sh keeps every build in builds/<version>.bin and, with
+// DELTA=1, runs this against the version each node advertises over mDNS.
+// Upload the patch as a filesystem image (espota.py -s); the node applies it
+// from its data partition (ota.cpp) and can seed it to the mesh.
+//
+// Matching: every 8-byte window of the old image is indexed. A match is
+// extended past mismatches while matches keep paying for them, so code that
+// only moved - whose embedded addresses changed by a few bytes - becomes one
+// COPY with a sparse diff instead of fresh literals.
+
+#include "../delta.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+typedef std::vector<uint8_t> Bytes;
+
+static const int      HASH_BITS     = 20;
+static const uint32_t WINDOW        = 8;      // Indexed window
+static const uint32_t MIN_MATCH     = 12;     // Exact bytes needed to open a COPY
+static const int      MAX_CHAIN     = 48;     // Candidates tried per position
+static const int      MATCH_SCORE   = 1;      // Extension scoring: a matching byte saves one
+static const int      MISS_SCORE    = 3;      // A diff byte costs about as much as a literal plus group overhead
+static const int      XDROP         = 24;     // Stop extending this far below the best score
+static const uint32_t SHORT_RUN     = 3;      // Equal runs shorter than this stay inside a diff group
+
+static const double   WIFI_OTA_KBPS = 45.0;   // As tools/meshota_sim.cpp
+
+static bool readFile(const char* path, Bytes& b){
+  FILE* f = fopen(path, "rb");
+  if(!f) return false;
+  fseek(f, 0, SEEK_END);
+  long n = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  b.resize(n);
+  bool ok = fread(b.data(), 1, n, f) == (size_t)n;
+  fclose(f);
+  return ok;
+}
+
+static void putVarint(Bytes& out, uint32_t v){
+  while(v >= 0x80) { out.push_back(v | 0x80); v >>= 7; }
+  out.push_back(v);
+}
+
+static void putSigned(Bytes& out, int32_t v){
+  putVarint(out, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+// ── Encoder ──
+
+struct Encoder {
+  const Bytes& o;
+  const Bytes& n;
+  std::vector<int32_t> head, prev;
+  Bytes    out;
+  uint32_t oldCursor = 0;
+  uint32_t copies = 0, inserts = 0, copied = 0, diffBytes = 0, literal = 0;
+
+  Encoder(const Bytes& oldImg, const Bytes& newImg) : o(oldImg), n(newImg) {
+    head.assign(1 << HASH_BITS, -1);
+    prev.assign(o.size(), -1);
+    for(uint32_t i = 0; i + WINDOW <= o.size(); i++) {
+      uint32_t h = hash(&o[i]);
+      prev[i] = head[h];
+      head[h] = i;
+    }
+  }
+
+  static uint32_t hash(const uint8_t* p){
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return (uint32_t)((v * 0x9E3779B97F4A7C15ull) >> (64 - HASH_BITS));
+  }
+
+  uint32_t exactLen(uint32_t oi, uint32_t ni) const {
+    uint32_t k = 0;
+    while(oi + k < o.size() && ni + k < n.size() && o[oi + k] == n[ni + k]) k++;
+    return k;
+  }
+
+  // X-drop extension forward (dir = 1) or backward (dir = -1) from the pair
+  // (oi, ni), at most limit bytes. Returns the length with the best score.
+  uint32_t extend(uint32_t oi, uint32_t ni, int dir, uint32_t limit) const {
+    int score = 0, best = 0;
+    uint32_t bestLen = 0;
+    for(uint32_t k = 0; k < limit; k++) {
+      int64_t a = (int64_t)oi + dir * (int64_t)k, b = (int64_t)ni + dir * (int64_t)k;
+      if(a < 0 || b < 0 || a >= (int64_t)o.size() || b >= (int64_t)n.size()) break;
+      score += o[a] == n[b] ? MATCH_SCORE : -MISS_SCORE;
+      if(score > best) { best = score; bestLen = k + 1; }
+      else if(score < best - XDROP) break;
+    }
+    return bestLen;
+  }
+
+  void emitInsert(uint32_t from, uint32_t to){
+    if(to <= from) return;
+    out.push_back(DELTA_OP_INSERT);
+    putVarint(out, to - from);
+    out.insert(out.end(), n.begin() + from, n.begin() + to);
+    inserts++;
+    literal += to - from;
+  }
+
+  void emitCopy(uint32_t os, uint32_t ns, uint32_t len){
+    out.push_back(DELTA_OP_COPY);
+    putSigned(out, (int32_t)(os - oldCursor));
+    putVarint(out, len);
+    uint32_t i = 0;
+    while(i < len) {
+      uint32_t skip = 0;
+      while(i + skip < len && o[os + i + skip] == n[ns + i + skip]) skip++;
+      uint32_t j = i + skip, k = j;
+      while(k < len) {
+        if(o[os + k] != n[ns + k]) { k++; continue; }
+        uint32_t r = 0;
+        while(k + r < len && o[os + k + r] == n[ns + k + r]) r++;
+        if(r >= SHORT_RUN || k + r == len) break;
+        k += r;
+      }
+      putVarint(out, skip);
+      putVarint(out, k - j);
+      for(uint32_t m = j; m < k; m++) out.push_back(n[ns + m] - o[os + m]);
+      diffBytes += k - j;
+      i = k;
+    }
+    oldCursor = os + len;
+    copies++;
+    copied += len;
+  }
+
+  void run(){
+    uint32_t p = 0, litStart = 0;
+    while(p < n.size()) {
+      uint32_t bestO = 0, bestL = 0;
+      // Carrying on where the last COPY left off - same length edit, or pure insert
+      uint32_t cands[2] = {oldCursor + (p - litStart), oldCursor};
+      for(uint32_t c : cands) {
+        if(c >= o.size()) continue;
+        uint32_t l = exactLen(c, p);
+        if(l > bestL) { bestL = l; bestO = c; }
+      }
+      if(p + WINDOW <= n.size()) {
+        int tries = 0;
+        for(int32_t c = head[hash(&n[p])]; c >= 0 && tries < MAX_CHAIN; c = prev[c], tries++) {
+          uint32_t l = exactLen(c, p);
+          if(l > bestL) { bestL = l; bestO = c; }
+        }
+      }
+      if(bestL < MIN_MATCH) { p++; continue; }
+
+      uint32_t back = extend(bestO - 1, p - 1, -1, p - litStart < bestO ? p - litStart : bestO);
+      if(p == 0 || bestO == 0) back = 0;
+      uint32_t fwd = extend(bestO, p, 1, (uint32_t)n.size() - p);
+      if(fwd < bestL) fwd = bestL;
+      emitInsert(litStart, p - back);
+      emitCopy(bestO - back, p - back, back + fwd);
+      p += fwd;
+      litStart = p;
+    }
+    emitInsert(litStart, n.size());
+    out.push_back(DELTA_OP_END);
+  }
+};
+
+static Bytes makePatch(const Bytes& oldImg, const Bytes& newImg, Encoder** stats){
+  Encoder* e = new Encoder(oldImg, newImg);
+  e->out.resize(DELTA_HEADER_LEN);
+  e->run();
+  DeltaHeader h;
+  h.patchSize = e->out.size();
+  h.oldSize = oldImg.size();
+  h.newSize = newImg.size();
+  sha256(oldImg.data(), oldImg.size(), h.oldSha);
+  sha256(newImg.data(), newImg.size(), h.newSha);
+  deltaHeaderEncode(h, e->out.data());
+  *stats = e;
+  return e->out;
+}
+
+// ── Round trip through the firmware decoder ──
+
+struct ApplyCtx {
+  const Bytes* oldImg;
+  Bytes        rebuilt;
+  uint32_t     reads;
+};
+
+static bool readOld(void* ctx, uint32_t off, uint8_t* buf, uint32_t len){
+  ApplyCtx* c = (ApplyCtx*)ctx;
+  if(off + len > c->oldImg->size()) return false;
+  memcpy(buf, c->oldImg->data() + off, len);
+  c->reads++;
+  return true;
+}
+
+static bool writeNew(void* ctx, const uint8_t* buf, uint32_t len){
+  ApplyCtx* c = (ApplyCtx*)ctx;
+  c->rebuilt.insert(c->rebuilt.end(), buf, buf + len);
+  return true;
+}
+
+static bool verifyPatch(const Bytes& oldImg, const Bytes& newImg, const Bytes& patch){
+  ApplyCtx ctx = {&oldImg, Bytes(), 0};
+  DeltaApply* a = new DeltaApply;
+  deltaApplyBegin(*a, readOld, writeNew, &ctx);
+  DeltaResult r = DELTA_MORE;
+  // Mesh chunks are 192 bytes, WiFi blocks ~1460 - use an awkward mix of both
+  uint32_t sizes[] = {192, 1, 1460, 7, 250};
+  for(uint32_t off = 0, i = 0; off < patch.size() && r == DELTA_MORE; i++) {
+    uint32_t len = sizes[i % 5];
+    if(len > patch.size() - off) len = patch.size() - off;
+    r = deltaApplyFeed(*a, patch.data() + off, len);
+    off += len;
+  }
+  bool ok = r == DELTA_DONE && ctx.rebuilt == newImg;
+  if(!ok) fprintf(stderr, "verify FAILED: %s\n", r == DELTA_ERROR ? a->error : "patch ended early");
+  else printf("verify: rebuilt %zu bytes with %u old-image reads, %zu bytes of decoder state\n",
+              ctx.rebuilt.size(), ctx.reads, sizeof(DeltaApply));
+  delete a;
+  return ok;
+}
+
+static void report(const Bytes& newImg, const Bytes& patch, const Encoder& e){
+  double full = newImg.size() / 1024.0 / WIFI_OTA_KBPS, delta = patch.size() / 1024.0 / WIFI_OTA_KBPS;
+  printf("image %zu bytes, patch %zu bytes (%.1f%%, %.1fx smaller)\n",
+         newImg.size(), patch.size(), 100.0 * patch.size() / newImg.size(), (double)newImg.size() / patch.size());
+  printf("  %u copies (%u bytes, %u diff bytes), %u inserts (%u literal bytes)\n",
+         e.copies, e.copied, e.diffBytes, e.inserts, e.literal);
+  printf("  WiFi transfer at %.0fKB/s: %.1fs full, %.1fs delta\n", WIFI_OTA_KBPS, full, delta);
+}
+
+// ── Self test ──
+// Xtensa-ish image: code mixed with 32-bit literal pools pointing into the
+// image. The edit grows one function by 300 bytes, so everything after it
+// moves and every pointer past the edit changes.
+
+static uint32_t rng = 12345;
+static uint32_t nextRand(){ rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; }
+
+static Bytes synthImage(uint32_t size, uint32_t editAt, uint32_t grow){
+  rng = 12345;
+  Bytes img;
+  const uint32_t base = 0x400D0000;
+  while(img.size() < size) {
+    // A function: code, then its literal pool
+    uint32_t codeLen = 64 + nextRand() % 900;
+    for(uint32_t i = 0; i < codeLen; i++) img.push_back(nextRand());
+    if(img.size() >= editAt && img.size() - codeLen < editAt)
+      for(uint32_t i = 0; i < grow; i++) img.push_back(nextRand() ^ 0x5A);
+    uint32_t lits = 2 + nextRand() % 8;
+    for(uint32_t i = 0; i < lits; i++) {
+      uint32_t target = nextRand() % size;
+      uint32_t addr = base + target + (target > editAt ? grow : 0);
+      for(int b = 0; b < 4; b++) img.push_back(addr >> (8 * b));
+    }
+  }
+  img.resize(size + grow);
+  return img;
+}
+
+static int selftest(){
+  const uint32_t size = 1200 * 1024;
+  Bytes oldImg = synthImage(size, ~0u, 0);
+  oldImg.resize(size);
+  Bytes newImg = synthImage(size, size / 3, 300);
+  Encoder* e;
+  Bytes patch = makePatch(oldImg, newImg, &e);
+  report(newImg, patch, *e);
+  bool ok = verifyPatch(oldImg, newImg, patch);
+  // A corrupted patch must be refused, never written as a bad image
+  patch[patch.size() / 2] ^= 0x10;
+  ApplyCtx ctx = {&oldImg, Bytes(), 0};
+  DeltaApply* a = new DeltaApply;
+  deltaApplyBegin(*a, readOld, writeNew, &ctx);
+  DeltaResult r = deltaApplyFeed(*a, patch.data(), patch.size());
+  printf("corrupted patch: %s\n", r == DELTA_ERROR ? a->error : "ACCEPTED");
+  ok = ok && r == DELTA_ERROR;
+  delete a;
+  delete e;
+  return ok ? 0 : 2;
+}
+
+int main(int argc, char** argv){
+  if(argc == 2 && !strcmp(argv[1], "--selftest")) return selftest();
+  if(argc != 4) {
+    fprintf(stderr, "usage: mkdelta old.bin new.bin patch.pld | mkdelta --selftest\n");
+    return 1;
+  }
+  Bytes oldImg, newImg;
+  if(!readFile(argv[1], oldImg) || !readFile(argv[2], newImg)) {
+    fprintf(stderr, "can't read %s / %s\n", argv[1], argv[2]);
+    return 1;
+  }
+  Encoder* e;
+  Bytes patch = makePatch(oldImg, newImg, &e);
+  report(newImg, patch, *e);
+  delete e;
+  if(!verifyPatch(oldImg, newImg, patch)) return 2;
+  if(patch.size() >= newImg.size()) fprintf(stderr, "note: patch is no smaller than the image - send the full build\n");
+  FILE* f = fopen(argv[3], "wb");
+  if(!f || fwrite(patch.data(), 1, patch.size(), f) != patch.size()) {
+    fprintf(stderr, "can't write %s\n", argv[3]);
+    return 1;
+  }
+  fclose(f);
+  printf("wrote %s\n", argv[3]);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// ── Settings Persistence Simulator ───────────────────────────────────────────
+// Host-side check of deferred settings writes: the firmware's scheduler
+// (scheduler.cpp) and write policy (persist.cpp) driven together the way
+// loop() drives them - handleButtons() first, so a change lands between two
+// schedulerRun() calls, then schedulerRun(millis()). The storage.cpp side
+// (settingsChanged / persistTimerFired) is mirrored here with the flash write
+// replaced by a counter. Every scenario checks that each burst of changes is
+// written exactly once, within the quiet period plus one loop, and that
+// nothing is left dirty.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o persist_sim tools/persist_sim.cpp scheduler.cpp persist.cpp
+// Run:
+//   ./persist_sim         one click, a burst, a knob that never settles - at several loop periods
+
+#include "../persist.h"
+#include "../scheduler.h"
+#include <stdio.h>
+#include <vector>
+
+static const uint32_t RUN_MS = 60000;
+
+// ── storage.cpp, minus the flash ─────────────────────────────────────────────
+static PersistState persist;
+static TimerId      persistTimer = TIMER_NONE;
+static uint32_t     nowMs = 0;
+static std::vector<uint32_t> writeTimes;
+
+static void writeSettings(){
+  persistBeginWrite(persist);
+  writeTimes.push_back(nowMs);
+}
+
+static void persistTimerFired(void*){
+  persistTimer = TIMER_NONE;
+  if(!persist.dirty) return;
+  uint32_t left = persistDelayMs(persist, nowMs);
+  if(left) {
+    persistTimer = timerOnce(left, persistTimerFired);
+    return;
+  }
+  writeSettings();
+}
+
+static void settingsChanged(){
+  uint32_t delayMs = persistNoteChange(persist, nowMs);
+  timerCancel(persistTimer);
+  persistTimer = timerOnce(delayMs, persistTimerFired);
+}
+
+// ── Scenarios ────────────────────────────────────────────────────────────────
+struct Scenario {
+  const char* name;
+  uint32_t    firstMs, everyMs, untilMs;   // Changes from firstMs, every everyMs, until untilMs
+  uint32_t    expectWrites;
+  uint32_t    latestMs;                    // Last write due by (+ one loop period)
+};
+
+static bool run(const Scenario& sc, uint32_t loopMs){
+  persistReset(persist, 0);
+  persistTimer = TIMER_NONE;
+  writeTimes.clear();
+  nowMs = 1000;
+  schedulerInit(nowMs);
+
+  uint32_t nextChange = sc.firstMs;
+  for(; nowMs < RUN_MS; nowMs += loopMs) {
+    // handleButtons(): a change seen this pass, just before the scheduler runs
+    if(nextChange <= nowMs && nextChange <= sc.untilMs) {
+      settingsChanged();
+      nextChange += sc.everyMs ? sc.everyMs : RUN_MS;
+    }
+    schedulerRun(nowMs);
+  }
+
+  bool ok = writeTimes.size() == sc.expectWrites && !persist.dirty
+         && !writeTimes.empty() && writeTimes.back() <= sc.latestMs + loopMs;
+  printf("%-22s %5ums %7zu %8u %9u %8u  %s\n", sc.name, loopMs, writeTimes.size(),
+         persist.changes, writeTimes.empty() ? 0 : writeTimes.back(), persist.dirty, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+int main(){
+  const Scenario scenarios[] = {
+    // One click: written one quiet period later
+    {"one click",           2000, 0,   2000,  1, 2000 + PERSIST_QUIET_MS},
+    // Ten quick clicks: one write, a quiet period after the last
+    {"burst of 10",         2000, 150, 3350,  1, 3350 + PERSIST_QUIET_MS},
+    // Turning for 45s: written every PERSIST_MAX_DELAY_MS, then once after it stops
+    {"knob never settles",  2000, 500, 47000, 3, 47000 + PERSIST_QUIET_MS},
+  };
+  const uint32_t loops[] = {1, 7, 20, 50};
+
+  bool ok = true;
+  printf("%-22s %7s %7s %8s %9s %8s  %s\n", "scenario", "loop", "writes", "changes", "last at", "dirty", "check");
+  for(const Scenario& sc : scenarios)
+    for(uint32_t loopMs : loops) ok &= run(sc, loopMs);
+  printf("\nDeferred writes %s\n", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// ── Pixel Map Bench ──────────────────────────────────────────────────────────
+// Host-side check and benchmark of the firmware's pixel map (pixelmap.cpp):
+// builds line, pole and arch maps the way a node does at boot, checks the
+// geometry came out right, then times the boot-time build and one frame of
+// mapped fields - a plane wave, a spiral, a ripple and a kaleidoscope fold -
+// with the fixed-point sampling API against the same fields done with float
+// trig per pixel, as patterns would without the map.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o pixelmap_bench tools/pixelmap_bench.cpp pixelmap.cpp
+// Run:
+//   ./pixelmap_bench      334 and 1000 pixels, every map
+//
+// Host timings - the ESP32 is several times slower and has a slow FPU, so
+// look at the ratio and the headroom. The PATTERNS serial command reports the
+// mapped patterns' render time on the node itself.
+
+#include "../pixelmap.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const uint32_t FRAME_US     = 20000;   // 50fps leader
+static const int      BUILD_RUNS   = 200;
+static const int      FRAME_RUNS   = 2000;
+
+static double nowUs(){
+  using namespace std::chrono;
+  return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Same shapes as config.h, scaled with the pixel count
+struct BenchMap {
+  const char*             name;
+  std::vector<MapSegment> segs;
+  uint8_t                 polarAxis;
+};
+
+static BenchMap poleMap(uint16_t n){
+  return {"pole", {mapArc(n, MAP_AXIS_Y, 0, 0, 0, 50, 0, (int16_t)(360 * (n / 21)), (int16_t)(n * 7))}, MAP_AXIS_Y};
+}
+
+static BenchMap archMap(uint16_t n){
+  uint16_t leg = n * 72 / 334;
+  int16_t r = n * 3;
+  return {"arch", {mapLine(leg, -r, 0, 0, -r, (int16_t)(r * 6 / 5), 0),
+                   mapArc(n - 2 * leg, MAP_AXIS_Z, 0, (int16_t)(r * 6 / 5), 0, r, 180, 0, 0),
+                   mapLine(leg, r, (int16_t)(r * 6 / 5), 0, r, 0, 0)}, MAP_AXIS_Z};
+}
+
+// ── Geometry checks ──────────────────────────────────────────────────────────
+static bool check(bool ok, const char* what, uint16_t n, const char* map){
+  if(!ok) printf("  FAIL %s (%s, %u pixels)\n", what, map, n);
+  return ok;
+}
+
+static bool checkMaps(uint16_t n){
+  bool ok = true;
+  std::vector<MapPoint> pts(n);
+
+  // Line: x climbs end to end, centred, radius folds about the middle
+  PixelMapDef line = {"line", nullptr, 0, MAP_AXIS_Z};
+  mapBuild(line, n, pts.data());
+  for(uint16_t i = 1; i < n; i++) ok &= check(pts[i].x > pts[i - 1].x, "line x increasing", n, "line");
+  ok &= check(abs(pts[0].x + pts[n - 1].x) <= 1 && pts[0].x < -32000, "line spans -1..1", n, "line");
+  ok &= check(abs((int)pts[0].radius - pts[n - 1].radius) <= 1, "line radius symmetric", n, "line");
+
+  // Pole: every pixel the same distance from the axis (to within the centre
+  // the samples give), y climbs
+  BenchMap pole = poleMap(n);
+  PixelMapDef poleDef = {pole.name, pole.segs.data(), (uint8_t)pole.segs.size(), pole.polarAxis};
+  ok &= check(mapBuild(poleDef, n, pts.data()), "pole fits", n, "pole");
+  uint16_t nearest = 65535;
+  for(uint16_t i = 0; i < n; i++) if(pts[i].radius < nearest) nearest = pts[i].radius;
+  ok &= check(nearest > 65535 * 97 / 100, "pole radius constant", n, "pole");
+  for(uint16_t i = 1; i < n; i++) ok &= check(pts[i].y >= pts[i - 1].y, "pole y climbing", n, "pole");
+
+  // Arch: mirror image left to right, top in the middle
+  BenchMap arch = archMap(n);
+  PixelMapDef archDef = {arch.name, arch.segs.data(), (uint8_t)arch.segs.size(), arch.polarAxis};
+  ok &= check(mapBuild(archDef, n, pts.data()), "arch fits", n, "arch");
+  for(uint16_t i = 0; i < n / 2; i++) {
+    const MapPoint& a = pts[i];
+    const MapPoint& b = pts[n - 1 - i];
+    ok &= check(abs(a.x + b.x) <= 2 && abs(a.y - b.y) <= 2, "arch symmetric", n, "arch");
+  }
+  ok &= check(pts[n / 2].y > 32000, "arch top highest", n, "arch");
+
+  // A map for another strip length falls back to the line
+  ok &= check(!mapBuild(poleDef, n + 1, pts.data()), "wrong length rejected", n, "pole");
+
+  // Sampling: distance to itself 0, projection on +x is x
+  mapBuild(archDef, n, pts.data());
+  MapDir ax = mapDir(0, 0);
+  for(uint16_t i = 0; i < n; i++) {
+    ok &= check(mapDistance(pts[i], pts[i].x, pts[i].y, pts[i].z) == 0, "distance to self", n, "arch");
+    ok &= check(abs(mapProject(pts[i], ax) - pts[i].x) <= 1, "project onto x", n, "arch");
+  }
+  return ok;
+}
+
+// ── Field evaluation ─────────────────────────────────────────────────────────
+static uint8_t SIN8[256];   // Stands in for FastLED's sin8
+
+// Four mapped fields per pixel, fixed point - what the mapped patterns do
+static uint32_t fieldsMapped(const MapPoint* pts, uint16_t n, uint8_t t){
+  MapDir dir = mapDir(t * 256, 65536 / 12);   // Once per frame
+  const MapPoint& c = pts[n / 3];
+  uint32_t sum = 0;
+  for(uint16_t i = 0; i < n; i++) {
+    const MapPoint& p = pts[i];
+    uint8_t wave = SIN8[(uint8_t)(((mapProject(p, dir) + 32768) >> 8) * 4 + t)];
+    uint8_t spiral = SIN8[(uint8_t)((mapSpiral(p, 2, 5 * 256) >> 8) + t)];
+    uint8_t ripple = SIN8[(uint8_t)((mapDistance(p, c.x, c.y, c.z) >> 8) * 8 - t)];
+    uint16_t wedge = p.angle * 6;
+    uint8_t fold = (wedge & 0x8000 ? ~wedge : wedge) >> 7;
+    sum += wave + spiral + ripple + fold;
+  }
+  return sum;
+}
+
+// The same fields from float positions, trig per pixel
+static uint32_t fieldsTrig(const float* xyz, uint16_t n, uint8_t t, bool poleAxis){
+  float az = t * 2 * 3.14159265f / 256, el = 3.14159265f / 6;
+  const float* c = xyz + (n / 3) * 3;
+  uint32_t sum = 0;
+  for(uint16_t i = 0; i < n; i++) {
+    float x = xyz[i * 3], y = xyz[i * 3 + 1], z = xyz[i * 3 + 2];
+    float proj = x * cosf(el) * cosf(az) + y * sinf(el) + z * cosf(el) * sinf(az);
+    float v = poleAxis ? z : y;
+    float angle = atan2f(v, x), radius = sqrtf(x * x + v * v);
+    float dist = sqrtf((x - c[0]) * (x - c[0]) + (y - c[1]) * (y - c[1]) + (z - c[2]) * (z - c[2]));
+    uint8_t wave = 128 + 127 * sinf(proj * 8 * 3.14159265f + t * 0.0245f);
+    uint8_t spiral = 128 + 127 * sinf(angle * 2 + radius * 10 * 3.14159265f + t * 0.0245f);
+    uint8_t ripple = 128 + 127 * sinf(dist * 16 * 3.14159265f - t * 0.0245f);
+    uint8_t fold = 255 * fabsf(fmodf(angle * 6 / (2 * 3.14159265f) + 6, 1.0f) * 2 - 1);
+    sum += wave + spiral + ripple + fold;
+  }
+  return sum;
+}
+
+static volatile uint32_t sink;   // Keeps the optimiser from dropping the work
+
+static void benchMap(const PixelMapDef& def, uint16_t n){
+  std::vector<MapPoint> pts(n);
+  double t0 = nowUs();
+  for(int r = 0; r < BUILD_RUNS; r++) mapBuild(def, n, pts.data());
+  double buildUs = (nowUs() - t0) / BUILD_RUNS;
+
+  std::vector<float> xyz(n * 3);
+  for(uint16_t i = 0; i < n; i++) {
+    xyz[i * 3] = pts[i].x / 32767.0f;
+    xyz[i * 3 + 1] = pts[i].y / 32767.0f;
+    xyz[i * 3 + 2] = pts[i].z / 32767.0f;
+  }
+
+  t0 = nowUs();
+  for(int f = 0; f < FRAME_RUNS; f++) sink += fieldsMapped(pts.data(), n, f);
+  double mappedUs = (nowUs() - t0) / FRAME_RUNS;
+  t0 = nowUs();
+  for(int f = 0; f < FRAME_RUNS; f++) sink += fieldsTrig(xyz.data(), n, f, def.polarAxis == MAP_AXIS_Y);
+  double trigUs = (nowUs() - t0) / FRAME_RUNS;
+
+  printf("%7u %-6s %10.1f %8u %10.1f %6.2f%% %10.1f %6.1fx\n", n, def.name, buildUs,
+         (unsigned)(sizeof(MapPoint) * n), mappedUs, 100 * mappedUs / FRAME_US, trigUs, trigUs / mappedUs);
+}
+
+int main(){
+  for(int i = 0; i < 256; i++) SIN8[i] = 128 + 127 * sinf(i * 2 * 3.14159265f / 256);
+
+  bool ok = true;
+  const uint16_t sizes[] = {334, 1000};
+  for(uint16_t n : sizes) ok &= checkMaps(n);
+  printf("Geometry checks %s\n\n", ok ? "ok" : "FAILED");
+
+  printf("%7s %-6s %10s %8s %10s %7s %10s %7s\n", "pixels", "map", "build us", "bytes",
+         "mapped us", "budget", "trig us", "ratio");
+  for(uint16_t n : sizes) {
+    BenchMap pole = poleMap(n), arch = archMap(n);
+    PixelMapDef defs[] = {
+      {"line", nullptr, 0, MAP_AXIS_Z},
+      {pole.name, pole.segs.data(), (uint8_t)pole.segs.size(), pole.polarAxis},
+      {arch.name, arch.segs.data(), (uint8_t)arch.segs.size(), arch.polarAxis},
+    };
+    for(const PixelMapDef& def : defs) benchMap(def, n);
+  }
+  printf("\nbudget: mapped frame as a share of the %ums frame\n", FRAME_US / 1000);
+  return ok ? 0 : 1;
+}
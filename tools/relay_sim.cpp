@@ -0,0 +1,406 @@
+// ── Multi-hop Relay Simulator ────────────────────────────────────────────────
+// Host-side discrete-event simulation of the ESP-NOW relay mode, using the exact
+// dedupe / relay election / presentation-delay code from relay.cpp. Nodes are
+// placed in a spatial topology and the leader streams v2 frames the way the
+// firmware sends them at the top FEC link level (feedback.h): DEFAULT_LEDS
+// split into that level's chunks behind a PROTO_HEADER_LEN header, plus the
+// parity chunk, at its fps on the air. Every follower runs the same receive
+// path the firmware runs when loop() drains its receive ring, and completes a
+// frame with every data chunk or all but one plus the parity.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o relay_sim tools/relay_sim.cpp relay.cpp protocol.cpp
+// Run:
+//   ./relay_sim                         sweep node counts for every topology (direct vs relay)
+//   ./relay_sim corridor 40 [seed]      single run, including naive flooding, with per-hop breakdown
+//
+// Radio model: range-limited broadcast with distance-dependent loss, RSSI
+// falling linearly from -40dBm (co-located) to -90dBm (edge of range), carrier
+// sense within range and hidden-terminal collisions at the receiver. Relay mode
+// runs ESP-NOW at 11Mbps, with protoAirtimeUs() giving each packet's time on
+// the air; each relay goes out from a one-shot timer after its random jitter.
+// Packets are handled by loop(), which is blocked for SHOW_US while
+// FastLED.show() runs - anything that arrives meanwhile waits in the receive
+// ring until the show finishes.
+//
+// Each run lets the relay election settle for WARMUP_FRAMES, then measures.
+// Columns: reach = share of followers the hop limit can reach dependably (a
+// chain of at most RELAY_MAX_HOPS + 1 links from the leader that carries at
+// least half the frames end to end; a layout that reaches no one is reported
+// as such, not scored),
+// coverage = share of follower frames fully received, tx/frame = radio
+// transmissions per LED frame (airtime), relays = mean relays while measuring,
+// settled = when the relay set last changed (the latest of the runs a sweep
+// row averages), skew = spread between the first
+// and last node lighting a frame without / with per-hop presentation
+// compensation. Relay runs are checked against targets that don't grow with
+// the node count: at most RELAYS_PER_CELL relays per RANGE_M x RANGE_M cell of
+// the layout, and COVERAGE_TARGET of the reachable followers' frames.
+
+#include "../relay.h"
+#include "../protocol.h"
+#include "../feedback.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+static const uint16_t NUM_LEDS         = 334;       // config.h DEFAULT_LEDS
+static const LinkLevel& LEVEL          = LINK_LEVELS[1];   // Top FEC level - where a clean link settles
+static const int      DATA_CHUNKS      = linkChunks(LEVEL, NUM_LEDS);
+static const int      CHUNKS_PER_FRAME = DATA_CHUNKS + ((LEVEL.flags & PROTO_FLAG_FEC) ? 1 : 0);   // + parity
+static const uint32_t FRAME_US         = 1000000 / LEVEL.fps;
+static const uint16_t AIR_KBPS         = 11000;     // networking.cpp AIR_RATE_RELAY
+static const uint32_t SHOW_US          = 10000;     // FastLED.show() for 334 WS2812s blocks loop()
+static const int      FRAMES           = 30 * LEVEL.fps;   // 30s
+static const int      WARMUP_FRAMES    = 20 * LEVEL.fps;   // Let the relay election settle before measuring
+static const double   RANGE_M          = 120.0;
+static const int      RELAYS_PER_CELL  = 2;         // Relay target - one for reach, one for a second chance
+static const double   COVERAGE_TARGET  = 0.8;       // Of the reachable followers' frames
+static const int      SWEEP_SEEDS      = 8;         // Sweep rows average this many runs
+
+enum Mode { MODE_DIRECT, MODE_FLOOD, MODE_RELAY };
+static const char* MODE_NAMES[] = {"direct", "flood", "relay"};
+
+struct Packet {
+  uint8_t  hdr[RELAY_KEY_BYTES];   // v2 header up to the chunk count - as sent by sendRaw()
+  uint16_t len;                    // Packet length before any relay header
+  uint8_t  hops;
+  uint32_t frame;
+  uint8_t  chunk;
+};
+
+struct Node {
+  double x, y;
+  RelayCache cache;
+  RelayRole  role;
+  std::vector<uint8_t>  mask;      // Per-frame chunk assembly
+  std::vector<uint8_t>  hops;
+  std::vector<uint64_t> complete;
+  uint64_t busyFrom, busyUntil;    // loop() stuck in FastLED.show()
+};
+
+struct Tx { uint64_t created, start, end; int node; Packet pkt; };
+
+struct Event {
+  uint64_t t; int kind; int node; Packet pkt; size_t tx;
+  bool operator>(const Event& o) const { return t > o.t; }
+};
+enum { EV_FRAME, EV_TX_END, EV_RELAY_DUE };
+
+struct Result {
+  double reach, coverage, txPerFrame, meanSpread, meanSpreadUncomp, relays, settledS;
+  int    maxHops, relayTarget;
+  double hopLatencyMs[RELAY_MAX_HOPS + 2];
+  int    hopCount[RELAY_MAX_HOPS + 2];
+};
+
+static uint32_t rng = 1;
+static uint32_t nextRand(){ rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; }
+static double   uniform(){ return (nextRand() & 0xFFFFFF) / double(0x1000000); }
+
+static std::vector<Node> placeNodes(const char* topo, int n){
+  std::vector<Node> nodes(n);
+  for(int i = 0; i < n; i++){
+    Node& nd = nodes[i];
+    if(!strcmp(topo, "line")){             // Poles along a 450m path
+      nd.x = 450.0 * i / (n - 1); nd.y = 0;
+    } else if(!strcmp(topo, "grid")){      // Camp grid, 300m x 300m
+      int side = (int)ceil(sqrt((double)n));
+      nd.x = 300.0 * (i % side) / (side - 1); nd.y = 300.0 * (i / side) / (side - 1);
+    } else {                               // corridor: scattered 450m x 60m
+      nd.x = 450.0 * uniform(); nd.y = 60.0 * uniform();
+    }
+    relayCacheReset(nd.cache);
+    relayRoleReset(nd.role, 0);
+    nd.mask.assign(FRAMES, 0);
+    nd.hops.assign(FRAMES, 0);
+    nd.complete.assign(FRAMES, 0);
+    nd.busyFrom = nd.busyUntil = 0;
+  }
+  nodes[0].x = 0; nodes[0].y = 0;          // Leader at one end
+  return nodes;
+}
+
+static double dist(const Node& a, const Node& b){ return hypot(a.x - b.x, a.y - b.y); }
+
+// Chance a packet is lost over d metres (collisions aside)
+static double chunkLoss(double d){ return 0.02 + 0.3 * pow(d / RANGE_M, 4); }
+
+// Chance a frame gets through over d metres - the parity chunk covers one loss
+static double frameOk(double d){
+  double ok = 1 - chunkLoss(d), all = pow(ok, CHUNKS_PER_FRAME);
+  if(CHUNKS_PER_FRAME == DATA_CHUNKS) return all;
+  return all + CHUNKS_PER_FRAME * pow(ok, CHUNKS_PER_FRAME - 1) * (1 - ok);
+}
+
+// A frame is complete with every data chunk, or all but one and the parity
+static bool frameComplete(uint8_t mask){
+  uint8_t data = mask & ((1 << DATA_CHUNKS) - 1);
+  int have = __builtin_popcount(data);
+  return have == DATA_CHUNKS || (have == DATA_CHUNKS - 1 && mask != data);
+}
+static_assert(CHUNKS_PER_FRAME <= 8, "chunk masks are 8 bits");
+
+// Followers the leader can get at least half the frames to over a chain of at
+// most RELAY_MAX_HOPS + 1 links - the best chain's frame odds, link by link
+static double reachable(const std::vector<Node>& nodes){
+  int n = nodes.size();
+  std::vector<double> odds(n, 0.0);
+  odds[0] = 1;
+  for(int h = 0; h <= RELAY_MAX_HOPS; h++){
+    std::vector<double> next = odds;
+    for(int i = 0; i < n; i++)
+      for(int j = 1; j < n; j++)
+        next[j] = std::max(next[j], odds[i] * frameOk(dist(nodes[i], nodes[j])));
+    odds = next;
+  }
+  int reached = 0;
+  for(int j = 1; j < n; j++) reached += odds[j] >= 0.5;
+  return reached / double(n - 1);
+}
+
+// Relay target - RELAYS_PER_CELL for every cell of the layout's bounding box
+// beyond the leader's own
+static int relayTarget(const std::vector<Node>& nodes){
+  double w = 0, h = 0;
+  for(const Node& nd : nodes){ w = std::max(w, nd.x); h = std::max(h, nd.y); }
+  int cells = (int)ceil(w / RANGE_M - 1e-9) * std::max(1, (int)ceil(h / RANGE_M - 1e-9));
+  return RELAYS_PER_CELL * std::max(1, cells - 1);
+}
+
+static Result simulate(const char* topo, int n, Mode mode, uint32_t seed){
+  rng = seed;
+  std::vector<Node> nodes = placeNodes(topo, n);
+  std::vector<Tx> txs;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  std::vector<uint64_t> leaderPresent(FRAMES);
+  uint32_t token = 0xABCDEF;
+  const int bpl = protoPixelBytes(LEVEL.flags);
+  long measuredTx = 0, relaySamples = 0;
+  uint64_t lastChangeUs = 0;
+
+  if(mode == MODE_FLOOD) for(Node& nd : nodes) nd.role.active = true;
+
+  // On the air - the channel access wait is modelled by carrier sense below
+  auto airtime = [](const Packet& p){
+    return (uint64_t)(protoAirtimeUs(p.len + (p.hops ? 2 : 0), AIR_KBPS) - PROTO_AIR_ACCESS_US);
+  };
+  // Transmissions are appended in creation order and carrier sense never defers
+  // one by more than maxDefer, so only the tail of txs can still be on the air
+  uint64_t maxDefer = 0;
+  auto recent = [&](uint64_t t){
+    uint64_t horizon = maxDefer + protoAirtimeUs(PROTO_MAX_PACKET, AIR_KBPS);
+    size_t k = txs.size();
+    while(k > 0 && txs[k - 1].created + horizon > t) k--;
+    return k;
+  };
+  // Carrier sense: start after any in-range transmission still on the air.
+  // A relay still waiting a frame later is dropped - the firmware's relay
+  // queue only holds one frame's chunks
+  auto transmit = [&](int from, const Packet& p, uint64_t t){
+    uint64_t created = t;
+    for(size_t k = recent(t); k < txs.size(); k++){
+      const Tx& o = txs[k];
+      if(o.end > t && dist(nodes[o.node], nodes[from]) <= RANGE_M) t = o.end + nextRand() % 100;
+    }
+    if(from != 0 && t - created > FRAME_US) return;
+    maxDefer = std::max(maxDefer, t - created);
+    txs.push_back({created, t, t + airtime(p), from, p});
+    events.push({t + airtime(p), EV_TX_END, from, p, txs.size() - 1});
+    if(p.frame >= (uint32_t)WARMUP_FRAMES) measuredTx++;
+  };
+
+  for(int f = 0; f < FRAMES; f++) events.push({(uint64_t)f * FRAME_US, EV_FRAME, 0, {}, 0});
+
+  while(!events.empty()){
+    Event ev = events.top(); events.pop();
+
+    if(ev.kind == EV_FRAME){
+      uint32_t frame = ev.t / FRAME_US;
+      if(mode == MODE_RELAY){
+        for(int j = 1; j < n; j++)
+          if(relayUpdateRole(nodes[j].role, ev.t / 1000, nextRand())) lastChangeUs = ev.t;
+      }
+      if(frame >= (uint32_t)WARMUP_FRAMES)
+        for(int j = 1; j < n; j++) relaySamples += nodes[j].role.active;
+      for(int c = 0; c < CHUNKS_PER_FRAME; c++){
+        // Header only - the key never covers the payload
+        uint8_t hdr[PROTO_HEADER_LEN];
+        protoBuildV2(hdr, PKT_PIXELS, PROTO_FLAG_LEADER | LEVEL.flags, token, (uint16_t)frame, c, DATA_CHUNKS,
+                     (uint32_t)ev.t, c * LEVEL.ledsPerChunk, nullptr, 0);
+        int leds = c < DATA_CHUNKS ? std::min((int)LEVEL.ledsPerChunk, NUM_LEDS - c * LEVEL.ledsPerChunk)
+                                   : LEVEL.ledsPerChunk;
+        Packet p = {};
+        memcpy(p.hdr, hdr, RELAY_KEY_BYTES);
+        p.len = PROTO_HEADER_LEN + leds * bpl;
+        p.frame = frame; p.chunk = c; p.hops = 0;
+        transmit(0, p, ev.t);
+      }
+      leaderPresent[frame] = ev.t + (mode == MODE_DIRECT ? 0 : relayPresentDelayMs(0) * 1000);
+      continue;
+    }
+
+    if(ev.kind == EV_RELAY_DUE){
+      Packet out = ev.pkt;
+      out.hops++;
+      transmit(ev.node, out, ev.t);
+      continue;
+    }
+
+    // EV_TX_END - deliver to every receiver in range that did not see a collision
+    const Tx tx = txs[ev.tx];
+    for(int j = 1; j < n; j++){
+      if(j == tx.node) continue;
+      double d = dist(nodes[tx.node], nodes[j]);
+      if(d > RANGE_M) continue;
+      bool collided = false;
+      for(size_t k = recent(tx.start); k < txs.size(); k++){
+        const Tx& o = txs[k];
+        if(k == ev.tx || o.node == j) continue;
+        if(o.start < tx.end && o.end > tx.start && dist(nodes[o.node], nodes[j]) <= RANGE_M){ collided = true; break; }
+      }
+      if(collided) continue;
+      if(uniform() < chunkLoss(d)) continue;
+      int8_t rssi = (int8_t)(-40 - 50 * d / RANGE_M);
+
+      Node& nd = nodes[j];
+      const Packet& p = tx.pkt;
+      if(p.hops && mode == MODE_DIRECT) continue;
+
+      // The packet sits in the receive ring until loop() is free to drain it
+      uint64_t at = tx.end;
+      if(at >= nd.busyFrom && at < nd.busyUntil) at = nd.busyUntil;
+
+      // Same decision path as handleRxPacket() in networking.cpp
+      if(mode != MODE_DIRECT){
+        if(!relayCacheInsert(nd.cache, relayKey(p.hdr, RELAY_KEY_BYTES))){
+          relayNoteExtraCopy(nd.role, p.hops);
+          continue;
+        }
+        relayNoteFirstCopy(nd.role, rssi, p.hops);
+        if(nd.role.active && p.hops < RELAY_MAX_HOPS){
+          events.push({at + nextRand() % RELAY_JITTER_US, EV_RELAY_DUE, j, p, 0});
+        }
+      }
+
+      // Frame assembly, as in processPacket() + handleNetworking()
+      nd.mask[p.frame] |= 1 << p.chunk;
+      if(p.hops > nd.hops[p.frame]) nd.hops[p.frame] = p.hops;
+      if(frameComplete(nd.mask[p.frame]) && !nd.complete[p.frame]){
+        nd.complete[p.frame] = at;
+        nd.busyFrom  = at + (mode == MODE_DIRECT ? 0 : relayPresentDelayMs(nd.hops[p.frame]) * 1000);
+        nd.busyUntil = nd.busyFrom + SHOW_US;
+      }
+    }
+  }
+
+  Result res = {};
+  long received = 0, spreadFrames = 0;
+  double spread = 0, spreadUncomp = 0;
+  for(int f = WARMUP_FRAMES; f < FRAMES - 5; f++){
+    uint64_t lo = leaderPresent[f], hi = lo;
+    uint64_t loU = (uint64_t)f * FRAME_US, hiU = loU;
+    for(int j = 1; j < n; j++){
+      const Node& nd = nodes[j];
+      if(!nd.complete[f]) continue;
+      received++;
+      uint8_t h = nd.hops[f];
+      uint64_t present = nd.complete[f] + (mode == MODE_DIRECT ? 0 : relayPresentDelayMs(h) * 1000);
+      lo = std::min(lo, present); hi = std::max(hi, present);
+      loU = std::min(loU, nd.complete[f]); hiU = std::max(hiU, nd.complete[f]);
+      res.maxHops = std::max(res.maxHops, (int)h + 1);
+      res.hopLatencyMs[h + 1] += (nd.complete[f] - (uint64_t)f * FRAME_US) / 1000.0;
+      res.hopCount[h + 1]++;
+    }
+    spread += (hi - lo) / 1000.0; spreadUncomp += (hiU - loU) / 1000.0;
+    spreadFrames++;
+  }
+  res.reach            = reachable(nodes);
+  res.relayTarget      = relayTarget(nodes);
+  res.relays           = relaySamples / double(FRAMES - WARMUP_FRAMES);
+  res.settledS         = lastChangeUs / 1e6;
+  res.coverage         = received / double((n - 1) * spreadFrames);
+  res.txPerFrame       = measuredTx / double(FRAMES - WARMUP_FRAMES);
+  res.meanSpread       = spread / spreadFrames;
+  res.meanSpreadUncomp = spreadUncomp / spreadFrames;
+  for(int h = 1; h <= RELAY_MAX_HOPS + 1; h++)
+    if(res.hopCount[h]) res.hopLatencyMs[h] /= res.hopCount[h];
+  return res;
+}
+
+// Mean of SWEEP_SEEDS runs - the election is random, one run can be lucky
+static Result average(const char* topo, int n, Mode mode){
+  Result sum = {};
+  for(int s = 1; s <= SWEEP_SEEDS; s++){
+    Result r = simulate(topo, n, mode, s);
+    sum.reach += r.reach; sum.coverage += r.coverage; sum.txPerFrame += r.txPerFrame;
+    sum.meanSpread += r.meanSpread; sum.meanSpreadUncomp += r.meanSpreadUncomp;
+    sum.relays += r.relays; sum.settledS = std::max(sum.settledS, r.settledS);
+    sum.maxHops = std::max(sum.maxHops, r.maxHops);
+    sum.relayTarget = r.relayTarget;
+  }
+  sum.reach /= SWEEP_SEEDS; sum.coverage /= SWEEP_SEEDS; sum.txPerFrame /= SWEEP_SEEDS;
+  sum.meanSpread /= SWEEP_SEEDS; sum.meanSpreadUncomp /= SWEEP_SEEDS; sum.relays /= SWEEP_SEEDS;
+  return sum;
+}
+
+// Relay runs against the targets - true when both are met. A layout that
+// reaches no follower has nothing to score: it's listed, not passed.
+static bool printRow(const char* topo, int n, Mode mode, const Result& r){
+  bool ok = true;
+  char check[48] = "";
+  if(mode == MODE_RELAY && r.reach == 0) {
+    snprintf(check, sizeof(check), "out of reach - not scored");
+  } else if(mode == MODE_RELAY) {
+    bool relaysOk = r.relays < r.relayTarget + 0.5, coverageOk = r.coverage >= COVERAGE_TARGET * r.reach;
+    ok = relaysOk && coverageOk;
+    snprintf(check, sizeof(check), "<=%-3d %s  >=%4.1f%% %s", r.relayTarget, relaysOk ? "ok" : "OVER",
+             COVERAGE_TARGET * r.reach * 100, coverageOk ? "ok" : "LOW");
+  }
+  printf("%-9s %4d  %-6s  %5.1f%%  %7.1f%%  %8.1f  %6.1f  %7.1f  %4d  %7.1f  %7.1f  %s\n",
+         topo, n, MODE_NAMES[mode], r.reach * 100, r.coverage * 100, r.txPerFrame, r.relays,
+         r.settledS, r.maxHops, r.meanSpreadUncomp, r.meanSpread, check);
+  return ok;
+}
+
+int main(int argc, char** argv){
+  printf("%-9s %4s  %-6s  %6s  %8s  %8s  %6s  %7s  %4s  %7s  %7s  %s\n", "topology", "n", "mode", "reach",
+         "coverage", "tx/frame", "relays", "settled", "hops", "skew ms", "comp ms", "relay target  coverage target");
+
+  if(argc >= 3){
+    const char* topo = argv[1];
+    int n = atoi(argv[2]);
+    uint32_t seed = argc > 3 ? strtoul(argv[3], nullptr, 0) : 1;
+    for(int m = MODE_DIRECT; m <= MODE_RELAY; m++){
+      Result r = simulate(topo, n, (Mode)m, seed);
+      printRow(topo, n, (Mode)m, r);
+      for(int h = 1; h <= RELAY_MAX_HOPS + 1; h++){
+        if(r.hopCount[h]) printf("    hop %d: %6d frames, complete %.1f ms after leader send\n",
+                                 h, r.hopCount[h], r.hopLatencyMs[h]);
+      }
+    }
+    return 0;
+  }
+
+  const char* topos[] = {"line", "corridor", "grid"};
+  const int   sizes[] = {12, 25, 50, 100};
+  int met = 0, runs = 0, unreached = 0;
+  for(const char* topo : topos){
+    for(int n : sizes){
+      printRow(topo, n, MODE_DIRECT, average(topo, n, MODE_DIRECT));
+      Result r = average(topo, n, MODE_RELAY);
+      bool ok = printRow(topo, n, MODE_RELAY, r);
+      if(r.reach == 0) { unreached++; continue; }
+      met += ok;
+      runs++;
+    }
+  }
+  printf("\nRelay targets met in %d of %d layouts", met, runs);
+  if(unreached) printf(" (%d more out of reach of the leader)", unreached);
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,342 @@
+// ── ESP-NOW Capture Replayer ─────────────────────────────────────────────────
+// Feeds a packet capture (CAPTURE_MODE, see capture.h) through the follower
+// receive path - relay unwrap and dedupe from relay.cpp, parsing and CRC from
+// protocol.cpp, frame assembly and FEC from assembler.cpp, then the display
+// from playout.cpp - exactly as loop() runs it when it drains the receive ring. Field problems become repeatable
+// benchmarks: capture once, replay as often as the receive code changes.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o replay tools/replay.cpp protocol.cpp assembler.cpp capture.cpp relay.cpp feedback.cpp playout.cpp
+// Capture (CAPTURE_MODE 1 on a follower, port at CAPTURE_BAUD):
+//   stty -F /dev/ttyUSB0 921600 raw && cat /dev/ttyUSB0 > field.cap
+// Run:
+//   ./replay field.cap [token]          analyse (token = leader to follow, default: busiest sender)
+//   ./replay --synth out.cap [loss%] [leds] [Mbps] [fps]
+//                                       write a synthetic 30s capture to try the tool without hardware -
+//                                       leds pixels per frame (default 334), on the air at the rate the
+//                                       firmware would pick for them unless Mbps forces one, fps frames
+//                                       a second on the air (default the top FEC link level's, 25)
+//
+// Reports: what was on the air, frame completion for the followed leader, the
+// timing of reconstructed frames (interval and jitter between completions,
+// transit delay above the fastest frame), what the display made of them at
+// DISPLAY_FPS (blended, extrapolated or held, and the longest freeze next to
+// showing frames as they complete) and decode throughput - the whole
+// capture decoded repeatedly at full speed, wall-clock timed. The strip length
+// is taken from the followed leader's pixel offsets.
+
+#include "../protocol.h"
+#include "../assembler.h"
+#include "../capture.h"
+#include "../relay.h"
+#include "../feedback.h"
+#include "../playout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+
+static const uint16_t DEFAULT_LEDS   = 334;   // config.h
+static const uint16_t MAX_LEDS       = 1024;  // config.h
+static const uint8_t  MSGTYPE_RELAY  = 0x04;  // config.h
+static const uint32_t DISPLAY_FPS    = 100;   // config.h
+static const int      BENCH_MIN_MS   = 500;   // Decode benchmark runs at least this long
+
+struct Replay {
+  FrameAssembler fa;
+  RelayCache     cache;
+  uint16_t       numLeds;
+  uint8_t        rgb[MAX_LEDS * 3];
+  uint32_t       token;                // Leader being followed
+  uint32_t       crcErrors, badVersion, duplicates, otherLeaders, frames;
+  std::vector<uint32_t> completedAt;   // rxMicros of each completed frame
+  std::vector<int32_t>  transitUs;     // rx - leader timestamp, per completed frame
+  std::vector<uint32_t> stampUs;       // Leader timestamp (v1: rx time), per completed frame
+};
+
+static void replayReset(Replay& r, uint32_t token, bool keepTiming){
+  asmInit(r.fa, r.rgb, r.numLeds);
+  relayCacheReset(r.cache);
+  r.token = token;
+  r.crcErrors = r.badVersion = r.duplicates = r.otherLeaders = r.frames = 0;
+  if(keepTiming) {
+    r.completedAt.clear();
+    r.transitUs.clear();
+    r.stampUs.clear();
+  }
+}
+
+// The firmware's handleRxPacket() + processPacket() for a follower in AUTO mode
+static void replayPacket(Replay& r, const CaptureRecord& rec, bool keepTiming){
+  const uint8_t* data = rec.data;
+  int len = rec.len;
+  uint8_t hops = 0;
+  bool relayed = (len >= 2 && data[0] == MSGTYPE_RELAY);
+  if(relayed) {
+    hops = data[1];
+    data += 2;
+    len  -= 2;
+  }
+
+  PacketInfo pkt;
+  ParseResult res = protoParse(data, len, pkt);
+  if(res == PARSE_BAD_CRC)     { r.crcErrors++;  return; }
+  if(res == PARSE_BAD_VERSION) { r.badVersion++; return; }
+  if(res != PARSE_OK || pkt.kind != PKT_PIXELS) return;
+
+  // Only dedupe when relays are on the air, like a RELAY_MODE node
+  if(relayed || hops) {
+    if(!relayCacheInsert(r.cache, relayKey(data, len))) { r.duplicates++; return; }
+  }
+  if(pkt.token != r.token) { r.otherLeaders++; return; }
+
+  if(asmAddChunk(r.fa, pkt, hops, rec.rxMicros)) {
+    r.frames++;
+    if(keepTiming) {
+      r.completedAt.push_back(rec.rxMicros);
+      r.transitUs.push_back((int32_t)(rec.rxMicros - r.fa.timestampUs));
+      r.stampUs.push_back(r.fa.version >= 2 ? r.fa.timestampUs : rec.rxMicros);
+    }
+  }
+}
+
+static double percentile(std::vector<double> v, double p){
+  if(v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+  return v[i];
+}
+
+// The follower's display: completed frames into the playout history as they
+// complete, one render per display tick
+static void replayDisplay(const Replay& r){
+  static uint8_t slotA[MAX_LEDS * 3], slotB[MAX_LEDS * 3], slotC[MAX_LEDS * 3], out[MAX_LEDS * 3];
+  Playout po;
+  playoutInit(po, slotA, slotB, slotC, r.numLeds);
+  const uint32_t tickUs = 1000000 / DISPLAY_FPS;
+  uint32_t start = r.completedAt.front(), span = r.completedAt.back() - start;
+  uint32_t ticks = 0, holdRun = 0, longestHold = 0, moving = 0;
+  std::vector<double> delay;
+  size_t next = 0;
+  for(uint32_t t = 0; t <= span; t += tickUs) {
+    while(next < r.completedAt.size() && r.completedAt[next] - start <= t) {
+      playoutPush(po, r.rgb, r.stampUs[next], r.completedAt[next]);
+      next++;
+    }
+    PlayoutKind kind = playoutRender(po, start + t, 0, out);
+    if(kind == PLAYOUT_EMPTY) continue;
+    ticks++;
+    delay.push_back(playoutDelayUs(po, 0) / 1000.0);
+    if(kind == PLAYOUT_HOLD) {
+      if(++holdRun > longestHold) longestHold = holdRun;
+    } else {
+      holdRun = 0;
+      moving++;
+    }
+  }
+  if(!ticks) return;
+  uint32_t longestGap = 0;
+  for(size_t i = 1; i < r.completedAt.size(); i++) {
+    longestGap = std::max(longestGap, r.completedAt[i] - r.completedAt[i - 1]);
+  }
+  printf("\nDisplay at %ufps (playout):\n", DISPLAY_FPS);
+  printf("  blended=%.1f%% extrapolated=%.1f%% held=%.1f%%  moving on %.1f%% of ticks\n",
+    100.0 * po.stats.blended / ticks, 100.0 * po.stats.extrapolated / ticks, 100.0 * po.stats.held / ticks,
+    100.0 * moving / ticks);
+  printf("  delay behind the leader ms: p50=%.1f max=%.1f  longest hold %.0fms (%.1fms showing frames on completion)\n",
+    percentile(delay, 50), percentile(delay, 100), longestHold * tickUs / 1000.0, longestGap / 1000.0);
+}
+
+static std::vector<uint8_t> readFile(const char* path){
+  std::vector<uint8_t> buf;
+  FILE* f = fopen(path, "rb");
+  if(!f) { perror(path); exit(1); }
+  uint8_t tmp[65536];
+  size_t n;
+  while((n = fread(tmp, 1, sizeof(tmp), f)) > 0) buf.insert(buf.end(), tmp, tmp + n);
+  fclose(f);
+  return buf;
+}
+
+static int analyse(const char* path, uint32_t token){
+  std::vector<uint8_t> file = readFile(path);
+  std::vector<CaptureRecord> recs;
+  size_t pos = 0, skipped = 0;
+  CaptureRecord rec;
+  while(captureNext(file.data(), file.size(), pos, rec, &skipped)) recs.push_back(rec);
+  if(recs.empty()) { fprintf(stderr, "%s: no capture records found\n", path); return 1; }
+
+  // Capture-side losses show up as sequence gaps
+  uint32_t seqGaps = 0;
+  for(size_t i = 1; i < recs.size(); i++) seqGaps += (uint16_t)(recs[i].seq - recs[i-1].seq - 1);
+
+  // Census of senders and packet kinds
+  std::map<uint32_t, uint32_t> pixelsBy;
+  uint32_t kinds[4] = {0}, v1 = 0, relayed = 0;
+  uint64_t bytes = 0;
+  for(const CaptureRecord& c : recs) {
+    bytes += c.len;
+    const uint8_t* d = c.data;
+    int len = c.len;
+    if(len >= 2 && d[0] == MSGTYPE_RELAY) { d += 2; len -= 2; relayed++; }
+    PacketInfo pkt;
+    if(protoParse(d, len, pkt) != PARSE_OK) continue;
+    if(pkt.version == 1) v1++;
+    if(pkt.kind < 4) kinds[pkt.kind]++;
+    if(pkt.kind == PKT_PIXELS) pixelsBy[pkt.token]++;
+  }
+  if(!token) {
+    uint32_t best = 0;
+    for(auto& kv : pixelsBy) if(kv.second > best) { best = kv.second; token = kv.first; }
+  }
+  double spanS = (uint32_t)(recs.back().rxMicros - recs.front().rxMicros) / 1e6;
+
+  // Strip length - the furthest pixel the followed leader sends (parity chunks aside)
+  uint32_t numLeds = 0;
+  for(const CaptureRecord& c : recs) {
+    const uint8_t* d = c.data;
+    int len = c.len;
+    if(len >= 2 && d[0] == MSGTYPE_RELAY) { d += 2; len -= 2; }
+    PacketInfo pkt;
+    if(protoParse(d, len, pkt) != PARSE_OK || pkt.kind != PKT_PIXELS || pkt.version < 2 || pkt.token != token) continue;
+    if((pkt.flags & PROTO_FLAG_FEC) && pkt.chunkIdx == pkt.chunkCount) continue;
+    uint32_t end = pkt.offset + pkt.payloadLen / protoPixelBytes(pkt.flags);
+    if(end > numLeds) numLeds = end;
+  }
+  if(!numLeds) numLeds = DEFAULT_LEDS;
+  if(numLeds > MAX_LEDS) numLeds = MAX_LEDS;
+
+  printf("Capture: %s\n", path);
+  printf("  %zu records over %.1fs, %llu packet bytes, %zu bytes of other serial output skipped\n",
+    recs.size(), spanS, (unsigned long long)bytes, skipped);
+  printf("  %u records dropped on the node (serial full)\n", seqGaps);
+  printf("  pixels=%u heartbeats=%u reports=%u audio=%u  v1=%u relayed=%u\n",
+    kinds[PKT_PIXELS], kinds[PKT_HEARTBEAT], kinds[PKT_REPORT], kinds[PKT_AUDIO], v1, relayed);
+  for(auto& kv : pixelsBy) {
+    printf("  leader 0x%06X: %u pixel packets%s\n", kv.first, kv.second, kv.first == token ? "  <- followed" : "");
+  }
+  printf("  strip: %u LEDs\n", numLeds);
+
+  // Functional pass - one replay with timing kept
+  static Replay r;
+  r.numLeds = numLeds;
+  replayReset(r, token, true);
+  for(const CaptureRecord& c : recs) replayPacket(r, c, true);
+  const RxStats& st = r.fa.stats;
+  uint32_t attempted = st.framesComplete + st.framesLost;
+  printf("\nFrames (leader 0x%06X):\n", token);
+  printf("  complete=%u lost=%u  completion=%.2f%%  fec recovered=%u\n",
+    st.framesComplete, st.framesLost, attempted ? 100.0 * st.framesComplete / attempted : 0.0, st.fecRecovered);
+  printf("  chunks expected=%u lost=%u (%.2f%%)  crc errors=%u bad version=%u duplicates=%u\n",
+    st.chunksExpected, st.chunksLost, st.chunksExpected ? 100.0 * st.chunksLost / st.chunksExpected : 0.0,
+    r.crcErrors, r.badVersion, r.duplicates);
+
+  if(r.completedAt.size() > 2) {
+    std::vector<double> iv, tr;
+    double sum = 0, sq = 0;
+    for(size_t i = 1; i < r.completedAt.size(); i++) {
+      double d = (uint32_t)(r.completedAt[i] - r.completedAt[i-1]) / 1000.0;
+      iv.push_back(d);
+      sum += d;
+      sq += d * d;
+    }
+    double mean = sum / iv.size(), sd = sqrt(fmax(0, sq / iv.size() - mean * mean));
+    int32_t minTransit = *std::min_element(r.transitUs.begin(), r.transitUs.end());
+    for(int32_t t : r.transitUs) tr.push_back((t - minTransit) / 1000.0);
+
+    printf("\nReconstructed frame timing:\n");
+    printf("  interval ms: mean=%.2f (%.1ffps) sd=%.2f p50=%.2f p99=%.2f max=%.2f\n",
+      mean, mean > 0 ? 1000.0 / mean : 0.0, sd, percentile(iv, 50), percentile(iv, 99), percentile(iv, 100));
+    printf("  transit above fastest ms: p50=%.2f p90=%.2f p99=%.2f max=%.2f\n",
+      percentile(tr, 50), percentile(tr, 90), percentile(tr, 99), percentile(tr, 100));
+    replayDisplay(r);
+  }
+
+  // Throughput pass - the decode path only, as fast as it goes
+  auto t0 = std::chrono::steady_clock::now();
+  uint64_t runs = 0, frames = 0;
+  double elapsedMs = 0;
+  do {
+    replayReset(r, token, false);
+    for(const CaptureRecord& c : recs) replayPacket(r, c, false);
+    frames += r.frames;
+    runs++;
+    elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  } while(elapsedMs < BENCH_MIN_MS);
+
+  double pkts = (double)runs * recs.size();
+  printf("\nDecode throughput (%llu passes, %.0fms):\n", (unsigned long long)runs, elapsedMs);
+  printf("  %.2fM packets/s  %.1f MB/s  %.0fk frames/s  %.2fus per packet\n",
+    pkts / elapsedMs / 1000.0, (double)runs * bytes / elapsedMs / 1000.0,
+    frames / elapsedMs, elapsedMs * 1000.0 / pkts);
+  return 0;
+}
+
+// Synthetic capture: a v2 leader with FEC, random loss and retry bursts,
+// interleaved with the node's own debug text. Packets go out back to back at
+// the airtime of the chosen rate, so a frame that doesn't fit its interval
+// pushes the next one back - the interval in the report is what the air allows.
+static int synth(const char* path, double lossPct, uint16_t leds, double forceMbps, int fps){
+  if(leds < 1 || leds > MAX_LEDS) { fprintf(stderr, "leds must be 1-%u\n", MAX_LEDS); return 1; }
+  if(fps < 1 || fps > 100) { fprintf(stderr, "fps must be 1-100\n"); return 1; }
+  FILE* f = fopen(path, "wb");
+  if(!f) { perror(path); return 1; }
+  srand(1);
+  const uint32_t token = 0xC0FFEE;
+  const LinkLevel& lvl = LINK_LEVELS[1];                 // Clean air with FEC
+  const int chunks = linkChunks(lvl, leds);
+  const uint16_t rates[] = {1000, 2000, 5500, 11000};    // networking.cpp AIR_RATES
+  uint16_t kbps = forceMbps > 0 ? (uint16_t)(forceMbps * 1000) : rates[linkPickRate(rates, 4, leds)];
+  const uint8_t src[6] = {0x24, 0x0A, 0xC4, 0xC0, 0xFF, 0xEE};
+  static uint8_t rgb[MAX_LEDS * 3];
+  uint8_t pkt[PROTO_MAX_PACKET], rec[CAPTURE_MAX_RECORD];
+  uint16_t seq = 0;
+  uint32_t nowUs = 5000000, t = nowUs;
+
+  const uint32_t frames = 30 * fps, intervalUs = 1000000 / fps;
+  for(uint32_t frame = 0; frame < frames; frame++, nowUs += intervalUs) {
+    for(int i = 0; i < leds * 3; i++) rgb[i] = (uint8_t)(i * 3 + frame);
+    uint8_t parity[PROTO_MAX_PACKET] = {0};
+    uint8_t flags = PROTO_FLAG_LEADER | lvl.flags;
+    // Rendered on time, sent once the air is free
+    uint32_t start = nowUs + rand() % 500;
+    if((int32_t)(start - t) > 0) t = start;
+    for(int c = 0; c <= chunks; c++) {
+      int len;
+      if(c < chunks) {
+        int base = c * lvl.ledsPerChunk, cnt = std::min((int)lvl.ledsPerChunk, leds - base);
+        int n = protoEncodePixels(flags, rgb + base * 3, cnt, pkt + PROTO_HEADER_LEN);
+        for(int i = 0; i < n; i++) parity[i] ^= pkt[PROTO_HEADER_LEN + i];
+        len = protoBuildV2(pkt, PKT_PIXELS, flags, token, frame, c, chunks, nowUs, base, pkt + PROTO_HEADER_LEN, n);
+      } else {
+        len = protoBuildV2(pkt, PKT_PIXELS, flags, token, frame, chunks, chunks, nowUs, lvl.ledsPerChunk,
+                           parity, lvl.ledsPerChunk * 3);
+      }
+      t += protoAirtimeUs(len, kbps) + rand() % 100 + ((rand() % 100) < 3 ? rand() % 8000 : 0);   // The odd retry burst
+      if(rand() % 10000 < lossPct * 100) continue;
+      int n = captureEncode(rec, seq++, t, -55 - rand() % 20, src, pkt, len);
+      fwrite(rec, 1, n, f);
+    }
+    if(frame % (10 * fps) == 0) fprintf(f, "RX: ring depth=0 peak=3/32 overflows=0 crc=0 badver=0 lost=0 proto=v2 reports=%u\n", frame / fps);
+  }
+  fclose(f);
+  printf("Wrote %s: 30s of a %dfps leader, %u LEDs in %d chunks + parity at %.1fMbps (%.1fms on air per frame), %.1f%% packet loss\n",
+    path, fps, leds, chunks, kbps / 1000.0, linkFrameAirtimeUs(lvl, leds, kbps) / 1000.0, lossPct);
+  return 0;
+}
+
+int main(int argc, char** argv){
+  if(argc >= 3 && !strcmp(argv[1], "--synth")) {
+    return synth(argv[2], argc > 3 ? atof(argv[3]) : 2.0, argc > 4 ? atoi(argv[4]) : DEFAULT_LEDS,
+                 argc > 5 ? atof(argv[5]) : 0, argc > 6 ? atoi(argv[6]) : LINK_LEVELS[1].fps);
+  }
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s capture.cap [token] | --synth out.cap [loss%%] [leds] [Mbps] [fps]\n", argv[0]);
+    return 1;
+  }
+  return analyse(argv[1], argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 16) : 0);
+}
@@ -0,0 +1,159 @@
+// ── Multi-Strip Output Simulator ─────────────────────────────────────────────
+// Host-side mock of the LED output stage: the firmware's strip layout code
+// (striplayout.cpp) remaps a logical frame onto the strips, and a mock driver
+// clocks each strip out on its own channel the way FastLED's ESP32 RMT driver
+// does - every channel started in turn, then all of them transmitting at once
+// while show() waits for the slowest. Every frame is decoded back off the
+// mock wires and checked pixel by pixel against the layout.
+//
+// Build (from the sketch folder):
+//   g++ -std=c++17 -O2 -I. -o strips_sim tools/strips_sim.cpp striplayout.cpp
+// Run:
+//   ./strips_sim          sweep total pixel counts, one strip vs parallel strips
+//
+// Wire model: WS2812B at 800kHz (30us per pixel) plus the latch gap, per
+// channel (stripWireUs). Starting a channel costs CHANNEL_START_US of CPU and
+// happens one channel after another; remapping costs REMAP_NS_PER_PIXEL, or
+// REVERSED_NS_PER_PIXEL for a reversed strip - both only when the layout
+// isn't direct. Frame rate is capped at the leader's 50fps.
+
+#include "../striplayout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static const uint32_t CHANNEL_START_US      = 20;     // RMT setup and first buffer fill, per channel
+static const uint32_t REMAP_NS_PER_PIXEL    = 15;     // memcpy runs at 240MHz
+static const uint32_t REVERSED_NS_PER_PIXEL = 60;     // Pixel-at-a-time copy
+static const uint32_t FRAME_US              = 20000;  // 50fps leader
+static const uint16_t STRIP_PIXELS          = 334;    // One stick's strip today
+
+struct MockChannel {
+  uint32_t startUs, endUs;
+  std::vector<uint8_t> wire;       // Bytes as clocked out, first pixel first
+};
+
+struct ShowResult {
+  uint32_t frameUs;
+  bool     ok;
+};
+
+// One show(): remap, start the channels in turn, wait for the slowest,
+// then read every strip back off its wire and compare with the layout
+static ShowResult mockShow(const StripConfig* strips, uint8_t n, uint16_t total){
+  std::vector<uint8_t> logical(total * STRIP_PIXEL_BYTES), physical(total * STRIP_PIXEL_BYTES);
+  for(uint16_t i = 0; i < total; i++) {
+    // Pixel index in two channels, a frame-dependent byte in the third
+    logical[i * 3 + 0] = i & 0xFF;
+    logical[i * 3 + 1] = i >> 8;
+    logical[i * 3 + 2] = (i * 7) & 0xFF;
+  }
+
+  bool direct = stripLayoutDirect(strips, n);
+  uint32_t t = 0;
+  if(!direct) {
+    for(uint8_t i = 0; i < n; i++) {
+      t += strips[i].count * (strips[i].reversed ? REVERSED_NS_PER_PIXEL : REMAP_NS_PER_PIXEL) / 1000;
+    }
+    stripRemap(strips, n, logical.data(), physical.data());
+  } else {
+    physical = logical;
+  }
+
+  std::vector<MockChannel> ch(n);
+  uint32_t done = 0;
+  for(uint8_t i = 0; i < n; i++) {
+    t += CHANNEL_START_US;
+    ch[i].startUs = t;
+    ch[i].endUs = t + stripWireUs(strips[i].count);
+    const uint8_t* src = physical.data() + stripPhysicalStart(strips, i) * STRIP_PIXEL_BYTES;
+    ch[i].wire.assign(src, src + strips[i].count * STRIP_PIXEL_BYTES);
+    if(ch[i].endUs > done) done = ch[i].endUs;
+  }
+
+  // Pixel p down strip i must show the logical pixel the layout puts there
+  bool ok = true;
+  std::vector<uint8_t> seen(total, 0);
+  for(uint8_t i = 0; i < n && ok; i++) {
+    const StripConfig& s = strips[i];
+    for(uint16_t p = 0; p < s.count; p++) {
+      const uint8_t* px = &ch[i].wire[p * 3];
+      uint16_t got = px[0] | (px[1] << 8);
+      uint16_t want = s.reversed ? s.logicalStart + s.count - 1 - p : s.logicalStart + p;
+      if(got != want || px[2] != ((want * 7) & 0xFF) || want >= total || seen[want]++) {
+        printf("  MISMATCH strip %u pixel %u: shows %u, wired for %u\n", i, p, got, want);
+        ok = false;
+        break;
+      }
+    }
+  }
+  return {done, ok};
+}
+
+// total pixels split into strips of at most perStrip, every other one reversed
+// (fed from the middle of each pair) unless direct
+static uint8_t buildLayout(StripConfig* strips, uint16_t total, uint16_t perStrip, bool direct){
+  uint8_t n = 0;
+  for(uint16_t start = 0; start < total && n < STRIP_MAX_CHANNELS; n++) {
+    uint16_t count = total - start < perStrip ? total - start : perStrip;
+    strips[n] = {(uint8_t)(32 + n), start, count, !direct && (n % 2 == 0)};
+    start += count;
+  }
+  return n;
+}
+
+static void printHeader(){
+  printf("%7s %6s %7s  %10s %7s  %10s %7s  %s\n", "pixels", "strips", "layout",
+         "one strip", "fps", "parallel", "fps", "check");
+}
+
+int main(){
+  bool allOk = true;
+  uint32_t baseUs = 0, worstUs = 0;
+
+  printf("Strips of up to %u pixels, added as the pixel count grows:\n", STRIP_PIXELS);
+  printHeader();
+  for(uint8_t k = 1; k <= STRIP_MAX_CHANNELS; k++) {
+    for(int direct = 1; direct >= 0; direct--) {
+      uint16_t total = STRIP_PIXELS * k;
+      StripConfig strips[STRIP_MAX_CHANNELS];
+      uint8_t n = buildLayout(strips, total, STRIP_PIXELS, direct);
+      if(!stripLayoutValid(strips, n, total)) { printf("  invalid layout\n"); return 2; }
+      StripConfig one = {32, 0, total, false};
+      ShowResult serial = mockShow(&one, 1, total);
+      ShowResult par = mockShow(strips, n, total);
+      allOk = allOk && serial.ok && par.ok;
+      if(k == 1 && direct) baseUs = par.frameUs;
+      if(par.frameUs > worstUs) worstUs = par.frameUs;
+      uint32_t serialFrame = serial.frameUs > FRAME_US ? serial.frameUs : FRAME_US;
+      uint32_t parFrame = par.frameUs > FRAME_US ? par.frameUs : FRAME_US;
+      printf("%7u %6u %7s  %8.1fms %7.1f  %8.1fms %7.1f  %s\n", total, n, direct ? "direct" : "mapped",
+             serial.frameUs / 1000.0, 1e6 / serialFrame, par.frameUs / 1000.0, 1e6 / parFrame,
+             par.ok && serial.ok ? "ok" : "FAIL");
+    }
+  }
+
+  printf("\n1002 pixels split across more strips:\n");
+  printHeader();
+  const uint16_t splits[] = {1002, 501, 334, 167};
+  for(uint16_t per : splits) {
+    StripConfig strips[STRIP_MAX_CHANNELS];
+    uint8_t n = buildLayout(strips, 1002, per, false);
+    StripConfig one = {32, 0, 1002, false};
+    ShowResult serial = mockShow(&one, 1, 1002);
+    ShowResult par = mockShow(strips, n, 1002);
+    allOk = allOk && par.ok;
+    uint32_t serialFrame = serial.frameUs > FRAME_US ? serial.frameUs : FRAME_US;
+    uint32_t parFrame = par.frameUs > FRAME_US ? par.frameUs : FRAME_US;
+    printf("%7u %6u %7s  %8.1fms %7.1f  %8.1fms %7.1f  %s\n", 1002, n, "mapped",
+           serial.frameUs / 1000.0, 1e6 / serialFrame, par.frameUs / 1000.0, 1e6 / parFrame,
+           par.ok ? "ok" : "FAIL");
+  }
+
+  printf("\nParallel frame time %.1fms at %u pixels, at most %.1fms (+%.0f%%) at %u\n",
+         baseUs / 1000.0, STRIP_PIXELS, worstUs / 1000.0, 100.0 * (worstUs - baseUs) / baseUs,
+         STRIP_PIXELS * STRIP_MAX_CHANNELS);
+  if(!allOk) printf("Pixel check FAILED\n");
+  return allOk ? 0 : 1;
+}
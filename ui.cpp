@@ -1,9 +1,20 @@
 #include "ui.h"
 #include "version.h" // Include the auto-generated version file
 #include "networking.h" // For forceSyncReset function
+#include "scheduler.h"
+#include "storage.h"
+#include "output.h"
 
 // Non-blocking UI timing
 static uint32_t lastUIUpdate = 0;
+static bool     uiMessageHold = false;   // A full-screen message is up - drawUI() waits
+static bool     btnAWaitRelease = false; // Ignore Button A until the OFF long press is released
+
+static const uint32_t UI_MESSAGE_TIME = 1000;
+
+static void releaseUIMessage(void*) {
+  uiMessageHold = false;
+}
 
 const char* MODE_NAMES[MODE_COUNT] = {"AUTO","OFF"};
 
@@ -25,43 +36,26 @@ void initUI(){
   canvas.createSprite(M5.Lcd.width(), M5.Lcd.height());
 }
 
-void loadControls(){
-  prefs.begin("npref", false);
-  
-  // Load global brightness scale (stored separately)
-  globalBrightnessScale = prefs.getUChar("globalBright", 64);  // Default 25%
-  
-  for(int m = 0; m < MODE_COUNT; ++m){
-    for(int i = 0; i < 22; ++i){
-      char k[8];
-      snprintf(k, 8, "%d%dS", m, i); speedVals[m][i]  = prefs.getUChar(k, 5);
-      snprintf(k, 8, "%d%dB", m, i); brightVals[m][i] = prefs.getUChar(k, 9);
-      snprintf(k, 8, "%d%dX", m, i); ssensVals[m][i]  = prefs.getUChar(k, 5);
-      snprintf(k, 8, "%d%dY", m, i); bsensVals[m][i]  = prefs.getUChar(k, 5);
-      snprintf(k, 8, "%d%dV", m, i); vsensVals[m][i]  = prefs.getUChar(k, 5);
-      snprintf(k, 8, "%d%dD", m, i); decayVals[m][i]  = prefs.getUChar(k, 5);
-      snprintf(k, 8, "%d%dT", m, i); timeVals[m][i]   = prefs.getUChar(k, 1);
-    }
-  }
+// Shown once ESP-NOW is listening, until the first drawUI()
+void drawBootSplash(){
+  canvas.fillSprite(TFT_BLACK);
+  canvas.fillRect(0, 0, M5.Lcd.width(), 40, TFT_BLUE);
+  canvas.setTextSize(2);
+  canvas.setTextColor(TFT_WHITE);
+  canvas.setCursor(10, 10);
+  canvas.print("ESP-NOW READY");
+  canvas.setTextSize(1);
+  canvas.setCursor(10, 50);
+  canvas.print("Local mesh active");
+  canvas.setCursor(10, 65);
+  canvas.print("WiFi check starting...");
+  canvas.pushSprite(0, 0);
 }
 
+// Changes are written later, coalesced (storage.cpp) - no flash stall per click
 void saveControl(Control c){
-  if(c == STYLE) return;
-  char k[8]; 
-  uint8_t v = 0;
-  
-  switch(c){
-    case SPEED:  v = getSpeed();  snprintf(k, 8, "%d%dS", currentMode, styleIdx); break;
-    case BRIGHT: v = getBright(); snprintf(k, 8, "%d%dB", currentMode, styleIdx); break;
-    case SSENS:  v = getSS();     snprintf(k, 8, "%d%dX", currentMode, styleIdx); break;
-    case BSENS:  v = getBS();     snprintf(k, 8, "%d%dY", currentMode, styleIdx); break;
-    case VSENS:  v = getVS();     snprintf(k, 8, "%d%dV", currentMode, styleIdx); break;
-    case DECAY:  v = getDe();     snprintf(k, 8, "%d%dD", currentMode, styleIdx); break;
-    case TIME:   v = getTi();     snprintf(k, 8, "%d%dT", currentMode, styleIdx); break;
-    default: return;
-  }
-  
-  prefs.putUChar(k, v);
+  if(c == STYLE || c >= CTRL_COUNT) return;
+  settingsChanged();
   if(c == BRIGHT) {
     // Apply global brightness scaling
     uint8_t scaledBrightness = (map(getBright(), 0, 9, 0, 255) * globalBrightnessScale) / 255;
@@ -69,11 +63,11 @@ void saveControl(Control c){
   }
 }
 
-// Function to save global brightness scale to flash
+// Local brightness is saved with the other settings once the button goes quiet
 void saveGlobalBrightness(){
-  prefs.putUChar("globalBright", globalBrightnessScale);
+  settingsChanged();
   if(DEBUG_SERIAL) {
-    Serial.printf("Global brightness saved: %d/255 (%.1f%%)\n", 
+    Serial.printf("Global brightness set: %d/255 (%.1f%%)\n", 
       globalBrightnessScale, (globalBrightnessScale * 100.0f) / 255.0f);
   }
 }
@@ -81,31 +75,34 @@ void saveGlobalBrightness(){
 void handleButtons(){
   uint32_t now = millis();
   
+  // After going OFF, Button A is ignored until the long press is released
+  // (avoids an immediate wake)
+  if(btnAWaitRelease && !M5.BtnA.isPressed()) btnAWaitRelease = false;
+  
   // Long press = OFF mode
-  if(M5.BtnA.pressedFor(2000)) {
+  if(!btnAWaitRelease && M5.BtnA.pressedFor(2000)) {
     if(currentMode != OFF) {
+      // Save pending changes while the brightness is still the real one
+      flushSettings("off");
       currentMode = OFF;
       globalBrightnessScale = 0;
       
       // Turn off LEDs
-      fill_solid(leds, NUM_LEDS, CRGB::Black);
-      FastLED.show();
+      fill_solid(leds, numLeds, CRGB::Black);
+      showLeds();
       
       // Dim display for battery savings
       M5.Lcd.setBrightness(20);
       
       if(DEBUG_SERIAL) Serial.println("Mode: OFF (short press to wake)");
       
-      // Wait for button release to avoid immediate wake
-      while(M5.BtnA.isPressed()) {
-        M5.update();
-        delay(50);
-      }
+      // Wait for button release to avoid immediate wake (checked each loop)
+      btnAWaitRelease = true;
     }
   }
   
   // Short press = brightness cycle (or wake from OFF)
-  else if(M5.BtnA.wasClicked()) {
+  else if(!btnAWaitRelease && M5.BtnA.wasClicked()) {
     if(currentMode == OFF) {
       // Wake up from OFF mode
       currentMode = AUTO;
@@ -141,7 +138,7 @@ void handleButtons(){
 
   // Button C double-click = ESP-NOW suspend/resume toggle (safe, avoids long press conflicts)
   static uint32_t lastCClick = 0;
-  static uint8_t cClickCount = 0;
+  static uint8_t cClickCount = 0;   // Clicks so far in this burst - 0 until Button C is clicked
   
   if(M5.BtnC.wasClicked() && currentMode == AUTO) {
     uint32_t now = millis();
@@ -161,9 +158,12 @@ void handleButtons(){
     lastCClick = now;
   }
   
-  // Reset click count after timeout
+  // Reset click count after timeout - only a click that really happened can
+  // time out, so nothing fires in the first second after boot
+  bool cSingleClick = false;
   if(millis() - lastCClick > 500 && cClickCount == 1) {
     cClickCount = 0; // Single click timeout, process as sync reset below
+    cSingleClick = true;
   }
   
   // Button B: Short press = Pattern control (only works in AUTO mode when leader)
@@ -172,7 +172,7 @@ void handleButtons(){
       freezeActive = true;
       if(DEBUG_SERIAL) Serial.println("Pattern freeze ON");
     } else {
-      styleIdx = (styleIdx + 1) % 42;
+      styleIdx = (styleIdx + 1) % PATTERN_COUNT;
       if(DEBUG_SERIAL) {
         Serial.printf("Pattern advance → %s [frozen]\n", STYLE_NAMES[styleIdx]);
       }
@@ -180,7 +180,7 @@ void handleButtons(){
   }
   
   // Button C: Single click = Manual sync reset (only if not part of double-click)
-  if(cClickCount == 0 && millis() - lastCClick > 500 && millis() - lastCClick < 1000 && currentMode == AUTO) {
+  if(cSingleClick && currentMode == AUTO) {
     if(DEBUG_SERIAL) Serial.println("MANUAL SYNC RESET requested via Button C single click");
     
     // Show reset indication on screen briefly
@@ -198,8 +198,9 @@ void handleButtons(){
     // Force sync reset
     forceSyncReset();
     
-    delay(1000); // Show message for 1 second
-    lastCClick = 0; // Clear to prevent repeat
+    // Show message for 1 second
+    uiMessageHold = true;
+    timerOnce(UI_MESSAGE_TIME, releaseUIMessage);
   }
 }
 
@@ -293,7 +294,7 @@ void drawUI(){
   if(currentMode == AUTO) {
     int barH = 20, by = (h - barH) / 2; 
     uint8_t bri = FastLED.getBrightness();
-    for(int x = 0; x < w && x < NUM_LEDS; x++){
+    for(int x = 0; x < w && x < numLeds; x++){
       CRGB c = leds[x];
       if(fsmState == LEADER) c.nscale8_video(bri);
       canvas.drawFastVLine(x, by, barH, canvas.color565(c.r, c.g, c.b));
@@ -307,5 +308,6 @@ void drawUI(){
 }
 
 bool shouldUpdateUI() {
+  if(uiMessageHold) return false;
   return (millis() - lastUIUpdate >= FRAME_DELAY_MS);
 }
\ No newline at end of file
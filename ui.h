@@ -5,11 +5,11 @@
 
 // ── UI Functions ──────────────────────────────────────────────────────────────
 void initUI();
+void drawBootSplash();
 void handleButtons();
 void drawUI();
 bool shouldUpdateUI();  // Non-blocking UI timing check
-void loadControls();
-void saveControl(Control c);
+void saveControl(Control c);         // Marks dirty - storage.h writes it later
 void saveGlobalBrightness();
 
 #endif
\ No newline at end of file